@@ -1,3 +1,4 @@
+#define _POSIX_C_SOURCE 200809L // posix_memalign
 #include <string.h>
 #include "astree.h"
 #include "node.h"
@@ -9,145 +10,185 @@
 #include <stdio.h>
 #include "lib/sds.h"
 
-static sds sds_substr(const sds src, size_t start, size_t len) {
-	size_t src_len = sdslen(src);
-	if (start >= src_len) return sdsnew("");  // empty string if start past end
-	if (start + len > src_len) len = src_len - start;
-	return sdsnewlen(src + start, len);
+static inline u32 symbol_slot(const SymbolTable *st, u32 id, u32 scope) {
+	return ((id * 2654435761u) ^ (scope * 40503u)) & st->slot_mask;
 }
 
-static unsigned hash_str(const void *ptr) {
-	char *s = (char *) ptr;
-	unsigned hashval;
-	for (hashval = 0; *s != '\0'; s++)
-		hashval = *s + 31 * hashval;
-	return hashval;
-}
-static int equal_str(const void *a, const void *b) {
-	return strcmp((char *)a, (char *)b) == 0;
+u32 symboltable_find(const SymbolTable *st, u32 id, u32 scope) {
+	u32 handle;
+	for (u32 slot = symbol_slot(st, id, scope); (handle = st->slots[slot]); slot = (slot + 1) & st->slot_mask) {
+		Symbol *sym = symboltable_symbol(st, handle);
+		if (sym->id == id && sym->scope == scope)
+			return handle;
+	}
+	return 0;
 }
 
-static unsigned hash_symbol(const void *ptr) {
-	const Symbol *sym = (const Symbol *)ptr;
-	unsigned hash = 17;
-	hash = hash * 31 + (unsigned)(sym->index.start ^ (sym->index.start >> 32));
-	hash = hash * 31 + (unsigned)(sym->index.len ^ (sym->index.len >> 32));
-	hash = hash * 31 + sym->scope;
-	return hash;
+// keeps the load factor under a half
+static void grow_slots(SymbolTable *st) {
+	free(st->slots);
+	st->slot_mask = st->slot_mask * 2 + 1;
+	st->slots = calloc(st->slot_mask + 1, sizeof(u32));
+	for (u32 handle = 1; handle < st->symbol_count; handle++) {
+		Symbol *sym = symboltable_symbol(st, handle);
+		u32 slot = symbol_slot(st, sym->id, sym->scope);
+		while (st->slots[slot])
+			slot = (slot + 1) & st->slot_mask;
+		st->slots[slot] = handle;
+	}
 }
 
-static int equal_symbol(const void *a, const void *b) {
-	const Symbol *s1 = (const Symbol *)a;
-	const Symbol *s2 = (const Symbol *)b;
-	return s1->index.start == s2->index.start &&
-	       s1->index.len   == s2->index.len &&
-	       s1->scope       == s2->scope;
+u32 symboltable_intern(SymbolTable *st, u32 id, u32 scope) {
+	u32 slot = symbol_slot(st, id, scope);
+	u32 handle;
+	for (; (handle = st->slots[slot]); slot = (slot + 1) & st->slot_mask) {
+		Symbol *sym = symboltable_symbol(st, handle);
+		if (sym->id == id && sym->scope == scope)
+			return handle;
+	}
+	handle = st->symbol_count++;
+	if (!(handle & (SYMBOL_CHUNK - 1))) {
+		u32 chunk = handle >> SYMBOL_CHUNK_BITS;
+		if (chunk == st->chunk_cap) {
+			st->chunk_cap *= 2;
+			st->chunks = realloc(st->chunks, st->chunk_cap * sizeof(Symbol *));
+		}
+		st->chunks[chunk] = malloc(SYMBOL_CHUNK * sizeof(Symbol));
+	}
+	*symboltable_symbol(st, handle) = (Symbol){ id, scope, 0, NULL };
+	if (st->symbol_count * 2 > st->slot_mask + 1)
+		grow_slots(st);
+	else
+		st->slots[slot] = handle;
+	return handle;
 }
 
-static sds buffer_append(sds buf, sds str) {
-	if (sdsavail(buf) < sdslen(str)) {
-	    buf = sdsMakeRoomFor(buf, sdslen(str));
-	}
-	buf = sdscatsds(buf, str);
-	return buf;
+void node_set_symbol(ASTree *ast, ASTNode *n, Symbol *sym) {
+	n->symbol = sym ? symboltable_find(ast->symboltable, sym->id, sym->scope) : 0;
 }
 
-static struct sindex make_index(size_t start, size_t len) {
-	struct sindex new = { start, len };
-	return new;
+// iden is the name's id in the symbol table's string pool (interned by the lexer)
+Symbol *astree_add_symbol(ASTree *ast, u32 iden, u32 scope) {
+	SymbolTable *st = ast->symboltable;
+	return symboltable_symbol(st, symboltable_intern(st, iden, scope)); // for parser to add to AST
 }
 
-Symbol *make_symbol(struct sindex index, u16 scope) {
-	Symbol *new = malloc(sizeof(Symbol));
-	new->index = index;
-	new->scope = scope;
-	return new;
+Symbol *astree_get_symbol(ASTree *ast, u32 iden, u32 scope) {
+	SymbolTable *st = ast->symboltable;
+	return symboltable_symbol(st, symboltable_find(st, iden, scope));
 }
 
-Symbol *symboltable_add(SymbolTable *st, sds iden, u16 scope) {
-	if(!hashmap_contains(st->seen_idens, iden)) {
-		size_t start = sdslen(st->stringspace);
-		st->stringspace = buffer_append(st->stringspace, iden);
-		struct sindex *index = malloc(sizeof(struct sindex));
-		*index = make_index(start, sdslen(st->stringspace) - start);
-		hashmap_add(st->seen_idens, sdsdup(iden), index);
+// makes handle the innermost declaration of its name (a global goes under any the open scopes have)
+static void bind(SymbolTable *st, u32 handle) {
+	Symbol *sym = symboltable_symbol(st, handle);
+	if (sym->id >= st->binding_cap) {
+		u32 cap = st->binding_cap;
+		while (st->binding_cap <= sym->id)
+			st->binding_cap *= 2;
+		st->bindings = realloc(st->bindings, st->binding_cap * sizeof(u32));
+		memset(st->bindings + cap, 0, (st->binding_cap - cap) * sizeof(u32));
 	}
-	struct sindex *index = hashmap_get(st->seen_idens, iden);
-	Symbol* new_symbol = make_symbol(*index, scope);
-	if (!hashmap_contains(st->live_pointers, new_symbol)) {
-		hashmap_add(st->live_pointers, new_symbol, NULL);
+	u32 *link = &st->bindings[sym->id];
+	if (!sym->scope)
+		while (*link && symboltable_symbol(st, *link)->scope)
+			link = &symboltable_symbol(st, *link)->shadowed;
+	sym->shadowed = *link;
+	*link = handle;
+	if (sym->scope && st->scope_depth) {
+		if (st->bound_count == st->bound_cap) {
+			st->bound_cap *= 2;
+			st->bound = realloc(st->bound, st->bound_cap * sizeof(u32));
+		}
+		st->bound[st->bound_count++] = handle;
 	}
-	// hashmap_add(st->table, new_symbol, attributes);
-	// LinkedList *stack = hashmap_bucket_at(st->table, iden);
-	// this suffices here, but for a3 checks using symbol_equals(s0, s1) will be needed
-	return new_symbol; // for parser to add to AST
 }
 
-Symbol *astree_add_symbol(ASTree *ast, sds iden, u16 scope) {
-	return symboltable_add(ast->symboltable, iden, scope);
+static void unbind(SymbolTable *st, u32 handle) {
+	Symbol *sym = symboltable_symbol(st, handle);
+	if (sym->id >= st->binding_cap)
+		return;
+	for (u32 *link = &st->bindings[sym->id]; *link; link = &symboltable_symbol(st, *link)->shadowed) {
+		if (*link == handle) {
+			*link = sym->shadowed;
+			sym->shadowed = 0;
+			return;
+		}
+	}
 }
 
-Symbol *astree_get_symbol(ASTree *ast, sds iden, u16 scope) {
-	struct sindex *index = hashmap_get(ast->symboltable->seen_idens, iden);
-	if (!index)
-		return NULL;
-	return make_symbol(*index, scope);
+void symboltable_enter_scope(SymbolTable *st) {
+	if (st->scope_depth == st->scope_cap) {
+		st->scope_cap *= 2;
+		st->scope_starts = realloc(st->scope_starts, st->scope_cap * sizeof(u32));
+	}
+	st->scope_starts[st->scope_depth++] = st->bound_count;
 }
 
-int symboltable_add_attribute(SymbolTable *st, Symbol *key, Attribute *atr) {
-	if(!hashmap_contains(st->table, key)) {
-		hashmap_add(st->table, key, atr);
-		if (!hashmap_contains(st->live_pointers, key)) {
-			hashmap_add(st->live_pointers, key, NULL);
-		}
-		return 0;
-	} else {
-		return 1; // duplicate symbol - semantic error
-	}
+void symboltable_exit_scope(SymbolTable *st) {
+	u32 start = st->scope_starts[--st->scope_depth];
+	while (st->bound_count > start)
+		unbind(st, st->bound[--st->bound_count]);
 }
 
-int astree_add_attribute(ASTree *ast, Symbol *key, Attribute *atr) {
-	return symboltable_add_attribute(ast->symboltable, key, atr);
+void symboltable_exit_scopes(SymbolTable *st) {
+	while (st->scope_depth)
+		symboltable_exit_scope(st);
 }
 
-Attribute *astree_get_attribute(ASTree *ast, Symbol *key) {
-	if (!key) return NULL;
-	Attribute *result = hashmap_get(ast->symboltable->table, key);
-	if (result)
-		return result;
-	Symbol global_scoped = *key; // it might be in the global scope, so give that a try
-	global_scoped.scope = 0;
-	return hashmap_get(ast->symboltable->table, &global_scoped);
+Symbol *symboltable_global(const SymbolTable *st, u32 id) {
+	if (id >= st->binding_cap)
+		return NULL;
+	u32 handle = st->bindings[id];
+	while (handle && symboltable_symbol(st, handle)->scope)
+		handle = symboltable_symbol(st, handle)->shadowed;
+	return symboltable_symbol(st, handle);
 }
 
-static inline unsigned hash_ptr(const void *p) {
-	uintptr_t x = (uintptr_t)p;
-	return (unsigned)(x>>4) ^ (unsigned)(x * 2654435761u);
+// key must be one of the table's symbols
+int astree_add_attribute(ASTree *ast, Symbol *key, Attribute *atr) {
+	if (key->attribute)
+		return 1; // duplicate symbol - semantic error
+	key->attribute = atr;
+	bind(ast->symboltable, symboltable_find(ast->symboltable, key->id, key->scope));
+	return 0;
 }
 
-static inline int equal_ptr(const void *a, const void *b) {
-	return a == b;
+Attribute *astree_get_attribute(ASTree *ast, Symbol *key) {
+	if (!key) return NULL;
+	if (key->attribute || !key->scope)
+		return key->attribute;
+	// it might be in the global scope, so give that a try
+	Symbol *global = symboltable_global(ast->symboltable, key->id);
+	return global ? global->attribute : NULL;
 }
 
 SymbolTable *symboltable_create(size_t table_size) {
 	SymbolTable *temp = malloc(sizeof(SymbolTable));
-	temp->stringspace = sdsnewlen(NULL, 32);
+	temp->pool = stringpool_create();
 	// temp->table_size = table_size;
-	temp->seen_idens = hashmap_create(table_size, hash_str, equal_str);
-	temp->table = hashmap_create(table_size, hash_symbol, equal_symbol);
-	temp->live_pointers = hashmap_create(50, hash_ptr, equal_ptr);
+	temp->chunk_cap = 8;
+	temp->chunks = malloc(temp->chunk_cap * sizeof(Symbol *));
+	temp->chunks[0] = malloc(SYMBOL_CHUNK * sizeof(Symbol));
+	temp->symbol_count = 1; // past handle 0
+	temp->slot_mask = 127;
+	temp->slots = calloc(temp->slot_mask + 1, sizeof(u32));
+	temp->binding_cap = table_size > 16 ? table_size : 16; // grows with the names declared
+	temp->bindings = calloc(temp->binding_cap, sizeof(u32));
+	temp->bound_cap = 64;
+	temp->bound = malloc(temp->bound_cap * sizeof(u32));
+	temp->bound_count = 0;
+	temp->scope_cap = 4;
+	temp->scope_starts = malloc(temp->scope_cap * sizeof(u32));
+	temp->scope_depth = 0;
 	return temp;
 };
 
-// wrapper function to store symbols in the resource management map
-Attribute *astree_attribute_create(ASTree *ast, enum symbol_type type, void *data) {
+// a new attribute, data being the type's symbol for arrays and structs (the table owns it)
+Attribute *astree_attribute_create(enum symbol_type type, void *data) {
 	Attribute *atr = malloc(sizeof(Attribute));
 	atr->type = type;
 	if (type == SARRAY || type == SSTRUCT) {
-		if (!hashmap_contains(ast->symboltable->live_pointers, (Symbol *)data)) {
-			hashmap_add(ast->symboltable->live_pointers, (Symbol *)data, NULL);
-		}
-		atr->data = data;
+		atr->data = data; // the type's symbol, which the table owns
 	} else {
 		atr->data = NULL;
 	}
@@ -156,22 +197,13 @@ Attribute *astree_attribute_create(ASTree *ast, enum symbol_type type, void *dat
 	return atr;
 }
 
-static void sdsfree_wrapper(void *ptr) {
-	sdsfree((sds)ptr);
-}
-
-static void free_noop(void *ptr) {
-    (void)ptr; // do nothing (not the owner)
-}
-
 static void free_attribute(void *ptr) {
 	// if (!ptr) return;
 	Attribute *atr = (Attribute *)ptr;
 	switch (atr->type) {
 		case SARRAY:
 		case SSTRUCT:
-			free(atr->data);
-			break;
+			break; // the type's symbol belongs to the table
 		case SFIELDS:
 			linkedlist_free(atr->data);
 			break;
@@ -186,21 +218,78 @@ static void free_attribute(void *ptr) {
 	free(atr);
 }
 
+// drops key's attribute (and its parameter list, for a function)
+void astree_remove_attribute(ASTree *ast, Symbol *key) {
+	if (!key->attribute)
+		return;
+	unbind(ast->symboltable, symboltable_find(ast->symboltable, key->id, key->scope));
+	free_attribute(key->attribute);
+	key->attribute = NULL;
+}
+
 void symboltable_free(SymbolTable *st) {
-	sdsfree(st->stringspace);
-	hashmap_free(st->seen_idens, sdsfree_wrapper, free);
-	hashmap_free(st->table, free_noop, free_attribute);
-	hashmap_free(st->live_pointers, free, free_noop);
+	stringpool_free(st->pool);
+	for (u32 handle = 1; handle < st->symbol_count; handle++) {
+		Symbol *sym = symboltable_symbol(st, handle);
+		if (sym->attribute)
+			free_attribute(sym->attribute);
+	}
+	for (u32 i = 0; i <= (st->symbol_count - 1) >> SYMBOL_CHUNK_BITS; i++)
+		free(st->chunks[i]);
+	free(st->chunks);
+	free(st->slots);
+	free(st->bindings);
+	free(st->bound);
+	free(st->scope_starts);
 	free(st);
 }
 
-void node_free(ASTNode *n) {
+// node_id relies on this
+typedef char node_size_is_a_power_of_2[(sizeof(ASTNode) & (sizeof(ASTNode) - 1)) == 0 ? 1 : -1];
+
+static void add_chunk(ASTree *ast) {
+	if (ast->chunk_count == ast->chunk_cap) {
+		ast->chunk_cap = ast->chunk_cap ? ast->chunk_cap * 2 : 8;
+		ast->chunks = realloc(ast->chunks, ast->chunk_cap * sizeof(ASTNode *));
+	}
+	void *chunk;
+	if (posix_memalign(&chunk, NODE_CHUNK * sizeof(ASTNode), NODE_CHUNK * sizeof(ASTNode)))
+		abort();
+	ast->chunks[ast->chunk_count] = chunk;
+	ast->chunks[ast->chunk_count]->left = ast->chunk_count;
+	ast->chunk_count++;
+	ast->node_count++; // past the header
+}
+
+ASTNode *astree_node_alloc(ASTree *ast) {
+	u32 i = ast->spare;
+	if (i) {
+		ASTNode *n = astree_node(ast, i);
+		ast->spare = n->left;
+		return n;
+	}
+	if (!(ast->node_count & (NODE_CHUNK - 1)))
+		add_chunk(ast);
+	return astree_node(ast, ast->node_count++);
+}
+
+void node_free(ASTree *ast, ASTNode *n) {
 	if (!n) return;
-	// node does not own the symbol it holds
-	node_free(n->left_child);
-	node_free(n->middle_child);
-	node_free(n->right_child);
-	free(n);
+	// node does not own the symbol it holds, so the nodes still to free are chained through it
+	n->symbol = 0;
+	for (u32 todo = node_id(n); todo; ) {
+		n = astree_node(ast, todo);
+		todo = n->symbol;
+		u32 children[3] = { n->left, n->middle, n->right };
+		for (int k = 0; k < 3; k++) {
+			if (children[k]) {
+				astree_node(ast, children[k])->symbol = todo;
+				todo = children[k];
+			}
+		}
+		n->left = ast->spare;
+		ast->spare = node_id(n);
+	}
 }
 
 ASTree *astree_create(size_t table_size) {
@@ -208,21 +297,27 @@ ASTree *astree_create(size_t table_size) {
 	temp->root = NULL;
 	temp->symboltable = symboltable_create(table_size);
 	temp->is_valid = 1;
+	temp->chunks = NULL;
+	temp->chunk_count = temp->chunk_cap = 0;
+	temp->node_count = 0;
+	temp->spare = 0;
 	return temp;
 }
 
 void astree_free(ASTree *tree) {
-	node_free(tree->root);
+	for (u32 i = 0; i < tree->chunk_count; i++) // the nodes, without walking them
+		free(tree->chunks[i]);
+	free(tree->chunks);
 	symboltable_free(tree->symboltable);
 	free(tree);
 }
 
-void astree_set_offset(ASTree *ast, Symbol *key, u16 val) {
+void astree_set_offset(ASTree *ast, Symbol *key, u32 val) {
 	Attribute *atr = astree_get_attribute(ast, key);
 	atr->offset = val;
 }
 
-u16 astree_get_offset(ASTree *ast, Symbol *key) {
+u32 astree_get_offset(ASTree *ast, Symbol *key) {
 	Attribute *atr = astree_get_attribute(ast, key);
 	return atr->offset;
 }
@@ -244,15 +339,10 @@ void print_node(ASTree *ast, ASTNode *node, int *linelen) {
 	}
 	printf("%s", NPRINT[node->type]);
 	*linelen += 7;
-	if (node->symbol_value) {
-		sds symbol_str = sds_substr(
-			ast->symboltable->stringspace,
-			node->symbol_value->index.start,
-			node->symbol_value->index.len
-		);
-		printf("%s", symbol_str);
-		*linelen += sdslen(symbol_str) - 1; // why is this -1 needed for alignment??
-		sdsfree(symbol_str);
+	if (node->symbol) {
+		StrView symbol_str = stringpool_view(ast->symboltable->pool, node_symbol(ast, node)->id);
+		printf("%.*s", (int)symbol_str.len, symbol_str.str);
+		*linelen += symbol_str.len - 1; // why is this -1 needed for alignment??
 		printf(" "); // pad value with whitespace
 		(*linelen)++;
 		while (++(*linelen) % 7 != 0)
@@ -266,10 +356,14 @@ void print_node(ASTree *ast, ASTNode *node, int *linelen) {
 
 void print_traversal(ASTree *ast, ASTNode *node, int *linelen) {
 	if (!node) return;
-	print_node(ast, node, linelen);
-	print_traversal(ast, node->left_child, linelen);
-	print_traversal(ast, node->middle_child, linelen);
-	print_traversal(ast, node->right_child, linelen);
+	NodeStack todo = { 0 };
+	node_stack_push(&todo, node_id(node));
+	while (todo.count) { // preorder
+		node = astree_node(ast, node_stack_pop(&todo));
+		print_node(ast, node, linelen);
+		node_stack_push_children(&todo, node);
+	}
+	node_stack_free(&todo);
 }
 
 void astree_printf(ASTree *ast) {
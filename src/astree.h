@@ -7,8 +7,8 @@
 #include "lib/hashmap.h"
 #include "lib/sds.h"
 #include "lib/defs.h"
-
-void node_free(ASTNode *n);
+#include <stdint.h>
+#include <stdlib.h>
 
 // struct ssindex {
 // 	size_t start;
@@ -22,15 +22,85 @@ typedef struct struct_element {
 } Element;
 
 
+// nodes are kept in chunks of NODE_CHUNK, which never move once made (so pointers to nodes stay good
+// while the tree grows) and are aligned to their size (so node_id finds a node's index from its address)
+#define NODE_CHUNK_BITS 12
+#define NODE_CHUNK (1u << NODE_CHUNK_BITS)
+
 typedef struct astree {
 	ASTNode *root;
 	SymbolTable *symboltable;
 	int is_valid; //bool
+	ASTNode **chunks; // the first node of each is a header, holding the chunk's number in left
+	u32 chunk_count, chunk_cap;
+	u32 node_count; // the next index handed out (index 0 is chunk 0's header, so means no node)
+	u32 spare; // nodes given back by node_free (chained through left)
 } ASTree;
 
 ASTree *astree_create(size_t table_size);
 void astree_free(ASTree *tree);
 
+// uninitialised, from the tree's chunks
+ASTNode *astree_node_alloc(ASTree *ast);
+// gives n and everything under it back to the tree, for reuse by astree_node_alloc
+void node_free(ASTree *ast, ASTNode *n);
+
+static inline ASTNode *astree_node(const ASTree *ast, u32 i) {
+	return i ? ast->chunks[i >> NODE_CHUNK_BITS] + (i & (NODE_CHUNK - 1)) : NULL;
+}
+static inline u32 node_id(const ASTNode *n) {
+	if (!n)
+		return 0;
+	const ASTNode *chunk = (const ASTNode *)((uintptr_t)n & ~(uintptr_t)(NODE_CHUNK * sizeof(ASTNode) - 1));
+	return chunk->left << NODE_CHUNK_BITS | (u32)(n - chunk);
+}
+static inline ASTNode *node_left(const ASTree *ast, const ASTNode *n) {
+	return astree_node(ast, n->left);
+}
+static inline ASTNode *node_middle(const ASTree *ast, const ASTNode *n) {
+	return astree_node(ast, n->middle);
+}
+static inline ASTNode *node_right(const ASTree *ast, const ASTNode *n) {
+	return astree_node(ast, n->right);
+}
+static inline Symbol *node_symbol(const ASTree *ast, const ASTNode *n) {
+	return symboltable_symbol(ast->symboltable, n->symbol);
+}
+// sym must be one of the table's (from astree_add_symbol or astree_get_symbol)
+void node_set_symbol(ASTree *ast, ASTNode *n, Symbol *sym);
+
+// node indices still to visit, for walking the tree on the heap rather than the C stack (4 bytes a level)
+// no tree gets near 2^31 nodes, so a walker can mark an entry with NODE_VISITED
+typedef struct node_stack {
+	u32 *items;
+	u32 count, cap;
+} NodeStack;
+
+#define NODE_VISITED (1u << 31)
+
+static inline void node_stack_push(NodeStack *s, u32 item) {
+	if (s->count == s->cap) {
+		s->cap = s->cap ? s->cap * 2 : 64;
+		s->items = realloc(s->items, s->cap * sizeof(u32));
+	}
+	s->items[s->count++] = item;
+}
+static inline u32 node_stack_pop(NodeStack *s) {
+	return s->items[--s->count];
+}
+// the ones n has, so that they come off left first
+static inline void node_stack_push_children(NodeStack *s, const ASTNode *n) {
+	if (n->right)
+		node_stack_push(s, n->right);
+	if (n->middle)
+		node_stack_push(s, n->middle);
+	if (n->left)
+		node_stack_push(s, n->left);
+}
+static inline void node_stack_free(NodeStack *s) {
+	free(s->items);
+}
+
 // union symbol_value
 // Symbol
 // union symbol_data {
@@ -51,16 +121,21 @@ typedef struct attribute {
 	// u16 col;
 } Attribute;
 
-Attribute *astree_attribute_create(ASTree *ast, enum symbol_type type, void *data);
+Attribute *astree_attribute_create(enum symbol_type type, void *data);
 
-Symbol *astree_add_symbol(ASTree *ast, sds iden, u16 scope);
-Symbol *astree_get_symbol(ASTree *ast, sds iden, u16 scope);
+// the table's symbol for iden in scope (the same one each time), made on first use
+Symbol *astree_add_symbol(ASTree *ast, u32 iden, u32 scope);
+// as above, but NULL if there isn't one
+Symbol *astree_get_symbol(ASTree *ast, u32 iden, u32 scope);
 
+// declares key (one of the table's) as atr in the innermost open scope, 1 if it already was
 int astree_add_attribute(ASTree *ast, Symbol *key, Attribute *atr);
+// what key was declared as, or failing that the global of the same name
 Attribute *astree_get_attribute(ASTree *ast, Symbol *key);
+void astree_remove_attribute(ASTree *ast, Symbol *key);
 
-void astree_set_offset(ASTree *ast, Symbol *key, u16 val);
-u16 astree_get_offset(ASTree *ast, Symbol *key);
+void astree_set_offset(ASTree *ast, Symbol *key, u32 val);
+u32 astree_get_offset(ASTree *ast, Symbol *key);
 
 void astree_mark_param(ASTree *ast, Symbol *key);
 int astree_is_param(ASTree *ast, Symbol *key);
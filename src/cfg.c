@@ -0,0 +1,515 @@
+#include "cfg.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+static inline Line *line_at(const TAC *tac, u32 i) {
+	return vector_at(tac->lines, i);
+}
+
+static int ends_block(enum operation op) {
+	switch (op) {
+		case O_GOTO: case O_GOTOT: case O_GOTOF:
+		case O_RETN: case O_RVAL:
+			return 1;
+		default:
+			return 0;
+	}
+}
+
+static void push_u32(u32 **items, u32 *count, u32 *cap, u32 item) {
+	if (*count == *cap) {
+		*cap = *cap ? *cap * 2 : 16;
+		*items = realloc(*items, *cap * sizeof(u32));
+		if (!*items) abort();
+	}
+	(*items)[(*count)++] = item;
+}
+
+u32 cfg_next_func(const TAC *tac, u32 func) {
+	u32 i = func + 1;
+	while (i < vector_len(tac->lines) && line_at(tac, i)->op != O_FUNC)
+		i++;
+	return i;
+}
+
+// a graph as lists of edges, so dominators are found the same way over the CFG and its reverse
+struct graph {
+	u32 node_count;
+	u32 *out_start, *out; // node n's successors are out[out_start[n]] up to out[out_start[n + 1]]
+	u32 *in_start, *in;
+};
+
+// edges are (from, to) pairs, listed by from (side 0) or to (side 1)
+static void list_edges(u32 node_count, const u32 *edges, u32 edge_count, int side, u32 **start, u32 **list) {
+	*start = calloc(node_count + 1, sizeof(u32));
+	*list = malloc((edge_count ? edge_count : 1) * sizeof(u32));
+	for (u32 e = 0; e < edge_count; e++)
+		(*start)[edges[2 * e + side] + 1]++;
+	for (u32 n = 0; n < node_count; n++)
+		(*start)[n + 1] += (*start)[n];
+	u32 *fill = malloc(node_count * sizeof(u32));
+	for (u32 n = 0; n < node_count; n++)
+		fill[n] = (*start)[n];
+	for (u32 e = 0; e < edge_count; e++)
+		(*list)[fill[edges[2 * e + side]]++] = edges[2 * e + !side];
+	free(fill);
+}
+
+// the nodes reachable from root in postorder, with number[n] being n's place in a preorder of the same walk
+// (CFG_NONE if unreached) and parent[n] the node it was first reached from
+// each node's edges are followed last first (a jump before falling through), so a loop's exit is finished
+// before its body, and the body comes straight after the header in reverse postorder
+static u32 depth_first(const struct graph *g, u32 root, u32 *order, u32 *number, u32 *parent) {
+	u32 *stack = malloc(g->node_count * sizeof(u32));
+	u32 *next = calloc(g->node_count, sizeof(u32)); // the next of each node's edges to follow
+	for (u32 n = 0; n < g->node_count; n++)
+		number[n] = CFG_NONE;
+	u32 count = 0, seen = 0, depth = 0;
+	stack[depth++] = root;
+	number[root] = seen++;
+	parent[root] = root;
+	while (depth) {
+		u32 n = stack[depth - 1];
+		if (g->out_start[n] + next[n] < g->out_start[n + 1]) {
+			u32 s = g->out[g->out_start[n + 1] - 1 - next[n]++];
+			if (number[s] == CFG_NONE) {
+				number[s] = seen++;
+				parent[s] = n;
+				stack[depth++] = s;
+			}
+		} else {
+			order[count++] = n;
+			depth--;
+		}
+	}
+	free(stack);
+	free(next);
+	return count;
+}
+
+// lengauer and tarjan's path compression: points v past the nodes between it and the root of its tree,
+// label[v] becoming the least label on the way (the root's aside)
+static void compress(u32 *ancestor, u32 *label, u32 *path, u32 v) {
+	u32 depth = 0;
+	for (; ancestor[ancestor[v]] != CFG_NONE; v = ancestor[v])
+		path[depth++] = v;
+	while (depth--) {
+		u32 n = path[depth], a = ancestor[n];
+		if (label[a] < label[n])
+			label[n] = label[a];
+		ancestor[n] = ancestor[a];
+	}
+}
+
+// semi-NCA (georgiadis): semidominators as lengauer and tarjan find them, by preorder number from the last,
+// then each node's idom is the nearest dominator of its parent in the walk at or above its semidominator
+// leaves CFG_NONE for unreached nodes, returns how many were reached, order holding them in postorder
+static u32 dominators(const struct graph *g, u32 root, u32 *idom, u32 *order) {
+	u32 *number = malloc(g->node_count * sizeof(u32)), *parent = malloc(g->node_count * sizeof(u32));
+	u32 count = depth_first(g, root, order, number, parent);
+	// the rest is by preorder number
+	u32 *vertex = malloc(count * sizeof(u32)), *semi = malloc(count * sizeof(u32));
+	u32 *label = malloc(count * sizeof(u32)), *ancestor = malloc(count * sizeof(u32));
+	u32 *dom = malloc(count * sizeof(u32)), *path = malloc(count * sizeof(u32));
+	for (u32 n = 0; n < g->node_count; n++) {
+		idom[n] = CFG_NONE;
+		if (number[n] != CFG_NONE)
+			vertex[number[n]] = n;
+	}
+	for (u32 i = 0; i < count; i++) {
+		semi[i] = label[i] = i;
+		ancestor[i] = CFG_NONE;
+	}
+	for (u32 i = count; i-- > 1;) {
+		u32 n = vertex[i];
+		for (u32 e = g->in_start[n]; e < g->in_start[n + 1]; e++) {
+			u32 p = number[g->in[e]];
+			if (p == CFG_NONE)
+				continue; // not reached
+			if (ancestor[p] != CFG_NONE)
+				compress(ancestor, label, path, p);
+			if (label[p] < semi[i])
+				semi[i] = label[p];
+		}
+		label[i] = semi[i];
+		ancestor[i] = number[parent[n]];
+	}
+	dom[0] = 0;
+	idom[root] = root;
+	for (u32 i = 1; i < count; i++) {
+		u32 d = number[parent[vertex[i]]];
+		while (d > semi[i])
+			d = dom[d];
+		dom[i] = d;
+		idom[vertex[i]] = vertex[d];
+	}
+	free(number);
+	free(parent);
+	free(vertex);
+	free(semi);
+	free(label);
+	free(ancestor);
+	free(dom);
+	free(path);
+	return count;
+}
+
+// numbers the tree where each node's parent is up[n] (the root's being itself, CFG_NONE for nodes not in it)
+// in preorder, last[n] being the highest number under n, so a is an ancestor of b (or b itself) exactly when
+// first[a] <= first[b] <= last[a]; nodes not in the tree get an empty range
+static void number_tree(u32 node_count, u32 root, const u32 *up, u32 *first, u32 *last) {
+	u32 *edges = malloc(node_count * 2 * sizeof(u32));
+	u32 edge_count = 0;
+	for (u32 n = 0; n < node_count; n++) {
+		first[n] = CFG_NONE;
+		last[n] = 0;
+		if (n != root && up[n] != CFG_NONE) {
+			edges[2 * edge_count] = n;
+			edges[2 * edge_count++ + 1] = up[n];
+		}
+	}
+	u32 *child_start, *child;
+	list_edges(node_count, edges, edge_count, 1, &child_start, &child);
+	free(edges);
+	u32 *stack = malloc(node_count * sizeof(u32));
+	u32 *next = malloc(node_count * sizeof(u32)); // the next of each node's children to visit
+	u32 count = 0, depth = 0;
+	stack[depth++] = root;
+	first[root] = count++;
+	next[root] = child_start[root];
+	while (depth) {
+		u32 n = stack[depth - 1];
+		if (next[n] < child_start[n + 1]) {
+			u32 c = child[next[n]++];
+			first[c] = count++;
+			next[c] = child_start[c];
+			stack[depth++] = c;
+		} else {
+			last[n] = count - 1;
+			depth--;
+		}
+	}
+	free(stack);
+	free(next);
+	free(child_start);
+	free(child);
+}
+
+// the outermost loop found so far around loop, halving the way there as it goes
+static u32 outermost(u32 *up, u32 loop) {
+	while (up[loop] != loop) {
+		up[loop] = up[up[loop]];
+		loop = up[loop];
+	}
+	return loop;
+}
+
+// loops are numbered by header in reverse postorder but filled in innermost first, walking back from each
+// back edge to the header; a block already in a loop stands for the outermost loop found around it, which
+// gets nested in this one and is walked on from its header, so each block and loop is only stepped over once
+void cfg_find_loops(CFG *cfg) {
+	u32 count = cfg->block_count;
+	free(cfg->loops);
+	free(cfg->loop_bodies);
+	for (u32 b = 0; b < count; b++)
+		cfg->blocks[b].loop = CFG_NONE;
+	cfg->loops = malloc((cfg->rpo_count ? cfg->rpo_count : 1) * sizeof(Loop)); // no more than a loop a block
+	cfg->loop_count = 0;
+	for (u32 i = 0; i < cfg->rpo_count; i++) {
+		u32 h = cfg->rpo[i];
+		for (u32 e = 0; e < cfg->blocks[h].pred_count; e++) {
+			if (cfg_dominates(cfg, h, cfg_pred(cfg, h, e))) { // a back edge
+				cfg->loops[cfg->loop_count++] = (Loop){ h, CFG_NONE, 1, 0, 0 };
+				break;
+			}
+		}
+	}
+	u32 *up = malloc((cfg->loop_count ? cfg->loop_count : 1) * sizeof(u32));
+	u32 *work = NULL, depth = 0, work_cap = 0;
+	for (u32 loop = cfg->loop_count; loop-- > 0;) {
+		u32 h = cfg->loops[loop].header;
+		up[loop] = loop;
+		cfg->blocks[h].loop = loop;
+		for (u32 e = 0; e < cfg->blocks[h].pred_count; e++) {
+			u32 p = cfg_pred(cfg, h, e);
+			if (cfg_dominates(cfg, h, p))
+				push_u32(&work, &depth, &work_cap, p);
+		}
+		while (depth) {
+			u32 n = work[--depth];
+			u32 inner = cfg->blocks[n].loop;
+			if (inner == CFG_NONE) {
+				cfg->blocks[n].loop = loop;
+			} else {
+				inner = outermost(up, inner);
+				if (inner == loop)
+					continue;
+				up[inner] = loop;
+				cfg->loops[inner].parent = loop;
+				n = cfg->loops[inner].header;
+			}
+			for (u32 e = 0; e < cfg->blocks[n].pred_count; e++) {
+				u32 q = cfg_pred(cfg, n, e);
+				if (cfg->blocks[q].idom != CFG_NONE)
+					push_u32(&work, &depth, &work_cap, q);
+			}
+		}
+	}
+	free(up);
+	free(work);
+
+	// each loop's own blocks, header first
+	u32 total = 0;
+	for (u32 loop = 0; loop < cfg->loop_count; loop++) {
+		Loop *lp = &cfg->loops[loop];
+		if (lp->parent != CFG_NONE)
+			lp->depth = cfg->loops[lp->parent].depth + 1; // parents come first
+		lp->body_count = 1;
+	}
+	for (u32 b = 0; b < count; b++) {
+		u32 loop = cfg->blocks[b].loop;
+		if (loop != CFG_NONE && cfg->loops[loop].header != b)
+			cfg->loops[loop].body_count++;
+	}
+	for (u32 loop = 0; loop < cfg->loop_count; loop++) {
+		cfg->loops[loop].body_start = total;
+		total += cfg->loops[loop].body_count;
+		cfg->loops[loop].body_count = 1;
+	}
+	cfg->loop_bodies = malloc((total ? total : 1) * sizeof(u32));
+	for (u32 loop = 0; loop < cfg->loop_count; loop++)
+		cfg->loop_bodies[cfg->loops[loop].body_start] = cfg->loops[loop].header;
+	for (u32 b = 0; b < count; b++) {
+		u32 loop = cfg->blocks[b].loop;
+		if (loop != CFG_NONE && cfg->loops[loop].header != b)
+			cfg->loop_bodies[cfg->loops[loop].body_start + cfg->loops[loop].body_count++] = b;
+	}
+}
+
+static u32 jump_target(const u32 *label_block, u32 low, u32 high, const Line *jump) {
+	if (!label_block || jump->left.adr < low || jump->left.adr > high)
+		abort(); // a jump out of its function
+	return label_block[jump->left.adr - low];
+}
+
+static void add_succ(Block *block, u32 succ) {
+	if (block->succ_count && block->succ[0] == succ)
+		return; // a branch to where it would fall through anyway
+	block->succ[block->succ_count++] = succ;
+}
+
+CFG *cfg_build(const TAC *tac, u32 func) {
+	u32 end = cfg_next_func(tac, func);
+	CFG *cfg = malloc(sizeof(CFG));
+	cfg->tac = tac;
+	cfg->func = func;
+
+	// blocks start at the function, at each label and after each jump or return
+	u32 count = 0, low = UINT32_MAX, high = 0;
+	for (u32 i = func; i < end; i++) {
+		Line *l = line_at(tac, i);
+		if (i == func || l->op == O_LABEL || ends_block(line_at(tac, i - 1)->op))
+			count++;
+		if (l->op == O_LABEL) {
+			low = l->left.adr < low ? l->left.adr : low;
+			high = l->left.adr > high ? l->left.adr : high;
+		}
+	}
+	cfg->block_count = count;
+	cfg->exit = count;
+	cfg->blocks = malloc(count * sizeof(Block));
+	u32 *label_block = low <= high ? malloc((high - low + 1) * sizeof(u32)) : NULL;
+	u32 b = 0;
+	for (u32 i = func; i < end; i++) {
+		Line *l = line_at(tac, i);
+		if (i == func || l->op == O_LABEL || ends_block(line_at(tac, i - 1)->op)) {
+			if (i != func)
+				cfg->blocks[b++].end = i;
+			cfg->blocks[b] = (Block){ i, end, { 0, 0 }, 0, 0, 0, 0, CFG_NONE, CFG_NONE, CFG_NONE, 0, 0, 0, 0 };
+		}
+		if (l->op == O_LABEL)
+			label_block[l->left.adr - low] = b;
+	}
+
+	// edges, with those leaving the function going to the exit
+	u32 *edges = malloc(count * 4 * sizeof(u32)); // no block has more than two
+	u32 edge_count = 0;
+	for (b = 0; b < count; b++) {
+		Block *block = &cfg->blocks[b];
+		Line *last = line_at(tac, block->end - 1);
+		switch (last->op) {
+			case O_RETN: case O_RVAL:
+				block->exits = 1;
+				break;
+			case O_GOTO:
+				add_succ(block, jump_target(label_block, low, high, last));
+				break;
+			case O_GOTOT: case O_GOTOF:
+				if (b + 1 < count)
+					add_succ(block, b + 1);
+				else
+					block->exits = 1;
+				add_succ(block, jump_target(label_block, low, high, last));
+				break;
+			default:
+				if (b + 1 < count)
+					add_succ(block, b + 1);
+				else
+					block->exits = 1;
+		}
+		for (u32 s = 0; s < block->succ_count; s++) {
+			edges[2 * edge_count] = b;
+			edges[2 * edge_count++ + 1] = block->succ[s];
+		}
+		if (block->exits) {
+			edges[2 * edge_count] = b;
+			edges[2 * edge_count++ + 1] = cfg->exit;
+		}
+	}
+	free(label_block);
+
+	struct graph g = { count + 1, NULL, NULL, NULL, NULL };
+	list_edges(g.node_count, edges, edge_count, 0, &g.out_start, &g.out);
+	list_edges(g.node_count, edges, edge_count, 1, &g.in_start, &g.in);
+	free(edges);
+	for (b = 0; b < count; b++) {
+		cfg->blocks[b].pred_start = g.in_start[b];
+		cfg->blocks[b].pred_count = g.in_start[b + 1] - g.in_start[b];
+	}
+	cfg->preds = g.in;
+
+	u32 *idom = malloc(g.node_count * sizeof(u32));
+	u32 *order = malloc(g.node_count * sizeof(u32));
+	u32 *first = malloc(g.node_count * sizeof(u32)), *last = malloc(g.node_count * sizeof(u32));
+	u32 reached = dominators(&g, 0, idom, order);
+	number_tree(g.node_count, 0, idom, first, last);
+	cfg->rpo = malloc(count * sizeof(u32));
+	cfg->rpo_count = 0;
+	for (u32 i = reached; i-- > 0;) {
+		if (order[i] != cfg->exit)
+			cfg->rpo[cfg->rpo_count++] = order[i];
+	}
+	for (b = 0; b < count; b++) {
+		cfg->blocks[b].idom = idom[b];
+		cfg->blocks[b].dom_first = first[b];
+		cfg->blocks[b].dom_last = last[b];
+	}
+
+	// post-dominators are the dominators of the reversed graph, from the exit
+	struct graph reversed = { g.node_count, g.in_start, g.in, g.out_start, g.out };
+	dominators(&reversed, cfg->exit, idom, order);
+	number_tree(g.node_count, cfg->exit, idom, first, last);
+	for (b = 0; b < count; b++) {
+		cfg->blocks[b].ipdom = idom[b];
+		cfg->blocks[b].pdom_first = first[b];
+		cfg->blocks[b].pdom_last = last[b];
+	}
+	free(idom);
+	free(order);
+	free(first);
+	free(last);
+	free(g.out_start);
+	free(g.out);
+	free(g.in_start);
+	cfg->loops = NULL;
+	cfg->loop_count = 0;
+	cfg->loop_bodies = NULL;
+	return cfg;
+}
+
+void cfg_free(CFG *cfg) {
+	if (!cfg) return;
+	free(cfg->blocks);
+	free(cfg->preds);
+	free(cfg->rpo);
+	free(cfg->loops);
+	free(cfg->loop_bodies);
+	free(cfg);
+}
+
+int cfg_dominates(const CFG *cfg, u32 a, u32 b) {
+	const Block *x = &cfg->blocks[a], *y = &cfg->blocks[b];
+	return x->dom_first <= y->dom_first && y->dom_first <= x->dom_last;
+}
+
+int cfg_post_dominates(const CFG *cfg, u32 a, u32 b) {
+	if (a == b)
+		return 1;
+	if (b == cfg->exit)
+		return 0;
+	const Block *y = &cfg->blocks[b];
+	if (a == cfg->exit)
+		return y->ipdom != CFG_NONE; // the root of the post-dominator tree
+	const Block *x = &cfg->blocks[a];
+	return x->pdom_first <= y->pdom_first && y->pdom_first <= x->pdom_last;
+}
+
+static void print_block_ref(const CFG *cfg, u32 b) {
+	if (b == CFG_NONE)
+		printf("-");
+	else if (b == cfg->exit)
+		printf("exit");
+	else
+		printf("B%u", b);
+}
+
+static void print_cfg(const CFG *cfg) {
+	printf("function: %u blocks, %u loops\n", cfg->block_count, cfg->loop_count);
+	for (u32 b = 0; b < cfg->block_count; b++) {
+		Block *block = &cfg->blocks[b];
+		printf("B%u: lines %u-%u, pred", b, block->first, block->end - 1);
+		if (!block->pred_count)
+			printf(" -");
+		for (u32 i = 0; i < block->pred_count; i++) {
+			printf(" ");
+			print_block_ref(cfg, cfg_pred(cfg, b, i));
+		}
+		printf(", succ");
+		for (u32 i = 0; i < block->succ_count; i++) {
+			printf(" ");
+			print_block_ref(cfg, block->succ[i]);
+		}
+		if (block->exits)
+			printf(" exit");
+		printf(", idom ");
+		print_block_ref(cfg, block->idom);
+		printf(", ipdom ");
+		print_block_ref(cfg, block->ipdom);
+		printf(", loop ");
+		if (block->loop == CFG_NONE)
+			printf("-\n");
+		else
+			printf("%u\n", block->loop);
+		for (u32 i = block->first; i < block->end; i++) {
+			Line *l = line_at(cfg->tac, i);
+			printf("\t");
+			if (l->linenum != 0)
+				printf("%u: ", l->linenum);
+			print_tac_line(l);
+		}
+	}
+	for (u32 loop = 0; loop < cfg->loop_count; loop++) {
+		Loop *lp = &cfg->loops[loop];
+		printf("loop %u: header B%u, depth %u, parent ", loop, lp->header, lp->depth);
+		if (lp->parent == CFG_NONE)
+			printf("-");
+		else
+			printf("%u", lp->parent);
+		printf(", blocks");
+		for (u32 i = 0; i < lp->body_count; i++)
+			printf(" B%u", cfg_loop_block(cfg, loop, i));
+		printf("\n");
+	}
+}
+
+void cfg_printf(const TAC *tac) {
+	u32 func = 0;
+	while (func < vector_len(tac->lines) && line_at(tac, func)->op != O_FUNC)
+		func++;
+	for (; func < vector_len(tac->lines); func = cfg_next_func(tac, func)) {
+		CFG *cfg = cfg_build(tac, func);
+		cfg_find_loops(cfg);
+		print_cfg(cfg);
+		cfg_free(cfg);
+	}
+}
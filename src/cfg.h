@@ -0,0 +1,77 @@
+// control-flow graphs over a function's TAC: its basic blocks, their dominators and post-dominators,
+// and the natural loops they make
+
+#ifndef CFG_H
+#define CFG_H
+
+#include <stdint.h>
+#include "threeaddresscode.h"
+#include "lib/defs.h"
+
+#define CFG_NONE UINT32_MAX // no block
+
+// lines [first, end) of the TAC, only ever entered at first and left after end - 1
+typedef struct basic_block {
+	u32 first, end;
+	u32 succ[2]; // falling through first, then a jump's target
+	u32 succ_count;
+	u32 pred_start, pred_count; // into the CFG's preds
+	int exits; // left by returning (or running off the end of the function)
+	u32 idom; // immediate dominator (the entry's is itself), CFG_NONE if unreachable
+	u32 ipdom; // immediate post-dominator (the CFG's exit if nothing else), CFG_NONE if it can't return
+	u32 loop; // innermost loop it's in, CFG_NONE for none (or before cfg_find_loops)
+	u32 dom_first, dom_last; // its number in a preorder walk of the dominator tree, and the last one under it
+	u32 pdom_first, pdom_last; // the same for the post-dominator tree
+} Block;
+
+// a natural loop: its header, and every block reaching a back edge to it without passing through it
+// only the blocks it's the innermost loop of are listed for it, the rest of its body being those of the loops
+// nested in it, so the lists take a block each however deep the nesting
+typedef struct loop {
+	u32 header;
+	u32 parent; // the loop it's nested in, CFG_NONE for none
+	u32 depth; // 1 for an outermost loop
+	u32 body_start, body_count; // into the CFG's loop_bodies, the header first
+} Loop;
+
+typedef struct cfg {
+	const TAC *tac;
+	u32 func; // the function's O_FUNC line
+	Block *blocks; // the entry (starting with the O_FUNC line) first
+	u32 block_count;
+	u32 exit; // a node after the blocks that every return goes to (block_count), for post-dominators
+	u32 *preds;
+	u32 *rpo; // the reachable blocks in reverse postorder (so before their successors, bar back edges)
+	u32 rpo_count;
+	Loop *loops; // by header in reverse postorder, so each after the loops around it
+	u32 loop_count;
+	u32 *loop_bodies;
+} CFG;
+
+// the O_FUNC line after func, or the line count if func is the last (main)
+u32 cfg_next_func(const TAC *tac, u32 func);
+
+// func is an O_FUNC line, and the function runs up to the next one
+// loops are left for cfg_find_loops, so passes that don't need them don't pay for them
+CFG *cfg_build(const TAC *tac, u32 func);
+void cfg_free(CFG *cfg);
+
+// fills in loops, loop_bodies and each block's loop
+void cfg_find_loops(CFG *cfg);
+
+// each block dominates (and post-dominates) itself, and the exit post-dominates every block that returns
+// both take constant time
+int cfg_dominates(const CFG *cfg, u32 a, u32 b);
+int cfg_post_dominates(const CFG *cfg, u32 a, u32 b);
+
+static inline u32 cfg_pred(const CFG *cfg, u32 block, u32 i) {
+	return cfg->preds[cfg->blocks[block].pred_start + i];
+}
+static inline u32 cfg_loop_block(const CFG *cfg, u32 loop, u32 i) {
+	return cfg->loop_bodies[cfg->loops[loop].body_start + i];
+}
+
+// every function's blocks with their edges, (post) dominators and loops
+void cfg_printf(const TAC *tac);
+
+#endif
@@ -0,0 +1,455 @@
+#include "dataflow.h"
+#include <stdlib.h>
+#include <string.h>
+
+// a copy, as the line helpers hand out pointers into what they're given
+static inline Line line_at(const CFG *cfg, u32 i) {
+	return *(Line *)vector_at(cfg->tac->lines, i);
+}
+
+static inline u32 func_end(const CFG *cfg) {
+	return cfg->blocks[cfg->block_count - 1].end;
+}
+
+// (key, value) pairs listed by key, keeping their order: key k's values are list[start[k]] up to list[start[k + 1]]
+static void group(u32 key_count, const u32 *pairs, u32 pair_count, u32 **start, u32 **list) {
+	*start = calloc(key_count + 1, sizeof(u32));
+	*list = malloc((pair_count ? pair_count : 1) * sizeof(u32));
+	for (u32 p = 0; p < pair_count; p++)
+		(*start)[pairs[2 * p] + 1]++;
+	for (u32 k = 0; k < key_count; k++)
+		(*start)[k + 1] += (*start)[k];
+	u32 *fill = malloc((key_count ? key_count : 1) * sizeof(u32));
+	memcpy(fill, *start, key_count * sizeof(u32));
+	for (u32 p = 0; p < pair_count; p++)
+		(*list)[fill[pairs[2 * p]]++] = pairs[2 * p + 1];
+	free(fill);
+}
+
+static void push_u32(u32 **items, u32 *count, u32 *cap, u32 item) {
+	if (*count == *cap) {
+		*cap = *cap ? *cap * 2 : 16;
+		*items = realloc(*items, *cap * sizeof(u32));
+		if (!*items) abort();
+	}
+	(*items)[(*count)++] = item;
+}
+
+static void count_adr(VarNumbering *vars, Adr adr) {
+	if (!adr_is_var(adr))
+		return;
+	u32 *count = adr.type == A_PARAM ? &vars->param_count : adr.type == A_VAR ? &vars->var_count : &vars->tmp_count;
+	if (adr.adr >= *count)
+		*count = adr.adr + 1;
+}
+
+VarNumbering var_numbering(const Line *lines, u32 line_count) {
+	VarNumbering vars = { 0, 0, 0 };
+	for (u32 i = 0; i < line_count; i++) {
+		count_adr(&vars, lines[i].left);
+		count_adr(&vars, lines[i].middle);
+		count_adr(&vars, lines[i].right);
+	}
+	return vars;
+}
+
+Dataflow *dataflow_create(const CFG *cfg, u32 bits) {
+	Dataflow *df = malloc(sizeof(Dataflow));
+	df->cfg = cfg;
+	df->bits = bits;
+	df->words = bitset_words(bits);
+	size_t size = (size_t)cfg->block_count * df->words + 1;
+	df->in = calloc(size, sizeof(u64));
+	df->out = calloc(size, sizeof(u64));
+	df->gen = calloc(size, sizeof(u64));
+	df->kill = calloc(size, sizeof(u64));
+	if (!df->in || !df->out || !df->gen || !df->kill) abort();
+	df->fact_lines = NULL;
+	df->fact_vars = NULL;
+	df->var_facts = NULL;
+	return df;
+}
+
+void dataflow_free(Dataflow *df) {
+	if (!df) return;
+	free(df->in);
+	free(df->out);
+	free(df->gen);
+	free(df->kill);
+	free(df->fact_lines);
+	free(df->fact_vars);
+	free(df->var_facts);
+	free(df);
+}
+
+static void gen_kill(const Dataflow *df, u32 block, const u64 *from, u64 *to) {
+	const u64 *gen = dataflow_gen(df, block), *kill = dataflow_kill(df, block);
+	for (u32 w = 0; w < df->words; w++)
+		to[w] = gen[w] | (from[w] & ~kill[w]);
+}
+
+// what a set is before anything meets in it: every fact for an intersection, none for a union
+static void fill_top(const Dataflow *df, const DataflowProblem *p, u64 *set) {
+	if (p->meet == DF_UNION) {
+		memset(set, 0, df->words * sizeof(u64));
+		return;
+	}
+	memset(set, 0xff, df->words * sizeof(u64));
+	if (df->bits % 64)
+		set[df->words - 1] = (1ull << (df->bits % 64)) - 1;
+}
+
+static void meet_into(const Dataflow *df, const DataflowProblem *p, u64 *to, const u64 *from) {
+	if (p->meet == DF_UNION) {
+		for (u32 w = 0; w < df->words; w++)
+			to[w] |= from[w];
+	} else {
+		for (u32 w = 0; w < df->words; w++)
+			to[w] &= from[w];
+	}
+}
+
+void dataflow_solve(Dataflow *df, const DataflowProblem *p) {
+	const CFG *cfg = df->cfg;
+	u32 n = cfg->rpo_count;
+	if (!n) return;
+	int forward = p->direction == DF_FORWARD;
+	size_t bytes = df->words * sizeof(u64);
+	u64 *met = malloc(bytes + sizeof(u64));
+	u64 *result = malloc(bytes + sizeof(u64));
+	u64 *none = calloc(df->words + 1, sizeof(u64));
+	const u64 *boundary = p->boundary ? p->boundary : none;
+
+	// blocks waiting to be (re)done, by their place in the order facts flow (reverse postorder going forward,
+	// postorder going backward), always taking the earliest so that a loop settles before what follows it
+	u32 *order = malloc(n * sizeof(u32));
+	u32 *place = malloc(cfg->block_count * sizeof(u32)); // CFG_NONE for unreachable
+	u64 *pending = calloc(bitset_words(n), sizeof(u64));
+	for (u32 b = 0; b < cfg->block_count; b++)
+		place[b] = CFG_NONE;
+	for (u32 i = 0; i < n; i++) {
+		u32 b = order[i] = cfg->rpo[forward ? i : n - 1 - i];
+		place[b] = i;
+		fill_top(df, p, forward ? dataflow_out(df, b) : dataflow_in(df, b));
+		bitset_set(pending, i);
+	}
+	u32 cursor = 0; // no place before it is pending
+	for (;;) {
+		u32 w = cursor / 64;
+		u64 bits = w < bitset_words(n) ? pending[w] & ~0ull << cursor % 64 : 0;
+		while (!bits && ++w < bitset_words(n))
+			bits = pending[w];
+		if (!bits)
+			break;
+		u32 i = w * 64 + __builtin_ctzll(bits);
+		bitset_clear(pending, i);
+		cursor = i + 1;
+		u32 b = order[i];
+		const Block *block = &cfg->blocks[b];
+		u64 *enter = forward ? dataflow_in(df, b) : dataflow_out(df, b);
+		u64 *leave = forward ? dataflow_out(df, b) : dataflow_in(df, b);
+		if (forward && b == 0) {
+			memcpy(met, boundary, bytes);
+		} else if (forward) {
+			fill_top(df, p, met);
+			for (u32 k = 0; k < block->pred_count; k++) {
+				u32 pred = cfg_pred(cfg, b, k);
+				if (cfg->blocks[pred].idom != CFG_NONE)
+					meet_into(df, p, met, dataflow_out(df, pred));
+			}
+		} else {
+			fill_top(df, p, met);
+			for (u32 k = 0; k < block->succ_count; k++)
+				meet_into(df, p, met, dataflow_in(df, block->succ[k]));
+			if (block->exits)
+				meet_into(df, p, met, boundary);
+		}
+		memcpy(enter, met, bytes);
+		if (p->transfer)
+			p->transfer(df, b, met, result, p->ctx);
+		else
+			gen_kill(df, b, met, result);
+		if (!memcmp(result, leave, bytes))
+			continue;
+		memcpy(leave, result, bytes);
+		u32 next_count = forward ? block->succ_count : block->pred_count;
+		for (u32 k = 0; k < next_count; k++) {
+			u32 j = place[forward ? block->succ[k] : cfg_pred(cfg, b, k)];
+			if (j == CFG_NONE)
+				continue;
+			bitset_set(pending, j);
+			if (j < cursor)
+				cursor = j;
+		}
+	}
+	free(met);
+	free(result);
+	free(none);
+	free(order);
+	free(place);
+	free(pending);
+}
+
+// the variables some reachable block reads before writing, in order, returning how many; var_facts gets each
+// one's place among them, CFG_NONE for the rest
+static u32 crossing_vars(const CFG *cfg, const VarNumbering *vars, u32 **var_facts) {
+	u32 var_count = var_total(vars), count = 0;
+	*var_facts = malloc((var_count ? var_count : 1) * sizeof(u32));
+	u32 *written_in = calloc(var_count + 1, sizeof(u32)); // the block (+ 1) each was last written in
+	for (u32 v = 0; v < var_count; v++)
+		(*var_facts)[v] = CFG_NONE;
+	for (u32 b = 0; b < cfg->block_count; b++) {
+		if (cfg->blocks[b].idom == CFG_NONE)
+			continue;
+		for (u32 i = cfg->blocks[b].first; i < cfg->blocks[b].end; i++) {
+			Line l = line_at(cfg, i);
+			Adr *uses[3];
+			u32 n = tac_line_uses(&l, uses);
+			for (u32 k = 0; k < n; k++) {
+				u32 v = var_number(vars, *uses[k]);
+				if (written_in[v] != b + 1)
+					(*var_facts)[v] = 0;
+			}
+			Adr *dest = tac_line_def(&l);
+			if (dest)
+				written_in[var_number(vars, *dest)] = b + 1;
+		}
+	}
+	for (u32 v = 0; v < var_count; v++) {
+		if ((*var_facts)[v] != CFG_NONE)
+			(*var_facts)[v] = count++;
+	}
+	free(written_in);
+	return count;
+}
+
+static inline u32 var_fact(const u32 *var_facts, const VarNumbering *vars, Adr adr) {
+	return adr_is_var(adr) ? var_facts[var_number(vars, adr)] : CFG_NONE;
+}
+
+Dataflow *dataflow_liveness(const CFG *cfg, const VarNumbering *vars) {
+	u32 *var_facts;
+	u32 count = crossing_vars(cfg, vars, &var_facts);
+	Dataflow *df = dataflow_create(cfg, count);
+	df->var_facts = var_facts;
+	df->fact_vars = malloc((count ? count : 1) * sizeof(u32));
+	for (u32 v = 0; v < var_total(vars); v++) {
+		if (var_facts[v] != CFG_NONE)
+			df->fact_vars[var_facts[v]] = v;
+	}
+	for (u32 b = 0; b < cfg->block_count; b++) {
+		u64 *use = dataflow_gen(df, b), *def = dataflow_kill(df, b);
+		for (u32 i = cfg->blocks[b].first; i < cfg->blocks[b].end; i++) {
+			Line l = line_at(cfg, i);
+			Adr *uses[3];
+			u32 n = tac_line_uses(&l, uses);
+			for (u32 k = 0; k < n; k++) {
+				u32 f = var_fact(var_facts, vars, *uses[k]);
+				if (f != CFG_NONE && !bitset_test(def, f))
+					bitset_set(use, f);
+			}
+			Adr *dest = tac_line_def(&l);
+			u32 f = dest ? var_fact(var_facts, vars, *dest) : CFG_NONE;
+			if (f != CFG_NONE)
+				bitset_set(def, f);
+		}
+	}
+	DataflowProblem p = { DF_BACKWARD, DF_UNION, NULL, NULL, NULL };
+	dataflow_solve(df, &p);
+	return df;
+}
+
+Dataflow *dataflow_reaching_defs(const CFG *cfg, const VarNumbering *vars) {
+	u32 end = func_end(cfg), *var_facts;
+	u32 var_count = crossing_vars(cfg, vars, &var_facts);
+	// the definitions, and which are each variable's
+	u32 *lines = NULL, *pairs = NULL, def_count = 0, lines_cap = 0, pair_count = 0, pairs_cap = 0;
+	for (u32 i = cfg->func; i < end; i++) {
+		Line l = line_at(cfg, i);
+		Adr *dest = tac_line_def(&l);
+		u32 v = dest ? var_fact(var_facts, vars, *dest) : CFG_NONE;
+		if (v == CFG_NONE)
+			continue;
+		push_u32(&pairs, &pair_count, &pairs_cap, v);
+		push_u32(&pairs, &pair_count, &pairs_cap, def_count);
+		push_u32(&lines, &def_count, &lines_cap, i);
+	}
+	u32 *def_start, *defs;
+	group(var_count, pairs, pair_count / 2, &def_start, &defs);
+	free(pairs);
+
+	Dataflow *df = dataflow_create(cfg, def_count);
+	df->fact_lines = lines;
+	// each variable's last definition so far, and the block (+ 1) that was in
+	u32 *last = malloc((var_count ? var_count : 1) * sizeof(u32));
+	u32 *last_block = calloc(var_count + 1, sizeof(u32));
+	u32 d = 0;
+	for (u32 b = 0; b < cfg->block_count; b++) {
+		u64 *gen = dataflow_gen(df, b), *kill = dataflow_kill(df, b);
+		for (; d < def_count && lines[d] < cfg->blocks[b].end; d++) {
+			Line l = line_at(cfg, lines[d]);
+			u32 v = var_fact(var_facts, vars, *tac_line_def(&l));
+			if (last_block[v] == b + 1) {
+				bitset_clear(gen, last[v]);
+			} else {
+				last_block[v] = b + 1;
+				for (u32 k = def_start[v]; k < def_start[v + 1]; k++)
+					bitset_set(kill, defs[k]);
+			}
+			bitset_set(gen, d);
+			last[v] = d;
+		}
+	}
+	free(var_facts);
+	free(last);
+	free(last_block);
+	free(def_start);
+	free(defs);
+	DataflowProblem p = { DF_FORWARD, DF_UNION, NULL, NULL, NULL };
+	dataflow_solve(df, &p);
+	return df;
+}
+
+static int is_expr(enum operation op) {
+	switch (op) {
+		case O_ADDF: case O_ADDI: case O_SUBF: case O_SUBI: case O_MULF: case O_MULI: case O_DIVF: case O_DIVI: case O_POWIF: case O_POWII: case O_MOD:
+		case O_EQI: case O_NEQI: case O_LTI: case O_LTEI: case O_GTI: case O_GTEI:
+		case O_EQF: case O_NEQF: case O_LTF: case O_LTEF: case O_GTF: case O_GTEF:
+		case O_OR: case O_AND: case O_XOR:
+		case O_ITOF: case O_NOT:
+			return 1;
+		default:
+			return 0;
+	}
+}
+
+struct expr {
+	enum operation op;
+	Adr middle, right;
+	u32 line;
+};
+
+static int adr_compare(Adr a, Adr b) {
+	if (a.type != b.type)
+		return a.type < b.type ? -1 : 1;
+	return a.adr < b.adr ? -1 : a.adr > b.adr;
+}
+
+// by what's computed, then where
+static int expr_compare(const void *x, const void *y) {
+	const struct expr *a = x, *b = y;
+	int c;
+	if (a->op != b->op)
+		return a->op < b->op ? -1 : 1;
+	if ((c = adr_compare(a->middle, b->middle)) || (c = adr_compare(a->right, b->right)))
+		return c;
+	return a->line < b->line ? -1 : a->line > b->line;
+}
+
+// an expression line whose variable operands all cross blocks, with middle empty for the one-operand ops
+static int crossing_expr(const u32 *var_facts, const VarNumbering *vars, Line *l) {
+	if (!is_expr(l->op))
+		return 0;
+	if (l->op == O_ITOF || l->op == O_NOT)
+		l->middle = (Adr){ A_EMPTY, 0 };
+	return (!adr_is_var(l->middle) || var_fact(var_facts, vars, l->middle) != CFG_NONE)
+		&& (!adr_is_var(l->right) || var_fact(var_facts, vars, l->right) != CFG_NONE);
+}
+
+Dataflow *dataflow_available_exprs(const CFG *cfg, const VarNumbering *vars) {
+	u32 end = func_end(cfg), *var_facts;
+	u32 var_count = crossing_vars(cfg, vars, &var_facts);
+	struct expr *exprs = malloc((end - cfg->func) * sizeof(struct expr));
+	u32 count = 0;
+	for (u32 i = cfg->func; i < end; i++) {
+		Line l = line_at(cfg, i);
+		if (crossing_expr(var_facts, vars, &l))
+			exprs[count++] = (struct expr){ l.op, l.middle, l.right, i };
+	}
+	qsort(exprs, count, sizeof(struct expr), expr_compare);
+
+	// a fact for each different expression, and the lines computing it and variables it reads
+	u32 *line_expr = malloc((end - cfg->func) * sizeof(u32));
+	u32 *lines = NULL, *pairs = NULL, fact_count = 0, lines_cap = 0, pair_count = 0, pairs_cap = 0;
+	for (u32 e = 0; e < count; e++) {
+		const struct expr *x = &exprs[e];
+		if (!e || x->op != x[-1].op || !adr_equals(x->middle, x[-1].middle) || !adr_equals(x->right, x[-1].right)) {
+			if (adr_is_var(x->middle)) {
+				push_u32(&pairs, &pair_count, &pairs_cap, var_fact(var_facts, vars, x->middle));
+				push_u32(&pairs, &pair_count, &pairs_cap, fact_count);
+			}
+			if (adr_is_var(x->right) && !adr_equals(x->right, x->middle)) {
+				push_u32(&pairs, &pair_count, &pairs_cap, var_fact(var_facts, vars, x->right));
+				push_u32(&pairs, &pair_count, &pairs_cap, fact_count);
+			}
+			push_u32(&lines, &fact_count, &lines_cap, x->line);
+		}
+		line_expr[x->line - cfg->func] = fact_count - 1;
+	}
+	free(exprs);
+	u32 *reader_start, *readers;
+	group(var_count, pairs, pair_count / 2, &reader_start, &readers);
+	free(pairs);
+
+	Dataflow *df = dataflow_create(cfg, fact_count);
+	df->fact_lines = lines;
+	// per variable, the block (+ 1) its readers were last killed in, and the expressions the block has made
+	// available since last writing it (chained through made_next, from made[v] if made_in[v] is the block + 1),
+	// so a write only goes over what it has to
+	u32 *killed_in = calloc(var_count + 1, sizeof(u32));
+	u32 *made_in = calloc(var_count + 1, sizeof(u32));
+	u32 *made = malloc((var_count ? var_count : 1) * sizeof(u32));
+	u32 *made_expr = malloc(2 * (end - cfg->func) * sizeof(u32));
+	u32 *made_next = malloc(2 * (end - cfg->func) * sizeof(u32));
+	for (u32 b = 0; b < cfg->block_count; b++) {
+		u64 *gen = dataflow_gen(df, b), *kill = dataflow_kill(df, b);
+		u32 made_count = 0;
+		for (u32 i = cfg->blocks[b].first; i < cfg->blocks[b].end; i++) {
+			Line l = line_at(cfg, i);
+			if (crossing_expr(var_facts, vars, &l)) {
+				u32 e = line_expr[i - cfg->func];
+				bitset_set(gen, e);
+				Adr operands[2] = { l.middle, l.right };
+				for (u32 k = 0; k < 2; k++) {
+					if (!adr_is_var(operands[k]) || (k && adr_equals(operands[0], operands[1])))
+						continue;
+					u32 v = var_fact(var_facts, vars, operands[k]);
+					if (made_in[v] != b + 1) {
+						made_in[v] = b + 1;
+						made[v] = CFG_NONE;
+					}
+					made_expr[made_count] = e;
+					made_next[made_count] = made[v];
+					made[v] = made_count++;
+				}
+			}
+			// the write comes after the operands are read, so can undo what the line itself made available
+			Adr *dest = tac_line_def(&l);
+			u32 v = dest ? var_fact(var_facts, vars, *dest) : CFG_NONE;
+			if (v == CFG_NONE)
+				continue;
+			if (made_in[v] == b + 1) {
+				for (u32 k = made[v]; k != CFG_NONE; k = made_next[k])
+					bitset_clear(gen, made_expr[k]);
+				made[v] = CFG_NONE;
+			}
+			if (killed_in[v] != b + 1) {
+				killed_in[v] = b + 1;
+				for (u32 k = reader_start[v]; k < reader_start[v + 1]; k++)
+					bitset_set(kill, readers[k]);
+			}
+		}
+	}
+	free(var_facts);
+	free(killed_in);
+	free(made_in);
+	free(made);
+	free(made_expr);
+	free(made_next);
+	free(line_expr);
+	free(reader_start);
+	free(readers);
+	DataflowProblem p = { DF_FORWARD, DF_INTERSECTION, NULL, NULL, NULL };
+	dataflow_solve(df, &p);
+	return df;
+}
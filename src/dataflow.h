@@ -0,0 +1,117 @@
+// bit-vector dataflow over a function's basic blocks: a set of facts at the start (in) and end (out) of each,
+// solved with a worklist for any direction, meet and transfer, with liveness, reaching definitions and
+// available expressions built on it
+
+#ifndef DATAFLOW_H
+#define DATAFLOW_H
+
+#include "cfg.h"
+#include "threeaddresscode.h"
+#include "lib/defs.h"
+
+// the temporaries, variables and parameters of a function, numbered together: parameters, then variables,
+// then temporaries, each up to the highest of its kind in the function
+typedef struct var_numbering {
+	u32 param_count, var_count, tmp_count;
+} VarNumbering;
+
+VarNumbering var_numbering(const Line *lines, u32 line_count);
+
+static inline u32 var_total(const VarNumbering *vars) {
+	return vars->param_count + vars->var_count + vars->tmp_count;
+}
+// adr has to be a variable (adr_is_var) under the counts
+static inline u32 var_number(const VarNumbering *vars, Adr adr) {
+	switch (adr.type) {
+		case A_PARAM:
+			return adr.adr;
+		case A_VAR:
+			return vars->param_count + adr.adr;
+		default:
+			return vars->param_count + vars->var_count + adr.adr;
+	}
+}
+static inline Adr var_adr(const VarNumbering *vars, u32 var) {
+	if (var < vars->param_count)
+		return (Adr){ A_PARAM, var };
+	var -= vars->param_count;
+	if (var < vars->var_count)
+		return (Adr){ A_VAR, var };
+	return (Adr){ A_TMP, var - vars->var_count };
+}
+
+// sets of facts, a bit each, in 64-bit words
+static inline u32 bitset_words(u32 bits) {
+	return (bits + 63) / 64;
+}
+static inline int bitset_test(const u64 *set, u32 i) {
+	return set[i / 64] >> (i % 64) & 1;
+}
+static inline void bitset_set(u64 *set, u32 i) {
+	set[i / 64] |= 1ull << (i % 64);
+}
+static inline void bitset_clear(u64 *set, u32 i) {
+	set[i / 64] &= ~(1ull << (i % 64));
+}
+
+typedef struct dataflow {
+	const CFG *cfg;
+	u32 bits, words; // facts, and words a set
+	u64 *in, *out; // block b's sets are at words * b, unreachable blocks' left empty
+	u64 *gen, *kill; // the same, for gen/kill transfers
+	u32 *fact_lines; // the TAC line each fact stands for, where a client has one (NULL otherwise)
+	// where facts are variables, the one each stands for, and each variable's fact (CFG_NONE for none)
+	u32 *fact_vars, *var_facts;
+} Dataflow;
+
+static inline u64 *dataflow_in(const Dataflow *df, u32 block) {
+	return df->in + (size_t)block * df->words;
+}
+static inline u64 *dataflow_out(const Dataflow *df, u32 block) {
+	return df->out + (size_t)block * df->words;
+}
+static inline u64 *dataflow_gen(const Dataflow *df, u32 block) {
+	return df->gen + (size_t)block * df->words;
+}
+static inline u64 *dataflow_kill(const Dataflow *df, u32 block) {
+	return df->kill + (size_t)block * df->words;
+}
+
+enum dataflow_direction { DF_FORWARD, DF_BACKWARD };
+enum dataflow_meet { DF_UNION, DF_INTERSECTION }; // facts on some path (may), or on every path (must)
+
+typedef struct dataflow_problem {
+	enum dataflow_direction direction;
+	enum dataflow_meet meet;
+	// a block's set on leaving it (out going forward, in going backward) from its set on entering, NULL for
+	// to = gen | (from & ~kill)
+	void (*transfer)(const Dataflow *df, u32 block, const u64 *from, u64 *to, void *ctx);
+	void *ctx;
+	const u64 *boundary; // what enters at the function's start going forward, or its returns going backward, NULL for nothing
+} DataflowProblem;
+
+// with every set empty, for a client to fill in gen and kill
+Dataflow *dataflow_create(const CFG *cfg, u32 bits);
+void dataflow_free(Dataflow *df);
+
+// in and out for every reachable block, to the fixed point
+void dataflow_solve(Dataflow *df, const DataflowProblem *p);
+
+// the clients only have facts for variables some block reads before writing, and expressions over them:
+// nothing else is live across blocks or reaches a read in another, so variables only read after being written
+// in the same block, as nearly every temporary is, stay out of the sets
+
+// variables (their facts in var_facts) that may be read before being written after a block's start (in) and
+// end (out)
+// gen is what a block reads before writing, and kill what it writes
+Dataflow *dataflow_liveness(const CFG *cfg, const VarNumbering *vars);
+
+// lines writing a variable that may reach a block's start and end with no other write to it in between,
+// a fact each, in line order, so the sets grow with blocks times writes where a variable is written all over
+Dataflow *dataflow_reaching_defs(const CFG *cfg, const VarNumbering *vars);
+
+// expressions (an operation on two operands, or one for itof and not) computed on every path to a block's
+// start and end with no write to an operand since, a fact each for every different one, with its first line
+Dataflow *dataflow_available_exprs(const CFG *cfg, const VarNumbering *vars);
+
+#endif
@@ -1,17 +1,11 @@
 /*
   Takes a CD25 file and provides a token iterator
+  the source is mapped (or read) into memory once, and tokens are spans of that buffer
 */
+#define _POSIX_C_SOURCE 200809L // mmap, fstat, strdup, sched_yield
 #include <stddef.h>
 #include <string.h>
 #include <stdlib.h>
-static char* strdup(const char* s) {
-	size_t len = strlen(s) + 1;
-	char* dup = malloc(len);
-	if (dup) {
-		memcpy(dup, s, len);
-	}
-	return dup;
-}
 
 #include "lexer.h"
 #include "token.h"
@@ -19,100 +13,317 @@ static char* strdup(const char* s) {
 #include <stdlib.h>
 #include <ctype.h>
 #include <errno.h>
+#include <limits.h>
 #include <stdbool.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <sched.h>
+
+
+// the 31 keywords in token order (TCD25..TFALS), as they are spelled when lowercase
+static const char keyword_text[][10] = {
+	"cd25", "constants", "types", "is", "arrays", "main",
+	"begin", "end", "array", "of", "func", "void",
+	"const", "integer", "real", "boolean", "for", "repeat",
+	"until", "if", "else", "in", "out", "line",
+	"return", "not", "and", "or", "xor", "true",
+	"false"
+};
+
+// case insensitive compare against a lowercase keyword
+// lexemes here are only ever [A-Za-z0-9], where setting bit 5 lowercases letters and leaves digits alone
+static inline int keyword_equals(const char *s, const char *word, u32 len) {
+	for (u32 i = 1; i < len; i++) { // first char is matched by the switch
+		if ((s[i] | 0x20) != word[i])
+			return 0;
+	}
+	return 1;
+}
+
+// keyword token for an alphanumeric lexeme, or TIDEN (switch on length then first letter, no table to build)
+static enum token_type keyword_type(const char *s, u32 len) {
+	switch (len) {
+		case 2:
+			switch (s[0] | 0x20) {
+				case 'i':
+					if (keyword_equals(s, "is", 2)) return TTTIS;
+					if (keyword_equals(s, "if", 2)) return TIFTH;
+					if (keyword_equals(s, "in", 2)) return TINPT;
+					break;
+				case 'o':
+					if (keyword_equals(s, "of", 2)) return TTTOF;
+					if (keyword_equals(s, "or", 2)) return TTTOR;
+					break;
+			}
+			break;
+		case 3:
+			switch (s[0] | 0x20) {
+				case 'a':
+					if (keyword_equals(s, "and", 3)) return TTAND;
+					break;
+				case 'e':
+					if (keyword_equals(s, "end", 3)) return TTEND;
+					break;
+				case 'f':
+					if (keyword_equals(s, "for", 3)) return TTFOR;
+					break;
+				case 'n':
+					if (keyword_equals(s, "not", 3)) return TNOTT;
+					break;
+				case 'o':
+					if (keyword_equals(s, "out", 3)) return TOUTP;
+					break;
+				case 'x':
+					if (keyword_equals(s, "xor", 3)) return TTXOR;
+					break;
+			}
+			break;
+		case 4:
+			switch (s[0] | 0x20) {
+				case 'c':
+					if (keyword_equals(s, "cd25", 4)) return TCD25;
+					break;
+				case 'e':
+					if (keyword_equals(s, "else", 4)) return TELSE;
+					break;
+				case 'f':
+					if (keyword_equals(s, "func", 4)) return TFUNC;
+					break;
+				case 'l':
+					if (keyword_equals(s, "line", 4)) return TOUTL;
+					break;
+				case 'm':
+					if (keyword_equals(s, "main", 4)) return TMAIN;
+					break;
+				case 'r':
+					if (keyword_equals(s, "real", 4)) return TREAL;
+					break;
+				case 't':
+					if (keyword_equals(s, "true", 4)) return TTRUE;
+					break;
+				case 'v':
+					if (keyword_equals(s, "void", 4)) return TVOID;
+					break;
+			}
+			break;
+		case 5:
+			switch (s[0] | 0x20) {
+				case 'a':
+					if (keyword_equals(s, "array", 5)) return TARAY;
+					break;
+				case 'b':
+					if (keyword_equals(s, "begin", 5)) return TBEGN;
+					break;
+				case 'c':
+					if (keyword_equals(s, "const", 5)) return TCNST;
+					break;
+				case 'f':
+					if (keyword_equals(s, "false", 5)) return TFALS;
+					break;
+				case 't':
+					if (keyword_equals(s, "types", 5)) return TTYPS;
+					break;
+				case 'u':
+					if (keyword_equals(s, "until", 5)) return TUNTL;
+					break;
+			}
+			break;
+		case 6:
+			switch (s[0] | 0x20) {
+				case 'a':
+					if (keyword_equals(s, "arrays", 6)) return TARRS;
+					break;
+				case 'r':
+					if (keyword_equals(s, "repeat", 6)) return TREPT;
+					if (keyword_equals(s, "return", 6)) return TRETN;
+					break;
+			}
+			break;
+		case 7:
+			switch (s[0] | 0x20) {
+				case 'b':
+					if (keyword_equals(s, "boolean", 7)) return TBOOL;
+					break;
+				case 'i':
+					if (keyword_equals(s, "integer", 7)) return TINTG;
+					break;
+			}
+			break;
+		case 9:
+			switch (s[0] | 0x20) {
+				case 'c':
+					if (keyword_equals(s, "constants", 9)) return TCONS;
+					break;
+			}
+			break;
+	}
+	return TIDEN;
+}
 
-// std::unordered_map<std::pair<int, char>, int> transitions = std::unordered_map<>();
-// TODO: refactor my FSM to use the above
-// this'll slim down transitions, after which it should be easier to further minimise logic (e.g. buffer += ch, lex->buffer = "" branches)
-
-/* hash:  form hash value for string s */
-static unsigned hash_str(const void *ptr) {
-	char *s = (char *) ptr;
-	unsigned hashval;
-	for (hashval = 0; *s != '\0'; s++)
-		hashval = *s + 31 * hashval;
-	return hashval;
-}
-static int equal_str(const void *a, const void *b) {
-	return strcmp((char *)a, (char *)b) == 0;
-}
-
-void *heap_wrap(int type) {
-    int *ptr = malloc(sizeof(int));
-    *ptr = type;
-    return ptr;
-}
-
-void populate_keywords(HashMap *keywords) {
-	// initialising the keyword table (converting to lowercase is done upon access)
-	hashmap_add(keywords, strdup("cd25"), heap_wrap(TCD25)); //CD25
-	hashmap_add(keywords, strdup("constants"), heap_wrap(TCONS));
-	hashmap_add(keywords, strdup("types"), heap_wrap(TTYPS));
-	hashmap_add(keywords, strdup("is"), heap_wrap(TTTIS));
-	hashmap_add(keywords, strdup("arrays"), heap_wrap(TARRS));
-	hashmap_add(keywords, strdup("main"), heap_wrap(TMAIN));
-	hashmap_add(keywords, strdup("begin"), heap_wrap(TBEGN));
-	hashmap_add(keywords, strdup("end"), heap_wrap(TTEND));
-	hashmap_add(keywords, strdup("array"), heap_wrap(TARAY));
-	hashmap_add(keywords, strdup("of"), heap_wrap(TTTOF));
-	hashmap_add(keywords, strdup("func"), heap_wrap(TFUNC));
-	hashmap_add(keywords, strdup("void"), heap_wrap(TVOID));
-	hashmap_add(keywords, strdup("const"), heap_wrap(TCNST));
-	hashmap_add(keywords, strdup("integer"), heap_wrap(TINTG));
-	hashmap_add(keywords, strdup("real"), heap_wrap(TREAL));
-	hashmap_add(keywords, strdup("boolean"), heap_wrap(TBOOL));
-	hashmap_add(keywords, strdup("for"), heap_wrap(TTFOR));
-	hashmap_add(keywords, strdup("repeat"), heap_wrap(TREPT));
-	hashmap_add(keywords, strdup("until"), heap_wrap(TUNTL));
-	hashmap_add(keywords, strdup("if"), heap_wrap(TIFTH));
-	hashmap_add(keywords, strdup("else"), heap_wrap(TELSE));
-	hashmap_add(keywords, strdup("in"), heap_wrap(TINPT)); //In
-	hashmap_add(keywords, strdup("out"), heap_wrap(TOUTP)); //Out
-	hashmap_add(keywords, strdup("line"), heap_wrap(TOUTL)); //Line
-	hashmap_add(keywords, strdup("return"), heap_wrap(TRETN));
-	hashmap_add(keywords, strdup("not"), heap_wrap(TNOTT));
-	hashmap_add(keywords, strdup("and"), heap_wrap(TTAND));
-	hashmap_add(keywords, strdup("or"), heap_wrap(TTTOR));
-	hashmap_add(keywords, strdup("xor"), heap_wrap(TTXOR));
-	hashmap_add(keywords, strdup("true"), heap_wrap(TTRUE));
-	hashmap_add(keywords, strdup("false"), heap_wrap(TFALS));
+// maps the whole file (falls back to one read for things mmap refuses, like pipes)
+// the mapping is private and writable, as carriage returns get squeezed out of lexemes
+static int load_source(Lexer *lex, const char *source_path) {
+	int fd = open(source_path, O_RDONLY);
+	if (fd < 0)
+		return 1;
+	struct stat st;
+	if (fstat(fd, &st) != 0) {
+		close(fd);
+		return 1;
+	}
+	lex->mapped = 0;
+	lex->source = NULL;
+	lex->source_len = 0;
+	if (S_ISREG(st.st_mode) && st.st_size > 0) {
+		void *map = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+		if (map != MAP_FAILED) {
+			lex->source = map;
+			lex->source_len = st.st_size;
+			lex->mapped = 1;
+			close(fd);
+			return 0;
+		}
+	}
+	size_t cap = S_ISREG(st.st_mode) && st.st_size > 0 ? st.st_size : 4096;
+	char *buf = malloc(cap);
+	size_t len = 0;
+	ssize_t got;
+	while ((got = read(fd, buf + len, cap - len)) > 0) {
+		len += got;
+		if (len == cap) {
+			cap *= 2;
+			buf = realloc(buf, cap);
+		}
+	}
+	close(fd);
+	if (got < 0) {
+		free(buf);
+		return 1;
+	}
+	lex->source = buf;
+	lex->source_len = len;
+	return 0;
+}
+
+static Lexer *lexer_setup(Lexer *temp, Lister *lister, StringPool *pool) {
+	temp->lister = lister;
+	temp->tokens = (TokenStream){ 0 };
+	temp->cur = temp->source;
+	temp->end = temp->source + temp->source_len;
+	temp->lexeme = NULL;
+	temp->lexeme_crs = 0;
+	temp->skip = lexer_simd_kernels();
+	temp->pool = pool;
+	temp->state = START;
+	temp->row = temp->col = 1;
+	temp->twin = NULL;
+	temp->ring = NULL;
+	temp->deferred = NULL;
+	temp->deferred_count = temp->deferred_next = 0;
+	temp->text = NULL;
+	temp->lines = (LineIndex){ 0 };
+	// the whole source is listed up front (to not add the final \n before EOF to the listing)
+	if (temp->source_len > 0)
+		lister_write_source(lister, temp->source, temp->source_len - 1);
+	return temp;
 }
 
 // the lexer is stack allocated
-Lexer *lexer_create(const char *source_path, Lister *lister) {
+Lexer *lexer_create(const char *source_path, Lister *lister, StringPool *pool) {
 	Lexer *temp = malloc(sizeof(Lexer));
-	temp->lister = lister;
-	temp->tokens = linkedlist_create();
-	temp->source_file = fopen(source_path, "r");
-	if (!temp->source_file) {
+	if (load_source(temp, source_path)) {
 		fprintf(stderr, "could not open source file\n");
 		free(temp);
 		abort();
 	}
-	temp->state = START;
-	temp->row = temp->col = 1;
-	temp->buffer = sdsempty(); //todo: figure out how specifying size works
-	temp->keyword_map = hashmap_create(100, hash_str, equal_str);
-	populate_keywords(temp->keyword_map);
-	return temp;
+	return lexer_setup(temp, lister, pool);
+}
+
+Lexer *lexer_create_text(const char *text, size_t len, Lister *lister, StringPool *pool) {
+	Lexer *temp = malloc(sizeof(Lexer));
+	temp->source = malloc(len ? len : 1);
+	memcpy(temp->source, text, len);
+	temp->source_len = len;
+	temp->mapped = 0;
+	return lexer_setup(temp, lister, pool);
+}
+
+static void stream_free(TokenStream *ts) {
+	free(ts->type);
+	free(ts->offset);
+	free(ts->len);
+	free(ts->lit);
+	free(ts->id);
+	free(ts->row);
+	free(ts->col);
 }
 
+static void lexer_stop_async(Lexer *lex);
+static void drop_deferred(Lexer *lex);
+
 void lexer_free(Lexer *lex) {
-	fclose(lex->source_file);
-	linkedlist_free(lex->tokens);
-	sdsfree(lex->buffer);
-	hashmap_free(lex->keyword_map, free, free);
+	if (lex->twin)
+		lexer_stop_async(lex);
+	if (lex->deferred)
+		drop_deferred(lex);
+	if (lex->text) {
+		free(lex->text);
+		free(lex->lines.start);
+		free(lex->lines.first_token);
+		free(lex->lines.in_comment);
+	}
+	if (lex->mapped)
+		munmap(lex->source, lex->source_len);
+	else
+		free(lex->source);
+	stream_free(&lex->tokens);
 	free(lex);
 }
 
+static void stream_reserve(TokenStream *ts, u32 cap) {
+	if (cap <= ts->cap)
+		return;
+	ts->cap = cap;
+	ts->type = realloc(ts->type, ts->cap * sizeof(*ts->type));
+	ts->offset = realloc(ts->offset, ts->cap * sizeof(*ts->offset));
+	ts->len = realloc(ts->len, ts->cap * sizeof(*ts->len));
+	ts->lit = realloc(ts->lit, ts->cap * sizeof(*ts->lit));
+	ts->id = realloc(ts->id, ts->cap * sizeof(*ts->id));
+	ts->row = realloc(ts->row, ts->cap * sizeof(*ts->row));
+	ts->col = realloc(ts->col, ts->cap * sizeof(*ts->col));
+}
+
+static void stream_push(Lexer *lex, Token tok) {
+	TokenStream *ts = &lex->tokens;
+	if (ts->count == ts->cap)
+		stream_reserve(ts, ts->cap ? ts->cap * 2 : 1024);
+	u32 i = ts->count++;
+	ts->type[i] = tok.type;
+	ts->offset[i] = tok.val ? (u32)(tok.val - lex->source) : 0;
+	ts->len[i] = tok.len;
+	ts->lit[i] = tok.lit;
+	ts->id[i] = tok.id;
+	ts->row[i] = tok.row;
+	ts->col[i] = tok.col;
+}
+
+static Token stream_token(Lexer *lex, u32 i) {
+	TokenStream *ts = &lex->tokens;
+	return (Token){ ts->type[i], lex->source + ts->offset[i], ts->len[i], ts->id[i], ts->lit[i], ts->row[i], ts->col[i] };
+}
+
 // helper function, no other module should be generating tokens
-Token *make_token(enum token_type type, char* val, int row, int col) {
-	Token *temp = malloc(sizeof(Token));
-	temp->type = type;
-	temp->val = val;
-	temp->row = row;
-	temp->col = col;
-	return temp;
+static void push_token(Lexer *lex, enum token_type type, const char *val, u32 len, int col) {
+	u32 id = len ? stringpool_intern(lex->pool, val, len) : 0; // 0 is ""
+	stream_push(lex, (Token){ type, val, len, id, { 0 }, lex->row, col });
+}
+
+// a TILIT/TFLIT along with its parsed value
+static void push_literal(Lexer *lex, enum token_type type, const char *val, u32 len, int col, union literal lit) {
+	push_token(lex, type, val, len, col);
+	lex->tokens.lit[lex->tokens.count-1] = lit;
 }
 
 // insert a sds into a cstr
@@ -133,34 +344,39 @@ char *format_cstr(const char *format, const char *str) {
 // 	return msg;
 // }
 
-void lexer_handle_capitalisation_warnings(Lexer *lex, const sds lexeme) {
-	sds lowercase = sdsdup(lexeme);
-	sdstolower(lowercase);
-	if (hashmap_contains(lex->keyword_map, lowercase)) {
-		//TODO: add value to the hashmap and use a switch here
-		if (strcmp(lowercase, "cd25") == 0) {
-			if (strcmp(lexeme, "CD25") != 0) {
-				lister_lex_warn(lex->lister, lex->row, lex->col-sdslen(lexeme), "proper capitalisation is CD25");
+void lexer_handle_capitalisation_warnings(Lexer *lex, const char *lexeme, int len, enum token_type type) {
+	const char *proper;
+	char *msg;
+	switch (type) {
+		case TCD25:
+			proper = "CD25";
+			msg = "proper capitalisation is CD25";
+			break;
+		case TINPT:
+			proper = "In";
+			msg = "proper capitalisation is In";
+			break;
+		case TOUTP:
+			proper = "Out";
+			msg = "proper capitalisation is Out";
+			break;
+		case TOUTL:
+			proper = "Line";
+			msg = "proper capitalisation is Line";
+			break;
+		default: { // everything else is lowercase
+			const char *lowercase = keyword_text[type - TCD25];
+			if (memcmp(lexeme, lowercase, len) != 0) {
+				lister_lex_warn(lex->lister, lex->row, lex->col-len,
+					format_cstr("leave %s in lowercase", lowercase)
+				);
 			}
-		} else if (strcmp(lowercase, "in") == 0) {
-			if (strcmp(lexeme, "In") != 0) {
-				lister_lex_warn(lex->lister, lex->row, lex->col-sdslen(lexeme), "proper capitalisation is In");
-			}
-		} else if (strcmp(lowercase, "out") == 0) {
-			if (strcmp(lexeme, "Out") != 0) {
-				lister_lex_warn(lex->lister, lex->row, lex->col-sdslen(lexeme), "proper capitalisation is Out");
-			}
-		} else if (strcmp(lowercase, "line") == 0) {
-			if (strcmp(lexeme, "Line") != 0) {
-				lister_lex_warn(lex->lister, lex->row, lex->col-sdslen(lexeme), "proper capitalisation is Line");
-			}
-		} else if (strcmp(lexeme, lowercase) != 0) {
-			lister_lex_warn(lex->lister, lex->row, lex->col-sdslen(lexeme),
-				format_cstr("leave %s in lowercase", lowercase)
-			);
+			return;
 		}
 	}
-	sdsfree(lowercase);
+	if (memcmp(lexeme, proper, len) != 0) {
+		lister_lex_warn(lex->lister, lex->row, lex->col-len, msg);
+	}
 }
 
 // characters that are always exactly one token to themselves
@@ -191,425 +407,1448 @@ int lone_operator(char ch) {
 			return -1; // is not a lone operator (would not work if the enum moves from int to an alphabetical type)
 	}
 }
-// quickly and concisely check if a char is valid outside of comment/string
-int valid_char(char ch) {
-	if (isalpha(ch)) { return true; }
-	if (isdigit(ch)) { return true; }
-	switch (ch) {
-		case ',':
-		case ';':
-		case '[':
-		case ']':
-		case '(':
-		case ')':
-		case '=':
-		case '+':
-		case '-':
-		case '*':
-		case '/':
-		case '%':
-		case '^':
-		case '<':
-		case '>':
-		case ':':
-		case '.':
-		case '!': // future chars are not considered
-		case ' ': //space
-		case '	': //tab
-		case '\r': // carriage return 🤮
-		case '\n':
-			return true;
-		default:
-			return false;
+// length of the lexeme being built, up to (not including) pos
+// carriage returns are dropped, so any inside the lexeme are squeezed out in place first
+static int lexeme_len(Lexer *lex, const char *pos) {
+	if (!lex->lexeme)
+		return 0;
+	if (lex->lexeme_crs) {
+		char *dst = (char *)pos;
+		for (const char *src = pos; src-- > lex->lexeme;) {
+			if (*src != '\r')
+				*--dst = *src;
+		}
+		lex->lexeme = dst;
+		lex->lexeme_crs = 0;
 	}
+	return (int)(pos - lex->lexeme);
 }
 
-static sds buffer_append(sds buf, char c) {
-    if (sdsavail(buf) < 1) {
-        buf = sdsMakeRoomFor(buf, 1);
-    }
-	char temp[2] = {c, '\0'};
-    buf = sdscatlen(buf, temp, 1);
-    return buf;
+// integer literals are plain digit runs, so they're accumulated directly (0 on overflow)
+static int parse_int(const char *lexeme, int len, long *out) {
+	long val = 0;
+	for (int i = 0; i < len; i++) {
+		int digit = lexeme[i] - '0';
+		if (val > (LONG_MAX - digit) / 10)
+			return 0;
+		val = val * 10 + digit;
+	}
+	*out = val;
+	return 1;
 }
 
-// char *strip_sds_header(sds s) {
-//     size_t len = sdslen(s);
-//     char *result = malloc(len + 1);  // Allocate new memory
-//     if (!result) return NULL;
-//     memcpy(result, s, len + 1);     // Copy string content
-//     sdsfree(s);                     // Free the original SDS properly
-//     return result;
-// }
-// char *strip_sds_header(sds s) {
-//     char *result = realloc(s, sdslen(s) + 1);
-//     if (!result) return NULL; //redundant?
-//     return result;
-// }
+// real literals are digits.digits: when the digits fit in a double's mantissa and there are
+// few enough after the dot, one division by an exact power of 10 is correctly rounded
+// anything longer goes through strtod (which also catches overflow/underflow)
+static int parse_real(const char *lexeme, int len, double *out) {
+	static const double pow10[] = {
+		1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+		1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+	};
+	u64 mantissa = 0;
+	int frac_digits = -1;
+	int fast = 1;
+	for (int i = 0; i < len && fast; i++) {
+		if (lexeme[i] == '.') {
+			frac_digits = 0;
+			continue;
+		}
+		mantissa = mantissa * 10 + (lexeme[i] - '0');
+		fast = mantissa <= (1ull << 53);
+		if (frac_digits >= 0)
+			frac_digits++;
+	}
+	if (fast && frac_digits >= 0 && frac_digits <= 22) {
+		*out = (double)mantissa / pow10[frac_digits];
+		return 1;
+	}
+	// strtod needs a terminated copy, as the mapped source isn't terminated after the literal
+	sds literal = sdsnewlen(lexeme, len);
+	errno = 0; // bounds check
+	*out = strtod(literal, NULL);
+	sdsfree(literal);
+	return errno != ERANGE;
+}
+
+// byte classes, the columns of the transition table
+// (CL_OTHER is 0 so anything unlisted is an invalid character)
+enum byte_class {
+	CL_OTHER, CL_DIGIT, CL_ALPHA, CL_BLANK, CL_NL, CL_CR,
+	CL_DOT, CL_LONE, CL_PLUS, CL_MINUS, CL_STAR, CL_EQUAL,
+	CL_LESS, CL_GRTR, CL_EXCLM, CL_QUOTE, CL_SLASH,
+	CLASS_COUNT
+};
 
-sds buffer_substr(sds buf, size_t start, size_t len) {
-    if (start >= sdslen(buf)) return sdsempty();
-    if (start + len > sdslen(buf)) len = sdslen(buf) - start;
-    return sdsnewlen(buf + start, len);
+static const u8 byte_class[256] = {
+	['\t'] = CL_BLANK,
+	['\n'] = CL_NL,
+	['\r'] = CL_CR,
+	[' '] = CL_BLANK,
+	['!'] = CL_EXCLM,
+	['"'] = CL_QUOTE,
+	['%'] = CL_LONE,
+	['('] = CL_LONE,
+	[')'] = CL_LONE,
+	['*'] = CL_STAR,
+	['+'] = CL_PLUS,
+	[','] = CL_LONE,
+	['-'] = CL_MINUS,
+	['.'] = CL_DOT,
+	['/'] = CL_SLASH,
+	['0'] = CL_DIGIT,
+	['1'] = CL_DIGIT,
+	['2'] = CL_DIGIT,
+	['3'] = CL_DIGIT,
+	['4'] = CL_DIGIT,
+	['5'] = CL_DIGIT,
+	['6'] = CL_DIGIT,
+	['7'] = CL_DIGIT,
+	['8'] = CL_DIGIT,
+	['9'] = CL_DIGIT,
+	[':'] = CL_LONE,
+	[';'] = CL_LONE,
+	['<'] = CL_LESS,
+	['='] = CL_EQUAL,
+	['>'] = CL_GRTR,
+	['A'] = CL_ALPHA,
+	['B'] = CL_ALPHA,
+	['C'] = CL_ALPHA,
+	['D'] = CL_ALPHA,
+	['E'] = CL_ALPHA,
+	['F'] = CL_ALPHA,
+	['G'] = CL_ALPHA,
+	['H'] = CL_ALPHA,
+	['I'] = CL_ALPHA,
+	['J'] = CL_ALPHA,
+	['K'] = CL_ALPHA,
+	['L'] = CL_ALPHA,
+	['M'] = CL_ALPHA,
+	['N'] = CL_ALPHA,
+	['O'] = CL_ALPHA,
+	['P'] = CL_ALPHA,
+	['Q'] = CL_ALPHA,
+	['R'] = CL_ALPHA,
+	['S'] = CL_ALPHA,
+	['T'] = CL_ALPHA,
+	['U'] = CL_ALPHA,
+	['V'] = CL_ALPHA,
+	['W'] = CL_ALPHA,
+	['X'] = CL_ALPHA,
+	['Y'] = CL_ALPHA,
+	['Z'] = CL_ALPHA,
+	['['] = CL_LONE,
+	[']'] = CL_LONE,
+	['^'] = CL_LONE,
+	['a'] = CL_ALPHA,
+	['b'] = CL_ALPHA,
+	['c'] = CL_ALPHA,
+	['d'] = CL_ALPHA,
+	['e'] = CL_ALPHA,
+	['f'] = CL_ALPHA,
+	['g'] = CL_ALPHA,
+	['h'] = CL_ALPHA,
+	['i'] = CL_ALPHA,
+	['j'] = CL_ALPHA,
+	['k'] = CL_ALPHA,
+	['l'] = CL_ALPHA,
+	['m'] = CL_ALPHA,
+	['n'] = CL_ALPHA,
+	['o'] = CL_ALPHA,
+	['p'] = CL_ALPHA,
+	['q'] = CL_ALPHA,
+	['r'] = CL_ALPHA,
+	['s'] = CL_ALPHA,
+	['t'] = CL_ALPHA,
+	['u'] = CL_ALPHA,
+	['v'] = CL_ALPHA,
+	['w'] = CL_ALPHA,
+	['x'] = CL_ALPHA,
+	['y'] = CL_ALPHA,
+	['z'] = CL_ALPHA,
+};
+
+// what to do on a transition (col is the column of the current char)
+enum fsm_action {
+	A_NONE,
+	A_DROP, // carriage returns are dropped entirely (🤮)
+	A_BEGIN, // current char starts a lexeme
+	A_CLEAR, // lexeme turned out to be a comment
+	A_LONE, // [.,[]()%^;:] are a token to themselves
+	A_TOKEN, // operator that started at col-1
+	A_TOKEN_HERE, // < and > are reported at the following char
+	A_SPLIT, // /* or /- that wasn't a comment: / then * or -
+	A_INT, A_INT_DOT, A_REAL, A_WORD,
+	A_BANG, // ! that isn't part of !=
+	A_STRING, A_UNTERMINATED,
+	A_UNKNOWN
+};
+
+struct transition {
+	u8 next; // enum fsm_state
+	u8 action; // enum fsm_action
+	u8 token; // enum token_type for the operator actions
+	u8 retry; // the char isn't consumed, and is run again from START
+};
+
+// rows are states, columns are byte classes
+static const struct transition transitions[FSM_STATE_COUNT][CLASS_COUNT] = {
+	[START] = {
+		[CL_OTHER] = { ERROR, A_BEGIN, 0, 0 },
+		[CL_DIGIT] = { NUM, A_BEGIN, 0, 0 },
+		[CL_ALPHA] = { ALPHANUM, A_BEGIN, 0, 0 },
+		[CL_BLANK] = { START, A_NONE, 0, 0 },
+		[CL_NL] = { START, A_NONE, 0, 0 },
+		[CL_CR] = { START, A_DROP, 0, 0 },
+		[CL_DOT] = { START, A_LONE, 0, 0 },
+		[CL_LONE] = { START, A_LONE, 0, 0 },
+		[CL_PLUS] = { PRE_PLUS, A_BEGIN, 0, 0 },
+		[CL_MINUS] = { PRE_MINUS, A_BEGIN, 0, 0 },
+		[CL_STAR] = { PRE_STAR, A_BEGIN, 0, 0 },
+		[CL_EQUAL] = { PRE_EQUAL, A_BEGIN, 0, 0 },
+		[CL_LESS] = { LESS, A_BEGIN, 0, 0 },
+		[CL_GRTR] = { GRTR, A_BEGIN, 0, 0 },
+		[CL_EXCLM] = { EXCLM, A_BEGIN, 0, 0 },
+		[CL_QUOTE] = { STRING, A_BEGIN, 0, 0 },
+		[CL_SLASH] = { SLASH, A_BEGIN, 0, 0 },
+	},
+	[NUM] = {
+		[CL_OTHER] = { START, A_INT, 0, 1 },
+		[CL_DIGIT] = { NUM, A_NONE, 0, 0 },
+		[CL_ALPHA] = { START, A_INT, 0, 1 },
+		[CL_BLANK] = { START, A_INT, 0, 1 },
+		[CL_NL] = { START, A_INT, 0, 1 },
+		[CL_CR] = { NUM, A_DROP, 0, 0 },
+		[CL_DOT] = { NUMDOT, A_NONE, 0, 0 },
+		[CL_LONE] = { START, A_INT, 0, 1 },
+		[CL_PLUS] = { START, A_INT, 0, 1 },
+		[CL_MINUS] = { START, A_INT, 0, 1 },
+		[CL_STAR] = { START, A_INT, 0, 1 },
+		[CL_EQUAL] = { START, A_INT, 0, 1 },
+		[CL_LESS] = { START, A_INT, 0, 1 },
+		[CL_GRTR] = { START, A_INT, 0, 1 },
+		[CL_EXCLM] = { START, A_INT, 0, 1 },
+		[CL_QUOTE] = { START, A_INT, 0, 1 },
+		[CL_SLASH] = { START, A_INT, 0, 1 },
+	},
+	[ALPHANUM] = {
+		[CL_OTHER] = { START, A_WORD, 0, 1 },
+		[CL_DIGIT] = { ALPHANUM, A_NONE, 0, 0 },
+		[CL_ALPHA] = { ALPHANUM, A_NONE, 0, 0 },
+		[CL_BLANK] = { START, A_WORD, 0, 1 },
+		[CL_NL] = { START, A_WORD, 0, 1 },
+		[CL_CR] = { ALPHANUM, A_DROP, 0, 0 },
+		[CL_DOT] = { START, A_WORD, 0, 1 },
+		[CL_LONE] = { START, A_WORD, 0, 1 },
+		[CL_PLUS] = { START, A_WORD, 0, 1 },
+		[CL_MINUS] = { START, A_WORD, 0, 1 },
+		[CL_STAR] = { START, A_WORD, 0, 1 },
+		[CL_EQUAL] = { START, A_WORD, 0, 1 },
+		[CL_LESS] = { START, A_WORD, 0, 1 },
+		[CL_GRTR] = { START, A_WORD, 0, 1 },
+		[CL_EXCLM] = { START, A_WORD, 0, 1 },
+		[CL_QUOTE] = { START, A_WORD, 0, 1 },
+		[CL_SLASH] = { START, A_WORD, 0, 1 },
+	},
+	[NUMDOT] = {
+		[CL_OTHER] = { START, A_INT_DOT, 0, 1 },
+		[CL_DIGIT] = { FLOAT, A_NONE, 0, 0 },
+		[CL_ALPHA] = { START, A_INT_DOT, 0, 1 },
+		[CL_BLANK] = { START, A_INT_DOT, 0, 1 },
+		[CL_NL] = { START, A_INT_DOT, 0, 1 },
+		[CL_CR] = { NUMDOT, A_DROP, 0, 0 },
+		[CL_DOT] = { START, A_INT_DOT, 0, 1 },
+		[CL_LONE] = { START, A_INT_DOT, 0, 1 },
+		[CL_PLUS] = { START, A_INT_DOT, 0, 1 },
+		[CL_MINUS] = { START, A_INT_DOT, 0, 1 },
+		[CL_STAR] = { START, A_INT_DOT, 0, 1 },
+		[CL_EQUAL] = { START, A_INT_DOT, 0, 1 },
+		[CL_LESS] = { START, A_INT_DOT, 0, 1 },
+		[CL_GRTR] = { START, A_INT_DOT, 0, 1 },
+		[CL_EXCLM] = { START, A_INT_DOT, 0, 1 },
+		[CL_QUOTE] = { START, A_INT_DOT, 0, 1 },
+		[CL_SLASH] = { START, A_INT_DOT, 0, 1 },
+	},
+	[FLOAT] = {
+		[CL_OTHER] = { START, A_REAL, 0, 1 },
+		[CL_DIGIT] = { FLOAT, A_NONE, 0, 0 },
+		[CL_ALPHA] = { START, A_REAL, 0, 1 },
+		[CL_BLANK] = { START, A_REAL, 0, 1 },
+		[CL_NL] = { START, A_REAL, 0, 1 },
+		[CL_CR] = { FLOAT, A_DROP, 0, 0 },
+		[CL_DOT] = { START, A_REAL, 0, 1 },
+		[CL_LONE] = { START, A_REAL, 0, 1 },
+		[CL_PLUS] = { START, A_REAL, 0, 1 },
+		[CL_MINUS] = { START, A_REAL, 0, 1 },
+		[CL_STAR] = { START, A_REAL, 0, 1 },
+		[CL_EQUAL] = { START, A_REAL, 0, 1 },
+		[CL_LESS] = { START, A_REAL, 0, 1 },
+		[CL_GRTR] = { START, A_REAL, 0, 1 },
+		[CL_EXCLM] = { START, A_REAL, 0, 1 },
+		[CL_QUOTE] = { START, A_REAL, 0, 1 },
+		[CL_SLASH] = { START, A_REAL, 0, 1 },
+	},
+	[PRE_PLUS] = {
+		[CL_OTHER] = { START, A_TOKEN, TPLUS, 1 },
+		[CL_DIGIT] = { START, A_TOKEN, TPLUS, 1 },
+		[CL_ALPHA] = { START, A_TOKEN, TPLUS, 1 },
+		[CL_BLANK] = { START, A_TOKEN, TPLUS, 1 },
+		[CL_NL] = { START, A_TOKEN, TPLUS, 1 },
+		[CL_CR] = { PRE_PLUS, A_DROP, 0, 0 },
+		[CL_DOT] = { START, A_TOKEN, TPLUS, 1 },
+		[CL_LONE] = { START, A_TOKEN, TPLUS, 1 },
+		[CL_PLUS] = { START, A_TOKEN, TPLUS, 1 },
+		[CL_MINUS] = { START, A_TOKEN, TPLUS, 1 },
+		[CL_STAR] = { START, A_TOKEN, TPLUS, 1 },
+		[CL_EQUAL] = { START, A_TOKEN, TPLEQ, 0 },
+		[CL_LESS] = { START, A_TOKEN, TPLUS, 1 },
+		[CL_GRTR] = { START, A_TOKEN, TPLUS, 1 },
+		[CL_EXCLM] = { START, A_TOKEN, TPLUS, 1 },
+		[CL_QUOTE] = { START, A_TOKEN, TPLUS, 1 },
+		[CL_SLASH] = { START, A_TOKEN, TPLUS, 1 },
+	},
+	[PRE_MINUS] = {
+		[CL_OTHER] = { START, A_TOKEN, TMINS, 1 },
+		[CL_DIGIT] = { START, A_TOKEN, TMINS, 1 },
+		[CL_ALPHA] = { START, A_TOKEN, TMINS, 1 },
+		[CL_BLANK] = { START, A_TOKEN, TMINS, 1 },
+		[CL_NL] = { START, A_TOKEN, TMINS, 1 },
+		[CL_CR] = { PRE_MINUS, A_DROP, 0, 0 },
+		[CL_DOT] = { START, A_TOKEN, TMINS, 1 },
+		[CL_LONE] = { START, A_TOKEN, TMINS, 1 },
+		[CL_PLUS] = { START, A_TOKEN, TMINS, 1 },
+		[CL_MINUS] = { START, A_TOKEN, TMINS, 1 },
+		[CL_STAR] = { START, A_TOKEN, TMINS, 1 },
+		[CL_EQUAL] = { START, A_TOKEN, TMNEQ, 0 },
+		[CL_LESS] = { START, A_TOKEN, TMINS, 1 },
+		[CL_GRTR] = { START, A_TOKEN, TMINS, 1 },
+		[CL_EXCLM] = { START, A_TOKEN, TMINS, 1 },
+		[CL_QUOTE] = { START, A_TOKEN, TMINS, 1 },
+		[CL_SLASH] = { START, A_TOKEN, TMINS, 1 },
+	},
+	[PRE_STAR] = {
+		[CL_OTHER] = { START, A_TOKEN, TSTAR, 1 },
+		[CL_DIGIT] = { START, A_TOKEN, TSTAR, 1 },
+		[CL_ALPHA] = { START, A_TOKEN, TSTAR, 1 },
+		[CL_BLANK] = { START, A_TOKEN, TSTAR, 1 },
+		[CL_NL] = { START, A_TOKEN, TSTAR, 1 },
+		[CL_CR] = { PRE_STAR, A_DROP, 0, 0 },
+		[CL_DOT] = { START, A_TOKEN, TSTAR, 1 },
+		[CL_LONE] = { START, A_TOKEN, TSTAR, 1 },
+		[CL_PLUS] = { START, A_TOKEN, TSTAR, 1 },
+		[CL_MINUS] = { START, A_TOKEN, TSTAR, 1 },
+		[CL_STAR] = { START, A_TOKEN, TSTAR, 1 },
+		[CL_EQUAL] = { START, A_TOKEN, TSTEQ, 0 },
+		[CL_LESS] = { START, A_TOKEN, TSTAR, 1 },
+		[CL_GRTR] = { START, A_TOKEN, TSTAR, 1 },
+		[CL_EXCLM] = { START, A_TOKEN, TSTAR, 1 },
+		[CL_QUOTE] = { START, A_TOKEN, TSTAR, 1 },
+		[CL_SLASH] = { START, A_TOKEN, TSTAR, 1 },
+	},
+	[PRE_EQUAL] = {
+		[CL_OTHER] = { START, A_TOKEN, TEQUL, 1 },
+		[CL_DIGIT] = { START, A_TOKEN, TEQUL, 1 },
+		[CL_ALPHA] = { START, A_TOKEN, TEQUL, 1 },
+		[CL_BLANK] = { START, A_TOKEN, TEQUL, 1 },
+		[CL_NL] = { START, A_TOKEN, TEQUL, 1 },
+		[CL_CR] = { PRE_EQUAL, A_DROP, 0, 0 },
+		[CL_DOT] = { START, A_TOKEN, TEQUL, 1 },
+		[CL_LONE] = { START, A_TOKEN, TEQUL, 1 },
+		[CL_PLUS] = { START, A_TOKEN, TEQUL, 1 },
+		[CL_MINUS] = { START, A_TOKEN, TEQUL, 1 },
+		[CL_STAR] = { START, A_TOKEN, TEQUL, 1 },
+		[CL_EQUAL] = { START, A_TOKEN, TEQEQ, 0 },
+		[CL_LESS] = { START, A_TOKEN, TEQUL, 1 },
+		[CL_GRTR] = { START, A_TOKEN, TEQUL, 1 },
+		[CL_EXCLM] = { START, A_TOKEN, TEQUL, 1 },
+		[CL_QUOTE] = { START, A_TOKEN, TEQUL, 1 },
+		[CL_SLASH] = { START, A_TOKEN, TEQUL, 1 },
+	},
+	[LESS] = {
+		[CL_OTHER] = { START, A_TOKEN_HERE, TLESS, 1 },
+		[CL_DIGIT] = { START, A_TOKEN_HERE, TLESS, 1 },
+		[CL_ALPHA] = { START, A_TOKEN_HERE, TLESS, 1 },
+		[CL_BLANK] = { START, A_TOKEN_HERE, TLESS, 1 },
+		[CL_NL] = { START, A_TOKEN_HERE, TLESS, 1 },
+		[CL_CR] = { LESS, A_DROP, 0, 0 },
+		[CL_DOT] = { START, A_TOKEN_HERE, TLESS, 1 },
+		[CL_LONE] = { START, A_TOKEN_HERE, TLESS, 1 },
+		[CL_PLUS] = { START, A_TOKEN_HERE, TLESS, 1 },
+		[CL_MINUS] = { START, A_TOKEN_HERE, TLESS, 1 },
+		[CL_STAR] = { START, A_TOKEN_HERE, TLESS, 1 },
+		[CL_EQUAL] = { START, A_TOKEN, TLEQL, 0 },
+		[CL_LESS] = { START, A_TOKEN, TLSLS, 0 },
+		[CL_GRTR] = { START, A_TOKEN_HERE, TLESS, 1 },
+		[CL_EXCLM] = { START, A_TOKEN_HERE, TLESS, 1 },
+		[CL_QUOTE] = { START, A_TOKEN_HERE, TLESS, 1 },
+		[CL_SLASH] = { START, A_TOKEN_HERE, TLESS, 1 },
+	},
+	[GRTR] = {
+		[CL_OTHER] = { START, A_TOKEN_HERE, TGRTR, 1 },
+		[CL_DIGIT] = { START, A_TOKEN_HERE, TGRTR, 1 },
+		[CL_ALPHA] = { START, A_TOKEN_HERE, TGRTR, 1 },
+		[CL_BLANK] = { START, A_TOKEN_HERE, TGRTR, 1 },
+		[CL_NL] = { START, A_TOKEN_HERE, TGRTR, 1 },
+		[CL_CR] = { GRTR, A_DROP, 0, 0 },
+		[CL_DOT] = { START, A_TOKEN_HERE, TGRTR, 1 },
+		[CL_LONE] = { START, A_TOKEN_HERE, TGRTR, 1 },
+		[CL_PLUS] = { START, A_TOKEN_HERE, TGRTR, 1 },
+		[CL_MINUS] = { START, A_TOKEN_HERE, TGRTR, 1 },
+		[CL_STAR] = { START, A_TOKEN_HERE, TGRTR, 1 },
+		[CL_EQUAL] = { START, A_TOKEN, TGEQL, 0 },
+		[CL_LESS] = { START, A_TOKEN_HERE, TGRTR, 1 },
+		[CL_GRTR] = { START, A_TOKEN, TGRGR, 0 },
+		[CL_EXCLM] = { START, A_TOKEN_HERE, TGRTR, 1 },
+		[CL_QUOTE] = { START, A_TOKEN_HERE, TGRTR, 1 },
+		[CL_SLASH] = { START, A_TOKEN_HERE, TGRTR, 1 },
+	},
+	[EXCLM] = {
+		[CL_OTHER] = { ERROR, A_NONE, 0, 0 },
+		[CL_DIGIT] = { START, A_BANG, 0, 1 },
+		[CL_ALPHA] = { START, A_BANG, 0, 1 },
+		[CL_BLANK] = { START, A_BANG, 0, 1 },
+		[CL_NL] = { START, A_BANG, 0, 1 },
+		[CL_CR] = { EXCLM, A_DROP, 0, 0 },
+		[CL_DOT] = { START, A_BANG, 0, 1 },
+		[CL_LONE] = { START, A_BANG, 0, 1 },
+		[CL_PLUS] = { START, A_BANG, 0, 1 },
+		[CL_MINUS] = { START, A_BANG, 0, 1 },
+		[CL_STAR] = { START, A_BANG, 0, 1 },
+		[CL_EQUAL] = { START, A_TOKEN, TNEQL, 0 },
+		[CL_LESS] = { START, A_BANG, 0, 1 },
+		[CL_GRTR] = { START, A_BANG, 0, 1 },
+		[CL_EXCLM] = { ERROR, A_NONE, 0, 0 },
+		[CL_QUOTE] = { ERROR, A_NONE, 0, 0 },
+		[CL_SLASH] = { START, A_BANG, 0, 1 },
+	},
+	[STRING] = {
+		[CL_OTHER] = { STRING, A_NONE, 0, 0 },
+		[CL_DIGIT] = { STRING, A_NONE, 0, 0 },
+		[CL_ALPHA] = { STRING, A_NONE, 0, 0 },
+		[CL_BLANK] = { STRING, A_NONE, 0, 0 },
+		[CL_NL] = { START, A_UNTERMINATED, 0, 0 },
+		[CL_CR] = { STRING, A_DROP, 0, 0 },
+		[CL_DOT] = { STRING, A_NONE, 0, 0 },
+		[CL_LONE] = { STRING, A_NONE, 0, 0 },
+		[CL_PLUS] = { STRING, A_NONE, 0, 0 },
+		[CL_MINUS] = { STRING, A_NONE, 0, 0 },
+		[CL_STAR] = { STRING, A_NONE, 0, 0 },
+		[CL_EQUAL] = { STRING, A_NONE, 0, 0 },
+		[CL_LESS] = { STRING, A_NONE, 0, 0 },
+		[CL_GRTR] = { STRING, A_NONE, 0, 0 },
+		[CL_EXCLM] = { STRING, A_NONE, 0, 0 },
+		[CL_QUOTE] = { START, A_STRING, 0, 0 },
+		[CL_SLASH] = { STRING, A_NONE, 0, 0 },
+	},
+	[SLASH] = {
+		[CL_OTHER] = { START, A_TOKEN, TDIVD, 1 },
+		[CL_DIGIT] = { START, A_TOKEN, TDIVD, 1 },
+		[CL_ALPHA] = { START, A_TOKEN, TDIVD, 1 },
+		[CL_BLANK] = { START, A_TOKEN, TDIVD, 1 },
+		[CL_NL] = { START, A_TOKEN, TDIVD, 1 },
+		[CL_CR] = { SLASH, A_DROP, 0, 0 },
+		[CL_DOT] = { START, A_TOKEN, TDIVD, 1 },
+		[CL_LONE] = { START, A_TOKEN, TDIVD, 1 },
+		[CL_PLUS] = { START, A_TOKEN, TDIVD, 1 },
+		[CL_MINUS] = { SLASHMINUS, A_NONE, 0, 0 },
+		[CL_STAR] = { SLASHSTAR, A_NONE, 0, 0 },
+		[CL_EQUAL] = { START, A_TOKEN, TDVEQ, 0 },
+		[CL_LESS] = { START, A_TOKEN, TDIVD, 1 },
+		[CL_GRTR] = { START, A_TOKEN, TDIVD, 1 },
+		[CL_EXCLM] = { START, A_TOKEN, TDIVD, 1 },
+		[CL_QUOTE] = { START, A_TOKEN, TDIVD, 1 },
+		[CL_SLASH] = { START, A_TOKEN, TDIVD, 1 },
+	},
+	[SLASHSTAR] = {
+		[CL_OTHER] = { START, A_SPLIT, TSTAR, 1 },
+		[CL_DIGIT] = { START, A_SPLIT, TSTAR, 1 },
+		[CL_ALPHA] = { START, A_SPLIT, TSTAR, 1 },
+		[CL_BLANK] = { START, A_SPLIT, TSTAR, 1 },
+		[CL_NL] = { START, A_SPLIT, TSTAR, 1 },
+		[CL_CR] = { SLASHSTAR, A_DROP, 0, 0 },
+		[CL_DOT] = { START, A_SPLIT, TSTAR, 1 },
+		[CL_LONE] = { START, A_SPLIT, TSTAR, 1 },
+		[CL_PLUS] = { START, A_SPLIT, TSTAR, 1 },
+		[CL_MINUS] = { START, A_SPLIT, TSTAR, 1 },
+		[CL_STAR] = { ML_COM, A_CLEAR, 0, 0 },
+		[CL_EQUAL] = { START, A_SPLIT, TSTAR, 1 },
+		[CL_LESS] = { START, A_SPLIT, TSTAR, 1 },
+		[CL_GRTR] = { START, A_SPLIT, TSTAR, 1 },
+		[CL_EXCLM] = { START, A_SPLIT, TSTAR, 1 },
+		[CL_QUOTE] = { START, A_SPLIT, TSTAR, 1 },
+		[CL_SLASH] = { START, A_SPLIT, TSTAR, 1 },
+	},
+	[SLASHMINUS] = {
+		[CL_OTHER] = { START, A_SPLIT, TMINS, 1 },
+		[CL_DIGIT] = { START, A_SPLIT, TMINS, 1 },
+		[CL_ALPHA] = { START, A_SPLIT, TMINS, 1 },
+		[CL_BLANK] = { START, A_SPLIT, TMINS, 1 },
+		[CL_NL] = { START, A_SPLIT, TMINS, 1 },
+		[CL_CR] = { SLASHMINUS, A_DROP, 0, 0 },
+		[CL_DOT] = { START, A_SPLIT, TMINS, 1 },
+		[CL_LONE] = { START, A_SPLIT, TMINS, 1 },
+		[CL_PLUS] = { START, A_SPLIT, TMINS, 1 },
+		[CL_MINUS] = { SL_COM, A_CLEAR, 0, 0 },
+		[CL_STAR] = { START, A_SPLIT, TMINS, 1 },
+		[CL_EQUAL] = { START, A_SPLIT, TMINS, 1 },
+		[CL_LESS] = { START, A_SPLIT, TMINS, 1 },
+		[CL_GRTR] = { START, A_SPLIT, TMINS, 1 },
+		[CL_EXCLM] = { START, A_SPLIT, TMINS, 1 },
+		[CL_QUOTE] = { START, A_SPLIT, TMINS, 1 },
+		[CL_SLASH] = { START, A_SPLIT, TMINS, 1 },
+	},
+	[ML_COM] = {
+		[CL_OTHER] = { ML_COM, A_NONE, 0, 0 },
+		[CL_DIGIT] = { ML_COM, A_NONE, 0, 0 },
+		[CL_ALPHA] = { ML_COM, A_NONE, 0, 0 },
+		[CL_BLANK] = { ML_COM, A_NONE, 0, 0 },
+		[CL_NL] = { ML_COM, A_NONE, 0, 0 },
+		[CL_CR] = { ML_COM, A_DROP, 0, 0 },
+		[CL_DOT] = { ML_COM, A_NONE, 0, 0 },
+		[CL_LONE] = { ML_COM, A_NONE, 0, 0 },
+		[CL_PLUS] = { ML_COM, A_NONE, 0, 0 },
+		[CL_MINUS] = { ML_COM, A_NONE, 0, 0 },
+		[CL_STAR] = { ML_COMSTR, A_NONE, 0, 0 },
+		[CL_EQUAL] = { ML_COM, A_NONE, 0, 0 },
+		[CL_LESS] = { ML_COM, A_NONE, 0, 0 },
+		[CL_GRTR] = { ML_COM, A_NONE, 0, 0 },
+		[CL_EXCLM] = { ML_COM, A_NONE, 0, 0 },
+		[CL_QUOTE] = { ML_COM, A_NONE, 0, 0 },
+		[CL_SLASH] = { ML_COM, A_NONE, 0, 0 },
+	},
+	[ML_COMSTR] = {
+		[CL_OTHER] = { ML_COM, A_NONE, 0, 0 },
+		[CL_DIGIT] = { ML_COM, A_NONE, 0, 0 },
+		[CL_ALPHA] = { ML_COM, A_NONE, 0, 0 },
+		[CL_BLANK] = { ML_COM, A_NONE, 0, 0 },
+		[CL_NL] = { ML_COM, A_NONE, 0, 0 },
+		[CL_CR] = { ML_COMSTR, A_DROP, 0, 0 },
+		[CL_DOT] = { ML_COM, A_NONE, 0, 0 },
+		[CL_LONE] = { ML_COM, A_NONE, 0, 0 },
+		[CL_PLUS] = { ML_COM, A_NONE, 0, 0 },
+		[CL_MINUS] = { ML_COM, A_NONE, 0, 0 },
+		[CL_STAR] = { ML_COMSTRSTR, A_NONE, 0, 0 },
+		[CL_EQUAL] = { ML_COM, A_NONE, 0, 0 },
+		[CL_LESS] = { ML_COM, A_NONE, 0, 0 },
+		[CL_GRTR] = { ML_COM, A_NONE, 0, 0 },
+		[CL_EXCLM] = { ML_COM, A_NONE, 0, 0 },
+		[CL_QUOTE] = { ML_COM, A_NONE, 0, 0 },
+		[CL_SLASH] = { ML_COM, A_NONE, 0, 0 },
+	},
+	[ML_COMSTRSTR] = {
+		[CL_OTHER] = { ML_COM, A_NONE, 0, 0 },
+		[CL_DIGIT] = { ML_COM, A_NONE, 0, 0 },
+		[CL_ALPHA] = { ML_COM, A_NONE, 0, 0 },
+		[CL_BLANK] = { ML_COM, A_NONE, 0, 0 },
+		[CL_NL] = { ML_COM, A_NONE, 0, 0 },
+		[CL_CR] = { ML_COMSTRSTR, A_DROP, 0, 0 },
+		[CL_DOT] = { ML_COM, A_NONE, 0, 0 },
+		[CL_LONE] = { ML_COM, A_NONE, 0, 0 },
+		[CL_PLUS] = { ML_COM, A_NONE, 0, 0 },
+		[CL_MINUS] = { ML_COM, A_NONE, 0, 0 },
+		[CL_STAR] = { ML_COM, A_NONE, 0, 0 },
+		[CL_EQUAL] = { ML_COM, A_NONE, 0, 0 },
+		[CL_LESS] = { ML_COM, A_NONE, 0, 0 },
+		[CL_GRTR] = { ML_COM, A_NONE, 0, 0 },
+		[CL_EXCLM] = { ML_COM, A_NONE, 0, 0 },
+		[CL_QUOTE] = { ML_COM, A_NONE, 0, 0 },
+		[CL_SLASH] = { START, A_NONE, 0, 0 },
+	},
+	[SL_COM] = {
+		[CL_OTHER] = { SL_COM, A_NONE, 0, 0 },
+		[CL_DIGIT] = { SL_COM, A_NONE, 0, 0 },
+		[CL_ALPHA] = { SL_COM, A_NONE, 0, 0 },
+		[CL_BLANK] = { SL_COM, A_NONE, 0, 0 },
+		[CL_NL] = { START, A_NONE, 0, 0 },
+		[CL_CR] = { SL_COM, A_DROP, 0, 0 },
+		[CL_DOT] = { SL_COM, A_NONE, 0, 0 },
+		[CL_LONE] = { SL_COM, A_NONE, 0, 0 },
+		[CL_PLUS] = { SL_COM, A_NONE, 0, 0 },
+		[CL_MINUS] = { SL_COM, A_NONE, 0, 0 },
+		[CL_STAR] = { SL_COM, A_NONE, 0, 0 },
+		[CL_EQUAL] = { SL_COM, A_NONE, 0, 0 },
+		[CL_LESS] = { SL_COM, A_NONE, 0, 0 },
+		[CL_GRTR] = { SL_COM, A_NONE, 0, 0 },
+		[CL_EXCLM] = { SL_COM, A_NONE, 0, 0 },
+		[CL_QUOTE] = { SL_COM, A_NONE, 0, 0 },
+		[CL_SLASH] = { SL_COM, A_NONE, 0, 0 },
+	},
+	[ERROR] = {
+		[CL_OTHER] = { ERROR, A_NONE, 0, 0 },
+		[CL_DIGIT] = { START, A_UNKNOWN, 0, 1 },
+		[CL_ALPHA] = { START, A_UNKNOWN, 0, 1 },
+		[CL_BLANK] = { START, A_UNKNOWN, 0, 1 },
+		[CL_NL] = { START, A_UNKNOWN, 0, 1 },
+		[CL_CR] = { ERROR, A_DROP, 0, 0 },
+		[CL_DOT] = { START, A_UNKNOWN, 0, 1 },
+		[CL_LONE] = { START, A_UNKNOWN, 0, 1 },
+		[CL_PLUS] = { START, A_UNKNOWN, 0, 1 },
+		[CL_MINUS] = { START, A_UNKNOWN, 0, 1 },
+		[CL_STAR] = { START, A_UNKNOWN, 0, 1 },
+		[CL_EQUAL] = { START, A_UNKNOWN, 0, 1 },
+		[CL_LESS] = { START, A_UNKNOWN, 0, 1 },
+		[CL_GRTR] = { START, A_UNKNOWN, 0, 1 },
+		[CL_EXCLM] = { START, A_UNKNOWN, 0, 1 },
+		[CL_QUOTE] = { ERROR, A_NONE, 0, 0 },
+		[CL_SLASH] = { START, A_UNKNOWN, 0, 1 },
+	},
+};
+
+#ifdef LEXER_BRANCH_FSM
+// the nested per-state branches the table replaced, kept behind a build flag to benchmark against it
+// (make lexbench), making the same transitions one char at a time
+
+// quickly and concisely check if a char is valid outside of comment/string
+static int valid_char(char ch) {
+	if (isalpha((unsigned char)ch) || isdigit((unsigned char)ch))
+		return 1;
+	switch (ch) {
+		case ',': case ';': case '[': case ']': case '(': case ')':
+		case '=': case '+': case '-': case '*': case '/': case '%':
+		case '^': case '<': case '>': case ':': case '.': case '!':
+		case ' ': case '\t': case '\r': case '\n':
+			return 1;
+		default:
+			return 0;
+	}
+}
+
+// an operator that may be followed by = (+= -= *= ==), its token either way
+static struct transition pre_equal(char ch, enum token_type with_equal, enum token_type alone) {
+	if (ch == '=')
+		return (struct transition){ START, A_TOKEN, with_equal, 0 };
+	return (struct transition){ START, A_TOKEN, alone, 1 };
 }
 
-Token *lexer_get_token(Lexer *lex) {
-	if (!linkedlist_is_empty(lex->tokens)) {
-		return linkedlist_pop_tail(lex->tokens);
+static struct transition branch_transition(enum fsm_state state, char ch) {
+	if (ch == '\r') // dropping carriage returns (🤮)
+		return (struct transition){ state, A_DROP, 0, 0 };
+	switch (state) {
+		case START: // start (nothing in buffer)
+			if (ch == ' ' || ch == '\t' || ch == '\n')
+				return (struct transition){ START, A_NONE, 0, 0 };
+			if (isdigit((unsigned char)ch))
+				return (struct transition){ NUM, A_BEGIN, 0, 0 };
+			if (isalpha((unsigned char)ch))
+				return (struct transition){ ALPHANUM, A_BEGIN, 0, 0 };
+			if (lone_operator(ch) != -1)
+				return (struct transition){ START, A_LONE, 0, 0 };
+			switch (ch) {
+				case '+':
+					return (struct transition){ PRE_PLUS, A_BEGIN, 0, 0 };
+				case '-':
+					return (struct transition){ PRE_MINUS, A_BEGIN, 0, 0 };
+				case '*':
+					return (struct transition){ PRE_STAR, A_BEGIN, 0, 0 };
+				case '=':
+					return (struct transition){ PRE_EQUAL, A_BEGIN, 0, 0 };
+				case '<':
+					return (struct transition){ LESS, A_BEGIN, 0, 0 };
+				case '>':
+					return (struct transition){ GRTR, A_BEGIN, 0, 0 };
+				case '!':
+					return (struct transition){ EXCLM, A_BEGIN, 0, 0 };
+				case '"':
+					return (struct transition){ STRING, A_BEGIN, 0, 0 };
+				case '/':
+					return (struct transition){ SLASH, A_BEGIN, 0, 0 };
+				default:
+					return (struct transition){ ERROR, A_BEGIN, 0, 0 };
+			}
+		case NUM: // numeral
+			if (isdigit((unsigned char)ch))
+				return (struct transition){ NUM, A_NONE, 0, 0 };
+			if (ch == '.')
+				return (struct transition){ NUMDOT, A_NONE, 0, 0 };
+			return (struct transition){ START, A_INT, 0, 1 };
+		case ALPHANUM: // alpha
+			if (isalpha((unsigned char)ch) || isdigit((unsigned char)ch))
+				return (struct transition){ ALPHANUM, A_NONE, 0, 0 };
+			return (struct transition){ START, A_WORD, 0, 1 };
+		case NUMDOT: // dot after numeral
+			if (isdigit((unsigned char)ch))
+				return (struct transition){ FLOAT, A_NONE, 0, 0 };
+			return (struct transition){ START, A_INT_DOT, 0, 1 };
+		case FLOAT: // real literal
+			if (isdigit((unsigned char)ch))
+				return (struct transition){ FLOAT, A_NONE, 0, 0 };
+			return (struct transition){ START, A_REAL, 0, 1 };
+		case PRE_PLUS:
+			return pre_equal(ch, TPLEQ, TPLUS);
+		case PRE_MINUS:
+			return pre_equal(ch, TMNEQ, TMINS);
+		case PRE_STAR:
+			return pre_equal(ch, TSTEQ, TSTAR);
+		case PRE_EQUAL:
+			return pre_equal(ch, TEQEQ, TEQUL);
+		case LESS: // <
+			if (ch == '<')
+				return (struct transition){ START, A_TOKEN, TLSLS, 0 };
+			if (ch == '=')
+				return (struct transition){ START, A_TOKEN, TLEQL, 0 };
+			return (struct transition){ START, A_TOKEN_HERE, TLESS, 1 };
+		case GRTR: // >
+			if (ch == '>')
+				return (struct transition){ START, A_TOKEN, TGRGR, 0 };
+			if (ch == '=')
+				return (struct transition){ START, A_TOKEN, TGEQL, 0 };
+			return (struct transition){ START, A_TOKEN_HERE, TGRTR, 1 };
+		case EXCLM: // !
+			if (ch == '=')
+				return (struct transition){ START, A_TOKEN, TNEQL, 0 };
+			if (!valid_char(ch) || ch == '!')
+				return (struct transition){ ERROR, A_NONE, 0, 0 }; // the ! stays at the start of the lexeme
+			return (struct transition){ START, A_BANG, 0, 1 };
+		case STRING: // "  (string)
+			if (ch == '"')
+				return (struct transition){ START, A_STRING, 0, 0 };
+			if (ch == '\n')
+				return (struct transition){ START, A_UNTERMINATED, 0, 0 };
+			return (struct transition){ STRING, A_NONE, 0, 0 };
+		case SLASH: // /
+			if (ch == '=')
+				return (struct transition){ START, A_TOKEN, TDVEQ, 0 };
+			if (ch == '*')
+				return (struct transition){ SLASHSTAR, A_NONE, 0, 0 };
+			if (ch == '-')
+				return (struct transition){ SLASHMINUS, A_NONE, 0, 0 };
+			return (struct transition){ START, A_TOKEN, TDIVD, 1 };
+		case SLASHSTAR: // /*
+			if (ch == '*')
+				return (struct transition){ ML_COM, A_CLEAR, 0, 0 };
+			return (struct transition){ START, A_SPLIT, TSTAR, 1 };
+		case SLASHMINUS: // /-
+			if (ch == '-')
+				return (struct transition){ SL_COM, A_CLEAR, 0, 0 };
+			return (struct transition){ START, A_SPLIT, TMINS, 1 };
+		case ML_COM: // /** ...  multi line comment
+			return (struct transition){ ch == '*' ? ML_COMSTR : ML_COM, A_NONE, 0, 0 };
+		case ML_COMSTR: // /** ...  *
+			return (struct transition){ ch == '*' ? ML_COMSTRSTR : ML_COM, A_NONE, 0, 0 };
+		case ML_COMSTRSTR: // /** ... **
+			return (struct transition){ ch == '/' ? START : ML_COM, A_NONE, 0, 0 };
+		case SL_COM: // single line comment
+			return (struct transition){ ch == '\n' ? START : SL_COM, A_NONE, 0, 0 };
+		default: // error state
+			if (valid_char(ch))
+				return (struct transition){ START, A_UNKNOWN, 0, 1 };
+			return (struct transition){ ERROR, A_NONE, 0, 0 };
 	}
+}
+#endif
 
-	int ch_int;
-	while (linkedlist_is_empty(lex->tokens) && (ch_int = fgetc(lex->source_file)) != EOF) {
-		char ch = (char) ch_int;
-		// to not add the final \n before EOF to the listing
-		int next = fgetc(lex->source_file);
-		if (next != EOF) {
-			ungetc(next, lex->source_file);
-			lister_write(lex->lister, ch);
-		}
-		if (ch == '\t') {
-			lex->col += 3; // this logic is here because I believe tab is 1 char
-		}
-		if (ch == '\r') { // dropping carriage returns (🤮)
-			continue;
-		}
-		switch(lex->state) {
-			case START: // start (nothing in buffer)
-				start_state: // epsilon transitions
-				if (ch == ' ' || ch == '	' || ch == '\n') {
-					lex->col++;
-					if (ch == '\n') {
-						lex->row++;
-						lex->col = 1;
-					}
-					continue;
-				} else if (isdigit(ch)) { // [0-9]
-					lex->state = NUM;
-					lex->buffer = buffer_append(lex->buffer, ch);
-				} else if (isalpha(ch)) { // [A-Za-z]
-					lex->state = ALPHANUM;
-					lex->buffer = buffer_append(lex->buffer, ch);
-				} else if (lone_operator(ch) != -1) { // [.,[]()%^;:]
-					linkedlist_push_head(lex->tokens, make_token(lone_operator(ch), sdsempty(), lex->row, lex->col));
-				} else { // operator transitions
-					switch (ch) {
-						case '+':
-						case '-':
-						case '*':
-						case '=':
-							lex->state = PRE_EQUAL;
-							lex->buffer = buffer_append(lex->buffer, ch);
-							break;
-						case '<':
-							lex->state = LESS;
-							lex->buffer = buffer_append(lex->buffer, ch);
-							break;
-						case '>':
-							lex->state = GRTR;
-							lex->buffer = buffer_append(lex->buffer, ch);
-							break;
-						case '!':
-							lex->state = EXCLM;
-							lex->buffer = buffer_append(lex->buffer, ch);
-							break;
-						case '"':
-							lex->state = STRING;
-							lex->buffer = buffer_append(lex->buffer, ch);
-							break;
-						case '/':
-							lex->state = SLASH;
-							lex->buffer = buffer_append(lex->buffer, ch);
-							break;
-						default:
-							lex->state = ERROR; // if this line is reached - error
-							lex->buffer = buffer_append(lex->buffer, ch);
-							break;
-					}
-				}
+// runs the FSM until it emits at least one token (or reaches the end)
+static void lex_scan(Lexer *lex) {
+	u32 start_count = lex->tokens.count;
+	int len;
+	union literal lit;
+	while (lex->tokens.count == start_count && lex->cur < lex->end) {
+		const char *pos = lex->cur++;
+		char ch = *pos;
+		u8 cls = byte_class[(unsigned char)ch];
+		lex->col += (ch == '\t') * 3; // tab counts as 4 columns
+		const struct transition *t;
+#ifdef LEXER_BRANCH_FSM
+		struct transition branched;
+		dispatch:
+		branched = branch_transition(lex->state, ch);
+		t = &branched;
+#else
+		dispatch:
+		t = &transitions[lex->state][cls];
+#endif
+		lex->state = t->next;
+		switch (t->action) {
+			case A_NONE:
 				break;
-			case NUM: // numeral
-				if (isdigit(ch)) {
-					lex->buffer = buffer_append(lex->buffer, ch);
-				} else if (ch == '.') {
-					lex->buffer = buffer_append(lex->buffer, ch);
-					lex->state = NUMDOT;
-				} else {
-					errno = 0; // bounds check
-					long long val = strtoll(lex->buffer, NULL, 10);
-					if (errno != ERANGE) {
-						linkedlist_push_head(lex->tokens, make_token(TILIT, sdsdup(lex->buffer), lex->row, lex->col-sdslen(lex->buffer)));
-					} else {
-						lister_lex_error(lex->lister, lex->row, lex->col-sdslen(lex->buffer), "integer literal cannot be converted to a long long");
-						linkedlist_push_head(lex->tokens, make_token(TUNDF, sdsdup(lex->buffer), lex->row, lex->col-sdslen(lex->buffer)));
-					}
-					sdsclear(lex->buffer);
-					lex->state = START;
-					goto start_state;
-				}
+			case A_DROP:
+				if (lex->lexeme)
+					lex->lexeme_crs++;
+				continue;
+			case A_BEGIN:
+				lex->lexeme = (char *)pos;
+				lex->lexeme_crs = 0;
 				break;
-			case ALPHANUM: // alpha
-				if (isalpha(ch) || isdigit(ch)) {
-					lex->buffer = buffer_append(lex->buffer, ch);
-				} else {
-					//if != .to_lower(), else if != "CD25", else if != In,Out,Line
-					lexer_handle_capitalisation_warnings(lex, lex->buffer);
-					int token_type;
-					sds token_val;
-					char *lowercase_buffer = sdsdup(lex->buffer);
-					sdstolower(lowercase_buffer);
-					if (hashmap_contains(lex->keyword_map, lowercase_buffer)) {
-						token_type = *(int *) hashmap_get(lex->keyword_map, lowercase_buffer);
-						token_val = sdsempty();
-					} else {
-						token_type = TIDEN;
-						token_val = sdsdup(lex->buffer);
-					}
-					linkedlist_push_head(lex->tokens, make_token(token_type, token_val, lex->row, lex->col-sdslen(lex->buffer)));
-					sdsfree(lowercase_buffer);
-					sdsclear(lex->buffer);
-					lex->state = START;
-					goto start_state;
-				}
+			case A_CLEAR:
+				lex->lexeme = NULL;
 				break;
-			case NUMDOT: // dot after numeral
-				if (isdigit(ch)) { // match for [0-9]
-					lex->state = FLOAT;
-					lex->buffer = buffer_append(lex->buffer, ch);
-				} else {
-					// queue string until last char
-					sdsrange(lex->buffer, 0, -2);
-					errno = 0; // bounds check
-					long long val = strtoll(lex->buffer, NULL, 10);
-					if (errno != ERANGE) {
-						// the extra -1 is due to some dot funny business? TODO: sort out how I interact with the buffer?
-						linkedlist_push_head(lex->tokens, make_token(TILIT, sdsdup(lex->buffer), lex->row, lex->col-(sdslen(lex->buffer)+1)));
-					} else {
-						lister_lex_error(lex->lister, lex->row, lex->col-(sdslen(lex->buffer)+1), "integer literal cannot be converted to a long long");
-						linkedlist_push_head(lex->tokens, make_token(TUNDF, sdsdup(lex->buffer), lex->row, lex->col-(sdslen(lex->buffer)+1)));
-					}
-					sdsclear(lex->buffer);
-					linkedlist_push_head(lex->tokens, make_token(TDOTT, sdsempty(), lex->row, lex->col));
-					lex->state = START;
-					goto start_state;
-				}
-				break;
-			case FLOAT: // real literal
-				if (isdigit(ch)) {
-					lex->buffer = buffer_append(lex->buffer, ch);
-				} else {
-					errno = 0; // bounds check
-					double val = strtod(lex->buffer, NULL);
-					if (errno != ERANGE) {
-						linkedlist_push_head(lex->tokens, make_token(TFLIT, sdsdup(lex->buffer), lex->row, lex->col-sdslen(lex->buffer)));
-					} else {
-						lister_lex_error(lex->lister, lex->row, lex->col-sdslen(lex->buffer), "real literal cannot be converted to a double");
-						linkedlist_push_head(lex->tokens, make_token(TUNDF, sdsdup(lex->buffer), lex->row, lex->col-sdslen(lex->buffer)));
-					}
-					sdsclear(lex->buffer);
-					lex->state = START;
-					goto start_state;
-				}
-				break;
-			case PRE_EQUAL: // +-*=
-				if (ch == '=') {
-					switch (lex->buffer[0]) {
-						case '+':
-							linkedlist_push_head(lex->tokens, make_token(TPLEQ, sdsempty(), lex->row, lex->col-1));
-							break;
-						case '-':
-							linkedlist_push_head(lex->tokens, make_token(TMNEQ, sdsempty(), lex->row, lex->col-1));
-							break;
-						case '*':
-							linkedlist_push_head(lex->tokens, make_token(TSTEQ, sdsempty(), lex->row, lex->col-1));
-							break;
-						case '=':
-							linkedlist_push_head(lex->tokens, make_token(TEQEQ, sdsempty(), lex->row, lex->col-1));
-							break;
-					}
-					sdsclear(lex->buffer);
-					lex->state = START;
-				} else {
-					switch (lex->buffer[0]) {
-						case '+':
-							linkedlist_push_head(lex->tokens, make_token(TPLUS, sdsempty(), lex->row, lex->col-1));
-							break;
-						case '-':
-							linkedlist_push_head(lex->tokens, make_token(TMINS, sdsempty(), lex->row, lex->col-1));
-							break;
-						case '*':
-							linkedlist_push_head(lex->tokens, make_token(TSTAR, sdsempty(), lex->row, lex->col-1));
-							break;
-						case '=':
-							linkedlist_push_head(lex->tokens, make_token(TEQUL, sdsempty(), lex->row, lex->col-1));
-							break;
-					}
-					sdsclear(lex->buffer);
-					lex->state = START;
-					goto start_state;
-				}
+			case A_LONE:
+				push_token(lex, lone_operator(ch), NULL, 0, lex->col);
 				break;
-			case LESS: // <
-				if (ch == '<') {
-					linkedlist_push_head(lex->tokens, make_token(TLSLS, sdsempty(), lex->row, lex->col-1));
-					sdsclear(lex->buffer);
-					lex->state = START;
-				} else if (ch == '=') {
-					linkedlist_push_head(lex->tokens, make_token(TLEQL, sdsempty(), lex->row, lex->col-1));
-					sdsclear(lex->buffer);
-					lex->state = START;
-				} else {
-					linkedlist_push_head(lex->tokens, make_token(TLESS, sdsempty(), lex->row, lex->col));
-					sdsclear(lex->buffer);
-					lex->state = START;
-					goto start_state;
-				}
+			case A_TOKEN:
+				push_token(lex, t->token, NULL, 0, lex->col-1);
+				lex->lexeme = NULL;
 				break;
-			case GRTR: // >
-				if (ch == '>') {
-					linkedlist_push_head(lex->tokens, make_token(TGRGR, sdsempty(), lex->row, lex->col-1));
-					sdsclear(lex->buffer);
-					lex->state = START;
-				} else if (ch == '=') {
-					linkedlist_push_head(lex->tokens, make_token(TGEQL, sdsempty(), lex->row, lex->col-1));
-					sdsclear(lex->buffer);
-					lex->state = START;
-				} else {
-					linkedlist_push_head(lex->tokens, make_token(TGRTR, sdsempty(), lex->row, lex->col));
-					sdsclear(lex->buffer);
-					lex->state = START;
-					goto start_state;
-				}
+			case A_TOKEN_HERE:
+				push_token(lex, t->token, NULL, 0, lex->col);
+				lex->lexeme = NULL;
 				break;
-			case EXCLM: // !
-				if (ch == '=') {
-					linkedlist_push_head(lex->tokens, make_token(TNEQL, sdsempty(), lex->row, lex->col-1));
-					sdsclear(lex->buffer);
-					lex->state = START;
-				} else {
-					if (!valid_char(ch) || ch == '!') {
-						lex->state = ERROR;
-						lex->buffer = buffer_append(lex->buffer, ch);
-					} else {
-						lister_lex_error(lex->lister, lex->row, lex->col-1, "! is only valid as part of !=");
-						linkedlist_push_head(lex->tokens, make_token(TUNDF, sdsdup(lex->buffer), lex->row, lex->col-1));
-						sdsclear(lex->buffer);
-						lex->state = START;
-						goto start_state;
-					}
-				}
+			case A_SPLIT:
+				push_token(lex, TDIVD, NULL, 0, lex->col-1);
+				push_token(lex, t->token, NULL, 0, lex->col);
+				lex->lexeme = NULL;
 				break;
-			case STRING: // "  (string)
-				if (ch == '"') {
-					sds str_val = sdsdup(lex->buffer);
-					sdsrange(str_val, 1, -1);
-					linkedlist_push_head(lex->tokens, make_token(TSTRG, str_val, lex->row, lex->col-sdslen(lex->buffer)));
-					sdsclear(lex->buffer);
-					lex->state = START;
-				} else if (ch == '\n') {
-					lister_lex_error(lex->lister, lex->row, lex->col-sdslen(lex->buffer), "non-terminated string");
-					linkedlist_push_head(lex->tokens, make_token(TUNDF, sdsdup(lex->buffer), lex->row, lex->col-sdslen(lex->buffer)));
-					sdsclear(lex->buffer);
-					lex->state = START;
+			case A_INT:
+				len = lexeme_len(lex, pos);
+				if (parse_int(lex->lexeme, len, &lit.i)) {
+					push_literal(lex, TILIT, lex->lexeme, len, lex->col-len, lit);
 				} else {
-					lex->buffer = buffer_append(lex->buffer, ch);
+					lister_lex_error(lex->lister, lex->row, lex->col-len, "integer literal cannot be converted to a long long");
+					push_token(lex, TUNDF, lex->lexeme, len, lex->col-len);
 				}
+				lex->lexeme = NULL;
 				break;
-			case SLASH: // /
-				if (ch == '=') {
-					linkedlist_push_head(lex->tokens, make_token(TDVEQ, sdsempty(), lex->row, lex->col-1));
-					sdsclear(lex->buffer);
-					lex->state = START;
-				} else if (ch == '*') {
-					lex->buffer = buffer_append(lex->buffer, ch);
-					lex->state = SLASHSTAR;
-				} else if (ch == '-') {
-					lex->buffer = buffer_append(lex->buffer, ch);
-					lex->state = SLASHMINUS;
+			case A_INT_DOT: // the integer before a dot, then the dot
+				len = lexeme_len(lex, pos) - 1;
+				// the extra -1 is due to some dot funny business? TODO: sort out how I interact with the buffer?
+				if (parse_int(lex->lexeme, len, &lit.i)) {
+					push_literal(lex, TILIT, lex->lexeme, len, lex->col-(len+1), lit);
 				} else {
-					linkedlist_push_head(lex->tokens, make_token(TDIVD, sdsempty(), lex->row, lex->col-1));
-					sdsclear(lex->buffer);
-					lex->state = START;
-					goto start_state;
+					lister_lex_error(lex->lister, lex->row, lex->col-(len+1), "integer literal cannot be converted to a long long");
+					push_token(lex, TUNDF, lex->lexeme, len, lex->col-(len+1));
 				}
+				lex->lexeme = NULL;
+				push_token(lex, TDOTT, NULL, 0, lex->col);
 				break;
-			case SLASHSTAR: // /*
-				if (ch == '*') {
-					sdsclear(lex->buffer);
-					lex->state = ML_COM;
+			case A_REAL:
+				len = lexeme_len(lex, pos);
+				if (parse_real(lex->lexeme, len, &lit.f)) {
+					push_literal(lex, TFLIT, lex->lexeme, len, lex->col-len, lit);
 				} else {
-					linkedlist_push_head(lex->tokens, make_token(TDIVD, sdsempty(), lex->row, lex->col-1));
-					linkedlist_push_head(lex->tokens, make_token(TSTAR, sdsempty(), lex->row, lex->col));
-					sdsclear(lex->buffer);
-					lex->state = START;
-					goto start_state;
+					lister_lex_error(lex->lister, lex->row, lex->col-len, "real literal cannot be converted to a double");
+					push_token(lex, TUNDF, lex->lexeme, len, lex->col-len);
 				}
+				lex->lexeme = NULL;
 				break;
-			case SLASHMINUS: // /-
-				if (ch == '-') {
-					sdsclear(lex->buffer);
-					lex->state = SL_COM;
+			case A_WORD: {
+				len = lexeme_len(lex, pos);
+				enum token_type token_type = keyword_type(lex->lexeme, len);
+				if (token_type != TIDEN) {
+					//if != .to_lower(), else if != "CD25", else if != In,Out,Line
+					lexer_handle_capitalisation_warnings(lex, lex->lexeme, len, token_type);
+					push_token(lex, token_type, NULL, 0, lex->col-len);
 				} else {
-					linkedlist_push_head(lex->tokens, make_token(TDIVD, sdsempty(), lex->row, lex->col-1));
-					linkedlist_push_head(lex->tokens, make_token(TMINS, sdsempty(), lex->row, lex->col));
-					sdsclear(lex->buffer);
-					lex->state = START;
-					goto start_state;
+					push_token(lex, TIDEN, lex->lexeme, len, lex->col-len);
 				}
+				lex->lexeme = NULL;
 				break;
-			case ML_COM: // /** ...  multi line comment
-				if (ch == '*') {
-					lex->state = ML_COMSTR;
-				}
-				break;
-			case ML_COMSTR: // /** ...  *
-				if (ch == '*') {
-					lex->state = ML_COMSTRSTR;
-				} else {
-					lex->state = ML_COM;
-				}
+			}
+			case A_BANG:
+				lister_lex_error(lex->lister, lex->row, lex->col-1, "! is only valid as part of !=");
+				push_token(lex, TUNDF, lex->lexeme, 1, lex->col-1);
+				lex->lexeme = NULL;
 				break;
-			case ML_COMSTRSTR: // /** ... **
-				if (ch == '/') {
-					lex->state = START;
-				} else {
-					lex->state = ML_COM;
-				}
+			case A_STRING: // the value is the span between the quotes
+				len = lexeme_len(lex, pos);
+				push_token(lex, TSTRG, lex->lexeme + 1, len - 1, lex->col-len);
+				lex->lexeme = NULL;
 				break;
-			case SL_COM: // single line comment
-				if (ch == '\n') {
-					lex->state = START;
-				}
+			case A_UNTERMINATED:
+				len = lexeme_len(lex, pos);
+				lister_lex_error(lex->lister, lex->row, lex->col-len, "non-terminated string");
+				push_token(lex, TUNDF, lex->lexeme, len, lex->col-len);
+				lex->lexeme = NULL;
 				break;
-			case ERROR: // error state
-				if (valid_char(ch)) { // TODO: edgecase where !x would produce an extra TUNDF because ! is valid but only before =
-					lister_lex_error(lex->lister, lex->row, lex->col-sdslen(lex->buffer),
-							format_cstr("unknown characters (%s)", lex->buffer)
-					);
-					linkedlist_push_head(lex->tokens, make_token(TUNDF, sdsdup(lex->buffer), lex->row, lex->col - sdslen(lex->buffer)));
-					lex->state = START;
-					sdsclear(lex->buffer);
-					goto start_state;
-				} else {
-					lex->buffer = buffer_append(lex->buffer, ch);
-				}
+			case A_UNKNOWN: { // TODO: edgecase where !x would produce an extra TUNDF because ! is valid but only before =
+				len = lexeme_len(lex, pos);
+				sds unknown = sdsnewlen(lex->lexeme, len);
+				lister_lex_error(lex->lister, lex->row, lex->col-len,
+						format_cstr("unknown characters (%s)", unknown)
+				);
+				sdsfree(unknown);
+				push_token(lex, TUNDF, lex->lexeme, len, lex->col-len);
+				lex->lexeme = NULL;
 				break;
+			}
 		}
+		if (t->retry) // epsilon transition back through START
+			goto dispatch;
 		if (ch == '\n') {
 			lex->row++;
 			lex->col = 1;
 		} else {
 			lex->col++;
 		}
+		// the rest of a run that can't change state or emit anything is skipped in bulk
+		size_t run = 0, tabs = 0;
+		switch (lex->state) {
+			case START:
+				if (cls == CL_BLANK)
+					run = lex->skip->blank(lex->cur, lex->end, &tabs);
+				break;
+			case ALPHANUM:
+				run = lex->skip->alnum(lex->cur, lex->end);
+				break;
+			case NUM:
+			case FLOAT:
+				run = lex->skip->digits(lex->cur, lex->end);
+				break;
+			case ML_COM:
+				run = lex->skip->comment(lex->cur, lex->end, 1, &tabs);
+				break;
+			case SL_COM:
+				run = lex->skip->comment(lex->cur, lex->end, 0, &tabs);
+				break;
+		}
+		lex->cur += run;
+		lex->col += run + 3 * tabs;
+	}
+}
+
+// the next token(s), where the end of the source gives the leftover lexeme or T_EOF
+static void lex_next(Lexer *lex) {
+	u32 start_count = lex->tokens.count;
+	lex_scan(lex);
+	if (lex->tokens.count == start_count) {
+		int len = lexeme_len(lex, lex->cur);
+		if (len != 0) { // if the buffer has material, it's the program name
+			push_token(lex, TIDEN, lex->lexeme, len, lex->col-len);
+			lex->lexeme = NULL;
+		} else {
+			push_token(lex, T_EOF, NULL, 0, lex->col);
+		}
+	}
+}
+
+/*
+  Pipelined lexing: the twin lexes the whole file on its own thread and the parser's side pulls
+  from a bounded single producer/single consumer ring. Lexical errors and warnings travel in the
+  ring just ahead of the tokens lexed with them, so they reach the lister at the same point
+  relative to syntax errors as when lexing on demand.
+*/
+
+#define RING_SIZE 4096 // a power of two
+
+enum ring_kind { RING_TOKEN, RING_WARNING, RING_ERROR };
+
+struct ring_item {
+	enum ring_kind kind;
+	char *msg; // formatted diagnostic (RING_WARNING, RING_ERROR)
+	Token tok;
+};
+
+// head and tail only ever grow (wrapping), each is stored by one side and loaded by the other
+// they live on separate cache lines, along with each side's last look at the other's index
+typedef struct token_ring {
+	u32 head; // producer
+	u32 tail_seen;
+	char pad0[56];
+	u32 tail; // consumer
+	u32 head_seen;
+	char pad1[56];
+	struct ring_item items[RING_SIZE];
+} TokenRing;
+
+static void ring_push(TokenRing *ring, struct ring_item item) {
+	u32 head = ring->head;
+	while (head - ring->tail_seen == RING_SIZE) {
+		ring->tail_seen = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+		if (head - ring->tail_seen == RING_SIZE)
+			sched_yield();
+	}
+	ring->items[head & (RING_SIZE - 1)] = item;
+	__atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+}
+
+static struct ring_item ring_pop(TokenRing *ring) {
+	u32 tail = ring->tail;
+	while (tail == ring->head_seen) {
+		ring->head_seen = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+		if (tail == ring->head_seen)
+			sched_yield();
+	}
+	struct ring_item item = ring->items[tail & (RING_SIZE - 1)];
+	__atomic_store_n(&ring->tail, tail + 1, __ATOMIC_RELEASE);
+	return item;
+}
+
+// the twin's own stream only ever holds the tokens of one lex_next
+static void *lex_thread(void *arg) {
+	Lexer *lex = arg;
+	TokenStream *ts = &lex->tokens;
+	char *msg;
+	do {
+		ts->count = 0;
+		lex_next(lex);
+		while ((msg = lister_pop_warning(lex->lister)))
+			ring_push(lex->ring, (struct ring_item){ .kind = RING_WARNING, .msg = msg });
+		while ((msg = lister_pop_error(lex->lister)))
+			ring_push(lex->ring, (struct ring_item){ .kind = RING_ERROR, .msg = msg });
+		for (u32 i = 0; i < ts->count; i++)
+			ring_push(lex->ring, (struct ring_item){ .kind = RING_TOKEN, .tok = stream_token(lex, i) });
+	} while (ts->type[ts->count-1] != T_EOF);
+	return NULL;
+}
+
+void lexer_run_async(Lexer *lex) {
+	Lexer *twin = malloc(sizeof(Lexer));
+	*twin = *lex;
+	twin->tokens = (TokenStream){ 0 };
+	twin->lister = lister_create(NULL);
+	twin->ring = lex->ring = malloc(sizeof(TokenRing));
+	*lex->ring = (TokenRing){ 0 };
+	lex->twin = twin;
+	if (pthread_create(&lex->thread, NULL, lex_thread, twin) != 0) {
+		fprintf(stderr, "could not start the lexer thread\n");
+		abort();
+	}
+}
+
+// the parser may stop early (fatal syntax error), so whatever the twin still has coming is dropped
+static void lexer_stop_async(Lexer *lex) {
+	TokenStream *ts = &lex->tokens;
+	int done = ts->count && ts->type[ts->count-1] == T_EOF;
+	while (!done) {
+		struct ring_item item = ring_pop(lex->ring);
+		free(item.msg);
+		done = item.kind == RING_TOKEN && item.tok.type == T_EOF;
+	}
+	pthread_join(lex->thread, NULL);
+	stream_free(&lex->twin->tokens);
+	lister_close(lex->twin->lister);
+	free(lex->twin);
+	free(lex->ring);
+}
+
+// takes the next token off the ring, passing on any diagnostics ahead of it
+static void receive_next(Lexer *lex) {
+	for (;;) {
+		struct ring_item item = ring_pop(lex->ring);
+		switch (item.kind) {
+			case RING_WARNING:
+				lister_push_warning(lex->lister, item.msg);
+				break;
+			case RING_ERROR:
+				lister_push_error(lex->lister, item.msg);
+				break;
+			case RING_TOKEN:
+				stream_push(lex, item.tok);
+				return;
+		}
+	}
+}
+
+/*
+  Parallel lexing: the source is cut into chunks just after newlines, each lexed into a stream of
+  its own, then stitched back together. A newline ends any token or string, so past one the FSM
+  is always in START or ML_COM with no lexeme pending, and a chunk only needs that state and its
+  row to start. Those come from skimming the source with the bare state machine (on the calling
+  thread, while the chunks before are already being lexed).
+*/
+
+#ifndef LEX_MIN_CHUNK
+#define LEX_MIN_CHUNK (1 << 20) // bytes, smaller files are lexed on demand
+#endif
+
+struct deferred_msg {
+	u32 token; // handed to the lister when the parser first asks for this token
+	int is_error;
+	char *msg;
+};
+
+struct chunk {
+	Lexer lex; // shares the source, with its own stream, lister and (past the first chunk) string pool
+	int final; // runs into the end of the source
+	struct deferred_msg *msgs;
+	u32 msg_count, msg_cap;
+	pthread_t thread;
+};
+
+static void defer_msg(struct chunk *c, u32 token, int is_error, char *msg) {
+	if (c->msg_count == c->msg_cap) {
+		c->msg_cap = c->msg_cap ? c->msg_cap * 2 : 16;
+		c->msgs = realloc(c->msgs, c->msg_cap * sizeof(*c->msgs));
+	}
+	c->msgs[c->msg_count++] = (struct deferred_msg){ token, is_error, msg };
+}
+
+static void *lex_chunk(void *arg) {
+	struct chunk *c = arg;
+	Lexer *lex = &c->lex;
+	TokenStream *ts = &lex->tokens;
+	char *msg;
+	while (c->final ? !(ts->count && ts->type[ts->count-1] == T_EOF) : lex->cur < lex->end) {
+		u32 first = ts->count; // diagnostics belong to the first token lexed with them
+		if (c->final)
+			lex_next(lex);
+		else
+			lex_scan(lex);
+		while ((msg = lister_pop_warning(lex->lister)))
+			defer_msg(c, first, 0, msg);
+		while ((msg = lister_pop_error(lex->lister)))
+			defer_msg(c, first, 1, msg);
+	}
+	return NULL;
+}
+
+// the bare state machine over [p, end): no tokens or columns, only the state it ends in and the rows
+static enum fsm_state skim(const SkipKernels *skip, const char *p, const char *end, enum fsm_state state, int *row) {
+	size_t tabs;
+	while (p < end) {
+		u8 cls = byte_class[(unsigned char)*p++];
+		const struct transition *t;
+		do {
+			t = &transitions[state][cls];
+			state = t->next;
+		} while (t->retry);
+		*row += cls == CL_NL;
+		switch (state) {
+			case START:
+				if (cls == CL_BLANK)
+					p += skip->blank(p, end, &tabs);
+				break;
+			case ALPHANUM:
+				p += skip->alnum(p, end);
+				break;
+			case NUM:
+			case FLOAT:
+				p += skip->digits(p, end);
+				break;
+			case ML_COM:
+				p += skip->comment(p, end, 1, &tabs);
+				break;
+			case SL_COM:
+				p += skip->comment(p, end, 0, &tabs);
+				break;
+		}
+	}
+	return state;
+}
+
+static void start_chunk(struct chunk *c) {
+	if (pthread_create(&c->thread, NULL, lex_chunk, c) != 0) {
+		fprintf(stderr, "could not start a lexer thread\n");
+		abort();
 	}
-	if (!linkedlist_is_empty(lex->tokens)) {
-		return linkedlist_pop_tail(lex->tokens);
+}
+
+// appends a chunk's stream, moving its ids over to the lexer's pool (in first seen order, as lexing serially would)
+static void stitch_chunk(Lexer *lex, struct chunk *c) {
+	TokenStream *ts = &lex->tokens, *cs = &c->lex.tokens;
+	u32 base = ts->count;
+	memcpy(ts->type + base, cs->type, cs->count * sizeof(*ts->type));
+	memcpy(ts->offset + base, cs->offset, cs->count * sizeof(*ts->offset));
+	memcpy(ts->len + base, cs->len, cs->count * sizeof(*ts->len));
+	memcpy(ts->lit + base, cs->lit, cs->count * sizeof(*ts->lit));
+	memcpy(ts->row + base, cs->row, cs->count * sizeof(*ts->row));
+	memcpy(ts->col + base, cs->col, cs->count * sizeof(*ts->col));
+	if (c->lex.pool == lex->pool) {
+		memcpy(ts->id + base, cs->id, cs->count * sizeof(*ts->id));
 	} else {
-		if (sdslen(lex->buffer) != 0) { // if the buffer has material, it's the program name
-			Token *progname = make_token(TIDEN, sdsdup(lex->buffer), lex->row, lex->col-sdslen(lex->buffer));
-			sdsclear(lex->buffer);
-			return progname;
+		StringPool *pool = c->lex.pool;
+		u32 *to_global = malloc(pool->count * sizeof(u32));
+		for (u32 id = 0; id < pool->count; id++)
+			to_global[id] = stringpool_intern(lex->pool, stringpool_str(pool, id), stringpool_span(pool, id).len);
+		for (u32 i = 0; i < cs->count; i++)
+			ts->id[base + i] = to_global[cs->id[i]];
+		free(to_global);
+		stringpool_free(pool);
+	}
+	ts->count += cs->count;
+	for (u32 m = 0; m < c->msg_count; m++) {
+		c->msgs[m].token += base;
+		lex->deferred[lex->deferred_count++] = c->msgs[m];
+	}
+	free(c->msgs);
+	stream_free(cs);
+	lister_close(c->lex.lister);
+}
+
+int lexer_lex_parallel(Lexer *lex, int threads) {
+	size_t n = lex->source_len / LEX_MIN_CHUNK;
+	if (n > (size_t)threads)
+		n = threads;
+	if (n < 2)
+		return 0;
+	struct chunk *chunks = calloc(n, sizeof(struct chunk));
+	const char *start = lex->source;
+	enum fsm_state state = START;
+	int row = 1;
+	size_t count = 0;
+	while (1) {
+		const char *end = lex->end;
+		if (count < n - 1) { // cut just past the first newline after an even share
+			const char *cut = lex->source + lex->source_len / n * (count + 1);
+			if (cut < start)
+				cut = start;
+			const char *nl = memchr(cut, '\n', lex->end - cut);
+			if (nl)
+				end = nl + 1;
 		}
-		return make_token(T_EOF, sdsempty(), lex->row, lex->col);
+		struct chunk *c = &chunks[count++];
+		c->lex = *lex;
+		c->lex.tokens = (TokenStream){ 0 };
+		c->lex.lister = lister_create(NULL);
+		if (count > 1)
+			c->lex.pool = stringpool_create();
+		c->lex.cur = start;
+		c->lex.end = end;
+		c->lex.state = state;
+		c->lex.row = row;
+		c->lex.col = 1;
+		c->final = end == lex->end;
+		// skimmed before the chunk starts, as lexing squeezes carriage returns out of the source
+		if (!c->final)
+			state = skim(lex->skip, start, end, state, &row);
+		start_chunk(c);
+		if (c->final)
+			break;
+		start = end;
+	}
+	u32 total = 0, msgs = 0;
+	for (size_t k = 0; k < count; k++) {
+		pthread_join(chunks[k].thread, NULL);
+		total += chunks[k].lex.tokens.count;
+		msgs += chunks[k].msg_count;
+	}
+	TokenStream *ts = &lex->tokens;
+	*ts = (TokenStream){ .count = 0, .cap = total };
+	ts->type = malloc(total * sizeof(*ts->type));
+	ts->offset = malloc(total * sizeof(*ts->offset));
+	ts->len = malloc(total * sizeof(*ts->len));
+	ts->lit = malloc(total * sizeof(*ts->lit));
+	ts->id = malloc(total * sizeof(*ts->id));
+	ts->row = malloc(total * sizeof(*ts->row));
+	ts->col = malloc(total * sizeof(*ts->col));
+	if (msgs)
+		lex->deferred = malloc(msgs * sizeof(struct deferred_msg));
+	for (size_t k = 0; k < count; k++)
+		stitch_chunk(lex, &chunks[k]);
+	free(chunks);
+	lex->cur = lex->end;
+	return 1;
+}
+
+// diagnostics lexed ahead of token i go to the lister once the parser gets that far
+static void release_deferred(Lexer *lex, u32 i) {
+	while (lex->deferred_next < lex->deferred_count && lex->deferred[lex->deferred_next].token <= i) {
+		struct deferred_msg *d = &lex->deferred[lex->deferred_next++];
+		if (d->is_error)
+			lister_push_error(lex->lister, d->msg);
+		else
+			lister_push_warning(lex->lister, d->msg);
+	}
+}
+
+// the parser stopped early, so the rest were never reported
+static void drop_deferred(Lexer *lex) {
+	while (lex->deferred_next < lex->deferred_count)
+		free(lex->deferred[lex->deferred_next++].msg);
+	free(lex->deferred);
+}
+
+Token lexer_token_at(Lexer *lex, u32 i) {
+	TokenStream *ts = &lex->tokens;
+	while (i >= ts->count && !(ts->count && ts->type[ts->count-1] == T_EOF)) {
+		if (lex->ring)
+			receive_next(lex);
+		else
+			lex_next(lex);
+	}
+	if (lex->deferred)
+		release_deferred(lex, i);
+	if (i >= ts->count)
+		i = ts->count - 1;
+	return stream_token(lex, i);
+}
+
+/*
+  Editing: the untouched text is kept next to the lexer's copy, along with where each line starts,
+  the FSM state there (a newline leaves it in START or ML_COM, with nothing pending) and the first
+  token lexed from there. An edit re-lexes from the start of its line, one line at a time, until a
+  line start past the edit is reached in the same state as that line was before, from which point
+  the old tokens are reused as they are, moved down by the rows and bytes the edit added.
+*/
+
+void lexer_keep_source(Lexer *lex) {
+	lex->text = malloc(lex->source_len ? lex->source_len : 1);
+	memcpy(lex->text, lex->source, lex->source_len);
+	if (lex->mapped) { // edits resize the source, so it's moved to the heap
+		char *copy = malloc(lex->source_len);
+		memcpy(copy, lex->source, lex->source_len);
+		munmap(lex->source, lex->source_len);
+		lex->cur = copy + (lex->cur - lex->source);
+		lex->source = copy;
+		lex->end = copy + lex->source_len;
+		lex->mapped = 0;
+	}
+}
+
+const char *lexer_text(const Lexer *lex, size_t *len) {
+	*len = lex->source_len;
+	return lex->text;
+}
+
+static void lines_push(LineIndex *li, u32 *cap, u32 start, u32 first_token, int in_comment) {
+	if (li->count == *cap) {
+		*cap = *cap ? *cap * 2 : 256;
+		li->start = realloc(li->start, *cap * sizeof(u32));
+		li->first_token = realloc(li->first_token, *cap * sizeof(u32));
+		li->in_comment = realloc(li->in_comment, *cap);
 	}
+	li->start[li->count] = start;
+	li->first_token[li->count] = first_token;
+	li->in_comment[li->count++] = in_comment;
 }
 
+// the index for the whole text (tokens carry their row, which is the line they start on)
+static void index_lines(Lexer *lex) {
+	LineIndex *li = &lex->lines;
+	TokenStream *ts = &lex->tokens;
+	const char *p = lex->text, *end = lex->text + lex->source_len;
+	enum fsm_state state = START;
+	int row = 1;
+	u32 cap = 0, tok = 0;
+	while (1) {
+		while (tok < ts->count && ts->row[tok] < row)
+			tok++;
+		lines_push(li, &cap, p - lex->text, tok, state != START);
+		const char *nl = memchr(p, '\n', end - p);
+		if (!nl)
+			break;
+		state = skim(lex->skip, p, nl + 1, state, &row);
+		p = nl + 1;
+	}
+}
+
+static void splice(char **buf, size_t size, size_t start, size_t old_len, const char *text, size_t len) {
+	size_t new_size = size - old_len + len;
+	if (new_size > size)
+		*buf = realloc(*buf, new_size);
+	memmove(*buf + start + len, *buf + start + old_len, size - start - old_len);
+	if (len) // text may be NULL for a deletion
+		memcpy(*buf + start, text, len);
+	if (new_size < size)
+		*buf = realloc(*buf, new_size ? new_size : 1);
+}
+
+// last line starting at or before pos
+static u32 line_of(const LineIndex *li, size_t pos) {
+	u32 lo = 0, hi = li->count;
+	while (hi - lo > 1) {
+		u32 mid = lo + (hi - lo) / 2;
+		if (li->start[mid] <= pos)
+			lo = mid;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+
+LexEdit lexer_edit(Lexer *lex, size_t start, size_t old_len, const char *text, size_t len) {
+	TokenStream *ts = &lex->tokens;
+	LineIndex *li = &lex->lines;
+	lexer_token_at(lex, UINT32_MAX);
+	if (!li->count)
+		index_lines(lex);
+
+	// the same splice to both copies, the lexer's is refreshed line by line as it's re-lexed
+	u32 r0 = line_of(li, start);
+	size_t old_size = lex->source_len, new_size = old_size - old_len + len;
+	long delta = (long)new_size - (long)old_size;
+	splice(&lex->text, old_size, start, old_len, text, len);
+	splice(&lex->source, old_size, start, old_len, text, len);
+	lex->source_len = new_size;
+	lex->end = lex->cur = lex->source + new_size;
+
+	Lexer relex = *lex;
+	relex.tokens = (TokenStream){ 0 };
+	relex.lister = lister_create(NULL);
+	relex.cur = lex->source + li->start[r0];
+	relex.state = li->in_comment[r0] ? ML_COM : START;
+	relex.lexeme = NULL;
+	relex.row = r0 + 1;
+	relex.col = 1;
+	LineIndex lines = { 0 };
+	u32 lines_cap = 0;
+	lines_push(&lines, &lines_cap, li->start[r0], 0, li->in_comment[r0]);
+
+	u32 first = li->first_token[r0], old_end = ts->count, old_line = li->count;
+	int diagnostics = 0;
+	char *msg;
+	while (1) {
+		const char *nl = memchr(relex.cur, '\n', lex->end - relex.cur);
+		relex.end = nl ? nl + 1 : lex->end;
+		memcpy((char *)relex.cur, lex->text + (relex.cur - lex->source), relex.end - relex.cur);
+		if (nl) {
+			while (relex.cur < relex.end)
+				lex_scan(&relex);
+		} else { // the last line
+			do
+				lex_next(&relex);
+			while (relex.tokens.type[relex.tokens.count-1] != T_EOF);
+		}
+		while ((msg = lister_pop_warning(relex.lister)) || (msg = lister_pop_error(relex.lister))) {
+			free(msg);
+			diagnostics++;
+		}
+		if (!nl)
+			break;
+		size_t at = relex.cur - lex->source;
+		if ((long)at >= (long)(start + len) && at - delta <= old_size) {
+			u32 r = line_of(li, at - delta);
+			if (li->start[r] == at - delta && li->in_comment[r] == (relex.state != START)) {
+				old_line = r;
+				old_end = li->first_token[r];
+				break;
+			}
+		}
+		lines_push(&lines, &lines_cap, at, relex.tokens.count, relex.state != START);
+	}
+
+	// the new tokens replace [first, old_end), the ones after move over
+	TokenStream *ns = &relex.tokens;
+	u32 tail = ts->count - old_end, at = first + ns->count;
+	int row_delta = (r0 + lines.count) - old_line;
+	stream_reserve(ts, at + tail);
+	memmove(ts->type + at, ts->type + old_end, tail * sizeof(*ts->type));
+	memmove(ts->offset + at, ts->offset + old_end, tail * sizeof(*ts->offset));
+	memmove(ts->len + at, ts->len + old_end, tail * sizeof(*ts->len));
+	memmove(ts->lit + at, ts->lit + old_end, tail * sizeof(*ts->lit));
+	memmove(ts->id + at, ts->id + old_end, tail * sizeof(*ts->id));
+	memmove(ts->row + at, ts->row + old_end, tail * sizeof(*ts->row));
+	memmove(ts->col + at, ts->col + old_end, tail * sizeof(*ts->col));
+	if (ns->count) { // a stream that never grew has no arrays to copy from
+		memcpy(ts->type + first, ns->type, ns->count * sizeof(*ts->type));
+		memcpy(ts->offset + first, ns->offset, ns->count * sizeof(*ts->offset));
+		memcpy(ts->len + first, ns->len, ns->count * sizeof(*ts->len));
+		memcpy(ts->lit + first, ns->lit, ns->count * sizeof(*ts->lit));
+		memcpy(ts->id + first, ns->id, ns->count * sizeof(*ts->id));
+		memcpy(ts->row + first, ns->row, ns->count * sizeof(*ts->row));
+		memcpy(ts->col + first, ns->col, ns->count * sizeof(*ts->col));
+	}
+	for (u32 i = at; i < at + tail; i++) {
+		ts->row[i] += row_delta;
+		if (ts->offset[i]) // 0 is a token without a value
+			ts->offset[i] += delta;
+	}
+	ts->count = at + tail;
+
+	// and the same for the lines
+	u32 line_tail = li->count - old_line, line_at = r0 + lines.count;
+	long token_delta = (long)at - (long)old_end;
+	if (line_at + line_tail > li->count) {
+		li->start = realloc(li->start, (line_at + line_tail) * sizeof(u32));
+		li->first_token = realloc(li->first_token, (line_at + line_tail) * sizeof(u32));
+		li->in_comment = realloc(li->in_comment, line_at + line_tail);
+	}
+	memmove(li->start + line_at, li->start + old_line, line_tail * sizeof(u32));
+	memmove(li->first_token + line_at, li->first_token + old_line, line_tail * sizeof(u32));
+	memmove(li->in_comment + line_at, li->in_comment + old_line, line_tail);
+	for (u32 r = 0; r < lines.count; r++) {
+		li->start[r0 + r] = lines.start[r];
+		li->first_token[r0 + r] = first + lines.first_token[r];
+		li->in_comment[r0 + r] = lines.in_comment[r];
+	}
+	for (u32 r = line_at; r < line_at + line_tail; r++) {
+		li->start[r] += delta;
+		li->first_token[r] += token_delta;
+	}
+	li->count = line_at + line_tail;
+
+	free(lines.start);
+	free(lines.first_token);
+	free(lines.in_comment);
+	stream_free(ns);
+	lister_close(relex.lister);
+	return (LexEdit){ first, old_end, at, old_line + 1, row_delta, diagnostics };
+}
@@ -1,35 +1,90 @@
 #ifndef Lexer_H
 #define Lexer_H
 
+#include <pthread.h>
 #include "lib/sds.h"
-#include "lib/linkedlist.h"
-#include "lib/hashmap.h"
 #include "token.h"
 #include "lister.h"
+#include "lexer_simd.h"
+#include "lib/stringpool.h"
 
 enum fsm_state {
 	START, NUM, ALPHANUM, NUMDOT, FLOAT,
-	PRE_EQUAL, LESS, GRTR, EXCLM, STRING,
+	PRE_PLUS, PRE_MINUS, PRE_STAR, PRE_EQUAL,
+	LESS, GRTR, EXCLM, STRING,
 	SLASH, SLASHSTAR, SLASHMINUS,
 	ML_COM, ML_COMSTR, ML_COMSTRSTR,
 	SL_COM,
-	ERROR
+	ERROR,
+	FSM_STATE_COUNT
 };
 
+// where each line of the source starts, for re-lexing from a line after an edit
+typedef struct line_index {
+	u32 count;
+	u32 *start; // byte offset
+	u32 *first_token; // index of the first token lexed at or after start
+	u8 *in_comment; // the line starts inside a /** **/ comment (the FSM is in START otherwise)
+} LineIndex;
+
+// what an edit did to the token stream: the old tokens [first, old_end) became [first, new_end),
+// and the old tokens after them from old_row on moved down row_delta rows (their columns are unchanged)
+typedef struct lex_edit {
+	u32 first, old_end, new_end;
+	int old_row, row_delta;
+	int diagnostics; // lexical errors or warnings in the new tokens (dropped, as the window isn't reported)
+} LexEdit;
+
 typedef struct lexer {
 	Lister *lister;
-	LinkedList *tokens;
-	FILE *source_file;
+	TokenStream tokens;
+	char *source; // the whole file (mapped, or read in one go)
+	size_t source_len;
+	int mapped;
+	const char *cur, *end; // scanning position
 	enum fsm_state state;
 	int row, col;
-	sds buffer;
-	HashMap *keyword_map;
+	char *lexeme; // start of the lexeme being built (NULL when empty)
+	int lexeme_crs; // carriage returns dropped inside it
+	const SkipKernels *skip;
+	StringPool *pool;
+	// pipelined (lexer_run_async): a twin lexer runs the FSM on its own thread, handing tokens over a ring
+	struct lexer *twin;
+	struct token_ring *ring;
+	pthread_t thread;
+	// lexed up front (lexer_lex_parallel): diagnostics wait for the parser to reach their token
+	struct deferred_msg *deferred;
+	u32 deferred_count, deferred_next;
+	// kept for lexer_edit: the source as written (lexing squeezes carriage returns out of source) and its lines
+	char *text;
+	LineIndex lines;
 } Lexer;
 
-Lexer *lexer_create(const char *source_path, Lister *lister);
+// identifiers (and every other token value) are interned into pool as they are lexed
+Lexer *lexer_create(const char *source_path, Lister *lister, StringPool *pool);
+Lexer *lexer_create_text(const char *text, size_t len, Lister *lister, StringPool *pool);
 void lexer_free(Lexer *lex);
 
-Token *lexer_get_token(Lexer *lex);
+// lexes on demand up to token i (past the end, the T_EOF token is repeated)
+// once running async, tokens (and lexical errors, in the same order as lexing on demand) come off the ring
+Token lexer_token_at(Lexer *lex, u32 i);
+
+// starts lexing the whole source on a second thread (call before the first lexer_token_at)
+// the string pool belongs to that thread until lexer_free
+void lexer_run_async(Lexer *lex);
+
+// lexes the whole source now, in chunks on up to threads threads (call before the first lexer_token_at)
+// returns 0, having done nothing, when the file is too small to be worth splitting
+int lexer_lex_parallel(Lexer *lex, int threads);
+
+// keeps a copy of the untouched source so the lexer can take edits (call before the first lexer_token_at)
+void lexer_keep_source(Lexer *lex);
+// replaces old_len bytes at start with text[0..len), re-lexing from the start of that line only until
+// the new tokens line up with the old ones again (the rest of the stream is shifted, not re-lexed)
+// the whole source is lexed first if it hasn't been
+LexEdit lexer_edit(Lexer *lex, size_t start, size_t old_len, const char *text, size_t len);
+// the source as of the last edit
+const char *lexer_text(const Lexer *lex, size_t *len);
 
 #endif
 
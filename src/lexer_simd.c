@@ -0,0 +1,233 @@
+/*
+  Skips runs of identifier chars, digits, blanks and comment bodies 16/32 bytes at a time
+  the scalar versions finish every tail, and are all that's used off x86
+*/
+#include "lexer_simd.h"
+#include <string.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HAVE_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+static inline int is_alnum(unsigned char ch) {
+	return (unsigned)(ch - '0') < 10 || (unsigned)((ch | 0x20) - 'a') < 26;
+}
+
+static size_t scalar_alnum(const char *p, const char *end) {
+	const char *s = p;
+	while (p < end && is_alnum(*p))
+		p++;
+	return p - s;
+}
+
+static size_t scalar_digits(const char *p, const char *end) {
+	const char *s = p;
+	while (p < end && (unsigned)(*p - '0') < 10)
+		p++;
+	return p - s;
+}
+
+static size_t scalar_blank(const char *p, const char *end, size_t *tabs) {
+	const char *s = p;
+	for (; p < end && (*p == ' ' || *p == '\t'); p++)
+		*tabs += *p == '\t';
+	return p - s;
+}
+
+static size_t scalar_comment(const char *p, const char *end, int stop_at_star, size_t *tabs) {
+	const char *s = p;
+	for (; p < end && *p != '\n' && *p != '\r' && !(stop_at_star && *p == '*'); p++)
+		*tabs += *p == '\t';
+	return p - s;
+}
+
+static const SkipKernels scalar_kernels = {
+	scalar_alnum, scalar_digits, scalar_blank, scalar_comment, "scalar"
+};
+
+#ifdef HAVE_X86_SIMD
+
+#define SSE2 __attribute__((target("sse2"))) // baseline on x86-64, but not on i386
+
+// unsigned "x - lo < n" per byte, by biasing into signed range (SSE2 only has signed compares)
+SSE2 static inline __m128i sse2_in_range(__m128i v, char lo, char n) {
+	__m128i biased = _mm_add_epi8(v, _mm_set1_epi8((char)(0x80 - lo)));
+	return _mm_cmplt_epi8(biased, _mm_set1_epi8((char)(0x80 + n)));
+}
+
+SSE2 static inline __m128i sse2_alnum(__m128i v) {
+	__m128i lower = _mm_or_si128(v, _mm_set1_epi8(0x20));
+	return _mm_or_si128(sse2_in_range(v, '0', 10), sse2_in_range(lower, 'a', 26));
+}
+
+SSE2 static size_t sse2_alnum_run(const char *p, const char *end) {
+	const char *s = p;
+	for (; end - p >= 16; p += 16) {
+		__m128i v = _mm_loadu_si128((const __m128i *)p);
+		unsigned miss = ~_mm_movemask_epi8(sse2_alnum(v)) & 0xFFFF;
+		if (miss)
+			return p - s + __builtin_ctz(miss);
+	}
+	return p - s + scalar_alnum(p, end);
+}
+
+SSE2 static size_t sse2_digits_run(const char *p, const char *end) {
+	const char *s = p;
+	for (; end - p >= 16; p += 16) {
+		__m128i v = _mm_loadu_si128((const __m128i *)p);
+		unsigned miss = ~_mm_movemask_epi8(sse2_in_range(v, '0', 10)) & 0xFFFF;
+		if (miss)
+			return p - s + __builtin_ctz(miss);
+	}
+	return p - s + scalar_digits(p, end);
+}
+
+SSE2 static size_t sse2_blank_run(const char *p, const char *end, size_t *tabs) {
+	const char *s = p;
+	for (; end - p >= 16; p += 16) {
+		__m128i v = _mm_loadu_si128((const __m128i *)p);
+		unsigned tab = _mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('\t')));
+		unsigned space = _mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')));
+		unsigned miss = ~(tab | space) & 0xFFFF;
+		if (miss) {
+			unsigned n = __builtin_ctz(miss);
+			*tabs += __builtin_popcount(tab & ((1u << n) - 1));
+			return p - s + n;
+		}
+		*tabs += __builtin_popcount(tab);
+	}
+	return p - s + scalar_blank(p, end, tabs);
+}
+
+SSE2 static size_t sse2_comment_run(const char *p, const char *end, int stop_at_star, size_t *tabs) {
+	const char *s = p;
+	// a '\n' stands in for '*' when stars don't end the run
+	__m128i star = _mm_set1_epi8(stop_at_star ? '*' : '\n');
+	for (; end - p >= 16; p += 16) {
+		__m128i v = _mm_loadu_si128((const __m128i *)p);
+		__m128i stop = _mm_or_si128(
+			_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\n')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\r'))),
+			_mm_cmpeq_epi8(v, star)
+		);
+		unsigned tab = _mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('\t')));
+		unsigned hit = _mm_movemask_epi8(stop);
+		if (hit) {
+			unsigned n = __builtin_ctz(hit);
+			*tabs += __builtin_popcount(tab & ((1u << n) - 1));
+			return p - s + n;
+		}
+		*tabs += __builtin_popcount(tab);
+	}
+	return p - s + scalar_comment(p, end, stop_at_star, tabs);
+}
+
+static const SkipKernels sse2_kernels = {
+	sse2_alnum_run, sse2_digits_run, sse2_blank_run, sse2_comment_run, "sse2"
+};
+
+#define AVX2 __attribute__((target("avx2")))
+
+AVX2 static inline __m256i avx2_in_range(__m256i v, char lo, char n) {
+	__m256i biased = _mm256_add_epi8(v, _mm256_set1_epi8((char)(0x80 - lo)));
+	return _mm256_cmpgt_epi8(_mm256_set1_epi8((char)(0x80 + n)), biased);
+}
+
+AVX2 static inline __m256i avx2_alnum(__m256i v) {
+	__m256i lower = _mm256_or_si256(v, _mm256_set1_epi8(0x20));
+	return _mm256_or_si256(avx2_in_range(v, '0', 10), avx2_in_range(lower, 'a', 26));
+}
+
+AVX2 static size_t avx2_alnum_run(const char *p, const char *end) {
+	const char *s = p;
+	for (; end - p >= 32; p += 32) {
+		__m256i v = _mm256_loadu_si256((const __m256i *)p);
+		unsigned miss = ~(unsigned)_mm256_movemask_epi8(avx2_alnum(v));
+		if (miss)
+			return p - s + __builtin_ctz(miss);
+	}
+	return p - s + sse2_alnum_run(p, end);
+}
+
+AVX2 static size_t avx2_digits_run(const char *p, const char *end) {
+	const char *s = p;
+	for (; end - p >= 32; p += 32) {
+		__m256i v = _mm256_loadu_si256((const __m256i *)p);
+		unsigned miss = ~(unsigned)_mm256_movemask_epi8(avx2_in_range(v, '0', 10));
+		if (miss)
+			return p - s + __builtin_ctz(miss);
+	}
+	return p - s + sse2_digits_run(p, end);
+}
+
+AVX2 static size_t avx2_blank_run(const char *p, const char *end, size_t *tabs) {
+	const char *s = p;
+	for (; end - p >= 32; p += 32) {
+		__m256i v = _mm256_loadu_si256((const __m256i *)p);
+		unsigned tab = _mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\t')));
+		unsigned space = _mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')));
+		unsigned miss = ~(tab | space);
+		if (miss) {
+			unsigned n = __builtin_ctz(miss);
+			*tabs += __builtin_popcount(tab & ((1u << n) - 1));
+			return p - s + n;
+		}
+		*tabs += __builtin_popcount(tab);
+	}
+	return p - s + sse2_blank_run(p, end, tabs);
+}
+
+AVX2 static size_t avx2_comment_run(const char *p, const char *end, int stop_at_star, size_t *tabs) {
+	const char *s = p;
+	__m256i star = _mm256_set1_epi8(stop_at_star ? '*' : '\n');
+	for (; end - p >= 32; p += 32) {
+		__m256i v = _mm256_loadu_si256((const __m256i *)p);
+		__m256i stop = _mm256_or_si256(
+			_mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\r'))),
+			_mm256_cmpeq_epi8(v, star)
+		);
+		unsigned tab = _mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\t')));
+		unsigned hit = _mm256_movemask_epi8(stop);
+		if (hit) {
+			unsigned n = __builtin_ctz(hit);
+			*tabs += __builtin_popcount(tab & ((1u << n) - 1));
+			return p - s + n;
+		}
+		*tabs += __builtin_popcount(tab);
+	}
+	return p - s + sse2_comment_run(p, end, stop_at_star, tabs);
+}
+
+static const SkipKernels avx2_kernels = {
+	avx2_alnum_run, avx2_digits_run, avx2_blank_run, avx2_comment_run, "avx2"
+};
+
+#endif
+
+const SkipKernels *lexer_simd_kernels(void) {
+	static const SkipKernels *chosen = NULL;
+	if (chosen)
+		return chosen;
+	chosen = &scalar_kernels;
+#ifdef HAVE_X86_SIMD
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2"))
+		chosen = &avx2_kernels;
+	else if (__builtin_cpu_supports("sse2"))
+		chosen = &sse2_kernels;
+#endif
+	return chosen;
+}
+
+const SkipKernels *lexer_simd_kernels_named(const char *name) {
+	if (!strcmp(name, scalar_kernels.name))
+		return &scalar_kernels;
+#ifdef HAVE_X86_SIMD
+	__builtin_cpu_init();
+	if (!strcmp(name, sse2_kernels.name) && __builtin_cpu_supports("sse2"))
+		return &sse2_kernels;
+	if (!strcmp(name, avx2_kernels.name) && __builtin_cpu_supports("avx2"))
+		return &avx2_kernels;
+#endif
+	return NULL;
+}
@@ -0,0 +1,24 @@
+// bulk skipping of byte runs for the lexer (SSE2/AVX2 with a scalar fallback, chosen at runtime)
+
+#ifndef LEXER_SIMD_H
+#define LEXER_SIMD_H
+
+#include <stddef.h>
+
+// each returns the length of the run starting at p (never reading at or past end)
+// tabs counts the tabs inside the run, as they are 4 columns wide
+typedef struct skip_kernels {
+	size_t (*alnum)(const char *p, const char *end); // [A-Za-z0-9]
+	size_t (*digits)(const char *p, const char *end); // [0-9]
+	size_t (*blank)(const char *p, const char *end, size_t *tabs); // spaces and tabs
+	size_t (*comment)(const char *p, const char *end, int stop_at_star, size_t *tabs); // anything up to \n, \r (or *)
+	const char *name;
+} SkipKernels;
+
+// picks the widest kernels the cpu supports (once)
+const SkipKernels *lexer_simd_kernels(void);
+// the kernels called name ("scalar", "sse2" or "avx2"), NULL if there are none by that name or the cpu
+// can't run them (for comparing them against each other)
+const SkipKernels *lexer_simd_kernels_named(const char *name);
+
+#endif
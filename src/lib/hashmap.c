@@ -1,127 +1,139 @@
 #include "hashmap.h"
 #include <stdlib.h>
 
-#include <stdio.h>
+// spreads the caller's hash over the low bits the table indexes by (murmur3's finaliser)
+static inline u32 home(const HashMap *ht, u32 hash) {
+	hash ^= hash >> 16;
+	hash *= 0x85ebca6bu;
+	hash ^= hash >> 13;
+	hash *= 0xc2b2ae35u;
+	hash ^= hash >> 16;
+	return hash & ht->slot_mask;
+}
+
+// how far the entry in slot is from its home
+static inline u32 distance(const HashMap *ht, u32 slot) {
+	return (slot - home(ht, ht->slots[slot].hash)) & ht->slot_mask;
+}
 
-Entry *entry_create(void *key, void *val) {
-	Entry *entry = malloc(sizeof(Entry));
-	if (!entry) return NULL;
-	entry->key = key;
-	entry->val = val;
-	return entry;
+// robin hood: an entry passes those no further from home than it, and takes the slot of the first
+// that is closer (carrying that one on). the one being added goes after equal keys already there,
+// and one carried on stays ahead of them, so equal keys keep the order they were added in
+static void place(HashMap *ht, Entry entry) {
+	u32 slot = home(ht, entry.hash);
+	int carried = 0;
+	for (u32 dist = 0; ht->slots[slot].key; dist++, slot = (slot + 1) & ht->slot_mask) {
+		u32 d = distance(ht, slot);
+		if (d < dist || (carried && d == dist)) {
+			Entry displaced = ht->slots[slot];
+			ht->slots[slot] = entry;
+			entry = displaced;
+			dist = d;
+			carried = 1;
+		}
+	}
+	ht->slots[slot] = entry;
 }
 
-void entry_free(void *ptr, void (*free_key)(void*), void (*free_val)(void*)) {
-	Entry *entry = (Entry *)ptr;
-	free_key(entry->key);
-	free_val(entry->val);
-	free(entry);
+// keeps the load factor under three quarters
+static void grow_slots(HashMap *ht) {
+	Entry *old = ht->slots;
+	u32 old_mask = ht->slot_mask;
+	ht->slot_mask = ht->slot_mask * 2 + 1;
+	ht->slots = calloc(ht->slot_mask + 1, sizeof(Entry));
+	if (!ht->slots) abort();
+	// from just past an empty slot, so each run of entries is placed again in the order it was probed in
+	u32 start = 0;
+	while (old[start].key)
+		start++;
+	for (u32 i = 1; i <= old_mask + 1; i++) {
+		Entry *entry = &old[(start + i) & old_mask];
+		if (entry->key)
+			place(ht, *entry);
+	}
+	free(old);
 }
 
 HashMap *hashmap_create(u32 size, hash_func_t hash_func, equals_func_t equals_func) {
 	HashMap *ht = malloc(sizeof(HashMap));
 	if (!ht) return NULL;
 
-	ht->size = size;
-	ht->table = calloc(size, sizeof(LinkedList*));
-	if (!ht->table) {
+	u32 slots = 8;
+	while (slots / 4 * 3 < size)
+		slots *= 2;
+	ht->slots = calloc(slots, sizeof(Entry));
+	if (!ht->slots) {
 		free(ht);
 		return NULL;
 	}
-
-	for (u32 i = 0; i < size; ++i) {
-		ht->table[i] = linkedlist_create();
-	}
+	ht->slot_mask = slots - 1;
+	ht->count = 0;
 
 	ht->hash_func = hash_func;
 	ht->equals_func = equals_func;
 	return ht;
 }
 
-static void entry_free_with_context(void *entry_ptr, va_list args) {
-	void (*free_key)(void*) = va_arg(args, void (*)(void*));
-	void (*free_val)(void*) = va_arg(args, void (*)(void*));
-
-	Entry *entry = (Entry*)entry_ptr;
-	entry_free(entry, free_key, free_val);
-}
-
 void hashmap_free(HashMap *ht, void (*free_key)(void*), void (*free_val)(void*)) {
 	if (!ht) return;
-	for (u32 i = 0; i < ht->size; ++i) {
-		linkedlist_free_ctx(ht->table[i], entry_free_with_context, free_key, free_val);
+	for (u32 i = 0; i <= ht->slot_mask; ++i) {
+		if (ht->slots[i].key) {
+			free_key(ht->slots[i].key);
+			free_val(ht->slots[i].val);
+		}
 	}
-	free(ht->table);
+	free(ht->slots);
 	free(ht);
 }
 
 void hashmap_add(HashMap *ht, void *key, void *val) {
 	if (!ht || !key) return;
 
-	u32 index = ht->hash_func(key) % ht->size;
-	Entry *entry = entry_create(key, val);
-	linkedlist_push_tail(ht->table[index], entry);
+	if ((ht->count + 1) * 4 > (ht->slot_mask + 1) * 3)
+		grow_slots(ht);
+	place(ht, (Entry){ key, val, ht->hash_func(key) });
+	ht->count++;
 }
 
-int hashmap_contains(const HashMap *ht, void *key) {
-	if (!ht || !key) return 0;
-
-	u32 index = ht->hash_func(key) % ht->size;
-	LinkedList *list = ht->table[index];
-
-	linkedlist_start(list);
-	while (linkedlist_get_current(list) != NULL) {
-		Entry *entry = (Entry *)linkedlist_get_current(list);
-		if (ht->equals_func(entry->key, key)) {
-			return 1;
-		}
-		linkedlist_forward(list);
+// slot of the first entry added with an equal key, or -1
+static long find(const HashMap *ht, const void *key) {
+	u32 hash = ht->hash_func(key);
+	u32 slot = home(ht, hash);
+	for (u32 dist = 0; ht->slots[slot].key; dist++, slot = (slot + 1) & ht->slot_mask) {
+		if (distance(ht, slot) < dist)
+			break; // it would have taken this slot
+		Entry *entry = &ht->slots[slot];
+		if (entry->hash == hash && ht->equals_func(entry->key, key))
+			return slot;
 	}
-	return 0;
+	return -1;
 }
 
-void *hashmap_get(const HashMap *ht, void *key) {
-	if (!ht || !key) return NULL;
-
-	u32 index = ht->hash_func(key) % ht->size;
-	LinkedList *list = ht->table[index];
-
-	linkedlist_start(list);
-	while (linkedlist_get_current(list) != NULL) {
-		Entry *entry = (Entry *)linkedlist_get_current(list);
-		if (ht->equals_func(entry->key, key)) {
-			return entry->val;
-		}
-		linkedlist_forward(list);
-	}
-	return NULL;
+int hashmap_contains(const HashMap *ht, void *key) {
+	if (!ht || !key) return 0;
+	return find(ht, key) >= 0;
 }
 
-LinkedList *hashmap_bucket_at(const HashMap *ht, void *key) {
+void *hashmap_get(const HashMap *ht, void *key) {
 	if (!ht || !key) return NULL;
-	u32 index = ht->hash_func(key) % ht->size;
-	return ht->table[index];
+	long slot = find(ht, key);
+	return slot >= 0 ? ht->slots[slot].val : NULL;
 }
 
 void hashmap_remove(HashMap *ht, void *key, void (*free_key)(void*), void (*free_val)(void*)) {
 	if (!ht || !key) return;
 
-	u32 index = ht->hash_func(key) % ht->size;
-	LinkedList *list = ht->table[index];
-
-	linkedlist_start(list);
-	while (linkedlist_get_current(list) != NULL) {
-		Entry *entry = (Entry *)linkedlist_get_current(list);
-		if (ht->equals_func(entry->key, key)) {
-			Entry *removed = linkedlist_pop_current(list);
-			entry_free(removed, free_key, free_val);
-			return;
-		}
-		linkedlist_forward(list);
-	}
+	long found = find(ht, key);
+	if (found < 0)
+		return;
+	u32 slot = found;
+	free_key(ht->slots[slot].key);
+	free_val(ht->slots[slot].val);
+	// shift the rest of the run back a slot, until an entry already at home (or an empty slot)
+	for (u32 next = (slot + 1) & ht->slot_mask;
+			ht->slots[next].key && distance(ht, next) > 0;
+			slot = next, next = (next + 1) & ht->slot_mask)
+		ht->slots[slot] = ht->slots[next];
+	ht->slots[slot].key = NULL;
+	ht->count--;
 }
-
-// LinkedList *hashtable_get_bucket(HashTable *ht, void *item) {
-// 	return ht->table[ht->hashfunc(item) % ht->size];
-// }
-
@@ -1,3 +1,4 @@
+
 // implementation of a hashmap
 
 #ifndef HASHMAP_H
@@ -5,36 +6,37 @@
 
 #include <stddef.h>
 #include "defs.h"
-#include "linkedlist.h"
 
 // the hash function passed is not modular, size bounding is done by the table
 typedef u32 (*hash_func_t)(const void *key);
 typedef int (*equals_func_t)(const void *a, const void *b);
 
+// a slot of the table, empty when key is NULL
 typedef struct entry {
     void *key;
     void *val;
+    u32 hash; // as given by hash_func, kept so growing and probing don't call it again
 } Entry;
 
-Entry *entry_create(void *key, void *val);
-void entry_free(void *entry, void (*free_key)(void*), void (*free_val)(void*));
-
+// open addressing with robin hood probing: entries sit in order of their home slot,
+// so a lookup stops as soon as it passes where its key would be
 typedef struct hashmap {
-    u32 size;
-    LinkedList **table;
+    u32 count;
+    u32 slot_mask; // slot count - 1 (a power of 2)
+    Entry *slots;
     hash_func_t hash_func;
     equals_func_t equals_func;
 } HashMap;
 
+// size is a hint at the number of entries, the table grows past it as needed
 HashMap *hashmap_create(u32 size, hash_func_t hash_func, equals_func_t equals_func);
 void hashmap_free(HashMap *ht, void (*free_key)(void*), void (*free_val)(void*));
 
+// does not replace an equal key already there, hashmap_get keeps finding the first one added
 void hashmap_add(HashMap *ht, void *key, void *val);
 void hashmap_remove(HashMap *ht, void *key, void (*free_key)(void*), void (*free_val)(void*));
 
 int hashmap_contains(const HashMap *ht, void *key);
 void *hashmap_get(const HashMap *ht, void *key);
-LinkedList *hashmap_bucket_at(const HashMap *ht, void *key);
 
 #endif
-
@@ -4,7 +4,6 @@
 // Constructor
 LinkedList *linkedlist_create(void) {
 	LinkedList *list = malloc(sizeof(LinkedList));
-	list->current = NULL;
 	list->head = NULL;
 	list->tail = NULL;
 	return list;
@@ -66,63 +65,11 @@ void linkedlist_push_head(LinkedList *list, void *item) {
 	list->head = new_node;
 }
 
-// Move current forward
-void linkedlist_forward(LinkedList *list) {
-	if (list->current != NULL /*&& list->current != list->tail*/) {
-		list->current = list->current->next;
-	}
-}
-
-// Move current back
-void linkedlist_back(LinkedList *list) {
-	if (list->current != NULL /*&& list->current != list->head*/) {
-		list->current = list->current->prev;
-	}
-}
-
-// Move current to head
-void linkedlist_start(LinkedList *list) {
-	list->current = list->head;
-}
-
-// Move current to tail
-void linkedlist_end(LinkedList *list) {
-	list->current = list->tail;
-}
-
-// Get current data
-void *linkedlist_get_current(const LinkedList *list) {
-	return (list->current != NULL) ? list->current->data : NULL;
-}
-
 // Check if empty
 int linkedlist_is_empty(const LinkedList *list) {
 	return list->head == NULL;
 }
 
-// Remove from current
-void *linkedlist_pop_current(LinkedList *list) {
-	if (list->current == NULL) return NULL;
-
-	if (list->current == list->head) {
-		return linkedlist_pop_head(list);
-	} else if (list->current == list->tail) {
-		return linkedlist_pop_tail(list);
-	}
-
-	LLNode *left = list->current->prev;
-	LLNode *right = list->current->next;
-	void *data = list->current->data;
-
-	left->next = right;
-	right->prev = left;
-
-	free(list->current);
-	list->current = left;
-
-	return data;
-}
-
 // Remove from head
 void *linkedlist_pop_head(LinkedList *list) {
 	if (list->head == NULL) return NULL;
@@ -139,7 +86,6 @@ void *linkedlist_pop_head(LinkedList *list) {
 		list->tail = NULL;
 	}
 
-	list->current = list->head;
 	return data;
 }
 
@@ -159,18 +105,12 @@ void *linkedlist_pop_tail(LinkedList *list) {
 		list->head = NULL;
 	}
 
-	list->current = list->tail;
 	return data;
 }
 
-int linkedlist_len(LinkedList *list) {
-	LLNode *cur = list->current;
+int linkedlist_len(const LinkedList *list) {
 	int res = 0;
-	linkedlist_start(list);
-	while (linkedlist_get_current(list)) {
+	for (LLNode *cur = list->head; cur; cur = cur->next)
 		++res;
-		linkedlist_forward(list);
-	}
-	list->current = cur;
 	return res;
 }
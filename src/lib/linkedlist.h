@@ -13,9 +13,14 @@ typedef struct llnode {
 typedef struct linkedlist {
     LLNode *head;
     LLNode *tail;
-    LLNode *current;
 } LinkedList;
 
+// a position in a list, held by whoever is walking it rather than the list,
+// so reading a list never writes to it and any number of walks can share one
+typedef struct lliter {
+    LLNode *node;
+} LLIter;
+
 // Constructor/Destructor
 LinkedList *linkedlist_create(void);
 void linkedlist_free(LinkedList *list);
@@ -26,23 +31,28 @@ void linkedlist_free_ctx(LinkedList *list, void (*free_data)(void*, va_list), ..
 void linkedlist_push_head(LinkedList *list, void *item);
 void linkedlist_push_tail(LinkedList *list, void *item);
 
-// Navigation
-void linkedlist_forward(LinkedList *list);
-void linkedlist_back(LinkedList *list);
-void linkedlist_start(LinkedList *list);
-void linkedlist_end(LinkedList *list);
+// Iteration
+static inline LLIter linkedlist_iter(const LinkedList *list) {
+    return (LLIter){ list->head };
+}
+// NULL once past the end
+static inline void *lliter_get(LLIter it) {
+    return it.node ? it.node->data : NULL;
+}
+static inline void lliter_next(LLIter *it) {
+    if (it->node)
+        it->node = it->node->next;
+}
 
 // Access
-void *linkedlist_get_current(const LinkedList *list);
 int linkedlist_is_empty(const LinkedList *list);
 
 // Removal
 void *linkedlist_pop_head(LinkedList *list);
 void *linkedlist_pop_tail(LinkedList *list);
-void *linkedlist_pop_current(LinkedList *list);
 
 // Misc
-int linkedlist_len(LinkedList *list);
+int linkedlist_len(const LinkedList *list);
 
 #endif
 
@@ -0,0 +1,72 @@
+#include "stringpool.h"
+#include <stdlib.h>
+#include <string.h>
+
+// FNV-1a
+static u32 hash_bytes(const char *str, size_t len) {
+	u32 hash = 2166136261u;
+	for (size_t i = 0; i < len; i++) {
+		hash ^= (unsigned char)str[i];
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+static void place(StringPool *pool, u32 id) {
+	struct sindex span = pool->spans[id];
+	u32 slot = hash_bytes(pool->text + span.start, span.len) & pool->slot_mask;
+	while (pool->slots[slot])
+		slot = (slot + 1) & pool->slot_mask;
+	pool->slots[slot] = id + 1;
+}
+
+// keeps the load factor under a half
+static void grow_slots(StringPool *pool) {
+	free(pool->slots);
+	pool->slot_mask = pool->slot_mask * 2 + 1;
+	pool->slots = calloc(pool->slot_mask + 1, sizeof(u32));
+	for (u32 id = 0; id < pool->count; id++)
+		place(pool, id);
+}
+
+StringPool *stringpool_create(void) {
+	StringPool *pool = malloc(sizeof(StringPool));
+	pool->text = sdsempty();
+	pool->count = 0;
+	pool->cap = 64;
+	pool->spans = malloc(pool->cap * sizeof(struct sindex));
+	pool->slot_mask = 127;
+	pool->slots = calloc(pool->slot_mask + 1, sizeof(u32));
+	stringpool_intern(pool, "", 0);
+	return pool;
+}
+
+void stringpool_free(StringPool *pool) {
+	sdsfree(pool->text);
+	free(pool->spans);
+	free(pool->slots);
+	free(pool);
+}
+
+u32 stringpool_intern(StringPool *pool, const char *str, size_t len) {
+	u32 slot = hash_bytes(str, len) & pool->slot_mask;
+	u32 entry;
+	while ((entry = pool->slots[slot])) {
+		struct sindex span = pool->spans[entry - 1];
+		if (span.len == len && memcmp(pool->text + span.start, str, len) == 0)
+			return entry - 1;
+		slot = (slot + 1) & pool->slot_mask;
+	}
+	if (pool->count == pool->cap) {
+		pool->cap *= 2;
+		pool->spans = realloc(pool->spans, pool->cap * sizeof(struct sindex));
+	}
+	u32 id = pool->count++;
+	pool->spans[id] = (struct sindex){ sdslen(pool->text), len };
+	pool->text = sdscatlen(pool->text, str, len);
+	if (pool->count * 2 > pool->slot_mask + 1)
+		grow_slots(pool);
+	else
+		pool->slots[slot] = id + 1;
+	return id;
+}
@@ -0,0 +1,54 @@
+// interns strings into one buffer, handing out dense u32 ids
+
+#ifndef STRINGPOOL_H
+#define STRINGPOOL_H
+
+#include <stddef.h>
+#include <string.h>
+#include "defs.h"
+#include "sds.h"
+
+// where a string lives in the pool's text
+struct sindex {
+	size_t start;
+	size_t len;
+};
+
+typedef struct stringpool {
+	sds text; // every interned string back to back
+	struct sindex *spans; // id -> span of text
+	u32 count;
+	u32 cap;
+	u32 *slots; // open addressing over ids, storing id+1 (0 is an empty slot)
+	u32 slot_mask; // slot count - 1 (a power of 2)
+} StringPool;
+
+// id 0 is always the empty string
+StringPool *stringpool_create(void);
+void stringpool_free(StringPool *pool);
+
+u32 stringpool_intern(StringPool *pool, const char *str, size_t len);
+
+static inline struct sindex stringpool_span(const StringPool *pool, u32 id) {
+	return pool->spans[id];
+}
+static inline const char *stringpool_str(const StringPool *pool, u32 id) {
+	return pool->text + pool->spans[id].start;
+}
+
+// a string borrowed from where it already lives, not NUL terminated (print it with "%.*s")
+typedef struct strview {
+	const char *str;
+	u32 len;
+} StrView;
+
+// good until the pool next grows (so for as long as the tree, once lexing is done)
+static inline StrView stringpool_view(const StringPool *pool, u32 id) {
+	return (StrView){ pool->text + pool->spans[id].start, pool->spans[id].len };
+}
+
+static inline int strview_equals(StrView view, const char *str) {
+	return strncmp(view.str, str, view.len) == 0 && str[view.len] == '\0';
+}
+
+#endif
@@ -0,0 +1,67 @@
+#include "u64map.h"
+#include <stdlib.h>
+
+// murmur3's 64-bit finaliser, so keys differing only in high bits (like doubles) still spread
+static inline u32 home(const U64Map *map, u64 key) {
+	key ^= key >> 33;
+	key *= 0xff51afd7ed558ccdull;
+	key ^= key >> 33;
+	key *= 0xc4ceb9fe1a85ec53ull;
+	key ^= key >> 33;
+	return (u32)key & map->slot_mask;
+}
+
+// keeps the load factor under a half
+static void grow_slots(U64Map *map) {
+	u64 *old_keys = map->keys;
+	u32 *old_vals = map->vals;
+	u32 old_mask = map->slot_mask;
+	map->slot_mask = map->slot_mask * 2 + 1;
+	map->keys = malloc((map->slot_mask + 1) * sizeof(u64));
+	map->vals = calloc(map->slot_mask + 1, sizeof(u32));
+	if (!map->keys || !map->vals) abort();
+	for (u32 i = 0; i <= old_mask; i++) {
+		if (!old_vals[i])
+			continue;
+		u32 slot = home(map, old_keys[i]);
+		while (map->vals[slot])
+			slot = (slot + 1) & map->slot_mask;
+		map->keys[slot] = old_keys[i];
+		map->vals[slot] = old_vals[i];
+	}
+	free(old_keys);
+	free(old_vals);
+}
+
+U64Map *u64map_create(u32 size) {
+	U64Map *map = malloc(sizeof(U64Map));
+	u32 slots = 16;
+	while (slots / 2 < size)
+		slots *= 2;
+	map->slot_mask = slots - 1;
+	map->count = 0;
+	map->keys = malloc(slots * sizeof(u64));
+	map->vals = calloc(slots, sizeof(u32));
+	if (!map->keys || !map->vals) abort();
+	return map;
+}
+
+void u64map_free(U64Map *map) {
+	if (!map) return;
+	free(map->keys);
+	free(map->vals);
+	free(map);
+}
+
+u32 u64map_intern(U64Map *map, u64 key, u32 val) {
+	u32 slot = home(map, key);
+	for (; map->vals[slot]; slot = (slot + 1) & map->slot_mask) {
+		if (map->keys[slot] == key)
+			return map->vals[slot] - 1;
+	}
+	map->keys[slot] = key;
+	map->vals[slot] = val + 1;
+	if (++map->count * 2 > map->slot_mask + 1)
+		grow_slots(map);
+	return val;
+}
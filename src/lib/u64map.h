@@ -0,0 +1,23 @@
+// maps 64-bit keys to u32 values, both held in the table (so adding or finding one doesn't allocate)
+// numbers are keyed by their bits, which makes a double's identity exact
+
+#ifndef U64MAP_H
+#define U64MAP_H
+
+#include "defs.h"
+
+typedef struct u64map {
+	u64 *keys;
+	u32 *vals; // value + 1 (0 is an empty slot)
+	u32 count;
+	u32 slot_mask; // slot count - 1 (a power of 2)
+} U64Map;
+
+// size is a hint at the number of keys, the table grows past it as needed
+U64Map *u64map_create(u32 size);
+void u64map_free(U64Map *map);
+
+// the value key already has, or val after giving it that (val must be under UINT32_MAX)
+u32 u64map_intern(U64Map *map, u64 key, u32 val);
+
+#endif
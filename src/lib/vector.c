@@ -0,0 +1,28 @@
+#include "vector.h"
+#include <stdlib.h>
+#include <string.h>
+
+Vector *vector_create(u32 item_size) {
+	Vector *vec = malloc(sizeof(Vector));
+	vec->count = 0;
+	vec->cap = 16;
+	vec->item_size = item_size;
+	vec->items = malloc((size_t)vec->cap * item_size);
+	return vec;
+}
+
+void vector_free(Vector *vec) {
+	free(vec->items);
+	free(vec);
+}
+
+void *vector_push(Vector *vec, const void *item) {
+	if (vec->count == vec->cap) {
+		vec->cap *= 2;
+		vec->items = realloc(vec->items, (size_t)vec->cap * vec->item_size);
+		if (!vec->items) abort();
+	}
+	void *slot = vector_at(vec, vec->count++);
+	memcpy(slot, item, vec->item_size);
+	return slot;
+}
@@ -0,0 +1,31 @@
+// growable array holding its items by value, back to back
+
+#ifndef VECTOR_H
+#define VECTOR_H
+
+#include <stddef.h>
+#include "defs.h"
+
+typedef struct vector {
+	void *items;
+	u32 count;
+	u32 cap;
+	u32 item_size;
+} Vector;
+
+Vector *vector_create(u32 item_size);
+// the items go with it, anything they point to is the caller's
+void vector_free(Vector *vec);
+
+// copies item in at the end, returning where it now lives (good until the next push)
+void *vector_push(Vector *vec, const void *item);
+
+static inline void *vector_at(const Vector *vec, u32 i) {
+	return (char *)vec->items + (size_t)i * vec->item_size;
+}
+
+static inline u32 vector_len(const Vector *vec) {
+	return vec->count;
+}
+
+#endif
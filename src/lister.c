@@ -6,16 +6,10 @@
 
 void lister_print_to_terminal(Lister *lister) {
 	char *msg;
-	linkedlist_start(lister->warning_queue);
-	while (msg = (char *)linkedlist_get_current(lister->warning_queue)) {
+	for (LLIter it = linkedlist_iter(lister->warning_queue); (msg = lliter_get(it)); lliter_next(&it))
 		printf("%s", msg);
-		linkedlist_forward(lister->warning_queue);
-	}
-	linkedlist_start(lister->error_queue);
-	while (msg = (char *)linkedlist_get_current(lister->error_queue)) {
+	for (LLIter it = linkedlist_iter(lister->error_queue); (msg = lliter_get(it)); lliter_next(&it))
 		printf("%s", msg);
-		linkedlist_forward(lister->error_queue);
-	}
 }
 
 Lister *lister_create(const char *filename) {
@@ -70,11 +64,28 @@ void lister_write(Lister *lstr, char ch) {
 	// if you wanted listing file to have inline errors, here is where they would be printed
 }
 
-int int_len(u16 num) {
+// writes a run of source in one go, numbering each line after a '\n'
+void lister_write_source(Lister *lstr, const char *src, size_t len) {
+	if (!lstr->out_file)
+		return;
+	const char *end = src + len;
+	while (src < end) {
+		const char *nl = memchr(src, '\n', end - src);
+		if (!nl) {
+			fwrite(src, 1, end - src, lstr->out_file);
+			return;
+		}
+		fwrite(src, 1, nl + 1 - src, lstr->out_file);
+		fprintf(lstr->out_file, "%d ", ++(lstr->line_num));
+		src = nl + 1;
+	}
+}
+
+int int_len(u32 num) {
     if (num == 0) return 1;
 
     int length = 0;
-    int n = num;
+    u32 n = num;
 
     do {
         length++;
@@ -84,33 +95,48 @@ int int_len(u16 num) {
     return length;
 }
 
-void lister_lex_warn(Lister *lstr, u16 row, u16 col, char *msg) {
+void lister_lex_warn(Lister *lstr, u32 row, u32 col, char *msg) {
 	char *warning = malloc(23 + int_len(row) + int_len(col) + strlen(msg));
-	sprintf(warning, "Lexical warning (%d:%d): %s\n", row, col, msg);
+	sprintf(warning, "Lexical warning (%u:%u): %s\n", row, col, msg);
 	linkedlist_push_tail(lstr->warning_queue, warning);
 }
 
-void lister_lex_error(Lister *lstr, u16 row, u16 col, char *msg) {
+void lister_lex_error(Lister *lstr, u32 row, u32 col, char *msg) {
 	char *error = malloc(21 + int_len(row) + int_len(col) + strlen(msg));
-	sprintf(error, "Lexical error (%d:%d): %s\n", row, col, msg);
+	sprintf(error, "Lexical error (%u:%u): %s\n", row, col, msg);
 	linkedlist_push_tail(lstr->error_queue, error);
 }
 
-void lister_syn_warn(Lister *lstr, u16 row, u16 col, char *msg) {
+void lister_syn_warn(Lister *lstr, u32 row, u32 col, char *msg) {
 	char *warning = malloc(22 + int_len(row) + int_len(col) + strlen(msg));
-	sprintf(warning, "Syntax warning (%d:%d): %s\n", row, col, msg);
+	sprintf(warning, "Syntax warning (%u:%u): %s\n", row, col, msg);
 	linkedlist_push_tail(lstr->warning_queue, warning);
 }
 
-void lister_syn_error(Lister *lstr, u16 row, u16 col, char *msg) {
+void lister_syn_error(Lister *lstr, u32 row, u32 col, char *msg) {
 	char *error = malloc(20 + int_len(row) + int_len(col) + strlen(msg));
-	sprintf(error, "Syntax error (%d:%d): %s\n", row, col, msg);
+	sprintf(error, "Syntax error (%u:%u): %s\n", row, col, msg);
 	linkedlist_push_tail(lstr->error_queue, error);
 }
 
-void lister_sem_error(Lister *lstr, u16 row, u16 col, char *msg) {
+void lister_sem_error(Lister *lstr, u32 row, u32 col, char *msg) {
 	char *error = malloc(22 + int_len(row) + int_len(col) + strlen(msg));
-	sprintf(error, "Semantic error (%d:%d): %s\n", row, col, msg);
+	sprintf(error, "Semantic error (%u:%u): %s\n", row, col, msg);
 	linkedlist_push_tail(lstr->error_queue, error);
 }
 
+char *lister_pop_warning(Lister *lstr) {
+	return linkedlist_pop_head(lstr->warning_queue);
+}
+
+char *lister_pop_error(Lister *lstr) {
+	return linkedlist_pop_head(lstr->error_queue);
+}
+
+void lister_push_warning(Lister *lstr, char *msg) {
+	linkedlist_push_tail(lstr->warning_queue, msg);
+}
+
+void lister_push_error(Lister *lstr, char *msg) {
+	linkedlist_push_tail(lstr->error_queue, msg);
+}
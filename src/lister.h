@@ -10,7 +10,7 @@
 
 typedef struct lister {
 	FILE *out_file;
-	u16 line_num;
+	u32 line_num;
 	LinkedList *warning_queue;
 	LinkedList *error_queue;
 } Lister;
@@ -19,13 +19,20 @@ Lister *lister_create(const char *filename);
 void lister_close(Lister *lst);
 
 void lister_write(Lister *lst, char ch);
-void lister_lex_warn(Lister *lst, u16 row, u16 col, char *msg);
-void lister_lex_error(Lister *lst, u16 row, u16 col, char *msg);
+void lister_write_source(Lister *lst, const char *src, size_t len);
+void lister_lex_warn(Lister *lst, u32 row, u32 col, char *msg);
+void lister_lex_error(Lister *lst, u32 row, u32 col, char *msg);
 
-void lister_syn_warn(Lister *lst, u16 row, u16 col, char *msg);
-void lister_syn_error(Lister *lst, u16 row, u16 col, char *msg);
+void lister_syn_warn(Lister *lst, u32 row, u32 col, char *msg);
+void lister_syn_error(Lister *lst, u32 row, u32 col, char *msg);
 
-void lister_sem_error(Lister *lst, u16 row, u16 col, char *msg);
+void lister_sem_error(Lister *lst, u32 row, u32 col, char *msg);
+
+// hand over already formatted messages (the lexer thread queues into a lister of its own)
+char *lister_pop_warning(Lister *lst);
+char *lister_pop_error(Lister *lst);
+void lister_push_warning(Lister *lst, char *msg);
+void lister_push_error(Lister *lst, char *msg);
 
 void lister_print_to_terminal(Lister *lister);
 
@@ -1,22 +1,17 @@
+#define _POSIX_C_SOURCE 200809L // clock_gettime, strdup
 #include "parser.h"
 #include "semantic_analysis.h"
 #include "sm25_codegen/sm25_code_generation.h"
 #include "x86_codegen/x86_code_generation.h"
 #include "threeaddresscode.h"
+#include "cfg.h"
+#include "ssa.h"
 #include "lister.h"
 #include <stdlib.h>
 #include <libgen.h>
 #include <string.h>
 #include <unistd.h> // getcwd()
-
-static char* strdup(const char* s) {
-	size_t len = strlen(s) + 1;
-	char* dup = malloc(len);
-	if (dup) {
-		memcpy(dup, s, len);
-	}
-	return dup;
-}
+#include <time.h>
 
 /* todos:
    destructor for attribute
@@ -59,6 +54,10 @@ char *asm_filename(char *out_path, char *source_path) {
 	return full_asm_path;
 }
 
+static double elapsed_ms(const struct timespec *from, const struct timespec *to) {
+	return (to->tv_sec - from->tv_sec) * 1e3 + (to->tv_nsec - from->tv_nsec) / 1e6;
+}
+
 enum arch {
 	X86_LINUX,
 	SM25,
@@ -69,14 +68,19 @@ enum arch {
 
 #define OPTIONAL_ARGS \
 	OPTIONAL_STRING_ARG(out_path, "", "-o", "out_file", "Output filepath") \
-	OPTIONAL_STRING_ARG(arch, "x86", "-a", "arch", "Architecture [x86|sm25]")
+	OPTIONAL_STRING_ARG(arch, "x86", "-a", "arch", "Architecture [x86|sm25]") \
+	OPTIONAL_UINT_ARG(lex_threads, 1, "-j", "threads", "Lex large (1MB+) sources in parallel chunks on this many threads")
 
 #define BOOLEAN_ARGS \
 	BOOLEAN_ARG(debug, "-g", "Emit debugging symbols in asm (WIP)") \
 	BOOLEAN_ARG(print_tac, "-T", "Print TAC to stdout and stop compilation") \
+	BOOLEAN_ARG(print_cfg, "-G", "Print each function's TAC as a control-flow graph to stdout and stop compilation") \
+	BOOLEAN_ARG(through_ssa, "-O", "Take TAC into SSA form and back out before generating x86 (with -T or -G, print that)") \
 	BOOLEAN_ARG(print_ast, "-A", "Print AST to stdout and stop compilation") \
 	BOOLEAN_ARG(readable_sm25, "-S", "Print SM25 opcodes to stdout and stop compilation") \
 	BOOLEAN_ARG(make_listing, "-l", "Produce listing file next to output path") \
+	BOOLEAN_ARG(pipeline_lexer, "-p", "Lex on a separate thread while parsing") \
+	BOOLEAN_ARG(time_frontend, "-t", "Print front end (lex, parse, semantic) wall time to stderr") \
 	BOOLEAN_ARG(help, "-h", "Show help")
 
 #include "lib/easyargs.h"
@@ -104,7 +108,7 @@ int main(int argc, char **argv) {
 	if (args.readable_sm25) {
 		args.arch = "sm25";
 	}
-	if (args.print_tac) {
+	if (args.print_tac || args.print_cfg) {
 		args.arch = "x86";
 	}
 
@@ -132,8 +136,17 @@ int main(int argc, char **argv) {
 	Lister *lister = lister_create(full_ls_path);
 	free(full_ls_path);
 
-	ASTree *ast = get_AST(args.in_file, lister);
+	struct timespec start, parsed, analysed;
+	const char *lexed_as;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	ASTree *ast = get_AST(args.in_file, lister, args.pipeline_lexer, args.lex_threads, &lexed_as);
+	clock_gettime(CLOCK_MONOTONIC, &parsed);
 	analyse_program(ast, lister);
+	clock_gettime(CLOCK_MONOTONIC, &analysed);
+	if (args.time_frontend) {
+		fprintf(stderr, "front end: lex+parse %.3f ms, semantic %.3f ms (%s lexer)\n",
+			elapsed_ms(&start, &parsed), elapsed_ms(&parsed, &analysed), lexed_as);
+	}
 	if (args.print_ast && ast->is_valid) {
 		astree_printf(ast);
 		return 0;
@@ -144,11 +157,21 @@ int main(int argc, char **argv) {
 
 	char *filepath = NULL;
 	if (ast->is_valid) {
-		tac = tac_from_ast(ast);
+		TAC *tac = tac_from_ast(ast);
+		if (args.through_ssa && args.print_cfg) {
+			ssa_printf(tac);
+			return 0;
+		}
+		if (args.through_ssa)
+			ssa_roundtrip(tac);
 		if (args.print_tac) {
 			tac_printf(tac);
 			return 0;
 		}
+		if (args.print_cfg) {
+			cfg_printf(tac);
+			return 0;
+		}
 		// if an out filename was given, use it. if not, a per-arch default is used
 		if (*args.out_path) {
 			filepath = args.out_path;
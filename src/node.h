@@ -4,6 +4,7 @@
 
 #include "lib/defs.h"
 #include "symboltable.h"
+#include "token.h"
 
 enum node_type {
 	NPROG, NGLOB, NILIST, NINIT, NFUNCS, NMAIN, NSDLST, NTYPEL, NRTYPE, NATYPE,
@@ -33,15 +34,20 @@ static char SPRINT[10][7] = {
 	"none", "real", "int", "bool", "void", "array", "struct", "string", "fields", "error"
 };
 
+// columns past this are kept as it (see make_node)
+#define NODE_COL_MAX ((1u << 21) - 1)
+
+// 32 bytes, held in the tree's node chunks (see astree_node, node_left, node_symbol in astree.h)
 typedef struct astnode {
-	enum node_type type;
-	u16 row;
-	u16 col;
-	enum symbol_type symbol_type;
-	Symbol *symbol_value;
-	struct astnode *left_child;
-	struct astnode *middle_child;
-	struct astnode *right_child;
+	u32 left; // children as indices into the tree's nodes, 0 for none
+	u32 middle;
+	u32 right;
+	u32 symbol; // handle into the symbol table, 0 for none
+	u32 row;
+	u32 col : 21;
+	u32 type : 7; // enum node_type
+	u32 symbol_type : 4; // enum symbol_type
+	union literal lit; // value of an NILIT/NFLIT
 } ASTNode;
 
 #endif
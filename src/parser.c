@@ -1,7 +1,7 @@
 // vimargs ../cd25_programs/valid3_softmax.cd
 /*
   produces AST from the given filename (or returns null and prints errors to lister)
-  known memory leak when the longjmp skips freeing allocated memory, but whatever
+  known memory leak when the longjmp skips freeing allocated memory (nodes come back with the tree's node chunks), but whatever
 */
 #include "lib/sds.h"
 #include "lib/defs.h"
@@ -16,21 +16,92 @@
 #include <libgen.h>
 #include <setjmp.h>
 
+// token ranges of the statements and functions parsed, for re-parsing after an edit (see document_edit)
+struct stat_span {
+	ASTNode *list; // the NSTATS node holding the statement
+	u32 first, end; // [first, end) of the token stream
+	u32 scope;
+	u32 depth; // statement lists nested around it (0 for a function's or main's own)
+};
+
+struct func_span {
+	ASTNode *list; // the NFUNCS node holding the function
+	u32 first, end;
+	u32 scope;
+};
+
+// both in source order
+typedef struct spans {
+	struct stat_span *stat;
+	u32 stat_count, stat_cap;
+	struct func_span *func;
+	u32 func_count, func_cap;
+} Spans;
+
 typedef struct parser {
 	Lexer *lex;
-	Token *c/*urrent*/;
-	Token *n/*ext*/;
+	u32 i; // index of c in the lexer's token stream
+	Token c/*urrent*/;
+	Token n/*ext*/;
 	ASTree *ast;
-	u16 scope; // global=0, func∈[1,N), main=N
+	u32 scope; // global=0, func∈[1,N), main=N
 	Lister *lst;
 	u16 progress;
 	int fresh_error;
 	int in_recovery;
-	u16 int_offset;
-	u16 real_offset;
-	u16 string_offset;
+	u32 int_offset;
+	u32 real_offset;
+	u32 string_offset;
+	Spans *spans; // recorded when not NULL
+	u32 depth;
+	// work stacks for n_stats and n_binary, so nesting costs heap rather than C stack
+	// kept here so the longjmp out of error_recovery doesn't leak them (see parser_free_stacks)
+	struct open_block *blocks;
+	u32 block_count, block_cap;
+	struct open_operator *operators;
+	u32 operator_count, operator_cap;
 } Parser;
 
+// a for, repeat or if whose statements n_stats is partway through
+struct open_block {
+	enum { OPEN_FOR, OPEN_REPEAT, OPEN_THEN, OPEN_ELSE } kind;
+	ASTNode *stat; // the NFORL or NREPT, or an if's predicate
+	ASTNode *then; // an if's statements, once at its else
+	ASTNode *head, *tail; // the statement list the block sits in
+	u32 span; // of the block, in that list
+	u32 row, col;
+};
+
+// an n_binary level waiting on an operand, and what it does with it
+struct open_operator {
+	enum { AWAIT_NOT_LEFT, AWAIT_NOT_RIGHT, AWAIT_PAREN, AWAIT_BOOL, AWAIT_REL, AWAIT_ARITH } then;
+	ASTNode *left, *op;
+	u32 row, col;
+	u8 min, max; // enum binding
+};
+
+static void push_block(Parser *p, struct open_block b) {
+	if (p->block_count == p->block_cap) {
+		p->block_cap = p->block_cap ? p->block_cap * 2 : 16;
+		p->blocks = realloc(p->blocks, p->block_cap * sizeof(struct open_block));
+	}
+	p->blocks[p->block_count++] = b;
+}
+
+static void push_operator(Parser *p, struct open_operator o) {
+	if (p->operator_count == p->operator_cap) {
+		p->operator_cap = p->operator_cap ? p->operator_cap * 2 : 32;
+		p->operators = realloc(p->operators, p->operator_cap * sizeof(struct open_operator));
+	}
+	p->operators[p->operator_count++] = o;
+}
+
+static void parser_free_stacks(Parser *p) {
+	free(p->blocks);
+	free(p->operators);
+	symboltable_exit_scopes(p->ast->symboltable); // left open by a longjmp out of n_func or n_mainbody
+}
+
 
 void *heap_wrap_stype(enum symbol_type s) {
 	enum symbol_type *sp = malloc(sizeof(enum symbol_type));
@@ -38,17 +109,17 @@ void *heap_wrap_stype(enum symbol_type s) {
 	return sp;
 }
 
-void symbol_redefinition_error(Parser *p, u16 row, u16 col) {
+void symbol_redefinition_error(Parser *p, u32 row, u32 col) {
 	p->ast->is_valid = 0;
 	lister_sem_error(p->lst, row, col, "redefinition of variable within the same scope");
 }
 
 void append_attribute_from_node(Parser *p, LinkedList *attributes, ASTNode *leaf) {
 	if (leaf->type == NARRC) // todo: const checking
-		leaf = leaf->left_child;
+		leaf = node_left(p->ast, leaf);
 	Attribute *cur_atr = malloc(sizeof(Attribute));
 	if (leaf->type == NARRD) {
-		cur_atr = astree_get_attribute(p->ast, leaf->symbol_value);
+		*cur_atr = *astree_get_attribute(p->ast, node_symbol(p->ast, leaf)); // a copy, the list owns its items
 	} else {
 		cur_atr->type = leaf->symbol_type;
 		cur_atr->data = NULL;
@@ -66,8 +137,8 @@ Attribute *make_func_attribute(Parser *p, ASTNode *param_nodes, enum symbol_type
 	LinkedList *params = linkedlist_create();
 	if (param_nodes->type == NPLIST) {
 		while (param_nodes->type == NPLIST) {
-			append_attribute_from_node(p, params, param_nodes->left_child);
-			param_nodes = param_nodes->right_child;
+			append_attribute_from_node(p, params, node_left(p->ast, param_nodes));
+			param_nodes = node_right(p->ast, param_nodes);
 		}
 	}
 	append_attribute_from_node(p, params, param_nodes);
@@ -78,7 +149,7 @@ Attribute *make_func_attribute(Parser *p, ASTNode *param_nodes, enum symbol_type
 void append_struct_element(Parser *p, LinkedList *elements, ASTNode *field) {
 	// Attribute *cur = astree_get_attribute(p->ast, field->symbol_value);
 	Element *element = malloc(sizeof(Element));
-	*element = (Element){ field->symbol_value, field->symbol_type };
+	*element = (Element){ node_symbol(p->ast, field), field->symbol_type };
 	linkedlist_push_tail(elements, element);
 }
 
@@ -91,26 +162,18 @@ Attribute *struct_types_attribute(Parser *p, ASTNode *fields) {
 	}
 	LinkedList *elements = linkedlist_create();
 	while (fields->type == NFLIST) {
-		append_struct_element(p, elements, fields->left_child);
-		fields = fields->right_child;
+		append_struct_element(p, elements, node_left(p->ast, fields));
+		fields = node_right(p->ast, fields);
 	}
 	append_struct_element(p, elements, fields);
 	result->data = elements;
 	return result;
 }
 
-// this is the only file that needs to free tokens
-void free_token(Token *t) {
-	if (t->val)
-		sdsfree(t->val);
-	free(t);
-}
-
-// gets the next token and releases the current one
-void next_token(Parser *p, int owner_of_value) {
-	owner_of_value ? free_token(p->c) : free(p->c);
+// steps forward in the token stream (n is already lexed, to keep errors in source order)
+void next_token(Parser *p) {
 	p->c = p->n;
-	p->n = lexer_get_token(p->lex);
+	p->n = lexer_token_at(p->lex, ++p->i + 1);
 }
 
 static char *format_cstr(const char *format, const char *str1, const char *str2) {
@@ -129,10 +192,10 @@ void error_recovery(Parser *p);
 // wrapper for next_token with a syntax check (returns 1 if error)
 int match(Parser *p, enum token_type expected) {
 	int result = 0;
-	if (p->c->type != expected && p->fresh_error) {
+	if (p->c.type != expected && p->fresh_error) {
 		p->fresh_error = 0; // only one error per recovery
-		lister_syn_error(p->lst, p->c->row, p->c->col, format_cstr(
-			"expected to see %s, but saw %s", TPRINT[expected], TPRINT[p->c->type]
+		lister_syn_error(p->lst, p->c.row, p->c.col, format_cstr(
+			"expected to see %s, but saw %s", TPRINT[expected], TPRINT[p->c.type]
 			// todo: create a map from token back to plaintext
 		));
 		if (!p->in_recovery) { // preventing recursion in the error state
@@ -141,24 +204,54 @@ int match(Parser *p, enum token_type expected) {
 		}
 		result = 1;
 	}
-	next_token(p, 1);
+	next_token(p);
 	return result;
 }
 
-ASTNode *make_node(enum node_type type, u16 row, u16 col, enum symbol_type symbol_type, Symbol *symbol_value) {
-	ASTNode *temp = malloc(sizeof(ASTNode));
+ASTNode *make_node(ASTree *ast, enum node_type type, u32 row, u32 col, enum symbol_type symbol_type, Symbol *symbol_value) {
+	ASTNode *temp = astree_node_alloc(ast);
 	temp->type = type;
 	temp->row = row;
-	temp->col = col;
+	temp->col = col < NODE_COL_MAX ? col : NODE_COL_MAX;
 	temp->symbol_type = symbol_type;
-	temp->symbol_value = symbol_value;
-	temp->left_child = NULL;
-	temp->middle_child = NULL;
-	temp->right_child = NULL;
-	// *temp = { type, row, col, symbol_type, symbol_value, NULL, NULL, NULL };
+	node_set_symbol(ast, temp, symbol_value);
+	temp->lit = (union literal){ 0 };
+	temp->left = 0;
+	temp->middle = 0;
+	temp->right = 0;
 	return temp;
 }
 
+static u32 span_open_stat(Parser *p, ASTNode *list) {
+	Spans *sp = p->spans;
+	if (sp->stat_count == sp->stat_cap) {
+		sp->stat_cap = sp->stat_cap ? sp->stat_cap * 2 : 64;
+		sp->stat = realloc(sp->stat, sp->stat_cap * sizeof(struct stat_span));
+	}
+	sp->stat[sp->stat_count] = (struct stat_span){ list, p->i, p->i, p->scope, p->depth++ };
+	return sp->stat_count++;
+}
+
+static void span_close_stat(Parser *p, u32 span) {
+	p->spans->stat[span].end = p->i;
+	p->depth--;
+}
+
+static u32 span_open_func(Parser *p, ASTNode *list) {
+	Spans *sp = p->spans;
+	if (sp->func_count == sp->func_cap) {
+		sp->func_cap = sp->func_cap ? sp->func_cap * 2 : 16;
+		sp->func = realloc(sp->func, sp->func_cap * sizeof(struct func_span));
+	}
+	sp->func[sp->func_count] = (struct func_span){ list, p->i, p->i, 0 };
+	return sp->func_count++;
+}
+
+static void span_close_func(Parser *p, u32 span) {
+	p->spans->func[span].end = p->i;
+	p->spans->func[span].scope = p->scope; // n_func stepped into the function's scope
+}
+
 	ASTNode *n_program(Parser *p);
 	ASTNode *n_globals(Parser *p);
 	ASTNode *n_initlist(Parser *p);
@@ -209,21 +302,21 @@ jmp_buf error_close;
 // parse the rest of the program, dropping the nodes as no compilation will proceed
 void error_recovery(Parser *p) {
 	p->in_recovery = 1;
-	while (p->c->type != T_EOF) {
+	while (p->c.type != T_EOF) {
 		p->fresh_error = 1;
-		// printf("token: %s, state=%d\n", TPRINT[p->c->type], p->progress);
+		// printf("token: %s, state=%d\n", TPRINT[p->c.type], p->progress);
 		switch (p->progress) {
 			case 0: // CD25 <id>
 			case 1: // consts
-				switch (p->c->type) {
+				switch (p->c.type) {
 					// synchronise on , types, arrays, func, main
 					case TCNST: // state 0
 						match(p, TCNST);
-						node_free(n_init(p));
+						node_free(p->ast, n_init(p));
 						break;
 					case TCOMA:
 						match(p, TCOMA);
-						node_free(n_init(p));
+						node_free(p->ast, n_init(p));
 						break;
 					case TTYPS:
 						p->progress = 2;
@@ -238,18 +331,18 @@ void error_recovery(Parser *p) {
 						p->progress = 11;
 						break;
 					default:
-						next_token(p, 1);
+						next_token(p);
 						break;
 				}
 				break;
 			case 2: // types
-				switch (p->c->type) {
+				switch (p->c.type) {
 					case TTYPS:
 						match(p, TTYPS);
-						node_free(n_type(p));
+						node_free(p->ast, n_type(p));
 						break;
 					case TIDEN:
-						node_free(n_type(p));
+						node_free(p->ast, n_type(p));
 						break;
 					case TARRS:
 						p->progress = 3;
@@ -261,19 +354,19 @@ void error_recovery(Parser *p) {
 						p->progress = 11;
 						break;
 					default:
-						next_token(p, 1);
+						next_token(p);
 						break;
 				}
 				break;
 			case 3: // arrays
-				switch (p->c->type) {
+				switch (p->c.type) {
 					case TARRS:
 						match(p, TARRS);
-						node_free(n_arrdecl(p));
+						node_free(p->ast, n_arrdecl(p));
 						break;
 					case TCOMA:
 						match(p, TCOMA);
-						node_free(n_arrdecl(p));
+						node_free(p->ast, n_arrdecl(p));
 						break;
 					case TFUNC:
 						p->progress = 5;
@@ -282,12 +375,12 @@ void error_recovery(Parser *p) {
 						p->progress = 11;
 						break;
 					default:
-						next_token(p, 1);
+						next_token(p);
 						break;
 				}
 				break;
 			case 5: // funcs (4 was a mistake)
-				switch (p->c->type) {
+				switch (p->c.type) {
 					case TFUNC:
 						match(p, TFUNC);
 						match(p, TIDEN);
@@ -298,30 +391,30 @@ void error_recovery(Parser *p) {
 						p->progress = 11;
 						break;
 					default:
-						next_token(p, 1);
+						next_token(p);
 						break;
 				}
 				break;
 			case 6: // func params (sync on ')' | func | main)
-				switch (p->c->type) {
+				switch (p->c.type) {
 					case TIDEN:
-						node_free(n_param(p));
-						if (p->c->type == TCOMA)
+						node_free(p->ast, n_param(p));
+						if (p->c.type == TCOMA)
 							match(p, TCOMA);
 						break;
 					case TRPAR:
 						match(p, TRPAR);
 						match(p, TCOLN);
-						switch(p->c->type) {
+						switch(p->c.type) {
 							case TINTG:
 							case TREAL:
 							case TBOOL:
 							case TVOID:
-								next_token(p, 1);
+								next_token(p);
 								break;
 							default:
-								lister_syn_error(p->lst, p->c->row, p->c->col, "invalid return type");
-								next_token(p, 1);
+								lister_syn_error(p->lst, p->c.row, p->c.col, "invalid return type");
+								next_token(p);
 								break;
 						}
 						p->progress = 8;
@@ -333,21 +426,21 @@ void error_recovery(Parser *p) {
 						p->progress = 11;
 						break;
 					default:
-						next_token(p, 1);
+						next_token(p);
 						break;
 				}
 				break;
 			case 8: // funcbody (7 was a mistake)
-				switch(p->c->type) {
+				switch(p->c.type) {
 					case TIDEN:
-						node_free(n_decl(p));
-						if (p->c->type == TCOMA)
+						node_free(p->ast, n_decl(p));
+						if (p->c.type == TCOMA)
 							match(p, TCOMA);
 						break;
 					case TBEGN:
 						match(p, TBEGN);
 						p->progress = 9;
-						node_free(n_stat(p));
+						node_free(p->ast, n_stat(p));
 						break;
 					case TFUNC:
 						p->progress = 5;
@@ -356,78 +449,78 @@ void error_recovery(Parser *p) {
 						p->progress = 11;
 						break;
 					default:
-						next_token(p, 1);
+						next_token(p);
 						break;
 				}
 				break;
 			case 9: // stats [func]
-				switch(p->c->type) {
+				switch(p->c.type) {
 					case TSEMI:
 						match(p, TSEMI);
-						if (p->c->type != TTEND)
-							node_free(n_stat(p));
+						if (p->c.type != TTEND)
+							node_free(p->ast, n_stat(p));
 						break;
 					case TTEND:
 						match(p, TTEND);
-						if (p->c->type == TFUNC)
+						if (p->c.type == TFUNC)
 							p->progress = 5;
-						else if (p->c->type != TMAIN)
-							node_free(n_stat(p));
+						else if (p->c.type != TMAIN)
+							node_free(p->ast, n_stat(p));
 						break;
 					case TMAIN:
 						p->progress = 11;
 						break;
 					default:
-						next_token(p, 1);
+						next_token(p);
 						break;
 				}
 				break;
 			case 11:
-				switch(p->c->type) {
+				switch(p->c.type) {
 					case TMAIN:
 						match(p, TMAIN);
-						node_free(n_sdecl(p));
+						node_free(p->ast, n_sdecl(p));
 						break;
 					case TCOMA:
 						match(p, TCOMA);
-						node_free(n_sdecl(p));
+						node_free(p->ast, n_sdecl(p));
 						break;
 					case TBEGN:
 						p->progress = 12;
 						match(p, TBEGN);
-						node_free(n_stat(p));
+						node_free(p->ast, n_stat(p));
 						break;
 					// case TSEMI:
 					// 	p->progress = 12;
 					// 	break;
 					default:
-						next_token(p, 1);
+						next_token(p);
 						break;
 				}
 				break;
 			case 12: // stats [main]
-				switch(p->c->type) {
+				switch(p->c.type) {
 					case TSEMI:
 						match(p, TSEMI);
-						if (p->c->type == TTEND && p->n->type == TCD25) {
+						if (p->c.type == TTEND && p->n.type == TCD25) {
 							match(p, TTEND);
 							match(p, TCD25);
 							match(p, TIDEN);
 							break;
 						}
-						node_free(n_stat(p));
+						node_free(p->ast, n_stat(p));
 						break;
 					case TTEND:
 						match(p, TTEND);
-						if (p->c->type == TCD25) {
+						if (p->c.type == TCD25) {
 							match(p, TCD25);
 							match(p, TIDEN);
 							break;
 						}
-						node_free(n_stat(p));
+						node_free(p->ast, n_stat(p));
 						break;
 					default: // end CD25 <id> is not considered here
-						next_token(p, 1);
+						next_token(p);
 						break;
 				}
 				break;
@@ -436,110 +529,465 @@ void error_recovery(Parser *p) {
 	longjmp(error_close, 1);
 }
 
-ASTree *get_AST(const char *filename, Lister *list_file) {
-    Lexer *scanner = lexer_create(filename, list_file);
+ASTree *get_AST(const char *filename, Lister *list_file, int pipelined, int lex_threads, const char **lexed_as) {
 	ASTree *tree = astree_create(128);
+	Lexer *scanner = lexer_create(filename, list_file, tree->symboltable->pool);
+	int lexed = lex_threads > 1 && lexer_lex_parallel(scanner, lex_threads);
+	if (!lexed && pipelined)
+		lexer_run_async(scanner);
+	if (lexed_as)
+		*lexed_as = lexed ? "parallel" : pipelined ? "pipelined" : "on demand";
 
 	struct parser p = {
-		scanner,
-		lexer_get_token(scanner),
-		lexer_get_token(scanner),
-		tree,
-		0, // scope
-		list_file,
-		0, // parsing progress (recovery)
-		1, // fresh_error
-		0, // in_recovery
-		0 // offset
+		.lex = scanner,
+		.c = lexer_token_at(scanner, 0),
+		.n = lexer_token_at(scanner, 1),
+		.ast = tree,
+		.lst = list_file,
+		.fresh_error = 1,
 	};
 
 	if (setjmp(error_close) == 0)
 		tree->root = n_program(&p);
 	else
 		tree->root = NULL;
+	parser_free_stacks(&p);
 
 	lexer_free(scanner);
-	free_token(p.c);
-	free_token(p.n);
 	return tree;
 }
 
-int unscoped_symbol_equals(const Symbol *s1, const Symbol *s2) {
-	return s1->index.start == s2->index.start &&
-	       s1->index.len   == s2->index.len;
+struct document {
+	Lexer *lex; // keeps the source and the whole token stream
+	ASTree *ast;
+	Spans spans;
+};
+
+// parses doc->lex from the top, recording where each statement and function went
+static void document_parse(Document *doc, Lister *list_file) {
+	struct parser p = {
+		.lex = doc->lex,
+		.c = lexer_token_at(doc->lex, 0),
+		.n = lexer_token_at(doc->lex, 1),
+		.ast = doc->ast,
+		.lst = list_file,
+		.fresh_error = 1,
+		.spans = &doc->spans,
+	};
+	doc->spans.stat_count = 0;
+	doc->spans.func_count = 0;
+	if (setjmp(error_close) == 0)
+		doc->ast->root = n_program(&p);
+	else
+		doc->ast->root = NULL;
+	parser_free_stacks(&p);
+}
+
+Document *document_open(const char *filename, Lister *list_file) {
+	Document *doc = calloc(1, sizeof(Document));
+	doc->ast = astree_create(128);
+	doc->lex = lexer_create(filename, list_file, doc->ast->symboltable->pool);
+	lexer_keep_source(doc->lex);
+	document_parse(doc, list_file);
+	return doc;
+}
+
+ASTree *document_ast(const Document *doc) {
+	return doc->ast;
+}
+
+const char *document_text(const Document *doc, size_t *len) {
+	return lexer_text(doc->lex, len);
+}
+
+void document_close(Document *doc) {
+	lexer_free(doc->lex);
+	astree_free(doc->ast);
+	free(doc->spans.stat);
+	free(doc->spans.func);
+	free(doc);
+}
+
+// starts over from the edited text
+static void document_rebuild(Document *doc, Lister *list_file) {
+	size_t len;
+	const char *text = lexer_text(doc->lex, &len);
+	ASTree *tree = astree_create(128);
+	Lexer *lex = lexer_create_text(text, len, list_file, tree->symboltable->pool);
+	lexer_free(doc->lex);
+	astree_free(doc->ast);
+	doc->lex = lex;
+	doc->ast = tree;
+	lexer_keep_source(lex);
+	document_parse(doc, list_file);
+}
+
+// moves the nodes from row on down delta rows
+static void shift_rows(ASTree *ast, ASTNode *n, u32 row, int delta) {
+	if (!n)
+		return;
+	NodeStack todo = { 0 };
+	node_stack_push(&todo, node_id(n));
+	while (todo.count) {
+		n = astree_node(ast, node_stack_pop(&todo));
+		if (n->row >= row) {
+			n->row += delta;
+			if (n->type == NMAIN) // n_mainbody gives it the row as its column
+				n->col += delta;
+		}
+		node_stack_push_children(&todo, n);
+	}
+	node_stack_free(&todo);
+}
+
+// a re-parse is only kept if it ends exactly where the old one did, with nothing to report
+static int parsed_clean(Parser *p, u32 stop) {
+	char *msg;
+	int quiet = 1;
+	while ((msg = lister_pop_warning(p->lst)) || (msg = lister_pop_error(p->lst))) {
+		free(msg);
+		quiet = 0;
+	}
+	return quiet && p->i == stop && p->ast->is_valid;
+}
+
+// the statement span before s in the same list, if there is one
+static u32 previous_sibling(ASTree *ast, const Spans *sp, u32 s) {
+	for (u32 k = s; k-- > 0;)
+		if (sp->stat[k].depth <= sp->stat[s].depth)
+			return sp->stat[k].depth == sp->stat[s].depth && node_right(ast, sp->stat[k].list) == sp->stat[s].list ? k : UINT32_MAX;
+	return UINT32_MAX;
+}
+
+// the statement span s is nested in (statements at depth 0 have none)
+static u32 parent_span(const Spans *sp, u32 s) {
+	u32 k = s;
+	while (sp->stat[--k].depth != sp->stat[s].depth - 1);
+	return k;
+}
+
+// b is a, or comes after it in the same list (an if/else has two lists, functions and main one each)
+static int same_list(ASTree *ast, const Spans *sp, u32 a, u32 b) {
+	ASTNode *n = sp->stat[a].list;
+	while (n && n != sp->stat[b].list)
+		n = node_right(ast, n);
+	return n != NULL;
+}
+
+// re-parses the statements a to b (of the same list) in place, as however many statements they now are
+static int reparse_stats(Document *doc, u32 a, u32 b, const LexEdit *e) {
+	Spans *sp = &doc->spans;
+	struct stat_span first = sp->stat[a];
+	long tok_delta = (long)e->new_end - (long)e->old_end;
+	u32 end = sp->stat[b].end, stop = end + tok_delta, count = sp->stat_count;
+	u32 prev = previous_sibling(doc->ast, sp, a);
+	ASTNode *next = node_right(doc->ast, sp->stat[b].list);
+	struct parser p = {
+		.lex = doc->lex,
+		.i = first.first,
+		.c = lexer_token_at(doc->lex, first.first),
+		.n = lexer_token_at(doc->lex, first.first + 1),
+		.ast = doc->ast,
+		.scope = first.scope,
+		.lst = lister_create(NULL),
+		.progress = 9, // in a function body (recovery)
+		.fresh_error = 1,
+		.spans = sp,
+		.depth = first.depth,
+	};
+	u32 head_id = 0, *link = &head_id;
+	int clean = 0;
+	if (setjmp(error_close) == 0) {
+		while (p.i < stop) { // n_stats, without the lookahead (stop is where the list went on or ended before)
+			ASTNode *nstats = make_node(p.ast, NSTATS, p.c.row, p.c.col, SNONE, NULL);
+			*link = node_id(nstats);
+			link = &nstats->right;
+			u32 span = span_open_stat(&p, nstats);
+			nstats->left = node_id(n_stat(&p));
+			span_close_stat(&p, span);
+		}
+		clean = parsed_clean(&p, stop) && (head_id || prev != UINT32_MAX || next); // a list can't be empty
+	}
+	parser_free_stacks(&p);
+	lister_close(p.lst);
+	ASTNode *head = astree_node(doc->ast, head_id);
+	if (!clean) {
+		node_free(doc->ast, head); // after an error, only freed with the tree
+		sp->stat_count = count;
+		doc->ast->is_valid = 1;
+		return 0;
+	}
+
+	// out with the old statements, first's node stays where its parent (or previous statement) points
+	ASTNode *list = first.list;
+	for (ASTNode *n = list, *last = sp->stat[b].list, *r; ; n = r) {
+		r = node_right(doc->ast, n);
+		n->right = 0;
+		node_free(doc->ast, n == list ? node_left(doc->ast, n) : n);
+		if (n == last)
+			break;
+	}
+	list->left = 0;
+	list->right = node_id(next);
+	if (e->row_delta)
+		shift_rows(doc->ast, doc->ast->root, e->old_row, e->row_delta); // the new ones have their rows already
+	if (head) { // which first's node becomes
+		*link = node_id(next);
+		list->row = head->row;
+		list->col = head->col;
+		list->left = node_id(node_left(doc->ast, head));
+		list->right = node_id(node_right(doc->ast, head));
+		head->left = head->right = 0;
+		node_free(doc->ast, head);
+		sp->stat[count].list = list;
+	} else if (prev != UINT32_MAX) {
+		sp->stat[prev].list->right = node_id(next);
+		list->right = 0;
+		node_free(doc->ast, list);
+	} else { // next moves up into first's node
+		*list = *next;
+		next->left = next->right = 0;
+		node_free(doc->ast, next);
+	}
+
+	// the old spans from a to the end of b make way for the ones just recorded, the rest move over
+	u32 old_end = b + 1, added = sp->stat_count - count;
+	while (old_end < count && sp->stat[old_end].first < end)
+		old_end++;
+	struct stat_span *fresh = malloc(added * sizeof(struct stat_span) + 1);
+	memcpy(fresh, sp->stat + count, added * sizeof(struct stat_span));
+	for (u32 k = 0; k < a; k++)
+		if (sp->stat[k].end > first.first) // encloses them
+			sp->stat[k].end += tok_delta;
+	for (u32 k = old_end; k < count; k++) {
+		sp->stat[k].first += tok_delta;
+		sp->stat[k].end += tok_delta;
+	}
+	memmove(sp->stat + a + added, sp->stat + old_end, (count - old_end) * sizeof(struct stat_span));
+	memcpy(sp->stat + a, fresh, added * sizeof(struct stat_span));
+	sp->stat_count = count - (old_end - a) + added;
+	free(fresh);
+	if (!head && prev == UINT32_MAX)
+		for (u32 k = a; k < sp->stat_count && sp->stat[k].depth >= first.depth; k++)
+			if (sp->stat[k].list == next)
+				sp->stat[k].list = list;
+	for (u32 k = 0; k < sp->func_count; k++) {
+		if (sp->func[k].first >= end)
+			sp->func[k].first += tok_delta;
+		if (sp->func[k].end > first.first)
+			sp->func[k].end += tok_delta;
+	}
+	return 1;
+}
+
+// takes back the parameters and locals n_func declared
+static void drop_declarations(ASTree *ast, ASTNode *n) {
+	for (; n; n = node_right(ast, n)) {
+		if (n->type == NSDECL || n->type == NARRD)
+			astree_remove_attribute(ast, node_symbol(ast, n));
+		drop_declarations(ast, node_left(ast, n));
+	}
+}
+
+// re-parses function f in place, the symbol table is left without it if that fails
+static int reparse_func(Document *doc, u32 f, const LexEdit *e) {
+	Spans *sp = &doc->spans;
+	struct func_span old = sp->func[f];
+	long tok_delta = (long)e->new_end - (long)e->old_end;
+	u32 stop = old.end + tok_delta, count = sp->stat_count;
+	ASTNode *fund = node_left(doc->ast, old.list);
+	astree_remove_attribute(doc->ast, node_symbol(doc->ast, fund));
+	drop_declarations(doc->ast, node_left(doc->ast, fund));
+	drop_declarations(doc->ast, node_middle(doc->ast, fund));
+
+	struct parser p = {
+		.lex = doc->lex,
+		.i = old.first,
+		.c = lexer_token_at(doc->lex, old.first),
+		.n = lexer_token_at(doc->lex, old.first + 1),
+		.ast = doc->ast,
+		.scope = old.scope - 1, // n_func steps into it
+		.lst = lister_create(NULL),
+		.progress = 5, // parsing progress (recovery)
+		.fresh_error = 1,
+		.spans = sp,
+	};
+	fund = NULL;
+	int clean = 0;
+	if (setjmp(error_close) == 0) {
+		fund = n_func(&p);
+		clean = parsed_clean(&p, stop);
+	}
+	parser_free_stacks(&p);
+	lister_close(p.lst);
+	if (!clean) {
+		node_free(doc->ast, fund); // after an error, only freed with the tree
+		return 0;
+	}
+
+	node_free(doc->ast, node_left(doc->ast, old.list));
+	old.list->left = 0; // the new one has its rows already
+	if (e->row_delta)
+		shift_rows(doc->ast, doc->ast->root, e->old_row, e->row_delta);
+	Token t = lexer_token_at(doc->lex, old.first);
+	old.list->left = node_id(fund);
+	old.list->row = t.row;
+	old.list->col = t.col;
+
+	// its statements' spans are replaced, the ones after it move over
+	u32 a = 0, b, added = sp->stat_count - count;
+	while (a < count && sp->stat[a].first < old.first)
+		a++;
+	for (b = a; b < count && sp->stat[b].first < old.end; b++);
+	struct stat_span *fresh = malloc(added * sizeof(struct stat_span) + 1);
+	memcpy(fresh, sp->stat + count, added * sizeof(struct stat_span));
+	for (u32 k = b; k < count; k++) {
+		sp->stat[k].first += tok_delta;
+		sp->stat[k].end += tok_delta;
+	}
+	memmove(sp->stat + a + added, sp->stat + b, (count - b) * sizeof(struct stat_span));
+	memcpy(sp->stat + a, fresh, added * sizeof(struct stat_span));
+	sp->stat_count = count - (b - a) + added;
+	free(fresh);
+	sp->func[f].end = stop;
+	for (u32 k = f + 1; k < sp->func_count; k++) {
+		sp->func[k].first += tok_delta;
+		sp->func[k].end += tok_delta;
+	}
+	return 1;
+}
+
+// tries the statements around the changed tokens, then the ones around those, then the function they're in
+static int reparse(Document *doc, const LexEdit *e) {
+	Spans *sp = &doc->spans;
+	if (e->first == e->old_end && e->first == e->new_end) { // only blanks or comments changed
+		if (e->row_delta)
+			shift_rows(doc->ast, doc->ast->root, e->old_row, e->row_delta);
+		return 1;
+	}
+	// the innermost statements the change starts and ends in (or next to), later spans are nested deeper
+	u32 a = UINT32_MAX, b = UINT32_MAX;
+	for (u32 k = 0; k < sp->stat_count; k++) {
+		if (sp->stat[k].first <= e->first && e->first <= sp->stat[k].end)
+			a = k;
+		if (sp->stat[k].first < e->old_end && e->old_end <= sp->stat[k].end)
+			b = k;
+	}
+	if (e->first == e->old_end)
+		b = a;
+	if (a != UINT32_MAX && b != UINT32_MAX) {
+		// up to the same list
+		while (sp->stat[a].depth > sp->stat[b].depth)
+			a = parent_span(sp, a);
+		while (sp->stat[b].depth > sp->stat[a].depth)
+			b = parent_span(sp, b);
+		while (!same_list(doc->ast, sp, a, b) && sp->stat[a].depth) {
+			a = parent_span(sp, a);
+			b = parent_span(sp, b);
+		}
+		while (same_list(doc->ast, sp, a, b)) {
+			if (reparse_stats(doc, a, b, e))
+				return 1;
+			if (!sp->stat[a].depth)
+				break;
+			a = b = parent_span(sp, a);
+		}
+	}
+	for (u32 k = 0; k < sp->func_count; k++)
+		if (sp->func[k].first <= e->first && e->old_end <= sp->func[k].end)
+			return reparse_func(doc, k, e);
+	return 0;
+}
+
+int document_edit(Document *doc, size_t start, size_t old_len, const char *text, size_t len, Lister *list_file) {
+	size_t size;
+	lexer_text(doc->lex, &size);
+	if (start > size || old_len > size - start)
+		return -1;
+	int parsed = doc->ast->is_valid && doc->ast->root;
+	LexEdit e = lexer_edit(doc->lex, start, old_len, text, len);
+	if (!parsed || e.diagnostics || !reparse(doc, &e)) {
+		document_rebuild(doc, list_file);
+		return 0;
+	}
+	return 1;
 }
 
 ASTNode *n_program(Parser *p) {
 	match(p, TCD25);
-	Symbol *symbol = astree_add_symbol(p->ast, p->c->val, p->scope);
-	ASTNode *prog = make_node(NPROG, p->c->row, p->c->col, SNONE, symbol);
+	Symbol *symbol = astree_add_symbol(p->ast, p->c.id, p->scope);
+	ASTNode *prog = make_node(p->ast, NPROG, p->c.row, p->c.col, SNONE, symbol);
 	match(p, TIDEN);
 	// use current when next production is already known, use next when it can branch
-	if (p->c->type == TCONS || p->c->type == TTYPS || p->c->type == TARRS)
-		prog->left_child = n_globals(p); // can be epsilon
-	if (p->c->type == TFUNC)
-		prog->middle_child = n_funcs(p); // can be epsilon
-	prog->right_child = n_mainbody(p);
+	if (p->c.type == TCONS || p->c.type == TTYPS || p->c.type == TARRS)
+		prog->left = node_id(n_globals(p)); // can be epsilon
+	if (p->c.type == TFUNC)
+		prog->middle = node_id(n_funcs(p)); // can be epsilon
+	prog->right = node_id(n_mainbody(p));
 	match(p, T_EOF);
 	return prog;
 }
 
 ASTNode *n_globals(Parser *p) {
 	p->progress = 1; // synchronise on constants , types, arrays, func, main
-	ASTNode *globs = make_node(NGLOB, p->c->row, p->c->col, SNONE, NULL);
-	if (p->c->type == TCONS) {
+	ASTNode *globs = make_node(p->ast, NGLOB, p->c.row, p->c.col, SNONE, NULL);
+	if (p->c.type == TCONS) {
 		match(p, TCONS);
-		globs->left_child = n_initlist(p);
+		globs->left = node_id(n_initlist(p));
 	}
-	if (p->c->type == TTYPS) {
+	if (p->c.type == TTYPS) {
 		match(p, TTYPS);
-		globs->middle_child = n_typelist(p);
+		globs->middle = node_id(n_typelist(p));
 	}
-	if (p->c->type == TARRS) {
+	if (p->c.type == TARRS) {
 		match(p, TARRS);
-		globs->right_child = n_arrdecls(p);
+		globs->right = node_id(n_arrdecls(p));
 	}
 	return globs;
 }
 
 ASTNode *n_initlist(Parser *p) {
-	u16 row = p->c->row;
-	u16 col = p->c->col;
+	u32 row = p->c.row;
+	u32 col = p->c.col;
 	ASTNode *ninit = n_init(p);
-	if (p->c->type != TCOMA)
+	if (p->c.type != TCOMA)
 		return ninit;
 	match(p, TCOMA);
-	ASTNode *initlist = make_node(NILIST, row, col, SNONE, NULL);
-	initlist->left_child = ninit;
-	initlist->right_child = n_initlist(p);
+	ASTNode *initlist = make_node(p->ast, NILIST, row, col, SNONE, NULL);
+	initlist->left = node_id(ninit);
+	initlist->right = node_id(n_initlist(p));
 	return initlist;
 }
 
 ASTNode *n_init(Parser *p) {
-	Symbol *symbol = astree_add_symbol(p->ast, p->c->val, p->scope);
-	ASTNode *ninit = make_node(NINIT, p->c->row, p->c->col, SNONE, symbol);
+	Symbol *symbol = astree_add_symbol(p->ast, p->c.id, p->scope);
+	ASTNode *ninit = make_node(p->ast, NINIT, p->c.row, p->c.col, SNONE, symbol);
 	match(p, TIDEN);
 	match(p, TTTIS);
-	u16 row = p->c->row;
-	u16 col = p->c->col;
-	ninit->left_child = n_expr(p);
+	u32 row = p->c.row;
+	u32 col = p->c.col;
+	ninit->left = node_id(n_expr(p));
 	// symboltable attribute is handled in semantic analysis
 	return ninit;
 }
 
 ASTNode *n_funcs(Parser *p) {
-	if (p->c->type != TFUNC)
+	if (p->c.type != TFUNC)
 		return NULL;
-	ASTNode *nfuncs = make_node(NFUNCS, p->c->row, p->c->col, SNONE, NULL);
-	nfuncs->left_child = n_func(p);
-	nfuncs->right_child = n_funcs(p);
+	ASTNode *nfuncs = make_node(p->ast, NFUNCS, p->c.row, p->c.col, SNONE, NULL);
+	u32 span = p->spans ? span_open_func(p, nfuncs) : 0;
+	nfuncs->left = node_id(n_func(p));
+	if (p->spans)
+		span_close_func(p, span);
+	nfuncs->right = node_id(n_funcs(p));
 	return nfuncs;
 }
 
 ASTNode *n_mainbody(Parser *p) {
 	p->scope++;
-	u16 row = p->c->row;
-	u16 col = p->c->row;
+	symboltable_enter_scope(p->ast->symboltable);
+	u32 row = p->c.row;
+	u32 col = p->c.row;
 	match(p, TMAIN);
 	p->progress = 11; // synchronise on iden
 	ASTNode *slist = n_slist(p);
@@ -548,37 +996,38 @@ ASTNode *n_mainbody(Parser *p) {
 	ASTNode *stats = n_stats(p);
 	match(p, TTEND);
 	match(p, TCD25);
-	Symbol *progname = astree_add_symbol(p->ast, p->c->val, p->scope);
+	Symbol *progname = astree_add_symbol(p->ast, p->c.id, p->scope);
 	match(p, TIDEN);
-	ASTNode *nmain = make_node(NMAIN, row, col, SNONE, progname);
-	nmain->left_child = slist;
-	nmain->right_child = stats;
+	symboltable_exit_scope(p->ast->symboltable);
+	ASTNode *nmain = make_node(p->ast, NMAIN, row, col, SNONE, progname);
+	nmain->left = node_id(slist);
+	nmain->right = node_id(stats);
 	return nmain;
 }
 
 ASTNode *n_slist(Parser *p) {
-	u16 row = p->c->row;
-	u16 col = p->c->col;
+	u32 row = p->c.row;
+	u32 col = p->c.col;
 	ASTNode *sdecl = n_sdecl(p);
-	if (p->c->type != TCOMA) {
+	if (p->c.type != TCOMA) {
 		return sdecl;
 	}
-	ASTNode *nsdlst = make_node(NSDLST, row, col, SNONE, NULL);
-	nsdlst->left_child = sdecl;
+	ASTNode *nsdlst = make_node(p->ast, NSDLST, row, col, SNONE, NULL);
+	nsdlst->left = node_id(sdecl);
 	match(p, TCOMA);
-	nsdlst->right_child = n_slist(p);
+	nsdlst->right = node_id(n_slist(p));
 	return nsdlst;
 }
 
 ASTNode *n_typelist(Parser *p) {
 	p->progress = 2;
-	int row = p->c->row;
-	int col = p->c->col;
+	int row = p->c.row;
+	int col = p->c.col;
 	ASTNode *type = n_type(p);
-	if (p->c->type == TIDEN) {
-		ASTNode *ntypel = make_node(NTYPEL, row, col, SNONE, NULL);
-		ntypel->left_child = type;
-		ntypel->right_child = n_typelist(p);
+	if (p->c.type == TIDEN) {
+		ASTNode *ntypel = make_node(p->ast, NTYPEL, row, col, SNONE, NULL);
+		ntypel->left = node_id(type);
+		ntypel->right = node_id(n_typelist(p));
 		return ntypel;
 	}
 	return type;
@@ -586,29 +1035,29 @@ ASTNode *n_typelist(Parser *p) {
 
 ASTNode *n_type(Parser *p) {
 	Symbol *name_symbol;
-	int row = p->c->row;
-	int col = p->c->col;
-	name_symbol = astree_add_symbol(p->ast, p->c->val, p->scope);
+	int row = p->c.row;
+	int col = p->c.col;
+	name_symbol = astree_add_symbol(p->ast, p->c.id, p->scope);
 	match(p, TIDEN);
 	match(p, TTTIS);
-	if (p->c->type == TIDEN) { // struct
-		ASTNode *nrtype = make_node(NRTYPE, row, col, SNONE, name_symbol);
-		nrtype->left_child = n_fields(p);
-		if (astree_add_attribute(p->ast, name_symbol, struct_types_attribute(p, nrtype->left_child)))
-			symbol_redefinition_error(p, p->c->row, p->c->col);
+	if (p->c.type == TIDEN) { // struct
+		ASTNode *nrtype = make_node(p->ast, NRTYPE, row, col, SNONE, name_symbol);
+		nrtype->left = node_id(n_fields(p));
+		if (astree_add_attribute(p->ast, name_symbol, struct_types_attribute(p, node_left(p->ast, nrtype))))
+			symbol_redefinition_error(p, p->c.row, p->c.col);
 		match(p, TTEND);
 		return nrtype;
 	}
-	else if (p->c->type == TARAY) { // array
-		ASTNode *natype = make_node(NATYPE, row, col, SNONE, name_symbol);
+	else if (p->c.type == TARAY) { // array
+		ASTNode *natype = make_node(p->ast, NATYPE, row, col, SNONE, name_symbol);
 		match(p, TARAY);
 		match(p, TLBRK);
-		natype->left_child = n_expr(p);
+		natype->left = node_id(n_expr(p));
 		match(p, TRBRK);
 		match(p, TTTOF);
-		Symbol *type_symbol = astree_add_symbol(p->ast, p->c->val, p->scope);
-		if (astree_add_attribute(p->ast, name_symbol, astree_attribute_create(p->ast, SSTRUCT, type_symbol)))
-			symbol_redefinition_error(p, p->c->row, p->c->col);
+		Symbol *type_symbol = astree_add_symbol(p->ast, p->c.id, p->scope);
+		if (astree_add_attribute(p->ast, name_symbol, astree_attribute_create(SSTRUCT, type_symbol)))
+			symbol_redefinition_error(p, p->c.row, p->c.col);
 		match(p, TIDEN);
 		match(p, TTEND);
 		return natype;
@@ -618,11 +1067,11 @@ ASTNode *n_type(Parser *p) {
 
 ASTNode *n_fields(Parser *p) {
 	ASTNode *nsdecl = n_sdecl(p);
-	if (p->c->type == TCOMA) {
-		ASTNode *nflist = make_node(NFLIST, p->c->row, p->c->col, SNONE, NULL);
-		nflist->left_child = nsdecl;
+	if (p->c.type == TCOMA) {
+		ASTNode *nflist = make_node(p->ast, NFLIST, p->c.row, p->c.col, SNONE, NULL);
+		nflist->left = node_id(nsdecl);
 		match(p, TCOMA);
-		nflist->right_child = n_fields(p);
+		nflist->right = node_id(n_fields(p));
 		return nflist;
 	} else {
 		return nsdecl;
@@ -630,36 +1079,36 @@ ASTNode *n_fields(Parser *p) {
 }
 
 ASTNode *n_sdecl(Parser *p) {
-	Symbol *symbol = astree_add_symbol(p->ast, p->c->val, p->scope);
-	ASTNode *nsdecl = make_node(NSDECL, p->c->row, p->c->col, SNONE, symbol);
+	Symbol *symbol = astree_add_symbol(p->ast, p->c.id, p->scope);
+	ASTNode *nsdecl = make_node(p->ast, NSDECL, p->c.row, p->c.col, SNONE, symbol);
 	match(p, TIDEN);
 	match(p, TCOLN);
-	switch (p->c->type) {
+	switch (p->c.type) {
 		case TINTG:
 			if (p->scope != 0) // a scope 0 sdecl is a struct field
 				// todo: in error recovery symbol definition false positive is flagged
-				if (astree_add_attribute(p->ast, symbol, astree_attribute_create(p->ast, SINT, NULL)))
-					symbol_redefinition_error(p, p->c->row, p->c->col);
+				if (astree_add_attribute(p->ast, symbol, astree_attribute_create(SINT, NULL)))
+					symbol_redefinition_error(p, p->c.row, p->c.col);
 			nsdecl->symbol_type = SINT;
 			match(p, TINTG);
 			break;
 		case TREAL:
 			if (p->scope != 0)
-				if (astree_add_attribute(p->ast, symbol, astree_attribute_create(p->ast, SREAL, NULL)))
-					symbol_redefinition_error(p, p->c->row, p->c->col);
+				if (astree_add_attribute(p->ast, symbol, astree_attribute_create(SREAL, NULL)))
+					symbol_redefinition_error(p, p->c.row, p->c.col);
 			nsdecl->symbol_type = SREAL;
 			match(p, TREAL);
 			break;
 		case TBOOL:
 			if (p->scope != 0)
-				if (astree_add_attribute(p->ast, symbol, astree_attribute_create(p->ast, SBOOL, NULL)))
-					symbol_redefinition_error(p, p->c->row, p->c->col);
+				if (astree_add_attribute(p->ast, symbol, astree_attribute_create(SBOOL, NULL)))
+					symbol_redefinition_error(p, p->c.row, p->c.col);
 			nsdecl->symbol_type = SBOOL;
 			match(p, TBOOL);
 			break;
 		default:
 			p->ast->is_valid = 0;
-			lister_syn_error(p->lst, p->c->row, p->c->col, "expected integer, real or boolean");
+			lister_syn_error(p->lst, p->c.row, p->c.col, "expected integer, real or boolean");
 			error_recovery(p);
 			break;
 	}
@@ -668,51 +1117,52 @@ ASTNode *n_sdecl(Parser *p) {
 
 ASTNode *n_arrdecls(Parser *p) {
 	p->progress = 3;
-	int row = p->c->row;
-	int col = p->c->col;
+	int row = p->c.row;
+	int col = p->c.col;
 	ASTNode *narrd = n_arrdecl(p);
-	if (p->c->type == TCOMA) {
+	if (p->c.type == TCOMA) {
 		match(p, TCOMA);
-		ASTNode *nalist = make_node(NALIST, row, col, SNONE, NULL);
-		nalist->left_child = narrd;
-		nalist->right_child = n_arrdecls(p);
+		ASTNode *nalist = make_node(p->ast, NALIST, row, col, SNONE, NULL);
+		nalist->left = node_id(narrd);
+		nalist->right = node_id(n_arrdecls(p));
 		return nalist;
 	}
 	return narrd;
 }
 
 ASTNode *n_arrdecl(Parser *p) {
-	int row = p->c->row;
-	int col = p->c->col;
-	Symbol *var_symbol = astree_add_symbol(p->ast, p->c->val, p->scope);
+	int row = p->c.row;
+	int col = p->c.col;
+	Symbol *var_symbol = astree_add_symbol(p->ast, p->c.id, p->scope);
 	match(p, TIDEN);
 	match(p, TCOLN);
-	Symbol *type_symbol = astree_add_symbol(p->ast, p->c->val, p->scope);
+	Symbol *type_symbol = astree_add_symbol(p->ast, p->c.id, 0); // array defs are global scope
 	match(p, TIDEN);
 	if (!astree_get_attribute(p->ast, var_symbol)) {
-		astree_add_attribute(p->ast, var_symbol, astree_attribute_create(p->ast, SARRAY, type_symbol));
+		astree_add_attribute(p->ast, var_symbol, astree_attribute_create(SARRAY, type_symbol));
 	} else {
 		p->ast->is_valid = 0;
-		lister_sem_error(p->lst, p->c->row, p->c->col, "global array name has a collision");
+		lister_sem_error(p->lst, p->c.row, p->c.col, "global array name has a collision");
 	}
-	return make_node(NARRD, row, col, SARRAY, var_symbol);
+	return make_node(p->ast, NARRD, row, col, SARRAY, var_symbol);
 }
 
 ASTNode *n_func(Parser *p) {
 	p->progress = 5; // synchronise on TLPAR, ; , end
 	p->scope++;
-	ASTNode *nfund = make_node(NFUND, p->c->row, p->c->col, SNONE, NULL);
+	symboltable_enter_scope(p->ast->symboltable);
+	ASTNode *nfund = make_node(p->ast, NFUND, p->c.row, p->c.col, SNONE, NULL);
 	match(p, TFUNC);
-	Symbol *fname = astree_add_symbol(p->ast, p->c->val, 0); // functions are global scope
-	nfund->symbol_value = fname;
+	Symbol *fname = astree_add_symbol(p->ast, p->c.id, 0); // functions are global scope
+	node_set_symbol(p->ast, nfund, fname);
 	match(p, TIDEN);
 	match(p, TLPAR);
 	p->progress = 6;
-	nfund->left_child = n_plist(p);
+	nfund->left = node_id(n_plist(p));
 	match(p, TRPAR);
 	match(p, TCOLN);
 	enum symbol_type ret_type;
-	switch (p->c->type) {
+	switch (p->c.type) {
 		case TINTG:
 			ret_type = SINT;
 			match(p, TINTG);
@@ -731,121 +1181,240 @@ ASTNode *n_func(Parser *p) {
 			break;
 		default:
 			p->ast->is_valid = 0;
-			lister_syn_error(p->lst, p->c->row, p->c->col, "invalid return type");
+			lister_syn_error(p->lst, p->c.row, p->c.col, "invalid return type");
 			p->progress = 8;
 			error_recovery(p);
 	}
 	p->progress = 8;
-	nfund->middle_child = n_locals(p);
+	nfund->middle = node_id(n_locals(p));
 	match(p, TBEGN);
 	p->progress = 9;
-	nfund->right_child = n_stats(p);
+	nfund->right = node_id(n_stats(p));
 	match(p, TTEND);
-	if (astree_add_attribute(p->ast, fname, make_func_attribute(p, nfund->left_child, ret_type)))
-		symbol_redefinition_error(p, p->c->row, p->c->col);
+	symboltable_exit_scope(p->ast->symboltable);
+	if (astree_add_attribute(p->ast, fname, make_func_attribute(p, node_left(p->ast, nfund), ret_type)))
+		symbol_redefinition_error(p, p->c.row, p->c.col);
 	return nfund;
 }
 
 ASTNode *n_plist(Parser *p) {
-	if (p->c->type == TRPAR)
+	if (p->c.type == TRPAR)
 		return NULL;
 	return n_params(p);
 }
 
 ASTNode *n_params(Parser *p) {
-	u16 row = p->c->row;
-	u16 col = p->c->col;
+	u32 row = p->c.row;
+	u32 col = p->c.col;
 	ASTNode *left = n_param(p);
-	if (p->c->type != TCOMA)
+	if (p->c.type != TCOMA)
 		return left;
 	match(p, TCOMA);
-	ASTNode *nplist = make_node(NPLIST, row, col, SNONE, NULL);
-	nplist->left_child = left;
-	nplist->right_child = n_params(p);
+	ASTNode *nplist = make_node(p->ast, NPLIST, row, col, SNONE, NULL);
+	nplist->left = node_id(left);
+	nplist->right = node_id(n_params(p));
 	return nplist;
 }
 
 ASTNode *n_param(Parser *p) {
-	if (p->c->type == TCNST) {
-		ASTNode *narrc = make_node(NARRC, p->c->row, p->c->col, SNONE, NULL);
+	if (p->c.type == TCNST) {
+		ASTNode *narrc = make_node(p->ast, NARRC, p->c.row, p->c.col, SNONE, NULL);
 		match(p, TCNST);
-		narrc->left_child = n_arrdecl(p);
+		narrc->left = node_id(n_arrdecl(p));
 		return narrc;
 	}
 	return n_decl(p);
 }
 
 ASTNode *n_locals(Parser *p) {
-	if (p->c->type != TIDEN)
+	if (p->c.type != TIDEN)
 		return NULL;
 	return n_dlist(p);
 }
 
 ASTNode *n_dlist(Parser *p) {
-	u16 row = p->c->row;
-	u16 col = p->c->col;
+	u32 row = p->c.row;
+	u32 col = p->c.col;
 	ASTNode *left = n_decl(p);
-	if (p->c->type != TCOMA)
+	if (p->c.type != TCOMA)
 		return left;
 	match(p, TCOMA);
-	ASTNode *ndlist = make_node(NDLIST, row, col, SNONE, NULL);
-	ndlist->left_child = left;
-	ndlist->right_child = n_dlist(p);
+	ASTNode *ndlist = make_node(p->ast, NDLIST, row, col, SNONE, NULL);
+	ndlist->left = node_id(left);
+	ndlist->right = node_id(n_dlist(p));
 	return ndlist;
 }
 
 ASTNode *n_decl(Parser *p) {
 	// sadly you can't call n_sdecl or n_arrdecl without left factoring because that'd require a second lookahead
 	// although the symbol table operations are different too
-	int row = p->c->row;
-	int col = p->c->col;
-	Symbol *var_symbol = astree_add_symbol(p->ast, p->c->val, p->scope);
+	int row = p->c.row;
+	int col = p->c.col;
+	Symbol *var_symbol = astree_add_symbol(p->ast, p->c.id, p->scope);
 	match(p, TIDEN);
 	match(p, TCOLN);
-	if (p->c->type == TIDEN) { // array
-		Symbol *type_symbol = astree_get_symbol(p->ast, p->c->val, 0); // array defs are global scope
-		if (astree_add_attribute(p->ast, var_symbol, astree_attribute_create(p->ast, SARRAY, type_symbol)))
-			symbol_redefinition_error(p, p->c->row, p->c->col);
+	if (p->c.type == TIDEN) { // array
+		Symbol *type_symbol = astree_add_symbol(p->ast, p->c.id, 0); // array defs are global scope
+		if (astree_add_attribute(p->ast, var_symbol, astree_attribute_create(SARRAY, type_symbol)))
+			symbol_redefinition_error(p, p->c.row, p->c.col);
 		match(p, TIDEN);
-		return make_node(NARRD, row, col, SARRAY, var_symbol);
+		return make_node(p->ast, NARRD, row, col, SARRAY, var_symbol);
 	} else { // primitive
-		switch (p->c->type) {
+		switch (p->c.type) {
 			case TINTG:
-				if (astree_add_attribute(p->ast, var_symbol, astree_attribute_create(p->ast, SINT, NULL)))
-					symbol_redefinition_error(p, p->c->row, p->c->col);
+				if (astree_add_attribute(p->ast, var_symbol, astree_attribute_create(SINT, NULL)))
+					symbol_redefinition_error(p, p->c.row, p->c.col);
 				match(p, TINTG);
-				return make_node(NSDECL, row, col, SINT, var_symbol);
+				return make_node(p->ast, NSDECL, row, col, SINT, var_symbol);
 			case TREAL:
-				if (astree_add_attribute(p->ast, var_symbol, astree_attribute_create(p->ast, SREAL, NULL)))
-					symbol_redefinition_error(p, p->c->row, p->c->col);
+				if (astree_add_attribute(p->ast, var_symbol, astree_attribute_create(SREAL, NULL)))
+					symbol_redefinition_error(p, p->c.row, p->c.col);
 				match(p, TREAL);
-				return make_node(NSDECL, row, col, SREAL, var_symbol);
+				return make_node(p->ast, NSDECL, row, col, SREAL, var_symbol);
 			case TBOOL:
-				if (astree_add_attribute(p->ast, var_symbol, astree_attribute_create(p->ast, SBOOL, NULL)))
-					symbol_redefinition_error(p, p->c->row, p->c->col);
+				if (astree_add_attribute(p->ast, var_symbol, astree_attribute_create(SBOOL, NULL)))
+					symbol_redefinition_error(p, p->c.row, p->c.col);
 				match(p, TBOOL);
-				return make_node(NSDECL, row, col, SBOOL, var_symbol);
+				return make_node(p->ast, NSDECL, row, col, SBOOL, var_symbol);
 			default:
-				lister_syn_error(p->lst, p->c->row, p->c->col, "unknown primitive type");
+				lister_syn_error(p->lst, p->c.row, p->c.col, "unknown primitive type");
 				error_recovery(p);
 		}
 	}
 }
 
-ASTNode *n_stats(Parser *p) {
-	ASTNode *nstats = make_node(NSTATS, p->c->row, p->c->col, SNONE, NULL);
-	nstats->left_child = n_stat(p);
-	switch (p->c->type) {
+static int starts_stat(enum token_type type) {
+	switch (type) {
 		case TTFOR: case TIFTH: case TREPT: case TIDEN: case TINPT: case TOUTP: case TRETN:
-			nstats->right_child = n_stats(p);
-			break;
+			return 1;
+		default:
+			return 0;
+	}
+}
+
+static ASTNode *for_head(Parser *p) {
+	ASTNode *nforl = make_node(p->ast, NFORL, p->c.row, p->c.col, SNONE, NULL);
+	match(p, TTFOR);
+	match(p, TLPAR);
+	nforl->left = node_id(n_asgnlist(p));
+	match(p, TSEMI);
+	nforl->middle = node_id(n_bool(p));
+	match(p, TRPAR);
+	return nforl;
+}
+
+static ASTNode *repeat_head(Parser *p) {
+	ASTNode *nrept = make_node(p->ast, NREPT, p->c.row, p->c.col, SNONE, NULL);
+	match(p, TREPT);
+	match(p, TLPAR);
+	nrept->left = node_id(n_asgnlist(p));
+	match(p, TRPAR);
+	return nrept;
+}
+
+// the predicate
+static ASTNode *if_head(Parser *p) {
+	match(p, TIFTH);
+	match(p, TLPAR);
+	ASTNode *predicate = n_bool(p);
+	match(p, TRPAR);
+	return predicate;
+}
+
+static ASTNode *if_node(Parser *p, u32 row, u32 col, ASTNode *predicate, ASTNode *stats0, ASTNode *stats1) {
+	if (stats1) {
+		ASTNode *nifte = make_node(p->ast, NIFTE, row, col, SNONE, NULL);
+		nifte->left = node_id(predicate);
+		nifte->middle = node_id(stats0);
+		nifte->right = node_id(stats1);
+		return nifte;
+	} else {
+		ASTNode *nifth = make_node(p->ast, NIFTH, row, col, SNONE, NULL);
+		nifth->left = node_id(predicate);
+		nifth->right = node_id(stats0);
+		return nifth;
+	}
+}
+
+// a for, repeat or if doesn't recurse, its statements are parsed here with the block pushed on p->blocks
+ASTNode *n_stats(Parser *p) {
+	u32 base = p->block_count; // error_recovery can get here again from further in
+	ASTNode *head = NULL, *tail = NULL;
+	for (;;) {
+		ASTNode *nstats = make_node(p->ast, NSTATS, p->c.row, p->c.col, SNONE, NULL);
+		if (tail)
+			tail->right = node_id(nstats);
+		else
+			head = nstats;
+		tail = nstats;
+		u32 span = p->spans ? span_open_stat(p, nstats) : 0;
+		struct open_block b = { .head = head, .tail = tail, .span = span, .row = p->c.row, .col = p->c.col };
+		switch (p->c.type) {
+			case TTFOR:
+				b.kind = OPEN_FOR;
+				b.stat = for_head(p);
+				break;
+			case TREPT:
+				b.kind = OPEN_REPEAT;
+				b.stat = repeat_head(p);
+				break;
+			case TIFTH:
+				b.kind = OPEN_THEN;
+				b.stat = if_head(p);
+				break;
+			default: {
+				ASTNode *stat = n_stat(p);
+				// close the statement, and then any blocks it was the last of
+				int reopened = 0;
+				while (!reopened) {
+					tail->left = node_id(stat);
+					if (p->spans)
+						span_close_stat(p, span);
+					if (starts_stat(p->c.type))
+						break;
+					if (p->block_count == base)
+						return head;
+					ASTNode *list = head;
+					b = p->blocks[--p->block_count];
+					head = b.head;
+					tail = b.tail;
+					span = b.span;
+					if (b.kind == OPEN_FOR) {
+						b.stat->right = node_id(list);
+						match(p, TTEND);
+						stat = b.stat;
+					} else if (b.kind == OPEN_REPEAT) {
+						b.stat->middle = node_id(list);
+						match(p, TUNTL);
+						b.stat->right = node_id(n_bool(p));
+						match(p, TSEMI);
+						stat = b.stat;
+					} else if (b.kind == OPEN_THEN && p->c.type == TELSE) {
+						match(p, TELSE);
+						b.kind = OPEN_ELSE;
+						b.then = list;
+						reopened = 1;
+					} else {
+						match(p, TTEND);
+						if (b.kind == OPEN_ELSE)
+							stat = if_node(p, b.row, b.col, b.stat, b.then, list);
+						else
+							stat = if_node(p, b.row, b.col, b.stat, list, NULL);
+					}
+				}
+				if (!reopened)
+					continue; // on to the list's next statement
+				break;
+			}
+		}
+		push_block(p, b);
+		head = tail = NULL;
 	}
-	return nstats;
 }
 
 ASTNode *n_stat(Parser *p) {
 	ASTNode *result;
-	switch (p->c->type) {
+	switch (p->c.type) {
 		// strstat
 		case TTFOR:
 			result = n_forstat(p);
@@ -868,7 +1437,7 @@ ASTNode *n_stat(Parser *p) {
 			match(p, TSEMI);
 			return result;
 		case TIDEN:
-			if (p->n->type == TLPAR) {
+			if (p->n.type == TLPAR) {
 				result = n_callstat(p);
 			} else {
 				result = n_asgnstat(p);
@@ -877,88 +1446,67 @@ ASTNode *n_stat(Parser *p) {
 			return result;
 		default:
 			p->ast->is_valid = 0;
-			lister_syn_error(p->lst, p->c->row, p->c->col, "expected statement");
+			lister_syn_error(p->lst, p->c.row, p->c.col, "expected statement");
 			error_recovery(p);
 			return result;
 	}
 }
 
 ASTNode *n_forstat(Parser *p) {
-	ASTNode *nforl = make_node(NFORL, p->c->row, p->c->col, SNONE, NULL);
-	match(p, TTFOR);
-	match(p, TLPAR);
-	nforl->left_child = n_asgnlist(p);
-	match(p, TSEMI);
-	nforl->middle_child = n_bool(p);
-	match(p, TRPAR);
-	nforl->right_child = n_stats(p);
+	ASTNode *nforl = for_head(p);
+	nforl->right = node_id(n_stats(p));
 	match(p, TTEND);
 	return nforl;
 }
 
 ASTNode* n_repstat(Parser *p) {
-	ASTNode *nrept = make_node(NREPT, p->c->row, p->c->col, SNONE, NULL);
-	match(p, TREPT);
-	match(p, TLPAR);
-	nrept->left_child = n_asgnlist(p);
-	match(p, TRPAR);
-	nrept->middle_child = n_stats(p);
+	ASTNode *nrept = repeat_head(p);
+	nrept->middle = node_id(n_stats(p));
 	match(p, TUNTL);
-	nrept->right_child = n_bool(p);
+	nrept->right = node_id(n_bool(p));
 	return nrept;
 }
 
 ASTNode *n_asgnlist(Parser *p) {
-	if (p->c->type != TIDEN)
+	if (p->c.type != TIDEN)
 		return NULL; // ε
-	u16 row = p->c->row;
-	u16 col = p->c->col;
-	ASTNode *asgnstat = n_asgnstat(p);
-	if (p->c->type != TCOMA) {
-		return asgnstat;
-	} else {
-		ASTNode *nasgns = make_node(NASGNS, p->c->row, p->c->col, SNONE, NULL);
-		nasgns->left_child = asgnstat;
+	u32 head = 0, *link = &head;
+	for (;;) {
+		ASTNode *asgnstat = n_asgnstat(p);
+		if (p->c.type != TCOMA) {
+			*link = node_id(asgnstat);
+			return astree_node(p->ast, head);
+		}
+		ASTNode *nasgns = make_node(p->ast, NASGNS, p->c.row, p->c.col, SNONE, NULL);
+		nasgns->left = node_id(asgnstat);
+		*link = node_id(nasgns);
+		link = &nasgns->right;
 		match(p, TCOMA);
-		nasgns->right_child = n_asgnlist(p);
-		return nasgns;
+		if (p->c.type != TIDEN)
+			return astree_node(p->ast, head); // ε
 	}
 }
 
 ASTNode *n_ifstat(Parser *p) {
-	u16 row = p->c->row;
-	u16 col = p->c->col;
-	match(p, TIFTH);
-	match(p, TLPAR);
-	ASTNode *predicate = n_bool(p);
-	match(p, TRPAR);
+	u32 row = p->c.row;
+	u32 col = p->c.col;
+	ASTNode *predicate = if_head(p);
 	ASTNode *stats0 = n_stats(p);
 	ASTNode *stats1 = NULL;
-	if (p->c->type == TELSE) {
+	if (p->c.type == TELSE) {
 		match(p, TELSE);
 		stats1 = n_stats(p);
 	}
 	match(p, TTEND);
-	if (stats1) {
-		ASTNode *nifte = make_node(NIFTE, row, col, SNONE, NULL);
-		nifte->left_child = predicate;
-		nifte->middle_child = stats0;
-		nifte->right_child = stats1;
-		return nifte;
-	} else {
-		ASTNode *nifth = make_node(NIFTH, row, col, SNONE, NULL);
-		nifth->left_child = predicate;
-		nifth->right_child = stats0;
-		return nifth;
-	}
+	return if_node(p, row, col, predicate, stats0, stats1);
 }
 
 ASTNode *n_asgnstat(Parser *p) {
-	u16 row = p->c->row;
-	u16 col = p->c->col;
+	u32 row = p->c.row;
+	u32 col = p->c.col;
 	ASTNode *var = n_var(p);
 	enum node_type type;
-	switch (p->c->type) {
+	switch (p->c.type) {
 		case TEQUL:
 			type = NASGN;
 			break;
@@ -976,41 +1524,41 @@ ASTNode *n_asgnstat(Parser *p) {
 			break;
 		default:
 			p->ast->is_valid = 0;
-			lister_syn_error(p->lst, p->c->row, p->c->col, "expected asignment operator");
+			lister_syn_error(p->lst, p->c.row, p->c.col, "expected asignment operator");
 			error_recovery(p);
 			break;
 	}
-	ASTNode *oper = make_node(type, row, col, SNONE, NULL);
-	oper->left_child = var;
-	next_token(p, 1);
-	oper->right_child = n_bool(p);
+	ASTNode *oper = make_node(p->ast, type, row, col, SNONE, NULL);
+	oper->left = node_id(var);
+	next_token(p);
+	oper->right = node_id(n_bool(p));
 	return oper;
 }
 
 ASTNode *n_iostat(Parser *p) {
-	if (p->c->type == TINPT) {
-		ASTNode *ninput = make_node(NINPUT, p->c->row, p->c->col, SNONE, NULL);
+	if (p->c.type == TINPT) {
+		ASTNode *ninput = make_node(p->ast, NINPUT, p->c.row, p->c.col, SNONE, NULL);
 		match(p, TINPT);
 		match(p, TGRGR);
-		ninput->left_child = n_vlist(p);
+		ninput->left = node_id(n_vlist(p));
 		return ninput;
 	} else {
-		u16 row = p->c->row;
-		u16 col = p->c->col;
+		u32 row = p->c.row;
+		u32 col = p->c.col;
 		match(p, TOUTP);
 		match(p, TLSLS);
-		if (p->c->type == TOUTL) {
+		if (p->c.type == TOUTL) {
 			match(p, TOUTL);
-			return make_node(NOUTL, row, col, SNONE, NULL);
+			return make_node(p->ast, NOUTL, row, col, SNONE, NULL);
 		}
 		ASTNode *prlist = n_prlist(p);
-		if (p->c->type != TLSLS) {
-			ASTNode *noutp = make_node(NOUTP, row, col, SNONE, NULL);
-			noutp->left_child = prlist;
+		if (p->c.type != TLSLS) {
+			ASTNode *noutp = make_node(p->ast, NOUTP, row, col, SNONE, NULL);
+			noutp->left = node_id(prlist);
 			return noutp;
 		} else {
-			ASTNode *noutl = make_node(NOUTL, row, col, SNONE, NULL);
-			noutl->left_child = prlist;
+			ASTNode *noutl = make_node(p->ast, NOUTL, row, col, SNONE, NULL);
+			noutl->left = node_id(prlist);
 			match(p, TLSLS);
 			match(p, TOUTL);
 			return noutl;
@@ -1019,138 +1567,93 @@ ASTNode *n_iostat(Parser *p) {
 }
 
 ASTNode *n_callstat(Parser *p) {
-	Symbol *iden = astree_add_symbol(p->ast, p->c->val, p->scope);
-	ASTNode *ncall = make_node(NCALL, p->c->row, p->c->col, SNONE, iden);
+	Symbol *iden = astree_add_symbol(p->ast, p->c.id, p->scope);
+	ASTNode *ncall = make_node(p->ast, NCALL, p->c.row, p->c.col, SNONE, iden);
 	match(p, TIDEN);
 	match(p, TLPAR);
-	if (p->c->type != TRPAR) {
-		ncall->left_child = n_elist(p);
+	if (p->c.type != TRPAR) {
+		ncall->left = node_id(n_elist(p));
 	}
 	match(p, TRPAR);
 	return ncall;
 }
 
 ASTNode *n_returnstat(Parser *p) {
-	ASTNode *nretn = make_node(NRETN, p->c->row, p->c->col, SNONE, NULL);
+	ASTNode *nretn = make_node(p->ast, NRETN, p->c.row, p->c.col, SNONE, NULL);
 	match(p, TRETN);
-	if (p->c->type == TVOID) {
+	if (p->c.type == TVOID) {
 		match(p, TVOID);
 		return nretn;
 	} else {
-		nretn->left_child = n_expr(p);
+		nretn->left = node_id(n_expr(p));
 		return nretn;
 	}
 }
 
 ASTNode *n_vlist(Parser *p) {
-	u16 row = p->c->row;
-	u16 col = p->c->col;
-	ASTNode *var = n_var(p);
-	if (p->c->type != TCOMA) {
-		return var;
+	u32 head = 0, *link = &head;
+	for (;;) {
+		u32 row = p->c.row;
+		u32 col = p->c.col;
+		ASTNode *var = n_var(p);
+		if (p->c.type != TCOMA) {
+			*link = node_id(var);
+			return astree_node(p->ast, head);
+		}
+		ASTNode *nvlist = make_node(p->ast, NVLIST, row, col, SNONE, NULL);
+		nvlist->left = node_id(var);
+		*link = node_id(nvlist);
+		link = &nvlist->right;
+		match(p, TCOMA);
 	}
-	ASTNode *nvlist = make_node(NVLIST, row, col, SNONE, NULL);
-	nvlist->left_child = var;
-	match(p, TCOMA);
-	nvlist->right_child = n_vlist(p);
-	return nvlist;
 }
 
 ASTNode *n_var(Parser *p) {
-	Symbol *varname = astree_add_symbol(p->ast, p->c->val, p->scope);
-	ASTNode *nsimv = make_node(NSIMV, p->c->row, p->c->col, SNONE, varname);
-	if (p->n->type != TLBRK) {
+	Symbol *varname = astree_add_symbol(p->ast, p->c.id, p->scope);
+	ASTNode *nsimv = make_node(p->ast, NSIMV, p->c.row, p->c.col, SNONE, varname);
+	if (p->n.type != TLBRK) {
 		match(p, TIDEN);
 		return nsimv;
 	}
-	u16 row = p->c->row;
-	u16 col = p->c->col;
+	u32 row = p->c.row;
+	u32 col = p->c.col;
 	match(p, TIDEN);
 	match(p, TLBRK);
 	ASTNode *arr_index = n_expr(p);
 	match(p, TRBRK);
-	if (p->c->type != TDOTT) {
-		ASTNode *naelt = make_node(NAELT, row, col, SSTRUCT, NULL);
-		naelt->left_child = nsimv;
-		naelt->right_child = arr_index;
+	if (p->c.type != TDOTT) {
+		ASTNode *naelt = make_node(p->ast, NAELT, row, col, SSTRUCT, NULL);
+		naelt->left = node_id(nsimv);
+		naelt->right = node_id(arr_index);
 		return naelt;
 	} else {
-		ASTNode *narrv = make_node(NARRV, row, col, SNONE, NULL);
-		narrv->left_child = nsimv;
-		narrv->right_child = arr_index;
+		ASTNode *narrv = make_node(p->ast, NARRV, row, col, SNONE, NULL);
+		narrv->left = node_id(nsimv);
+		narrv->right = node_id(arr_index);
 		match(p, TDOTT);
-		Symbol *field_name = astree_add_symbol(p->ast, p->c->val, p->scope);
-		narrv->symbol_value = field_name;
+		Symbol *field_name = astree_add_symbol(p->ast, p->c.id, p->scope);
+		node_set_symbol(p->ast, narrv, field_name);
 		match(p, TIDEN);
 		return narrv;
 	}
 }
 
 ASTNode *n_elist(Parser *p) {
-	ASTNode *nexpl = make_node(NEXPL, p->c->row, p->c->col, SNONE, NULL);
-	nexpl->left_child = n_bool(p);
-	if (p->c->type == TCOMA) {
+	ASTNode *head = make_node(p->ast, NEXPL, p->c.row, p->c.col, SNONE, NULL);
+	head->left = node_id(n_bool(p));
+	for (ASTNode *nexpl = head; p->c.type == TCOMA; ) {
 		match(p, TCOMA);
-		nexpl->right_child = n_elist(p);
-	}
-	return nexpl;
-}
-
-ASTNode *n_bool(Parser *p) {
-	u16 row = p->c->row;
-	u16 col = p->c->col;
-	ASTNode *left = n_rel(p);
-	ASTNode *operator;
-	switch (p->c->type) {
-		case TTAND:
-			operator = make_node(NAND, p->c->row, p->c->col, SBOOL, NULL);
-			match(p, TTAND);
-			break;
-		case TTTOR:
-			operator = make_node(NOR, p->c->row, p->c->col, SBOOL, NULL);
-			match(p, TTTOR);
-			break;
-		case TTXOR:
-			operator = make_node(NXOR, p->c->row, p->c->col, SBOOL, NULL);
-			match(p, TTXOR);
-			break;
-		default:
-			return left;
-	}
-	ASTNode *nbool = make_node(NBOOL, row, col, SBOOL, NULL);
-	nbool->left_child = left;
-	nbool->middle_child = operator;
-	nbool->right_child = n_bool(p);
-	return nbool;
-}
-
-ASTNode *n_rel(Parser *p) {
-	if (p->c->type == TNOTT) {
-		// todo: move all such types into semantic analysis
-		ASTNode *nnot = make_node(NNOT, p->c->row, p->c->col, SBOOL, NULL);
-		match(p, TNOTT);
-		nnot->left_child = n_expr(p);
-		nnot->middle_child = n_relop(p);
-		nnot->right_child = n_expr(p);
-		return nnot;
-	}
-	ASTNode *left = n_expr(p);
-	enum token_type ct = p->c->type;
-	if (ct == TEQEQ || ct == TNEQL || ct == TGRTR || ct == TLESS || ct == TLEQL || ct == TGEQL) {
-		ASTNode *relop = n_relop(p);
-		ASTNode *right = n_rel(p);
-		relop->left_child = left;
-		relop->right_child = right;
-		return relop;
-	}
-	else {
-		return left;
+		ASTNode *next = make_node(p->ast, NEXPL, p->c.row, p->c.col, SNONE, NULL);
+		nexpl->right = node_id(next);
+		nexpl = next;
+		nexpl->left = node_id(n_bool(p));
 	}
+	return head;
 }
 
 ASTNode *n_relop(Parser *p) {
 	int node_type = -1;
-	switch(p->c->type) {
+	switch(p->c.type) {
 		case TEQEQ:
 			node_type = NEQL;
 			break;
@@ -1171,166 +1674,217 @@ ASTNode *n_relop(Parser *p) {
 			break;
 	}
 	if (node_type != -1) {
-		ASTNode *out = make_node(node_type, p->c->row, p->c->col, SBOOL, NULL);
-		next_token(p, 1);
+		ASTNode *out = make_node(p->ast, node_type, p->c.row, p->c.col, SBOOL, NULL);
+		next_token(p);
 		return out;
 	}
 	p->ast->is_valid = 0;
-	lister_syn_error(p->lst, p->c->row, p->c->col, "unexpected relational operator");
+	lister_syn_error(p->lst, p->c.row, p->c.col, "unexpected relational operator");
 	error_recovery(p);
 	return NULL;
 }
 
-static ASTNode *expr_helper(Parser *p, int is_root_of_fact);
-static ASTNode *term_helper(Parser *p, int is_root_of_fact);
-static ASTNode *fact_helper(Parser *p, int is_root_of_fact);
-// a fun recursive algorithm to turn a recursive descent expr tree valid
-// swaps the right child's left child with the current node, then steps to the former right child
-static ASTNode *invert_expr(ASTNode *a) {
-	ASTNode *b = a->right_child;
-	if (b->type != NADD && b->type != NSUB)
-		return a; // terminate when right is leaf
-	ASTNode *temp = b->left_child;
-	b->left_child = a;
-	a->right_child = temp;
-	return invert_expr(b);
-}
-
-// this used to be n_expr until I needed to differentiate first call for the inversion to be done only once on the final tree
-static ASTNode *expr_helper(Parser *p, int is_root_of_expr) {
-	ASTNode *left = term_helper(p, 0);
-	switch (p->c->type) {
+// how tightly each binary operator holds its operands, a level only takes operands from the levels above it
+enum binding { BIND_NONE, BIND_BOOL, BIND_REL, BIND_EXPR, BIND_TERM, BIND_FACT };
+
+static enum binding binding_of(enum token_type type) {
+	switch (type) {
+		case TTAND:
+		case TTTOR:
+		case TTXOR:
+			return BIND_BOOL;
+		case TEQEQ:
+		case TNEQL:
+		case TGRTR:
+		case TLESS:
+		case TLEQL:
+		case TGEQL:
+			return BIND_REL;
 		case TPLUS:
-			ASTNode *nadd = make_node(NADD, p->c->row, p->c->col, SNONE, NULL);
-			match(p, TPLUS);
-			nadd->left_child = left;
-			// the grammar says term, I have intentionally disregarded it here to extend for 3-1-1-1 to be valid syntax
-			nadd->right_child = expr_helper(p, 0);
-			if (is_root_of_expr)
-				nadd = invert_expr(nadd);
-			return nadd;
 		case TMINS:
-			ASTNode *nsub = make_node(NSUB, p->c->row, p->c->col, SNONE, NULL);
-			match(p, TMINS);
-			nsub->left_child = left;
-			nsub->right_child = expr_helper(p, 0);
-			if (is_root_of_expr)
-				nsub = invert_expr(nsub); // note: "nsub" may be a nadd after this
-			return nsub;
+			return BIND_EXPR;
+		case TSTAR:
+		case TDIVD:
+		case TPERC:
+			return BIND_TERM;
+		case TCART:
+			return BIND_FACT;
 		default:
-			return left;
+			return BIND_NONE;
 	}
 }
 
-ASTNode *n_expr(Parser *p) {
-	return expr_helper(p, 1);
-	// return invert_expr(expr_helper(p)); this approach leads to segfault, idk why
+static enum node_type arith_node(enum token_type type) {
+	switch (type) {
+		case TPLUS: return NADD;
+		case TMINS: return NSUB;
+		case TSTAR: return NMUL;
+		case TDIVD: return NDIV;
+		case TPERC: return NMOD;
+		default: return NPOW;
+	}
 }
 
-static ASTNode *invert_term(ASTNode *a) {
-	ASTNode *b = a->right_child;
-	if (b->type != NMUL && b->type != NDIV && b->type != NMOD)
-		return a; // terminate when right is leaf
-	ASTNode *temp = b->left_child;
-	b->left_child = a;
-	a->right_child = temp;
-	return invert_term(b);
+static enum node_type bool_node(enum token_type type) {
+	switch (type) {
+		case TTAND: return NAND;
+		case TTTOR: return NOR;
+		default: return NXOR;
+	}
 }
 
-static ASTNode *term_helper(Parser *p, int is_root_of_term) {
-	ASTNode *left = fact_helper(p, 0);
-	switch (p->c->type) {
-		case TSTAR:
-			ASTNode *nmul = make_node(NMUL, p->c->row, p->c->col, SNONE, NULL);
-			match(p, TSTAR);
-			nmul->left_child = left;
-			nmul->right_child = term_helper(p, 0);
-			if (is_root_of_term)
-				nmul = invert_term(nmul);
-			return nmul;
-		case TDIVD:
-			ASTNode *ndiv = make_node(NDIV, p->c->row, p->c->col, SNONE, NULL);
-			match(p, TDIVD);
-			ndiv->left_child = left;
-			ndiv->right_child = term_helper(p, 0);
-			if (is_root_of_term)
-				ndiv = invert_term(ndiv);
-			return ndiv;
-		case TPERC:
-			ASTNode *nmod = make_node(NMOD, p->c->row, p->c->col, SNONE, NULL);
-			match(p, TPERC);
-			nmod->left_child = left;
-			nmod->right_child = term_helper(p, 0);
-			if (is_root_of_term)
-				nmod = invert_term(nmod);
-			return nmod;
-		default: //ε
-			return left;
+// precedence climbing for everything from <bool> (at BIND_BOOL) down to <fact> (at BIND_FACT)
+// and/or/xor, the relops and ^ group to the right, + - * / % to the left
+// where this would recurse for an operand (after an operator, in a not or in brackets) it pushes the
+// level it's at onto p->operators instead, and picks that back up once the operand is parsed
+static ASTNode *n_binary(Parser *p, enum binding min) {
+	u32 base = p->operator_count; // calls and array indices get here again from further in
+	struct open_operator o;
+	ASTNode *operand;
+	for (;;) {
+		// start an operand at min
+		o = (struct open_operator){ .row = p->c.row, .col = p->c.col, .min = min, .max = BIND_FACT };
+		if (p->c.type == TNOTT && min <= BIND_REL) {
+			// todo: move all such types into semantic analysis
+			o.left = make_node(p->ast, NNOT, p->c.row, p->c.col, SBOOL, NULL);
+			match(p, TNOTT);
+			o.then = AWAIT_NOT_LEFT;
+			push_operator(p, o);
+			min = BIND_EXPR;
+			continue;
+		}
+		if (p->c.type == TLPAR) {
+			match(p, TLPAR);
+			o.then = AWAIT_PAREN;
+			push_operator(p, o);
+			min = BIND_BOOL;
+			continue;
+		}
+		o.left = n_exponent(p);
+		// take operators while they bind tightly enough, or hand the finished operand down
+		for (;;) {
+			enum binding bind = binding_of(p->c.type);
+			if (bind == BIND_NONE || bind < o.min || bind > o.max) {
+				operand = o.left;
+				if (p->operator_count == base)
+					return operand;
+				o = p->operators[--p->operator_count];
+				switch (o.then) {
+					case AWAIT_NOT_LEFT:
+						o.left->left = node_id(operand);
+						o.left->middle = node_id(n_relop(p));
+						o.then = AWAIT_NOT_RIGHT;
+						break;
+					case AWAIT_NOT_RIGHT:
+						o.left->right = node_id(operand);
+						o.max = BIND_BOOL; // a not is a whole <rel>
+						continue;
+					case AWAIT_PAREN:
+						match(p, TRPAR);
+						o.left = operand;
+						continue;
+					case AWAIT_BOOL:
+						o.op->right = node_id(operand);
+						o.left = o.op; // and it's done, nothing can follow
+						o.max = BIND_NONE;
+						continue;
+					case AWAIT_REL:
+						o.op->right = node_id(operand);
+						o.left = o.op; // only and/or/xor can follow
+						o.max = BIND_BOOL;
+						continue;
+					case AWAIT_ARITH:
+						o.op->right = node_id(operand);
+						o.left = o.op;
+						continue;
+				}
+				min = BIND_EXPR; // the not's right side
+				break;
+			}
+			switch (bind) {
+				case BIND_BOOL:
+					o.op = make_node(p->ast, bool_node(p->c.type), p->c.row, p->c.col, SBOOL, NULL);
+					next_token(p);
+					ASTNode *nbool = make_node(p->ast, NBOOL, o.row, o.col, SBOOL, NULL);
+					nbool->left = node_id(o.left);
+					nbool->middle = node_id(o.op);
+					o.op = nbool;
+					o.then = AWAIT_BOOL;
+					min = BIND_BOOL;
+					break;
+				case BIND_REL:
+					o.op = n_relop(p);
+					o.op->left = node_id(o.left);
+					o.then = AWAIT_REL;
+					min = BIND_REL;
+					break;
+				case BIND_FACT:
+					o.op = make_node(p->ast, NPOW, p->c.row, p->c.col, SNONE, NULL);
+					next_token(p);
+					o.op->left = node_id(o.left);
+					o.then = AWAIT_ARITH;
+					min = BIND_FACT;
+					break;
+				default: // + - * / %, the operator's right operand stops at anything as loose as it is
+					o.op = make_node(p->ast, arith_node(p->c.type), p->c.row, p->c.col, SNONE, NULL);
+					next_token(p);
+					o.op->left = node_id(o.left);
+					o.then = AWAIT_ARITH;
+					min = bind + 1;
+					break;
+			}
+			break;
+		}
+		push_operator(p, o);
 	}
 }
 
-ASTNode *n_term(Parser *p) {
-	return term_helper(p, 1);
+ASTNode *n_bool(Parser *p) {
+	return n_binary(p, BIND_BOOL);
 }
 
-static ASTNode *invert_fact(ASTNode *a) {
-	ASTNode *b = a->right_child;
-	if (b->type != NPOW)
-		return a; // terminate when right is leaf
-	ASTNode *temp = b->left_child;
-	b->left_child = a;
-	a->right_child = temp;
-	return invert_fact(b);
+ASTNode *n_rel(Parser *p) {
+	return n_binary(p, BIND_REL);
 }
 
-static ASTNode *fact_helper(Parser *p, int is_root_of_fact) {
-	ASTNode *left = n_exponent(p);
-	switch (p->c->type) {
-		case TCART:
-			ASTNode *npow = make_node(NPOW, p->c->row, p->c->col, SNONE, NULL);
-			match(p, TCART);
-			npow->left_child = left;
-			npow->right_child = fact_helper(p, 0);
-			if (is_root_of_fact)
-				npow = invert_fact(npow);
-			return npow;
-		default:
-			return left;
-	}
+ASTNode *n_expr(Parser *p) {
+	return n_binary(p, BIND_EXPR);
+}
+
+ASTNode *n_term(Parser *p) {
+	return n_binary(p, BIND_TERM);
 }
 
 ASTNode *n_fact(Parser *p) {
-	return fact_helper(p, 1);
+	return n_binary(p, BIND_FACT);
 }
 
 ASTNode *n_exponent(Parser *p) {
 	Symbol *symbol;
-	switch (p->c->type) {
+	switch (p->c.type) {
 		case TILIT:
-			symbol = astree_add_symbol(p->ast, p->c->val, p->scope);
-			ASTNode *nilit = make_node(NILIT, p->c->row, p->c->col, SINT, symbol);
+			symbol = astree_add_symbol(p->ast, p->c.id, p->scope);
+			ASTNode *nilit = make_node(p->ast, NILIT, p->c.row, p->c.col, SINT, symbol);
+			nilit->lit = p->c.lit;
 			match(p, TILIT);
 			return nilit;
 		case TFLIT:
-			symbol = astree_add_symbol(p->ast, p->c->val, p->scope);
-			ASTNode *nflit = make_node(NFLIT, p->c->row, p->c->col, SREAL, symbol);
+			symbol = astree_add_symbol(p->ast, p->c.id, p->scope);
+			ASTNode *nflit = make_node(p->ast, NFLIT, p->c.row, p->c.col, SREAL, symbol);
+			nflit->lit = p->c.lit;
 			match(p, TFLIT);
 			return nflit;
 		case TTRUE:
-			ASTNode *ntrue = make_node(NTRUE, p->c->row, p->c->col, SBOOL, NULL);
+			ASTNode *ntrue = make_node(p->ast, NTRUE, p->c.row, p->c.col, SBOOL, NULL);
 			match(p, TTRUE);
 			return ntrue;
 		case TFALS:
-			ASTNode *nfals = make_node(NFALS, p->c->row, p->c->col, SBOOL, NULL);
+			ASTNode *nfals = make_node(p->ast, NFALS, p->c.row, p->c.col, SBOOL, NULL);
 			match(p, TFALS);
 			return nfals;
-		case TLPAR:
-			match(p, TLPAR);
-			ASTNode *nbool = n_bool(p); // this might need to be bool_helper, but it seems to work
-			match(p, TRPAR);
-			return nbool;
+		// ( <bool> ) is taken by n_binary, which calls this for everything else
 		case TIDEN:
-			if (p->n->type == TLPAR) { // function
+			if (p->n.type == TLPAR) { // function
 				return n_fncall(p);
 			}
 			else { // id[
@@ -1338,44 +1892,48 @@ ASTNode *n_exponent(Parser *p) {
 			}
 		default:
 			p->ast->is_valid = 0;
-			lister_syn_error(p->lst, p->c->row, p->c->col, "unexpected exponent value");
-			next_token(p, 1);
+			lister_syn_error(p->lst, p->c.row, p->c.col, "unexpected exponent value");
+			next_token(p);
 			error_recovery(p);
 			return NULL;
 	}
 }
 
 ASTNode *n_fncall(Parser *p) {
-	u16 row = p->c->row;
-	u16 col = p->c->col;
-	Symbol *funcname = astree_add_symbol(p->ast, p->c->val, p->scope);
-	ASTNode *nfcall = make_node(NFCALL, p->c->row, p->c->col, SNONE, funcname);
+	u32 row = p->c.row;
+	u32 col = p->c.col;
+	Symbol *funcname = astree_add_symbol(p->ast, p->c.id, p->scope);
+	ASTNode *nfcall = make_node(p->ast, NFCALL, p->c.row, p->c.col, SNONE, funcname);
 	match(p, TIDEN);
 	match(p, TLPAR);
-	if (p->c->type != TRPAR)
-		nfcall->left_child = n_elist(p);
+	if (p->c.type != TRPAR)
+		nfcall->left = node_id(n_elist(p));
 	match(p, TRPAR);
 	return nfcall;
 }
 
 ASTNode *n_prlist(Parser *p) {
-	u16 row = p->c->row;
-	u16 col = p->c->col;
-	ASTNode *pritem = n_printitem(p);
-	if (p->c->type != TCOMA) {
-		return pritem;
-	}
-	ASTNode *nprlst = make_node(NPRLST, row, col, SNONE, NULL);
-	nprlst->left_child = pritem;
-	match(p, TCOMA);
-	nprlst->right_child = n_prlist(p);
-	return nprlst;
+	u32 head = 0, *link = &head;
+	for (;;) {
+		u32 row = p->c.row;
+		u32 col = p->c.col;
+		ASTNode *pritem = n_printitem(p);
+		if (p->c.type != TCOMA) {
+			*link = node_id(pritem);
+			return astree_node(p->ast, head);
+		}
+		ASTNode *nprlst = make_node(p->ast, NPRLST, row, col, SNONE, NULL);
+		nprlst->left = node_id(pritem);
+		*link = node_id(nprlst);
+		link = &nprlst->right;
+		match(p, TCOMA);
+	}
 }
 
  ASTNode *n_printitem(Parser *p) {
-	if (p->c->type == TSTRG) {
-		Symbol *str_val = astree_add_symbol(p->ast, p->c->val, p->scope);
-		ASTNode *nstrg = make_node(NSTRG, p->c->row, p->c->col, SSTRING, str_val);
+	if (p->c.type == TSTRG) {
+		Symbol *str_val = astree_add_symbol(p->ast, p->c.id, p->scope);
+		ASTNode *nstrg = make_node(p->ast, NSTRG, p->c.row, p->c.col, SSTRING, str_val);
 		match(p, TSTRG);
 		return nstrg;
 	} else {
@@ -5,7 +5,25 @@
 #include "lister.h"
 
 // Parser *parser_create(const char *filename);
-ASTree *get_AST(const char *filename, Lister *list_file);
+// pipelined lexes on a second thread while parsing, lex_threads > 1 lexes big files in parallel chunks up front
+// (same tree and messages either way)
+// lexed_as, if not NULL, is set to how it was lexed: "parallel", "pipelined" or "on demand" (a file too small to
+// split is lexed as if lex_threads were 1)
+ASTree *get_AST(const char *filename, Lister *list_file, int pipelined, int lex_threads, const char **lexed_as);
+
+// a source file kept parsed across edits, for tools that re-parse as it's typed
+// only statements (and whole functions) are re-parsed in place, anything else parses the file again
+// semantic analysis isn't incremental: it decorates the tree, so run it on a tree that won't be edited again
+typedef struct document Document;
+
+Document *document_open(const char *filename, Lister *list_file);
+ASTree *document_ast(const Document *doc);
+// the source as of the last edit
+const char *document_text(const Document *doc, size_t *len);
+// replaces old_len bytes at start with text[0..len), returns 1 if the tree was patched, 0 if it was parsed
+// again (diagnostics then go to list_file, a patched tree has none), -1 if the range is outside the source
+int document_edit(Document *doc, size_t start, size_t old_len, const char *text, size_t len, Lister *list_file);
+void document_close(Document *doc);
 
 #endif
 
@@ -15,67 +15,73 @@
 // advance declarations
 
 // semantic analysis helper functions
-// equality for symbols, ignoring scope
-static int unscoped_symbol_equals(const Symbol *s1, const Symbol *s2) {
-	return s1->index.start == s2->index.start &&
-	       s1->index.len   == s2->index.len;
-}
-
 // scans the expression for any function calls or array references
-int is_compiletime_expr(ASTNode *node) {
+int is_compiletime_expr(ASTree *ast, ASTNode *node) {
 	if (!node) return 1;
-	if (node->type == NFCALL || node->type == NARRV || node->type == NAELT)
-		return 0;
-	return (
-		is_compiletime_expr(node->left_child) &&
-		is_compiletime_expr(node->middle_child) &&
-		is_compiletime_expr(node->right_child)
-	);
+	NodeStack todo = { 0 };
+	node_stack_push(&todo, node_id(node));
+	int result = 1;
+	while (result && todo.count) {
+		node = astree_node(ast, node_stack_pop(&todo));
+		if (node->type == NFCALL || node->type == NARRV || node->type == NAELT)
+			result = 0;
+		node_stack_push_children(&todo, node);
+	}
+	node_stack_free(&todo);
+	return result;
 }
 
 // for array size
 int consts_ints_only_expr(ASTree *ast, ASTNode *node) {
 	if (!node) return 1;
-	// if leaf, check if NILIT or integer constant
-	if (!(node->left_child || node->middle_child || node->right_child)) {
-		if (node->type == NILIT)
-			return 1;
-		if (node->type == NSIMV) {
-			Symbol *name = node->symbol_value;
-			name->scope = 0;
-			Attribute *atr = astree_get_attribute(ast, name);
-			if (!atr || atr->type != SINT)
-				return 0;
-			else
-				return 1;
+	NodeStack todo = { 0 };
+	node_stack_push(&todo, node_id(node));
+	int result = 1;
+	while (result && todo.count) {
+		node = astree_node(ast, node_stack_pop(&todo));
+		// if leaf, check if NILIT or integer constant
+		if (!(node->left || node->middle || node->right)) {
+			if (node->type == NSIMV) {
+				// constants are global, so look the name up there
+				Symbol *name = astree_add_symbol(ast, node_symbol(ast, node)->id, 0);
+				node_set_symbol(ast, node, name);
+				Attribute *atr = astree_get_attribute(ast, name);
+				result = atr && atr->type == SINT;
+			} else {
+				result = node->type == NILIT;
+			}
+		} else if (node->type == NFCALL || node->type == NARRV || node->type == NAELT) {
+			result = 0;
 		}
-		return 0;
+		node_stack_push_children(&todo, node);
 	}
-	if (node->type == NFCALL || node->type == NARRV || node->type == NAELT)
-		return 0;
-	return (
-		consts_ints_only_expr(ast, node->left_child) &&
-		consts_ints_only_expr(ast, node->middle_child) &&
-		consts_ints_only_expr(ast, node->right_child)
-	);
+	node_stack_free(&todo);
+	return result;
 }
 
 // scans function for return calls
 int has_return(ASTree *ast, ASTNode *node) {
 	if (!node) return 0;
-	if (node->type == NRETN)
-		return 1;
-	return has_return(ast, node->left_child) || has_return(ast, node->middle_child) || has_return(ast, node->right_child);
+	NodeStack todo = { 0 };
+	node_stack_push(&todo, node_id(node));
+	int result = 0;
+	while (!result && todo.count) {
+		node = astree_node(ast, node_stack_pop(&todo));
+		result = node->type == NRETN;
+		node_stack_push_children(&todo, node);
+	}
+	node_stack_free(&todo);
+	return result;
 }
 
 // update_<node> sets the type of <node> using its children as reference
 void update_nfcall(ASTree *ast, ASTNode *node) {
-	Attribute *atr = astree_get_attribute(ast, node->symbol_value);
+	Attribute *atr = astree_get_attribute(ast, node_symbol(ast, node));
 	node->symbol_type = atr ? atr->type : SERROR;
 }
 
 void update_nsimv(ASTree *ast, ASTNode *node) {
-	Attribute *atr = astree_get_attribute(ast, node->symbol_value);
+	Attribute *atr = astree_get_attribute(ast, node_symbol(ast, node));
 	if (atr) {
 		node->symbol_type = atr->type;
 		// if (atr->type == SARRAY || atr->type == SSTRUCT) {
@@ -88,16 +94,16 @@ void update_nsimv(ASTree *ast, ASTNode *node) {
 
 void update_naelt(ASTree *ast, ASTNode *node) {
 	node->symbol_type = SSTRUCT;
-	Attribute *arr_atr = astree_get_attribute(ast, node->left_child->symbol_value);
+	Attribute *arr_atr = astree_get_attribute(ast, node_symbol(ast, node_left(ast, node)));
 	if (!arr_atr || arr_atr->type != SARRAY) {
 		node->symbol_type = SERROR;
 		return;
 	}
-	node->symbol_value = arr_atr->data;
+	node_set_symbol(ast, node, arr_atr->data);
 }
 
 void update_narrv(ASTree *ast, ASTNode *node) {
-	Symbol *array_name = node->left_child->symbol_value;
+	Symbol *array_name = node_symbol(ast, node_left(ast, node));
 	Attribute *array_atr = astree_get_attribute(ast, array_name);
 	if (!array_atr || array_atr->type != SARRAY) {
 		node->symbol_type = SERROR;
@@ -114,13 +120,13 @@ void update_narrv(ASTree *ast, ASTNode *node) {
 		return;
 	}
 	LinkedList *elements = (LinkedList *)struct_atr1->data;
-	linkedlist_start(elements);
+	LLIter it = linkedlist_iter(elements);
 	Element *cur;
-	while (cur = linkedlist_get_current(elements)) {
-		if (unscoped_symbol_equals(cur->name, node->symbol_value)) {
+	while ((cur = lliter_get(it))) {
+		if (unscoped_symbol_equals(cur->name, node_symbol(ast, node))) {
 			break; // found the relevant field
 		}
-		linkedlist_forward(elements);
+		lliter_next(&it);
 	}
 	if (cur) {
 		node->symbol_type = cur->type;
@@ -132,8 +138,8 @@ void update_narrv(ASTree *ast, ASTNode *node) {
 }
 
 void update_addsubmuldiv(ASTree *ast, ASTNode *node) {
-	enum symbol_type left = node->left_child->symbol_type;
-	enum symbol_type right = node->right_child->symbol_type;
+	enum symbol_type left = node_left(ast, node)->symbol_type;
+	enum symbol_type right = node_right(ast, node)->symbol_type;
 	if ((left != SINT && left != SREAL) || (right != SINT && right != SREAL)) {
 		node->symbol_type = SERROR;
 		return;
@@ -145,8 +151,8 @@ void update_addsubmuldiv(ASTree *ast, ASTNode *node) {
 }
 
 void update_mod(ASTree *ast, ASTNode *node) {
-	enum symbol_type left = node->left_child->symbol_type;
-	enum symbol_type right = node->right_child->symbol_type;
+	enum symbol_type left = node_left(ast, node)->symbol_type;
+	enum symbol_type right = node_right(ast, node)->symbol_type;
 	if (left != SINT || right != SINT) {
 		node->symbol_type = SERROR;
 		return;
@@ -155,8 +161,8 @@ void update_mod(ASTree *ast, ASTNode *node) {
 }
 
 void update_pow(ASTree *ast, ASTNode *node) {
-	enum symbol_type left = node->left_child->symbol_type;
-	enum symbol_type right = node->right_child->symbol_type;
+	enum symbol_type left = node_left(ast, node)->symbol_type;
+	enum symbol_type right = node_right(ast, node)->symbol_type;
 	if ((left != SINT && left != SREAL) || (right != SINT && right != SREAL)) {
 		node->symbol_type = SERROR;
 		return;
@@ -167,15 +173,10 @@ void update_pow(ASTree *ast, ASTNode *node) {
 		node->symbol_type = SREAL;
 }
 
-void update_node_symboltype(ASTree *ast, ASTNode *node, Lister *lst) {
-	if (!node)
-		return;
-	update_node_symboltype(ast, node->left_child, lst);
-	update_node_symboltype(ast, node->middle_child, lst);
-	update_node_symboltype(ast, node->right_child, lst);
+void update_node_type(ASTree *ast, ASTNode *node, Lister *lst) {
 	switch (node->type) {
 		case NINIT:
-			if (astree_add_attribute(ast, node->symbol_value, astree_attribute_create(ast, node->left_child->symbol_type, NULL))) {
+			if (astree_add_attribute(ast, node_symbol(ast, node), astree_attribute_create(node_left(ast, node)->symbol_type, NULL))) {
 				ast->is_valid = 0;
 				lister_sem_error(lst, node->row, node->col, "redefinition of variable already defined in scope");
 			}
@@ -207,6 +208,25 @@ void update_node_symboltype(ASTree *ast, ASTNode *node, Lister *lst) {
 	}
 }
 
+// sets the types bottom up, children before their parent
+void update_node_symboltype(ASTree *ast, ASTNode *root, Lister *lst) {
+	if (!root)
+		return;
+	NodeStack todo = { 0 };
+	node_stack_push(&todo, node_id(root));
+	while (todo.count) {
+		u32 id = node_stack_pop(&todo);
+		ASTNode *node = astree_node(ast, id & ~NODE_VISITED);
+		if (!(id & NODE_VISITED)) { // back to it once its children are done
+			node_stack_push(&todo, id | NODE_VISITED);
+			node_stack_push_children(&todo, node);
+			continue;
+		}
+		update_node_type(ast, node, lst);
+	}
+	node_stack_free(&todo);
+}
+
 void compare_arg(ASTree *ast, Attribute *cur_formal, ASTNode *cur_arg, Lister *lst) {
 	switch(cur_formal->type) {
 		case SREAL:
@@ -242,7 +262,7 @@ void compare_arg(ASTree *ast, Attribute *cur_formal, ASTNode *cur_arg, Lister *l
 				break;
 			}
 			// todo: this is unscoped, so if redefinition happens, it can mess this up
-			Attribute *cur_arg_atr = astree_get_attribute(ast, cur_arg->symbol_value);
+			Attribute *cur_arg_atr = astree_get_attribute(ast, node_symbol(ast, cur_arg));
 			if (!unscoped_symbol_equals(cur_formal->data, cur_arg_atr->data)) {
 				ast->is_valid = 0; // type mismatch
 				lister_sem_error(lst, cur_arg->row, cur_arg->col, "arrays are different types");
@@ -257,21 +277,21 @@ void compare_arg(ASTree *ast, Attribute *cur_formal, ASTNode *cur_arg, Lister *l
 
 void analyse_function_params(ASTree *ast, ASTNode *node, Lister *lst, Attribute *fnatr) {
 	LinkedList *formalparams = fnatr->data;
-	linkedlist_start(formalparams);
+	LLIter it = linkedlist_iter(formalparams);
 	Attribute *cur_formal;
 	int invalid = 0;
-	ASTNode *funcargs = node->left_child;
-	while (cur_formal = (Attribute *)linkedlist_get_current(formalparams)) {
+	ASTNode *funcargs = node_left(ast, node);
+	while ((cur_formal = (Attribute *)lliter_get(it))) {
 		if (!funcargs) {
 			ast->is_valid = 0;
 			lister_sem_error(lst, node->row, node->col, "too few function arguments");
 			break;
 		}
 		if (funcargs->type == NEXPL) {
-			compare_arg(ast, cur_formal, funcargs->left_child, lst);
+			compare_arg(ast, cur_formal, node_left(ast, funcargs), lst);
 		}
-		linkedlist_forward(formalparams);
-		funcargs = funcargs->right_child;
+		lliter_next(&it);
+		funcargs = node_right(ast, funcargs);
 	}
 	if (funcargs) {
 		ast->is_valid = 0;
@@ -280,7 +300,7 @@ void analyse_function_params(ASTree *ast, ASTNode *node, Lister *lst, Attribute
 }
 
 void analyse_ncall(ASTree *ast, ASTNode *node, Lister *lst) {
-	Symbol *funcname = node->symbol_value;
+	Symbol *funcname = node_symbol(ast, node);
 	Attribute *fnatr = astree_get_attribute(ast, funcname);
 	if (fnatr && fnatr->type != SVOID) {
 		ast->is_valid = 0;
@@ -291,7 +311,7 @@ void analyse_ncall(ASTree *ast, ASTNode *node, Lister *lst) {
 }
 
 void analyse_fncall(ASTree *ast, ASTNode *node, Lister *lst) {
-	Symbol *funcname = node->symbol_value;
+	Symbol *funcname = node_symbol(ast, node);
 	Attribute *fnatr = astree_get_attribute(ast, funcname);
 	if (fnatr && fnatr->type == SVOID) {
 		ast->is_valid = 0;
@@ -307,7 +327,7 @@ void analyse_fncall(ASTree *ast, ASTNode *node, Lister *lst) {
 }
 
 void analyse_nsimv(ASTree *ast, ASTNode *node, Lister *lst) {
-	Attribute *atr = astree_get_attribute(ast, node->symbol_value);
+	Attribute *atr = astree_get_attribute(ast, node_symbol(ast, node));
 	if (!atr) {
 		ast->is_valid = 0;
 		lister_sem_error(lst, node->row, node->col, "undeclared variable");
@@ -321,21 +341,21 @@ void analyse_nsimv(ASTree *ast, ASTNode *node, Lister *lst) {
 
 void analyse_init(ASTree *ast, ASTNode *node, Lister *lst) {
 		// todo: get type from the analysed expression and save that to symbol table for this const
-	if (!is_compiletime_expr(node->left_child)) {
+	if (!is_compiletime_expr(ast, node_left(ast, node))) {
 		ast->is_valid = 0;
-		lister_sem_error(lst, node->left_child->row, node->left_child->col, "constant value is not known at compile time");
+		lister_sem_error(lst, node_left(ast, node)->row, node_left(ast, node)->col, "constant value is not known at compile time");
 	}
 }
 
 void analyse_natype(ASTree *ast, ASTNode *node, Lister *lst) {
-	if (!consts_ints_only_expr(ast, node->left_child)) {
+	if (!consts_ints_only_expr(ast, node_left(ast, node))) {
 		ast->is_valid = 0;
 		lister_sem_error(lst, node->row, node->col, "array size contains variables or non-integers");
 	}
 }
 
 void analyse_arrdecl(ASTree *ast, ASTNode *node, Lister *lst) {
-	Symbol *arrname = node->symbol_value;
+	Symbol *arrname = node_symbol(ast, node);
 	Attribute *arratr = astree_get_attribute(ast, arrname);
 	if (!arratr || arratr->type != SARRAY) {
 		//if () //todo: clean up a cascading error here
@@ -352,21 +372,21 @@ void analyse_arrdecl(ASTree *ast, ASTNode *node, Lister *lst) {
 }
 
 void analyse_function(ASTree *ast, ASTNode *node, Lister *lst) {
-	if (!has_return(ast, node->right_child)) {
+	if (!has_return(ast, node_right(ast, node))) {
 		ast->is_valid = 0;
 		lister_sem_error(lst, node->row, node->col, "function does not return");
 	}
 }
 
 void analyse_nprog(ASTree *ast, ASTNode *node, Lister *lst) {
-	if (!unscoped_symbol_equals(node->symbol_value, node->right_child->symbol_value)) {
+	if (!unscoped_symbol_equals(node_symbol(ast, node), node_symbol(ast, node_right(ast, node)))) {
 		ast->is_valid = 0;
 		lister_sem_error(lst, node->row, 6, "program name mismatch"); // todo: figure out how to get this line number
 	}
 }
 
 void analyse_naelt(ASTree *ast, ASTNode *node, Lister *lst) {
-	Attribute *arr_atr = astree_get_attribute(ast, node->left_child->symbol_value);
+	Attribute *arr_atr = astree_get_attribute(ast, node_symbol(ast, node_left(ast, node)));
 	if (!arr_atr || arr_atr->type != SARRAY) {
 		ast->is_valid = 0;
 		lister_sem_error(lst, node->row, node->col, "variable is not an array");
@@ -374,8 +394,8 @@ void analyse_naelt(ASTree *ast, ASTNode *node, Lister *lst) {
 }
 
 void analyse_nasgn(ASTree *ast, ASTNode *node, Lister *lst) {
-	enum symbol_type left = node->left_child->symbol_type;
-	enum symbol_type right = node->right_child->symbol_type;
+	enum symbol_type left = node_left(ast, node)->symbol_type;
+	enum symbol_type right = node_right(ast, node)->symbol_type;
 	if (left != right) {
 		// after having done codegen, this promotion is erroneous IMO
 		// if (!(left == SREAL && right == SINT)) {
@@ -386,8 +406,8 @@ void analyse_nasgn(ASTree *ast, ASTNode *node, Lister *lst) {
 		// }
 		return;
 	}
-	Attribute *left_atr = astree_get_attribute(ast, node->left_child->symbol_value);
-	Attribute *right_atr = astree_get_attribute(ast, node->left_child->symbol_value);
+	Attribute *left_atr = astree_get_attribute(ast, node_symbol(ast, node_left(ast, node)));
+	Attribute *right_atr = astree_get_attribute(ast, node_symbol(ast, node_left(ast, node)));
 	if (left == SARRAY) {
 		// todo: if the user has reassigned array variables in local scope, this won't break when it should
 		if (!unscoped_symbol_equals(left_atr->data, right_atr->data)) {
@@ -403,8 +423,8 @@ void analyse_nasgn(ASTree *ast, ASTNode *node, Lister *lst) {
 }
 
 void analyse_npow(ASTree *ast, ASTNode *node, Lister *lst) {
-	if (node->left_child->symbol_type != SINT || node->right_child->symbol_type != SINT) {
-		if (node->left_child->symbol_type != SERROR && node->right_child->symbol_type != SERROR) {
+	if (node_left(ast, node)->symbol_type != SINT || node_right(ast, node)->symbol_type != SINT) {
+		if (node_left(ast, node)->symbol_type != SERROR && node_right(ast, node)->symbol_type != SERROR) {
 			ast->is_valid = 0;
 			lister_sem_error(lst, node->row, node->col, "exponentiation is a INT -> INT operation");
 		}
@@ -412,8 +432,8 @@ void analyse_npow(ASTree *ast, ASTNode *node, Lister *lst) {
 }
 
 void analyse_nmod(ASTree *ast, ASTNode *node, Lister *lst) {
-	if (node->left_child->symbol_type != SINT || node->right_child->symbol_type != SINT) {
-		if (node->left_child->symbol_type != SERROR && node->right_child->symbol_type != SERROR) {
+	if (node_left(ast, node)->symbol_type != SINT || node_right(ast, node)->symbol_type != SINT) {
+		if (node_left(ast, node)->symbol_type != SERROR && node_right(ast, node)->symbol_type != SERROR) {
 			ast->is_valid = 0;
 			lister_sem_error(lst, node->row, node->col, "modulus is only valid for integers");
 		}
@@ -428,33 +448,29 @@ void analyse_printitem(ASTree *ast, ASTNode *node, Lister *lst) {
 			break;
 		default:
 			ast->is_valid = 0;
-			lister_sem_error(lst, node->left_child->row, node->left_child->col, "only integers, reals or strings can be printed");
+			lister_sem_error(lst, node_left(ast, node)->row, node_left(ast, node)->col, "only integers, reals or strings can be printed");
 			break;
 	}
 }
 
 void analyse_prlist(ASTree *ast, ASTNode *node, Lister *lst) {
-	if (node->type == NPRLST) {
-		analyse_printitem(ast, node->left_child, lst);
-		analyse_prlist(ast, node->right_child, lst);
-	} else {
-		analyse_printitem(ast, node, lst);
-	}
+	for (; node->type == NPRLST; node = node_right(ast, node))
+		analyse_printitem(ast, node_left(ast, node), lst);
+	analyse_printitem(ast, node, lst);
 }
 
 void analyse_relop(ASTree *ast, ASTNode *node, Lister *lst) {
-	if ((node->left_child->symbol_type != SINT && node->left_child->symbol_type != SREAL ) &&
-		(node->right_child->symbol_type != SINT && node->right_child->symbol_type != SREAL )
+	if ((node_left(ast, node)->symbol_type != SINT && node_left(ast, node)->symbol_type != SREAL ) &&
+		(node_right(ast, node)->symbol_type != SINT && node_right(ast, node)->symbol_type != SREAL )
 	) {
-		if (node->left_child->symbol_type != SERROR || node->right_child->symbol_type != SERROR) {
+		if (node_left(ast, node)->symbol_type != SERROR || node_right(ast, node)->symbol_type != SERROR) {
 			ast->is_valid = 0;
 			lister_sem_error(lst, node->row, node->col, "relational operator requires integer arguments");
 		}
 	}
 }
 
-void analyse_node(ASTree *ast, ASTNode *node, Lister *lst) {
-	if (!node) return;
+void analyse_one(ASTree *ast, ASTNode *node, Lister *lst) {
 	switch (node->type) {
 		case NPROG:
 			analyse_nprog(ast, node, lst);
@@ -501,8 +517,8 @@ void analyse_node(ASTree *ast, ASTNode *node, Lister *lst) {
 			break;
 		case NOUTP:
 		case NOUTL:
-			if (node->left_child)
-				analyse_prlist(ast, node->left_child, lst);
+			if (node_left(ast, node))
+				analyse_prlist(ast, node_left(ast, node), lst);
 			break;
 		case NEQL:
 		case NNEQ:
@@ -513,9 +529,19 @@ void analyse_node(ASTree *ast, ASTNode *node, Lister *lst) {
 			analyse_relop(ast, node, lst);
 			break;
 	}
-	analyse_node(ast, node->left_child, lst);
-	analyse_node(ast, node->middle_child, lst);
-	analyse_node(ast, node->right_child, lst);
+}
+
+// preorder, so errors come out in the order they appear
+void analyse_node(ASTree *ast, ASTNode *node, Lister *lst) {
+	if (!node) return;
+	NodeStack todo = { 0 };
+	node_stack_push(&todo, node_id(node));
+	while (todo.count) {
+		node = astree_node(ast, node_stack_pop(&todo));
+		analyse_one(ast, node, lst);
+		node_stack_push_children(&todo, node);
+	}
+	node_stack_free(&todo);
 }
 
 void analyse_program(ASTree *ast, Lister *lst) {
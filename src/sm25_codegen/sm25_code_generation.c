@@ -8,11 +8,11 @@
 #include <stdio.h>
 #include <string.h>
 #include <math.h>
-#include "../lib/sds.h"
 #include "../lib/defs.h"
 #include "../lib/hashmap.h"
 #include "../symboltable.h"
 #include "../lib/linkedlist.h"
+#include "../lib/vector.h"
 #include <stdarg.h>
 
 enum addresstypes {
@@ -31,17 +31,17 @@ typedef struct instruction {
 typedef struct codegen {
 	ASTree *ast;
 	FILE *out_file;
-	u16 inst_bytes;
-	LinkedList *instructions;
-	u16 num_ints; // for offset
-	LinkedList *ints;
+	u32 inst_bytes;
+	Vector *instructions; // Instruction
+	u32 num_ints; // for offset
+	LinkedList *ints; // NILIT nodes (value for constexprs, glyph for the .mod)
 	LinkedList *int_offsets;
-	u16 cur_int;
-	u16 num_reals;
-	LinkedList *reals;
+	u32 cur_int;
+	u32 num_reals;
+	LinkedList *reals; // NFLIT nodes
 	LinkedList *real_offsets;
-	u16 cur_real;
-	u16 str_bytes;
+	u32 cur_real;
+	u32 str_bytes;
 	LinkedList *strings;
 	LinkedList *str_offsets;
 	HashMap *symbol_offset_map; // <symbol, int>
@@ -53,10 +53,19 @@ typedef struct codegen {
 	HashMap *array_len_map;
 	HashMap *array_structsize_map;
 	LinkedList *func_calls;
-	u16 scope_of_main;
+	u32 scope_of_main;
+	struct pending_push *pending; // operators whose operands are still being pushed (see codegen_expr_walk)
+	u32 pending_count, pending_cap;
 	// astree_get_attribute(cdg->ast, node->symbol_value)->offset = x;
 } Codegen;
 
+// a node for codegen_expr_walk to push as a number or boolean, or (once its operands are pushed) to finish
+struct pending_push {
+	ASTNode *node;
+	u8 boolean;
+	u8 operands_done;
+};
+
 	void codegen_stats(Codegen *cdg, ASTNode *node);
 	void codegen_numeric_push(Codegen *cdg, ASTNode *node);
 	void codegen_expr_push(Codegen *cdg, ASTNode *node);
@@ -64,36 +73,8 @@ typedef struct codegen {
 	void codegen_array_push(Codegen *cdg, ASTNode *node);
 	void codegen_push_adr(Codegen *cdg, ASTNode *node);
 
-static sds sds_substr(const sds src, size_t start, size_t len) {
-	size_t src_len = sdslen(src);
-	if (start >= src_len) return sdsnew("");  // empty string if start past end
-	if (start + len > src_len) len = src_len - start;
-	return sdsnewlen(src + start, len);
-}
-
-static sds sds_from_symbol(Codegen *cdg, Symbol *s) {
-	return sds_substr(
-		cdg->ast->symboltable->stringspace,
-		s->index.start,
-		s->index.len
-	);
-}
-
-static unsigned hash_symbol(const void *ptr) {
-	const Symbol *sym = (const Symbol *)ptr;
-	unsigned hash = 17;
-	hash = hash * 31 + (unsigned)(sym->index.start ^ (sym->index.start >> 32));
-	hash = hash * 31 + (unsigned)(sym->index.len ^ (sym->index.len >> 32));
-	hash = hash * 31 + sym->scope;
-	return hash;
-}
-
-static int equal_symbol(const void *a, const void *b) {
-	const Symbol *s1 = (const Symbol *)a;
-	const Symbol *s2 = (const Symbol *)b;
-	return s1->index.start == s2->index.start &&
-	       s1->index.len   == s2->index.len &&
-	       s1->scope       == s2->scope;
+static StrView view_of_symbol(Codegen *cdg, Symbol *s) {
+	return stringpool_view(cdg->ast->symboltable->pool, s->id);
 }
 
 Codegen *codegen_create(const char *outfile, ASTree *ast) {
@@ -102,7 +83,7 @@ Codegen *codegen_create(const char *outfile, ASTree *ast) {
 		ast,
 		fopen(outfile, "w"),
 		0, // inst_bytes
-		linkedlist_create(), // insts
+		vector_create(sizeof(Instruction)), // insts
 		0, // num_ints
 		linkedlist_create(), // ints
 		linkedlist_create(), // int offsets
@@ -114,16 +95,17 @@ Codegen *codegen_create(const char *outfile, ASTree *ast) {
 		0, // str_bytes
 		linkedlist_create(), // strings
 		linkedlist_create(), // strlens
-		hashmap_create(66, hash_symbol, equal_symbol),
+		hashmap_create(66, symbol_hash, symbol_equals),
 		calloc(16, sizeof(int)),
 		0, // num_jumps
 		16, // jump offset capacity
 		0, // number of global arrays
 		0, // bytes created by global arrays
-		hashmap_create(20, hash_symbol, equal_symbol), // symbol->arraysize
-		hashmap_create(20, hash_symbol, equal_symbol), // symbol->structsize of the array
+		hashmap_create(20, symbol_hash, symbol_equals), // symbol->arraysize
+		hashmap_create(20, symbol_hash, symbol_equals), // symbol->structsize of the array
 		linkedlist_create(), // function calls
 		1, // scope_of_main
+		NULL, 0, 0, // pending
 	};
 	if (!temp->out_file) {
 		fprintf(stderr, "could not create module file\n");
@@ -174,9 +156,9 @@ void instr_print(Codegen* cdg, Instruction *instr, int *printed_insts) {
 	}
 }
 
-void print_sm25_string(Codegen* cdg, sds str_const, int *printed_chars) {
-	for (int i = 0; i < sdslen(str_const); ++i) {
-		output_byte_to_mod(cdg, str_const[i], printed_chars);
+void print_sm25_string(Codegen* cdg, StrView str_const, int *printed_chars) {
+	for (u32 i = 0; i < str_const.len; ++i) {
+		output_byte_to_mod(cdg, str_const.str[i], printed_chars);
 	}
 	output_byte_to_mod(cdg, 0, printed_chars);
 }
@@ -192,7 +174,7 @@ static void noop_free(void *p) {
 
 void codegen_free(Codegen *cdg) {
 	linkedlist_free(cdg->strings);
-	linkedlist_free(cdg->instructions);
+	vector_free(cdg->instructions);
 	linkedlist_free(cdg->ints);
 	linkedlist_free(cdg->reals);
 	fclose(cdg->out_file);
@@ -201,18 +183,15 @@ void codegen_free(Codegen *cdg) {
 	linkedlist_free_ctx(cdg->str_offsets, noop_free_ctx);
 	hashmap_free(cdg->symbol_offset_map, noop_free, free);
 	free(cdg->jump_addresses);
+	free(cdg->pending);
 	free(cdg);
 }
 
 void codegen_close(Codegen *cdg) {
 	fprintf(cdg->out_file, "%d\n", cdg->inst_bytes/8);
 	int printed_insts = 0;
-	Instruction *instr;
-	// todo: use an iterator for this
-	while ( (instr = (Instruction *)linkedlist_pop_head(cdg->instructions)) != NULL) {
-		instr_print(cdg, instr, &printed_insts);
-		free(instr);
-	}
+	for (u32 i = 0; i < vector_len(cdg->instructions); i++)
+		instr_print(cdg, vector_at(cdg->instructions, i), &printed_insts);
 	int padded = 0;
 	while (printed_insts % 8 != 0) {
 		padded = 1;
@@ -223,23 +202,20 @@ void codegen_close(Codegen *cdg) {
 		fprintf(cdg->out_file, "\n");
 	fprintf(cdg->out_file, "%d\n", cdg->num_ints);
 	Symbol *const_sym;
-	while ( (const_sym = (Symbol *)linkedlist_pop_head(cdg->ints)) != NULL) {
-		sds const_sds = sds_from_symbol(cdg, const_sym);
-		fprintf(cdg->out_file, "%s\n", const_sds);
-		sdsfree(const_sds);
+	ASTNode *const_lit;
+	while ( (const_lit = (ASTNode *)linkedlist_pop_head(cdg->ints)) != NULL) {
+		StrView const_str = view_of_symbol(cdg, node_symbol(cdg->ast, const_lit));
+		fprintf(cdg->out_file, "%.*s\n", (int)const_str.len, const_str.str);
 	}
 	fprintf(cdg->out_file, "%d\n", cdg->num_reals);
-	while ( (const_sym = (Symbol *)linkedlist_pop_head(cdg->reals)) != NULL) {
-		sds const_sds = sds_from_symbol(cdg, const_sym);
-		fprintf(cdg->out_file, "%s\n", const_sds);
-		sdsfree(const_sds);
+	while ( (const_lit = (ASTNode *)linkedlist_pop_head(cdg->reals)) != NULL) {
+		StrView const_str = view_of_symbol(cdg, node_symbol(cdg->ast, const_lit));
+		fprintf(cdg->out_file, "%.*s\n", (int)const_str.len, const_str.str);
 	}
 	fprintf(cdg->out_file, "%d\n", (int)ceil(cdg->str_bytes / 8.0));
 	int printed_chars = 0;
 	while ( (const_sym = (Symbol *)linkedlist_pop_head(cdg->strings)) != NULL) {
-		sds const_sds = sds_from_symbol(cdg, const_sym);
-		print_sm25_string(cdg, const_sds, &printed_chars);
-		sdsfree(const_sds);
+		print_sm25_string(cdg, view_of_symbol(cdg, const_sym), &printed_chars);
 	}
 	while (printed_chars % 8 != 0) {
 		fprintf(cdg->out_file, "   0");
@@ -278,40 +254,33 @@ void instr_printf(Instruction *instr, int *byte_counter) {
 void sm25_printf(Codegen *cdg) {
 	printf( "%d\n", cdg->inst_bytes/8);
 	int cur_byte = 10000;
-	Instruction *instr;
-	while ( (instr = (Instruction *)linkedlist_pop_head(cdg->instructions)) != NULL) {
-		instr_printf(instr, &cur_byte);
-		free(instr);
-	}
+	for (u32 i = 0; i < vector_len(cdg->instructions); i++)
+		instr_printf(vector_at(cdg->instructions, i), &cur_byte);
 	cur_byte += (8 - cur_byte) % 8; // simulating padding to match SM25
 	printf( "%d\n", cdg->num_ints);
 	Symbol *const_sym;
-	while ( (const_sym = (Symbol *)linkedlist_pop_head(cdg->ints)) != NULL) {
-		sds const_sds = sds_from_symbol(cdg, const_sym);
-		printf( "%d %s\n", cur_byte, const_sds);
+	ASTNode *const_lit;
+	while ( (const_lit = (ASTNode *)linkedlist_pop_head(cdg->ints)) != NULL) {
+		StrView const_str = view_of_symbol(cdg, node_symbol(cdg->ast, const_lit));
+		printf( "%d %.*s\n", cur_byte, (int)const_str.len, const_str.str);
 		cur_byte += 8;
-		sdsfree(const_sds);
 	}
 	printf( "%d\n", cdg->num_reals);
-	while ( (const_sym = (Symbol *)linkedlist_pop_head(cdg->reals)) != NULL) {
-		sds const_sds = sds_from_symbol(cdg, const_sym);
-		printf( "%d %s\n", cur_byte, const_sds);
+	while ( (const_lit = (ASTNode *)linkedlist_pop_head(cdg->reals)) != NULL) {
+		StrView const_str = view_of_symbol(cdg, node_symbol(cdg->ast, const_lit));
+		printf( "%d %.*s\n", cur_byte, (int)const_str.len, const_str.str);
 		cur_byte += 8;
-		sdsfree(const_sds);
 	}
 	printf( "%d\n", (int)ceil(cdg->str_bytes / 8.0));
 	while ( (const_sym = (Symbol *)linkedlist_pop_head(cdg->strings)) != NULL) {
-		sds const_sds = sds_from_symbol(cdg, const_sym);
-		printf( "%d %s\n", cur_byte, const_sds);
-		cur_byte += sdslen(const_sds) + 1;
-		sdsfree(const_sds);
+		StrView const_str = view_of_symbol(cdg, const_sym);
+		printf( "%d %.*s\n", cur_byte, (int)const_str.len, const_str.str);
+		cur_byte += const_str.len + 1;
 	}
 }
 
 void push_instruction(Codegen *cdg, int type, int val) {
-	Instruction *temp = malloc(sizeof(Instruction));
-	*temp = (Instruction){ type, val };
-	linkedlist_push_tail(cdg->instructions, temp);
+	vector_push(cdg->instructions, &(Instruction){ type, val });
 	cdg->inst_bytes++;
 	switch (type) {
 		case 41:
@@ -342,29 +311,23 @@ void push_int_by_val(Codegen *cdg, int val) {
 	}
 }
 
-static int unscoped_symbol_equals(const Symbol *s1, const Symbol *s2) {
-	return s1->index.start == s2->index.start &&
-	       s1->index.len   == s2->index.len;
-}
-
 void codegen_var_push(Codegen *cdg, ASTNode *node) {
 	if (node->type == NARRV) {
 		codegen_push_adr(cdg, node);
 		push_instruction(cdg, L, 0);
 		return;
 	}
-	if (hashmap_get(cdg->symbol_offset_map, node->symbol_value)) { // local
-		int address = 8 * *(int*)hashmap_get(cdg->symbol_offset_map, node->symbol_value);
-		if (node->symbol_value->scope == cdg->scope_of_main) {
+	if (hashmap_get(cdg->symbol_offset_map, node_symbol(cdg->ast, node))) { // local
+		int address = 8 * *(int*)hashmap_get(cdg->symbol_offset_map, node_symbol(cdg->ast, node));
+		if (node_symbol(cdg->ast, node)->scope == cdg->scope_of_main) {
 			address += cdg->global_array_bytes + 8*cdg->num_global_arrays;
 			push_instruction(cdg, LV1, address);
 		} else
 			push_instruction(cdg, LV2, address);
 	} else { // global
-		Symbol *globscoped = malloc(sizeof(Symbol));
-		*globscoped = *(node->symbol_value);
-		globscoped->scope = 0;
-		int *offset = (int*)hashmap_get(cdg->symbol_offset_map, globscoped);
+		Symbol globscoped = *(node_symbol(cdg->ast, node));
+		globscoped.scope = 0;
+		int *offset = (int*)hashmap_get(cdg->symbol_offset_map, &globscoped);
 		switch (node->symbol_type) {
 			case SINT:
 				linkedlist_push_tail(cdg->int_offsets, offset);
@@ -375,28 +338,26 @@ void codegen_var_push(Codegen *cdg, ASTNode *node) {
 				push_instruction(cdg, LV0, AREAL);
 				break;
 		}
-		free(globscoped);
 	}
 }
 
-void codegen_numeric_push(Codegen *cdg, ASTNode *node) {
+// pushes node if it needs nothing pushed under it, returning 0 if it's an operator
+static int codegen_numeric_leaf(Codegen *cdg, ASTNode *node) {
 	Symbol *temp;
 	int *offset;
-	// first handle types that don't require recursive arithmetic
 	switch (node->type) {
 		case NILIT:
-			sds glyph = sds_from_symbol(cdg, node->symbol_value);
-			int value = atoi(glyph);
+			int value = (int)node->lit.i;
 			if (value <= 65535) {
 				push_int_by_val(cdg, value);
 			} else {
 				push_instruction(cdg, LV0, AINT);
-				temp = node->symbol_value;
+				temp = node_symbol(cdg->ast, node);
 				if (hashmap_contains(cdg->symbol_offset_map, temp)) {
 					offset = (int*)hashmap_get(cdg->symbol_offset_map, temp);
 					linkedlist_push_tail(cdg->int_offsets, offset);
 				} else {
-					linkedlist_push_tail(cdg->ints, temp);
+					linkedlist_push_tail(cdg->ints, node);
 					offset = malloc(sizeof(int));
 					*offset = cdg->num_ints*8;
 					hashmap_add(cdg->symbol_offset_map, temp, offset);
@@ -404,55 +365,32 @@ void codegen_numeric_push(Codegen *cdg, ASTNode *node) {
 					cdg->num_ints++;
 				}
 			}
-			sdsfree(glyph);
-			return;
+			return 1;
 		case NFLIT:
 			push_instruction(cdg, LV0, AREAL);
-			temp = node->symbol_value;
+			temp = node_symbol(cdg->ast, node);
 			if (hashmap_contains(cdg->symbol_offset_map, temp)) {
 				offset = (int*)hashmap_get(cdg->symbol_offset_map, temp);
 				linkedlist_push_tail(cdg->real_offsets, offset);
 			} else {
-				linkedlist_push_tail(cdg->reals, temp);
+				linkedlist_push_tail(cdg->reals, node);
 				offset = malloc(sizeof(int));
 				*offset = cdg->num_reals*8;
 				hashmap_add(cdg->symbol_offset_map, temp, offset);
 				linkedlist_push_tail(cdg->real_offsets, offset);
 				cdg->num_reals++;
 			}
-			return;
+			return 1;
 		case NSIMV:
 		case NAELT:
 		case NARRV:
 			codegen_var_push(cdg, node);
-			return;
+			return 1;
 		case NFCALL:
 			codegen_fncall(cdg, node);
-			return;
-	}
-	// it wasn't a leaf, so continue recursion
-	codegen_numeric_push(cdg, node->left_child);
-	codegen_numeric_push(cdg, node->right_child);
-	switch (node->type) {
-		case NADD:
-			push_instruction(cdg, ADD, 0);
-			break;
-		case NSUB:
-			push_instruction(cdg, SUB, 0);
-			break;
-		case NMUL:
-			push_instruction(cdg, MUL, 0);
-			break;
-		case NDIV:
-			push_instruction(cdg, DIV, 0);
-			break;
-		case NMOD:
-			push_instruction(cdg, REM, 0);
-			break;
-		case NPOW:
-			push_instruction(cdg, POW, 0);
-			break;
+			return 1;
 	}
+	return 0;
 }
 
 void codegen_printitem(Codegen *cdg, ASTNode *node) {
@@ -462,9 +400,9 @@ void codegen_printitem(Codegen *cdg, ASTNode *node) {
 		int *stroffset = malloc(sizeof(int));
 		*stroffset = cdg->str_bytes;
 		linkedlist_push_tail(cdg->str_offsets, stroffset);
-		Symbol *temp = node->symbol_value;
+		Symbol *temp = node_symbol(cdg->ast, node);
 		linkedlist_push_tail(cdg->strings, temp);
-		cdg->str_bytes += temp->index.len + 1;
+		cdg->str_bytes += stringpool_span(cdg->ast->symboltable->pool, temp->id).len + 1;
 	} else {
 		codegen_numeric_push(cdg, node);
 		push_instruction(cdg, VALPR, 0);
@@ -472,34 +410,31 @@ void codegen_printitem(Codegen *cdg, ASTNode *node) {
 }
 
 void codegen_prlist(Codegen *cdg, ASTNode *node) {
-	if (node->type == NPRLST) {
-		codegen_printitem(cdg, node->left_child);
-		codegen_prlist(cdg, node->right_child);
-	} else {
-		codegen_printitem(cdg, node);
-	}
+	for (; node->type == NPRLST; node = node_right(cdg->ast, node))
+		codegen_printitem(cdg, node_left(cdg->ast, node));
+	codegen_printitem(cdg, node);
 }
 
 void codegen_noutp(Codegen *cdg, ASTNode *node) {
-	codegen_prlist(cdg, node->left_child);
+	codegen_prlist(cdg, node_left(cdg->ast, node));
 }
 
 void codegen_noutl(Codegen *cdg, ASTNode *node) {
-	if (!node->left_child) {
+	if (!node_left(cdg->ast, node)) {
 		push_instruction(cdg, NEWLN, 0);
 		return;
 	}
-	codegen_prlist(cdg, node->left_child);
+	codegen_prlist(cdg, node_left(cdg->ast, node));
 	push_instruction(cdg, NEWLN, 0);
 }
 
 void codegen_input_var(Codegen *cdg, ASTNode *node) {
 	if (node->type == NSIMV) {
-		if (node->symbol_value->scope == cdg->scope_of_main) {
-			int offset = cdg->global_array_bytes + 8*cdg->num_global_arrays + 8 * *(int*)hashmap_get(cdg->symbol_offset_map, node->symbol_value);
+		if (node_symbol(cdg->ast, node)->scope == cdg->scope_of_main) {
+			int offset = cdg->global_array_bytes + 8*cdg->num_global_arrays + 8 * *(int*)hashmap_get(cdg->symbol_offset_map, node_symbol(cdg->ast, node));
 			push_instruction(cdg, LA1, offset);
 		} else {
-			int offset = 8 * *(int*)hashmap_get(cdg->symbol_offset_map, node->symbol_value);
+			int offset = 8 * *(int*)hashmap_get(cdg->symbol_offset_map, node_symbol(cdg->ast, node));
 			push_instruction(cdg, LA2, offset);
 		}
 		if (node->symbol_type == SREAL) {
@@ -510,9 +445,9 @@ void codegen_input_var(Codegen *cdg, ASTNode *node) {
 		push_instruction(cdg, ST, 0);
 	} else if (node->type == NARRV) {
 		// TODO: I think this is code duplication, clean up getting the address
-		Attribute *array_atr = astree_get_attribute(cdg->ast, node->left_child->symbol_value);
-		codegen_array_push(cdg, node->left_child);
-		codegen_numeric_push(cdg, node->right_child);
+		Attribute *array_atr = astree_get_attribute(cdg->ast, node_symbol(cdg->ast, node_left(cdg->ast, node)));
+		codegen_array_push(cdg, node_left(cdg->ast, node));
+		codegen_numeric_push(cdg, node_right(cdg->ast, node));
 		int struct_size = * (int*)hashmap_get(cdg->array_structsize_map, array_atr->data);
 		if (struct_size != 1) {
 			push_instruction(cdg, LB, struct_size);
@@ -522,13 +457,13 @@ void codegen_input_var(Codegen *cdg, ASTNode *node) {
 		Attribute *struct_atr = astree_get_attribute(cdg->ast, array_atr->data);
 		Attribute *struct_fields = astree_get_attribute(cdg->ast, struct_atr->data);
 		LinkedList *elements = (LinkedList *)struct_fields->data;
-		linkedlist_start(elements);
-		Symbol *target_element = node->symbol_value;
+		LLIter it = linkedlist_iter(elements);
+		Symbol *target_element = node_symbol(cdg->ast, node);
 		while (!unscoped_symbol_equals(
-			((Element*)linkedlist_get_current(elements))->name,
+			((Element*)lliter_get(it))->name,
 			target_element
 		) ) {
-			linkedlist_forward(elements);
+			lliter_next(&it);
 			struct_offset++;
 		}
 		if (struct_offset != 0) {
@@ -546,16 +481,13 @@ void codegen_input_var(Codegen *cdg, ASTNode *node) {
 }
 
 void codegen_nvlist(Codegen *cdg, ASTNode *node) {
-	if (node->type == NVLIST) {
-		codegen_input_var(cdg, node->left_child);
-		codegen_nvlist(cdg, node->right_child);
-	} else {
-		codegen_input_var(cdg, node);
-	}
+	for (; node->type == NVLIST; node = node_right(cdg->ast, node))
+		codegen_input_var(cdg, node_left(cdg->ast, node));
+	codegen_input_var(cdg, node);
 }
 
 void codegen_ninput(Codegen *cdg, ASTNode *node) {
-	codegen_nvlist(cdg, node->left_child);
+	codegen_nvlist(cdg, node_left(cdg->ast, node));
 }
 
 void codegen_relop_push(Codegen *cdg, ASTNode *node) {
@@ -582,28 +514,46 @@ void codegen_relop_push(Codegen *cdg, ASTNode *node) {
 	}
 }
 
-void codegen_boolean_push(Codegen *cdg, ASTNode *node) {
+static void push_pending(Codegen *cdg, ASTNode *node, int boolean, int operands_done) {
+	if (cdg->pending_count == cdg->pending_cap) {
+		cdg->pending_cap = cdg->pending_cap ? cdg->pending_cap * 2 : 32;
+		cdg->pending = realloc(cdg->pending, cdg->pending_cap * sizeof(struct pending_push));
+	}
+	cdg->pending[cdg->pending_count++] = (struct pending_push){ node, boolean, operands_done };
+}
+
+// the instruction(s) an operator ends with, after its operands
+static void codegen_operator(Codegen *cdg, ASTNode *node, int boolean) {
+	if (!boolean) {
+		switch (node->type) {
+			case NADD:
+				push_instruction(cdg, ADD, 0);
+				break;
+			case NSUB:
+				push_instruction(cdg, SUB, 0);
+				break;
+			case NMUL:
+				push_instruction(cdg, MUL, 0);
+				break;
+			case NDIV:
+				push_instruction(cdg, DIV, 0);
+				break;
+			case NMOD:
+				push_instruction(cdg, REM, 0);
+				break;
+			case NPOW:
+				push_instruction(cdg, POW, 0);
+				break;
+		}
+		return;
+	}
 	switch (node->type) {
-		case NFALS:
-			push_instruction(cdg, FALSE, 0);
-			break;
-		case NTRUE:
-			push_instruction(cdg, TRUE, 0);
-			break;
-		case NSIMV:
-		case NARRV:
-			codegen_var_push(cdg, node);
-			break;
 		case NNOT:
-			codegen_numeric_push(cdg, node->left_child);
-			codegen_numeric_push(cdg, node->right_child);
-			codegen_relop_push(cdg, node->middle_child);
+			codegen_relop_push(cdg, node_middle(cdg->ast, node));
 			push_instruction(cdg, NOT, 0);
 			break;
 		case NBOOL:
-			codegen_boolean_push(cdg, node->left_child);
-			codegen_boolean_push(cdg, node->right_child);
-			switch (node->middle_child->type) {
+			switch (node_middle(cdg->ast, node)->type) {
 				case NAND:
 					push_instruction(cdg, AND, 0);
 					break;
@@ -621,25 +571,79 @@ void codegen_boolean_push(Codegen *cdg, ASTNode *node) {
 		case NLSS:
 		case NLEQ:
 		case NGEQ:
-			codegen_numeric_push(cdg, node->left_child);
-			codegen_numeric_push(cdg, node->right_child);
 			codegen_relop_push(cdg, node);
 			break;
-		case NFCALL:
-			codegen_fncall(cdg, node);
-			break;
 	}
 }
 
+// pushes node's value (as a boolean, or a number) onto the SM25 stack, operands first
+// the operators go on cdg->pending rather than the C stack; a call's arguments and an array index
+// still come back through here from codegen_fncall and codegen_push_adr
+static void codegen_expr_walk(Codegen *cdg, ASTNode *node, int boolean) {
+	u32 base = cdg->pending_count;
+	push_pending(cdg, node, boolean, 0);
+	while (cdg->pending_count > base) {
+		struct pending_push next = cdg->pending[--cdg->pending_count];
+		node = next.node;
+		if (next.operands_done) {
+			codegen_operator(cdg, node, next.boolean);
+			continue;
+		}
+		int operands_boolean = 0;
+		if (!next.boolean) {
+			if (codegen_numeric_leaf(cdg, node))
+				continue;
+		} else {
+			switch (node->type) {
+				case NFALS:
+					push_instruction(cdg, FALSE, 0);
+					continue;
+				case NTRUE:
+					push_instruction(cdg, TRUE, 0);
+					continue;
+				case NSIMV:
+				case NARRV:
+					codegen_var_push(cdg, node);
+					continue;
+				case NFCALL:
+					codegen_fncall(cdg, node);
+					continue;
+				case NBOOL:
+					operands_boolean = 1;
+					break;
+				case NNOT:
+				case NEQL:
+				case NNEQ:
+				case NGRT:
+				case NLSS:
+				case NLEQ:
+				case NGEQ:
+					break;
+				default:
+					continue;
+			}
+		}
+		push_pending(cdg, node, next.boolean, 1);
+		push_pending(cdg, node_right(cdg->ast, node), operands_boolean, 0);
+		push_pending(cdg, node_left(cdg->ast, node), operands_boolean, 0);
+	}
+}
+
+void codegen_numeric_push(Codegen *cdg, ASTNode *node) {
+	codegen_expr_walk(cdg, node, 0);
+}
+
+void codegen_boolean_push(Codegen *cdg, ASTNode *node) {
+	codegen_expr_walk(cdg, node, 1);
+}
+
 // push the address of the given variable in SM25
 void codegen_push_adr(Codegen *cdg, ASTNode *node) {
 	switch (node->type) {
 		case NARRV:
-			Attribute *array_atr = astree_get_attribute(cdg->ast, node->left_child->symbol_value);
-			codegen_array_push(cdg, node->left_child);
-			codegen_numeric_push(cdg, node->right_child);
-			// todo: why is the scope of that not 0? it's written as 0
-			((Symbol*)array_atr->data)->scope = 0;
+			Attribute *array_atr = astree_get_attribute(cdg->ast, node_symbol(cdg->ast, node_left(cdg->ast, node)));
+			codegen_array_push(cdg, node_left(cdg->ast, node));
+			codegen_numeric_push(cdg, node_right(cdg->ast, node));
 			int struct_size = * (int*)hashmap_get(cdg->array_structsize_map, array_atr->data);
 			if (struct_size != 1) {
 				push_int_by_val(cdg, struct_size);
@@ -649,13 +653,13 @@ void codegen_push_adr(Codegen *cdg, ASTNode *node) {
 			Attribute *struct_atr = astree_get_attribute(cdg->ast, array_atr->data);
 			Attribute *struct_fields = astree_get_attribute(cdg->ast, struct_atr->data);
 			LinkedList *elements = (LinkedList *)struct_fields->data;
-			linkedlist_start(elements);
-			Symbol *target_element = node->symbol_value;
+			LLIter it = linkedlist_iter(elements);
+			Symbol *target_element = node_symbol(cdg->ast, node);
 			while (!unscoped_symbol_equals(
-				((Element*)linkedlist_get_current(elements))->name,
+				((Element*)lliter_get(it))->name,
 				target_element
 			) ) {
-				linkedlist_forward(elements);
+				lliter_next(&it);
 				struct_offset++;
 			}
 			// this should be in an optimiser module, if there were one
@@ -666,8 +670,8 @@ void codegen_push_adr(Codegen *cdg, ASTNode *node) {
 			push_instruction(cdg, INDEX, 0);
 			break;
 		case NSIMV:
-			int offset = 8 * *(int*)hashmap_get(cdg->symbol_offset_map, node->symbol_value);
-			if (node->symbol_value->scope == cdg->scope_of_main) {
+			int offset = 8 * *(int*)hashmap_get(cdg->symbol_offset_map, node_symbol(cdg->ast, node));
+			if (node_symbol(cdg->ast, node)->scope == cdg->scope_of_main) {
 				offset += cdg->global_array_bytes + 8*cdg->num_global_arrays;
 				push_instruction(cdg, LA1, offset);
 			} else
@@ -677,27 +681,27 @@ void codegen_push_adr(Codegen *cdg, ASTNode *node) {
 }
 
 void codegen_nasgn(Codegen *cdg, ASTNode *node) {
-	switch (node->right_child->symbol_type) {
+	switch (node_right(cdg->ast, node)->symbol_type) {
 		case SINT:
 		case SREAL:
-			codegen_push_adr(cdg, node->left_child);
-			codegen_numeric_push(cdg, node->right_child);
+			codegen_push_adr(cdg, node_left(cdg->ast, node));
+			codegen_numeric_push(cdg, node_right(cdg->ast, node));
 			push_instruction(cdg, ST, 0);
 			break;
 		case SBOOL:
-			codegen_push_adr(cdg, node->left_child);
-			codegen_boolean_push(cdg, node->right_child);
+			codegen_push_adr(cdg, node_left(cdg->ast, node));
+			codegen_boolean_push(cdg, node_right(cdg->ast, node));
 			push_instruction(cdg, ST, 0);
 			break;
 		case SARRAY:
-			Attribute *array_atr0 = astree_get_attribute(cdg->ast, node->left_child->symbol_value);
+			Attribute *array_atr0 = astree_get_attribute(cdg->ast, node_symbol(cdg->ast, node_left(cdg->ast, node)));
 			int array_size = *(int*)hashmap_get(cdg->array_len_map, array_atr0->data);
 			// todo: figure out how to do an inline loop, by creating i as a variable on the stack, then referencing it. would be easy if "top of stack" was a base register
 			for (int i = 0; i < array_size; ++i) {
-				codegen_array_push(cdg, node->left_child);
+				codegen_array_push(cdg, node_left(cdg->ast, node));
 				push_int_by_val(cdg, i);
 				push_instruction(cdg, INDEX, 0);
-				codegen_array_push(cdg, node->right_child);
+				codegen_array_push(cdg, node_right(cdg->ast, node));
 				push_int_by_val(cdg, i);
 				push_instruction(cdg, INDEX, 0);
 				push_instruction(cdg, L, 0);
@@ -705,12 +709,12 @@ void codegen_nasgn(Codegen *cdg, ASTNode *node) {
 			}
 			break;
 		case SSTRUCT:
-			Attribute *array_atr = astree_get_attribute(cdg->ast, node->left_child->left_child->symbol_value);
+			Attribute *array_atr = astree_get_attribute(cdg->ast, node_symbol(cdg->ast, node_left(cdg->ast, node_left(cdg->ast, node))));
 			int struct_size = *(int*)hashmap_get(cdg->array_structsize_map, array_atr->data);
 			int field = 0;
 			for (int field = 0; field < struct_size; ++field) {
-				codegen_array_push(cdg, node->left_child->left_child);
-				codegen_numeric_push(cdg, node->left_child->right_child);
+				codegen_array_push(cdg, node_left(cdg->ast, node_left(cdg->ast, node)));
+				codegen_numeric_push(cdg, node_right(cdg->ast, node_left(cdg->ast, node)));
 				if (struct_size != 1) {
 					push_int_by_val(cdg, struct_size);
 					push_instruction(cdg, MUL, 0);
@@ -718,8 +722,8 @@ void codegen_nasgn(Codegen *cdg, ASTNode *node) {
 				push_int_by_val(cdg, field);
 				push_instruction(cdg, ADD, 0);
 				push_instruction(cdg, INDEX, 0);
-				codegen_array_push(cdg, node->right_child->left_child);
-				codegen_numeric_push(cdg, node->right_child->right_child);
+				codegen_array_push(cdg, node_left(cdg->ast, node_right(cdg->ast, node)));
+				codegen_numeric_push(cdg, node_right(cdg->ast, node_right(cdg->ast, node)));
 				if (struct_size != 1) {
 					push_int_by_val(cdg, struct_size);
 					push_instruction(cdg, MUL, 0);
@@ -735,8 +739,8 @@ void codegen_nasgn(Codegen *cdg, ASTNode *node) {
 }
 
 void codegen_nasgnop(Codegen *cdg, ASTNode *node) {
-	int offset = 8 * *(int*)hashmap_get(cdg->symbol_offset_map, node->left_child->symbol_value);
-	if (node->left_child->symbol_value->scope == cdg->scope_of_main) {
+	int offset = 8 * *(int*)hashmap_get(cdg->symbol_offset_map, node_symbol(cdg->ast, node_left(cdg->ast, node)));
+	if (node_symbol(cdg->ast, node_left(cdg->ast, node))->scope == cdg->scope_of_main) {
 		offset += cdg->global_array_bytes + 8*cdg->num_global_arrays;
 		push_instruction(cdg, LA1, offset);
 	} else {
@@ -751,13 +755,13 @@ void codegen_nasgnop(Codegen *cdg, ASTNode *node) {
 			push_instruction(cdg, L, 0);
 			break;
 	}
-	switch (node->right_child->symbol_type) {
+	switch (node_right(cdg->ast, node)->symbol_type) {
 		case SINT:
 		case SREAL:
-			codegen_numeric_push(cdg, node->right_child);
+			codegen_numeric_push(cdg, node_right(cdg->ast, node));
 			break;
 		case SBOOL:
-			codegen_boolean_push(cdg, node->right_child);
+			codegen_boolean_push(cdg, node_right(cdg->ast, node));
 			break;
 	}
 	switch (node->type) {
@@ -785,77 +789,110 @@ void anchor_jump(Codegen *cdg, int arr_index) {
 	cdg->jump_addresses[arr_index] = cdg->inst_bytes;
 }
 
-void codegen_if(Codegen *cdg, ASTNode *node) {
+// what's left to do of the statements being generated, the next thing last
+typedef struct codegen_work {
+	enum { W_STATS, W_ANCHOR, W_ELSE, W_LOOP, W_UNTIL } what;
+	ASTNode *node; // the statements for W_STATS, the if for W_ELSE, the repeat for W_UNTIL
+	int jump; // index into jump_addresses
+	int start_anchor;
+} CodegenWork;
+
+typedef struct codegen_work_stack {
+	CodegenWork *items;
+	u32 count, cap;
+} CodegenWorkStack;
+
+static void push_work(CodegenWorkStack *w, CodegenWork item) {
+	if (w->count == w->cap) {
+		w->cap = w->cap ? w->cap * 2 : 16;
+		w->items = realloc(w->items, w->cap * sizeof(CodegenWork));
+	}
+	w->items[w->count++] = item;
+}
+
+// the block statements push up to their statements, and leave what comes after on w
+void codegen_if(Codegen *cdg, ASTNode *node, CodegenWorkStack *w) {
 	int arr_index = cdg->num_jumps++;
 	push_instruction(cdg, LA0, AJUMP);
-	codegen_boolean_push(cdg, node->left_child);
+	codegen_boolean_push(cdg, node_left(cdg->ast, node));
 	push_instruction(cdg, BF, 0);
-	codegen_stats(cdg, node->right_child);
-	anchor_jump(cdg, arr_index);
+	push_work(w, (CodegenWork){ .what = W_ANCHOR, .jump = arr_index });
+	push_work(w, (CodegenWork){ .what = W_STATS, .node = node_right(cdg->ast, node) });
 }
 
-void codegen_ifelse(Codegen *cdg, ASTNode *node) {
+void codegen_ifelse(Codegen *cdg, ASTNode *node, CodegenWorkStack *w) {
 	int arr_index = cdg->num_jumps++;
 	push_instruction(cdg, LA0, AJUMP);
-	codegen_boolean_push(cdg, node->left_child);
+	codegen_boolean_push(cdg, node_left(cdg->ast, node));
 	push_instruction(cdg, BF, 0); // first jump
-	codegen_stats(cdg, node->middle_child);
+	push_work(w, (CodegenWork){ .what = W_ELSE, .node = node, .jump = arr_index });
+	push_work(w, (CodegenWork){ .what = W_STATS, .node = node_middle(cdg->ast, node) });
+}
+
+// between the then and else statements
+void codegen_else(Codegen *cdg, ASTNode *node, int arr_index, CodegenWorkStack *w) {
 	push_instruction(cdg, LA0, AJUMP);
 	push_instruction(cdg, BR, 0); // second jump
 
 	anchor_jump(cdg, arr_index); // first jump
 	arr_index = cdg->num_jumps++;
-	codegen_stats(cdg, node->right_child);
-	anchor_jump(cdg, arr_index); // second jump
+	push_work(w, (CodegenWork){ .what = W_ANCHOR, .jump = arr_index }); // second jump
+	push_work(w, (CodegenWork){ .what = W_STATS, .node = node_right(cdg->ast, node) });
 }
 
 void codegen_asgnlist(Codegen *cdg, ASTNode *node) {
 	if (!node)
 		return;
-	if (node->type == NASGNS) {
-		codegen_nasgnop(cdg, node->left_child);
-		codegen_asgnlist(cdg, node->right_child);
-	}
+	for (; node->type == NASGNS; node = node_right(cdg->ast, node))
+		codegen_nasgnop(cdg, node_left(cdg->ast, node));
 	codegen_nasgnop(cdg, node);
 }
 
-void codegen_for(Codegen *cdg, ASTNode *node) {
-	codegen_asgnlist(cdg, node->left_child);
+void codegen_for(Codegen *cdg, ASTNode *node, CodegenWorkStack *w) {
+	codegen_asgnlist(cdg, node_left(cdg->ast, node));
 	int start_anchor = cdg->inst_bytes; // second jump
 	int arr_index = cdg->num_jumps++;
 	push_instruction(cdg, LA0, AJUMP);
-	codegen_boolean_push(cdg, node->middle_child);
+	codegen_boolean_push(cdg, node_middle(cdg->ast, node));
 	push_instruction(cdg, BF, 0); // first jump
-	codegen_stats(cdg, node->right_child);
+	push_work(w, (CodegenWork){ .what = W_LOOP, .jump = arr_index, .start_anchor = start_anchor });
+	push_work(w, (CodegenWork){ .what = W_STATS, .node = node_right(cdg->ast, node) });
+}
+
+// after the for's statements
+void codegen_loop(Codegen *cdg, int arr_index, int start_anchor) {
 	// jump back to start
 	push_instruction(cdg, LA0, start_anchor);
 	push_instruction(cdg, BR, 0); // second jump
 	anchor_jump(cdg, arr_index); // first jump
 }
 
-void codegen_repeat(Codegen *cdg, ASTNode *node) {
-	codegen_asgnlist(cdg, node->left_child);
+void codegen_repeat(Codegen *cdg, ASTNode *node, CodegenWorkStack *w) {
+	codegen_asgnlist(cdg, node_left(cdg->ast, node));
 	int start_anchor = cdg->inst_bytes;
-	codegen_stats(cdg, node->middle_child);
+	push_work(w, (CodegenWork){ .what = W_UNTIL, .node = node, .start_anchor = start_anchor });
+	push_work(w, (CodegenWork){ .what = W_STATS, .node = node_middle(cdg->ast, node) });
+}
+
+// after the repeat's statements
+void codegen_until(Codegen *cdg, ASTNode *node, int start_anchor) {
 	push_instruction(cdg, LA0, start_anchor);
-	codegen_boolean_push(cdg, node->right_child);
+	codegen_boolean_push(cdg, node_right(cdg->ast, node));
 	push_instruction(cdg, BF, 0);
 }
 
 void codegen_array_push(Codegen *cdg, ASTNode *node) {
 	// todo: local array
 	int arr_offset;
-	Symbol *globscoped = malloc(sizeof(Symbol));
-	*globscoped = *(node->symbol_value);
-	globscoped->scope = 0;
-	if (hashmap_get(cdg->symbol_offset_map, node->symbol_value)) {
-		arr_offset = 8 * *(int*)hashmap_get(cdg->symbol_offset_map, node->symbol_value);
+	Symbol globscoped = *(node_symbol(cdg->ast, node));
+	globscoped.scope = 0;
+	if (hashmap_get(cdg->symbol_offset_map, node_symbol(cdg->ast, node))) {
+		arr_offset = 8 * *(int*)hashmap_get(cdg->symbol_offset_map, node_symbol(cdg->ast, node));
 		push_instruction(cdg, LV2, arr_offset);
 	} else {
-		arr_offset = 8 * *(int*)hashmap_get(cdg->symbol_offset_map, globscoped);
+		arr_offset = 8 * *(int*)hashmap_get(cdg->symbol_offset_map, &globscoped);
 		push_instruction(cdg, LV1, arr_offset);
 	}
-	free(globscoped);
 }
 
 void codegen_expr_push(Codegen *cdg, ASTNode *node) {
@@ -877,8 +914,8 @@ void codegen_expr_push(Codegen *cdg, ASTNode *node) {
 void codegen_parameters(Codegen *cdg, ASTNode *node, int *paramcount) {
 	if (!node) return;
 	if (node->type == NEXPL) {
-		codegen_parameters(cdg, node->right_child, paramcount);
-		codegen_expr_push(cdg, node->left_child);
+		codegen_parameters(cdg, node_right(cdg->ast, node), paramcount);
+		codegen_expr_push(cdg, node_left(cdg->ast, node));
 		(*paramcount)++;
 	} else {
 		codegen_expr_push(cdg, node);
@@ -888,7 +925,7 @@ void codegen_parameters(Codegen *cdg, ASTNode *node, int *paramcount) {
 
 void codegen_callstat(Codegen *cdg, ASTNode *node) {
 	int paramcount = 0;
-	codegen_parameters(cdg, node->left_child, &paramcount);
+	codegen_parameters(cdg, node_left(cdg->ast, node), &paramcount);
 	if (paramcount == 0) {
 		push_instruction(cdg, ZERO, 0);
 	} else if (paramcount <= 0xFF) {
@@ -896,13 +933,8 @@ void codegen_callstat(Codegen *cdg, ASTNode *node) {
 	} else if (paramcount <= 0xFFFF) {
 		push_instruction(cdg, LH, paramcount);
 	}
-	int len = 0;
-	linkedlist_start(cdg->func_calls);
-	while (linkedlist_get_current(cdg->func_calls)) {
-		len++;
-		linkedlist_forward(cdg->func_calls);
-	}
-	linkedlist_push_tail(cdg->func_calls, node->symbol_value);
+	int len = linkedlist_len(cdg->func_calls);
+	linkedlist_push_tail(cdg->func_calls, node_symbol(cdg->ast, node));
 	push_instruction(cdg, LA0, AFUNC * (len+1));
 	push_instruction(cdg, JS2, 0);
 }
@@ -915,14 +947,14 @@ void codegen_fncall(Codegen *cdg, ASTNode *node) {
 }
 
 void codegen_returnstat(Codegen *cdg, ASTNode *node) {
-	if (node->left_child) {
-		codegen_expr_push(cdg, node->left_child);
+	if (node_left(cdg->ast, node)) {
+		codegen_expr_push(cdg, node_left(cdg->ast, node));
 		push_instruction(cdg, RVAL, 0);
 	}
 	push_instruction(cdg, RETN, 0);
 }
 
-void codegen_stat(Codegen *cdg, ASTNode *node) {
+void codegen_stat(Codegen *cdg, ASTNode *node, CodegenWorkStack *w) {
 	switch (node->type) {
 		case NOUTP:
 			codegen_noutp(cdg, node);
@@ -934,16 +966,16 @@ void codegen_stat(Codegen *cdg, ASTNode *node) {
 			codegen_ninput(cdg, node);
 			break;
 		case NIFTH:
-			codegen_if(cdg, node);
+			codegen_if(cdg, node, w);
 			break;
 		case NIFTE:
-			codegen_ifelse(cdg, node);
+			codegen_ifelse(cdg, node, w);
 			break;
 		case NREPT:
-			codegen_repeat(cdg, node);
+			codegen_repeat(cdg, node, w);
 			break;
 		case NFORL:
-			codegen_for(cdg, node);
+			codegen_for(cdg, node, w);
 			break;
 		case NASGN:
 			codegen_nasgn(cdg, node);
@@ -963,14 +995,38 @@ void codegen_stat(Codegen *cdg, ASTNode *node) {
 	}
 }
 
+// nested blocks go on a work stack rather than the C stack
 void codegen_stats(Codegen *cdg, ASTNode *node) {
-	if (node->type == NSTATS) {
-		codegen_stat(cdg, node->left_child);
-		if (node->right_child)
-			codegen_stats(cdg, node->right_child);
-	} else {
-		codegen_stat(cdg, node);
+	CodegenWorkStack w = { 0 };
+	push_work(&w, (CodegenWork){ .what = W_STATS, .node = node });
+	while (w.count) {
+		CodegenWork next = w.items[--w.count];
+		switch (next.what) {
+			case W_STATS:
+				node = next.node;
+				if (node->type != NSTATS) {
+					codegen_stat(cdg, node, &w);
+					break;
+				}
+				if (node_right(cdg->ast, node))
+					push_work(&w, (CodegenWork){ .what = W_STATS, .node = node_right(cdg->ast, node) });
+				codegen_stat(cdg, node_left(cdg->ast, node), &w);
+				break;
+			case W_ANCHOR:
+				anchor_jump(cdg, next.jump);
+				break;
+			case W_ELSE:
+				codegen_else(cdg, next.node, next.jump, &w);
+				break;
+			case W_LOOP:
+				codegen_loop(cdg, next.jump, next.start_anchor);
+				break;
+			case W_UNTIL:
+				codegen_until(cdg, next.node, next.start_anchor);
+				break;
+		}
 	}
+	free(w.items);
 }
 
 void codegen_sdecl(Codegen *cdg, ASTNode *node) {
@@ -978,20 +1034,20 @@ void codegen_sdecl(Codegen *cdg, ASTNode *node) {
 	switch (node->symbol_type) {
 		case SREAL:
 			// todo: ask what happens to uninitialised reals/bools
-			offset = cdg->global_array_bytes + 8*cdg->num_global_arrays + 8 * *(int*)hashmap_get(cdg->symbol_offset_map, node->symbol_value);
+			offset = cdg->global_array_bytes + 8*cdg->num_global_arrays + 8 * *(int*)hashmap_get(cdg->symbol_offset_map, node_symbol(cdg->ast, node));
 			push_instruction(cdg, LA1, offset);
 			push_instruction(cdg, ZERO, 0);
 			push_instruction(cdg, TYPE, 0);
 			push_instruction(cdg, ST, 0);
 			break;
 		case SINT:
-			offset = cdg->global_array_bytes + 8*cdg->num_global_arrays + 8 * *(int*)hashmap_get(cdg->symbol_offset_map, node->symbol_value);
+			offset = cdg->global_array_bytes + 8*cdg->num_global_arrays + 8 * *(int*)hashmap_get(cdg->symbol_offset_map, node_symbol(cdg->ast, node));
 			push_instruction(cdg, LA1, offset);
 			push_instruction(cdg, ZERO, 0);
 			push_instruction(cdg, ST, 0);
 			break;
 		case SBOOL: // assumption: uninitialised booleans are false
-			offset = cdg->global_array_bytes + 8*cdg->num_global_arrays + 8 * *(int*)hashmap_get(cdg->symbol_offset_map, node->symbol_value);
+			offset = cdg->global_array_bytes + 8*cdg->num_global_arrays + 8 * *(int*)hashmap_get(cdg->symbol_offset_map, node_symbol(cdg->ast, node));
 			push_instruction(cdg, LA1, offset);
 			push_instruction(cdg, FALSE, 0);
 			push_instruction(cdg, ST, 0);
@@ -1001,19 +1057,19 @@ void codegen_sdecl(Codegen *cdg, ASTNode *node) {
 
 void add_var_offset(Codegen *cdg, ASTNode *sdecl, int offset) {
 	if (sdecl->type == NARRC)
-		sdecl = sdecl->left_child;
+		sdecl = node_left(cdg->ast, sdecl);
 	int *heap_num_vars = malloc(sizeof(int));
 	*heap_num_vars = offset;
-	hashmap_add(cdg->symbol_offset_map, sdecl->symbol_value, heap_num_vars);
+	hashmap_add(cdg->symbol_offset_map, node_symbol(cdg->ast, sdecl), heap_num_vars);
 }
 
 void codegen_slist(Codegen *cdg, ASTNode *node) {
 	int num_vars = 0;
 	ASTNode *cursor = node;
 	while (cursor->type == NSDLST) {
-		add_var_offset(cdg, cursor->left_child, num_vars);
+		add_var_offset(cdg, node_left(cdg->ast, cursor), num_vars);
 		num_vars++;
-		cursor = cursor->right_child;
+		cursor = node_right(cdg->ast, cursor);
 	}
 	add_var_offset(cdg, cursor, num_vars);
 	num_vars++;
@@ -1021,55 +1077,54 @@ void codegen_slist(Codegen *cdg, ASTNode *node) {
 	push_instruction(cdg, ALLOC, 0);
 	cursor = node;
 	while (cursor->type == NSDLST) {
-		codegen_sdecl(cdg, cursor->left_child);
-		cursor = cursor->right_child;
+		codegen_sdecl(cdg, node_left(cdg->ast, cursor));
+		cursor = node_right(cdg->ast, cursor);
 	}
 	codegen_sdecl(cdg, cursor);
 }
 
 void codegen_main(Codegen *cdg, ASTNode *nmain) {
-	codegen_slist(cdg, nmain->left_child);
-	codegen_stats(cdg, nmain->right_child);
+	codegen_slist(cdg, node_left(cdg->ast, nmain));
+	codegen_stats(cdg, node_right(cdg->ast, nmain));
 }
 
 void codegen_update_addresses(Codegen *cdg) {
-	linkedlist_start(cdg->int_offsets);
-	linkedlist_start(cdg->real_offsets);
-	linkedlist_start(cdg->str_offsets);
+	LLIter int_offsets = linkedlist_iter(cdg->int_offsets);
+	LLIter real_offsets = linkedlist_iter(cdg->real_offsets);
+	LLIter str_offsets = linkedlist_iter(cdg->str_offsets);
 	int jump_address_index = 0;
-	linkedlist_start(cdg->instructions);
-	while (linkedlist_get_current(cdg->instructions)) {
-		Instruction *cur = (Instruction*)linkedlist_get_current(cdg->instructions);
+	for (u32 i = 0; i < vector_len(cdg->instructions); i++) {
+		Instruction *cur = vector_at(cdg->instructions, i);
 		switch (cur->type) {
 			case 80:
 				switch (cur->value) {
 					case AINT: //int
-						int int_offset = *(int *)linkedlist_get_current(cdg->int_offsets);
+						int int_offset = *(int *)lliter_get(int_offsets);
 						cur->value = cdg->inst_bytes + int_offset;
-						linkedlist_forward(cdg->int_offsets);
+						lliter_next(&int_offsets);
 						break;
 					case AREAL: //real
-						int real_offset = *(int *)linkedlist_get_current(cdg->real_offsets);
+						int real_offset = *(int *)lliter_get(real_offsets);
 						cur->value = cdg->inst_bytes + cdg->num_ints*8 + real_offset;
-						linkedlist_forward(cdg->real_offsets);
+						lliter_next(&real_offsets);
 						break;
 				}
 			case 90:
 				switch (cur->value) {
 					case AINT: //int
-						int int_offset = *(int *)linkedlist_get_current(cdg->int_offsets);
+						int int_offset = *(int *)lliter_get(int_offsets);
 						cur->value = cdg->inst_bytes + int_offset;
-						linkedlist_forward(cdg->int_offsets);
+						lliter_next(&int_offsets);
 						break;
 					case AREAL: //real
-						int real_offset = *(int *)linkedlist_get_current(cdg->real_offsets);
+						int real_offset = *(int *)lliter_get(real_offsets);
 						cur->value = cdg->inst_bytes + cdg->num_ints*8 + real_offset;
-						linkedlist_forward(cdg->real_offsets);
+						lliter_next(&real_offsets);
 						break;
 					case ASTR: //string
-						int str_offset = *(int *)linkedlist_get_current(cdg->str_offsets);
+						int str_offset = *(int *)lliter_get(str_offsets);
 						cur->value = cdg->inst_bytes + cdg->num_ints*8 + cdg->num_reals*8 + str_offset;
-						linkedlist_forward(cdg->str_offsets);
+						lliter_next(&str_offsets);
 						break;
 					case AJUMP: //jump
 						cur->value = cdg->jump_addresses[jump_address_index++];
@@ -1079,42 +1134,39 @@ void codegen_update_addresses(Codegen *cdg) {
 							break;
 						}
 						int index = cur->value / AFUNC - 1;
-						linkedlist_start(cdg->func_calls);
-						for (int i = 0; i < index; ++i) {
-							linkedlist_forward(cdg->func_calls);
+						LLIter call = linkedlist_iter(cdg->func_calls);
+						for (int k = 0; k < index; ++k) {
+							lliter_next(&call);
 						}
-						Symbol glob_scoped = *(Symbol*)linkedlist_get_current(cdg->func_calls);
+						Symbol glob_scoped = *(Symbol*)lliter_get(call);
 						glob_scoped.scope = 0;
 						cur->value = *(int *)hashmap_get(cdg->symbol_offset_map, &glob_scoped);
 				}
 				break;
 		}
-		linkedlist_forward(cdg->instructions);
 	}
 }
 
 void codegen_init(Codegen *cdg, ASTNode* node) {
-	if (node->left_child->type != NILIT && node->left_child->type != NFLIT) {
+	if (node_left(cdg->ast, node)->type != NILIT && node_left(cdg->ast, node)->type != NFLIT) {
 		// todo: put constexpr here (nontrivial because int is not symbol)
 		printf("sorry, only integer/float literals are implemented as constants\n");
 		return;
 	}
 	int *offset;
-	if (node->left_child->type == NILIT) {
-		Symbol *temp = node->left_child->symbol_value;
-		linkedlist_push_tail(cdg->ints, temp);
+	if (node_left(cdg->ast, node)->type == NILIT) {
+		linkedlist_push_tail(cdg->ints, node_left(cdg->ast, node));
 		offset = malloc(sizeof(int));
 		*offset = cdg->num_ints*8;
-		hashmap_add(cdg->symbol_offset_map, node->symbol_value, offset);
+		hashmap_add(cdg->symbol_offset_map, node_symbol(cdg->ast, node), offset);
 		// linkedlist_push_tail(cdg->int_offsets, offset);
 		cdg->num_ints++;
 	}
-	if (node->left_child->type == NFLIT) {
-		Symbol *temp = node->left_child->symbol_value;
-		linkedlist_push_tail(cdg->reals, temp);
+	if (node_left(cdg->ast, node)->type == NFLIT) {
+		linkedlist_push_tail(cdg->reals, node_left(cdg->ast, node));
 		offset = malloc(sizeof(int));
 		*offset = cdg->num_reals*8;
-		hashmap_add(cdg->symbol_offset_map, node->symbol_value, offset);
+		hashmap_add(cdg->symbol_offset_map, node_symbol(cdg->ast, node), offset);
 		// linkedlist_push_tail(cdg->real_offsets, offset);
 		cdg->num_reals++;
 	}
@@ -1123,37 +1175,28 @@ void codegen_init(Codegen *cdg, ASTNode* node) {
 void codegen_consts(Codegen *cdg, ASTNode* node) {
 	if (!node) return;
 	while (node->type == NILIST) {
-		codegen_init(cdg, node->left_child);
-		node = node->right_child;
+		codegen_init(cdg, node_left(cdg->ast, node));
+		node = node_right(cdg->ast, node);
 	}
 	codegen_init(cdg, node);
 }
 
 int codegen_constexpr(Codegen *cdg, ASTNode* node) {
-	sds glyph;
-	int result;
 	int offset;
 	switch (node->type) {
 		case NILIT:
-			glyph = sds_from_symbol(cdg, node->symbol_value);
-			result = atoi(glyph);
-			sdsfree(glyph);
-			return result;
+			return (int)node->lit.i;
 		case NSIMV:
-			offset = * (int*)hashmap_get(cdg->symbol_offset_map, node->symbol_value);
-			linkedlist_start(cdg->ints);
+			offset = * (int*)hashmap_get(cdg->symbol_offset_map, node_symbol(cdg->ast, node));
+			LLIter it = linkedlist_iter(cdg->ints);
 			for (int i = 0; i < offset; ++i) {
-				linkedlist_forward(cdg->ints);
+				lliter_next(&it);
 			}
-			glyph = sds_from_symbol(cdg, (Symbol*)linkedlist_get_current(cdg->ints));
-			result = atoi(glyph);
-			sdsfree(glyph);
-			return result;
-			break;
+			return (int)((ASTNode*)lliter_get(it))->lit.i;
 		default: abort();
 	}
-	int lhs = codegen_constexpr(cdg, node->left_child);
-	int rhs = codegen_constexpr(cdg, node->right_child);
+	int lhs = codegen_constexpr(cdg, node_left(cdg->ast, node));
+	int rhs = codegen_constexpr(cdg, node_right(cdg->ast, node));
 	switch (node->type) {
 		case NADD:
 			return lhs + rhs;
@@ -1170,30 +1213,25 @@ int codegen_constexpr(Codegen *cdg, ASTNode* node) {
 }
 
 void codegen_arrtype(Codegen *cdg, ASTNode *node) {
-	Attribute *struct_atr = astree_get_attribute(cdg->ast, node->symbol_value);
+	Attribute *struct_atr = astree_get_attribute(cdg->ast, node_symbol(cdg->ast, node));
 	Attribute *struct_fields = astree_get_attribute(cdg->ast, struct_atr->data);
 	LinkedList *elements = (LinkedList *)struct_fields->data;
-	int structsize = 0;
-	linkedlist_start(elements);
-	while (linkedlist_get_current(elements)) {
-		linkedlist_forward(elements);
-		structsize++;
-	}
+	int structsize = linkedlist_len(elements);
 	int *len = malloc(sizeof(int));
-	*len = structsize * codegen_constexpr(cdg, node->left_child);
+	*len = structsize * codegen_constexpr(cdg, node_left(cdg->ast, node));
 	// cdg->global_array_bytes += 8 * *len;
-	hashmap_add(cdg->array_len_map, node->symbol_value, len);
+	hashmap_add(cdg->array_len_map, node_symbol(cdg->ast, node), len);
 	int *structsize_heap = malloc(sizeof(int));
 	*structsize_heap = structsize;
-	hashmap_add(cdg->array_structsize_map, node->symbol_value, structsize_heap);
+	hashmap_add(cdg->array_structsize_map, node_symbol(cdg->ast, node), structsize_heap);
 }
 
 void codegen_types(Codegen *cdg, ASTNode *node) {
 	if (!node) return;
 	while (node->type == NTYPEL) {
 		if (node->type == NATYPE)
-			codegen_arrtype(cdg, node->left_child);
-		node = node->right_child;
+			codegen_arrtype(cdg, node_left(cdg->ast, node));
+		node = node_right(cdg->ast, node);
 	}
 	if (node->type == NATYPE)
 		codegen_arrtype(cdg, node);
@@ -1202,10 +1240,10 @@ void codegen_types(Codegen *cdg, ASTNode *node) {
 // todo: initialise the array using struct fields for 0, 0.0, false
 void codegen_array(Codegen *cdg, ASTNode *node) {
 	if (!node) return;
-	Attribute *atr = astree_get_attribute(cdg->ast, node->symbol_value);
+	Attribute *atr = astree_get_attribute(cdg->ast, node_symbol(cdg->ast, node));
 	int *arr_offset = malloc(sizeof(int));
 	*arr_offset = cdg->num_global_arrays;
-	hashmap_add(cdg->symbol_offset_map, node->symbol_value, arr_offset);
+	hashmap_add(cdg->symbol_offset_map, node_symbol(cdg->ast, node), arr_offset);
 	cdg->global_array_bytes += 8 * *(int*)hashmap_get(cdg->array_len_map, atr->data);
 	push_instruction(cdg, LA1, 8*cdg->num_global_arrays++);
 	int len = * (int*)hashmap_get(cdg->array_len_map, atr->data);
@@ -1219,36 +1257,36 @@ void codegen_arrays(Codegen *cdg, ASTNode *node) {
 	ASTNode *scan = node;
 	while (scan->type == NALIST) {
 		count++;
-		scan = scan->right_child;
+		scan = node_right(cdg->ast, scan);
 	}
 	push_int_by_val(cdg, count);
 	push_instruction(cdg, ALLOC, 0);
 	while (node->type == NALIST) {
-		codegen_array(cdg, node->left_child);
-		node = node->right_child;
+		codegen_array(cdg, node_left(cdg->ast, node));
+		node = node_right(cdg->ast, node);
 	}
 	codegen_array(cdg, node);
 }
 
 void codegen_globals(Codegen *cdg, ASTNode* nglobs) {
 	if (!nglobs) return;
-	codegen_consts(cdg, nglobs->left_child);
-	codegen_types(cdg, nglobs->middle_child);
-	codegen_arrays(cdg, nglobs->right_child);
+	codegen_consts(cdg, node_left(cdg->ast, nglobs));
+	codegen_types(cdg, node_middle(cdg->ast, nglobs));
+	codegen_arrays(cdg, node_right(cdg->ast, nglobs));
 }
 
 void codegen_plist(Codegen *cdg, ASTNode *node) {
 	// todo: this could be in parser
 	int num_vars = 0;
 	while (node->type == NPLIST) {
-		add_var_offset(cdg, node->left_child, -1*(1+num_vars++));
-		node = node->right_child;
+		add_var_offset(cdg, node_left(cdg->ast, node), -1*(1+num_vars++));
+		node = node_right(cdg->ast, node);
 	}
 	add_var_offset(cdg, node, -1*(1+num_vars++));
 }
 
 void codegen_decl(Codegen *cdg, ASTNode *node) {
-	int offset = 8 * *(int*)hashmap_get(cdg->symbol_offset_map, node->symbol_value);
+	int offset = 8 * *(int*)hashmap_get(cdg->symbol_offset_map, node_symbol(cdg->ast, node));
 	switch (node->symbol_type) {
 		case SREAL:
 			push_instruction(cdg, LA2, offset);
@@ -1274,16 +1312,16 @@ void codegen_func_locals(Codegen *cdg, ASTNode* node) {
 	int num_vars = 0;
 	ASTNode *cursor = node;
 	while (cursor->type == NDLIST) {
-		add_var_offset(cdg, cursor->left_child, 2+num_vars++);
-		cursor = cursor->right_child;
+		add_var_offset(cdg, node_left(cdg->ast, cursor), 2+num_vars++);
+		cursor = node_right(cdg->ast, cursor);
 	}
 	add_var_offset(cdg, cursor, 2+num_vars++);
 	push_instruction(cdg, LB, num_vars);
 	push_instruction(cdg, ALLOC, 0);
 	cursor = node;
 	while (cursor->type == NDLIST) {
-		codegen_decl(cdg, cursor->left_child);
-		cursor = cursor->right_child;
+		codegen_decl(cdg, node_left(cdg->ast, cursor));
+		cursor = node_right(cdg->ast, cursor);
 	}
 	codegen_decl(cdg, cursor);
 }
@@ -1291,17 +1329,17 @@ void codegen_func_locals(Codegen *cdg, ASTNode* node) {
 void codegen_func(Codegen *cdg, ASTNode* nfuncs) {
 	int *adr = malloc(sizeof(int));
 	*adr = cdg->inst_bytes;
-	hashmap_add(cdg->symbol_offset_map, nfuncs->symbol_value, adr);
-	codegen_plist(cdg, nfuncs->left_child);
-	codegen_func_locals(cdg, nfuncs->middle_child);
-	codegen_stats(cdg, nfuncs->right_child);
+	hashmap_add(cdg->symbol_offset_map, node_symbol(cdg->ast, nfuncs), adr);
+	codegen_plist(cdg, node_left(cdg->ast, nfuncs));
+	codegen_func_locals(cdg, node_middle(cdg->ast, nfuncs));
+	codegen_stats(cdg, node_right(cdg->ast, nfuncs));
 }
 
 void codegen_funcs(Codegen *cdg, ASTNode* nfuncs) {
 	if (!nfuncs) return;
-	while (nfuncs && nfuncs->left_child) {
-		codegen_func(cdg, nfuncs->left_child);
-		nfuncs = nfuncs->right_child;
+	while (nfuncs && node_left(cdg->ast, nfuncs)) {
+		codegen_func(cdg, node_left(cdg->ast, nfuncs));
+		nfuncs = node_right(cdg->ast, nfuncs);
 	}
 	if (nfuncs)
 		codegen_func(cdg, nfuncs);
@@ -1309,11 +1347,11 @@ void codegen_funcs(Codegen *cdg, ASTNode* nfuncs) {
 
 void sm25_code_gen(char *mod_output, ASTree *ast, int print_opcodes) {
 	Codegen *cdg = codegen_create(mod_output, ast);
-	cdg->scope_of_main = ast->root->right_child->symbol_value->scope;
-	codegen_globals(cdg, ast->root->left_child);
-	codegen_main(cdg, ast->root->right_child);
+	cdg->scope_of_main = node_symbol(cdg->ast, node_right(cdg->ast, ast->root))->scope;
+	codegen_globals(cdg, node_left(cdg->ast, ast->root));
+	codegen_main(cdg, node_right(cdg->ast, ast->root));
 	push_instruction(cdg, HALT, 0);
-	codegen_funcs(cdg, ast->root->middle_child);
+	codegen_funcs(cdg, node_middle(cdg->ast, ast->root));
 	// padding byte counter to word size (printing doesn't use this value, but constant addresses do)
 	cdg->str_bytes += cdg->str_bytes % 8 == 0
 		? 0
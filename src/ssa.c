@@ -0,0 +1,518 @@
+#include "ssa.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define RENAMED (1u << 31) // marks a block on the renaming stack whose dominator tree children are done
+
+static void push_u32(u32 **items, u32 *count, u32 *cap, u32 item) {
+	if (*count == *cap) {
+		*cap = *cap ? *cap * 2 : 16;
+		*items = realloc(*items, *cap * sizeof(u32));
+		if (!*items) abort();
+	}
+	(*items)[(*count)++] = item;
+}
+
+// (key, value) pairs listed by key, keeping their order: key k's values are list[start[k]] up to list[start[k + 1]]
+static void group(u32 key_count, const u32 *pairs, u32 pair_count, u32 **start, u32 **list) {
+	*start = calloc(key_count + 1, sizeof(u32));
+	*list = malloc((pair_count ? pair_count : 1) * sizeof(u32));
+	for (u32 p = 0; p < pair_count; p++)
+		(*start)[pairs[2 * p] + 1]++;
+	for (u32 k = 0; k < key_count; k++)
+		(*start)[k + 1] += (*start)[k];
+	u32 *fill = malloc((key_count ? key_count : 1) * sizeof(u32));
+	memcpy(fill, *start, key_count * sizeof(u32));
+	for (u32 p = 0; p < pair_count; p++)
+		(*list)[fill[pairs[2 * p]]++] = pairs[2 * p + 1];
+	free(fill);
+}
+
+static inline Line *block_line(const SSA *ssa, u32 i) {
+	return &ssa->lines[i - ssa->cfg->func];
+}
+
+// the place of pred among block's preds, which is where its phi args are
+static u32 pred_index(const CFG *cfg, u32 block, u32 pred) {
+	for (u32 i = 0; i < cfg->blocks[block].pred_count; i++) {
+		if (cfg_pred(cfg, block, i) == pred)
+			return i;
+	}
+	abort();
+}
+
+// each reachable block's children in the dominator tree, by block number
+static void dom_children(const CFG *cfg, u32 **start, u32 **list) {
+	u32 *pairs = NULL, count = 0, cap = 0;
+	for (u32 b = 1; b < cfg->block_count; b++) {
+		if (cfg->blocks[b].idom != CFG_NONE) {
+			push_u32(&pairs, &count, &cap, cfg->blocks[b].idom);
+			push_u32(&pairs, &count, &cap, b);
+		}
+	}
+	group(cfg->block_count, pairs, count / 2, start, list);
+	free(pairs);
+}
+
+// phis for each variable at the frontiers of its writes (iterated), only where it's live, so only for those
+// live has facts for
+// the frontiers aren't listed, as on nested loops they take blocks squared: sreedhar and gao's walk finds them
+// from the dominator tree, taking the blocks to look from deepest first and walking each one's subtree for
+// edges to blocks no deeper than it, so a variable walks each block at most once
+static void place_phis(SSA *ssa, const Dataflow *live) {
+	const CFG *cfg = ssa->cfg;
+	u32 *child_start, *children;
+	dom_children(cfg, &child_start, &children);
+	u32 *level = malloc((cfg->block_count + 1) * sizeof(u32)); // depth in the dominator tree
+	u32 levels = 1;
+	for (u32 i = 0; i < cfg->rpo_count; i++) { // each after its dominators
+		u32 b = cfg->rpo[i];
+		level[b] = b ? level[cfg->blocks[b].idom] + 1 : 0;
+		if (level[b] >= levels)
+			levels = level[b] + 1;
+	}
+
+	// where each variable's written
+	u32 *pairs = NULL, count = 0, cap = 0;
+	for (u32 b = 0; b < cfg->block_count; b++) {
+		if (cfg->blocks[b].idom == CFG_NONE)
+			continue;
+		const u64 *def = dataflow_kill(live, b);
+		for (u32 w = 0; w < live->words; w++) {
+			for (u64 bits = def[w]; bits; bits &= bits - 1) {
+				push_u32(&pairs, &count, &cap, w * 64 + __builtin_ctzll(bits));
+				push_u32(&pairs, &count, &cap, b);
+			}
+		}
+	}
+	u32 *site_start, *sites;
+	group(live->bits, pairs, count / 2, &site_start, &sites);
+
+	// each block stamped with the variable's fact (+ 1) it last got a phi for, was last banked for, and last
+	// walked for
+	u32 *has_phi = calloc(cfg->block_count + 1, sizeof(u32));
+	u32 *banked = calloc(cfg->block_count + 1, sizeof(u32));
+	u32 *walked = calloc(cfg->block_count + 1, sizeof(u32));
+	u32 *bank = malloc(levels * sizeof(u32)); // the blocks waiting at each level, chained through next_banked
+	u32 *next_banked = malloc((cfg->block_count + 1) * sizeof(u32));
+	u32 *stack = malloc((cfg->block_count + 1) * sizeof(u32));
+	for (u32 l = 0; l < levels; l++)
+		bank[l] = CFG_NONE;
+	count = 0;
+	for (u32 v = 0; v < live->bits; v++) {
+		u32 top = 0;
+		for (u32 i = site_start[v]; i < site_start[v + 1]; i++) {
+			u32 b = sites[i];
+			banked[b] = v + 1;
+			next_banked[b] = bank[level[b]];
+			bank[level[b]] = b;
+			top = level[b] > top ? level[b] : top;
+		}
+		for (u32 l = top + 1; l-- > 0;) {
+			while (bank[l] != CFG_NONE) {
+				u32 x = bank[l], depth = 0;
+				bank[l] = next_banked[x];
+				walked[x] = v + 1;
+				stack[depth++] = x;
+				while (depth) {
+					u32 y = stack[--depth];
+					const Block *block = &cfg->blocks[y];
+					for (u32 s = 0; s < block->succ_count; s++) {
+						u32 f = block->succ[s];
+						if (level[f] > l || has_phi[f] == v + 1 || !bitset_test(dataflow_in(live, f), v))
+							continue; // not on x's frontier, or done with
+						has_phi[f] = v + 1;
+						push_u32(&pairs, &count, &cap, f);
+						push_u32(&pairs, &count, &cap, live->fact_vars[v]);
+						if (banked[f] != v + 1) {
+							banked[f] = v + 1;
+							next_banked[f] = bank[level[f]];
+							bank[level[f]] = f;
+						}
+					}
+					for (u32 i = child_start[y]; i < child_start[y + 1]; i++) {
+						if (walked[children[i]] != v + 1) { // else walked from a block at least as deep as x
+							walked[children[i]] = v + 1;
+							stack[depth++] = children[i];
+						}
+					}
+				}
+			}
+		}
+	}
+	u32 *vars;
+	group(cfg->block_count, pairs, count / 2, &ssa->phi_start, &vars);
+	u32 phi_count = ssa->phi_start[cfg->block_count];
+	ssa->phis = malloc((phi_count ? phi_count : 1) * sizeof(Phi));
+	u32 arg_count = 0;
+	for (u32 b = 0; b < cfg->block_count; b++)
+		arg_count += (ssa->phi_start[b + 1] - ssa->phi_start[b]) * cfg->blocks[b].pred_count;
+	ssa->phi_args = malloc((arg_count ? arg_count : 1) * sizeof(Adr));
+	arg_count = 0;
+	for (u32 b = 0; b < cfg->block_count; b++) {
+		for (u32 i = ssa->phi_start[b]; i < ssa->phi_start[b + 1]; i++) {
+			ssa->phis[i] = (Phi){ var_adr(&ssa->vars, vars[i]), vars[i], arg_count };
+			for (u32 a = 0; a < cfg->blocks[b].pred_count; a++)
+				ssa->phi_args[arg_count++] = ssa->phis[i].dest;
+		}
+	}
+	free(vars);
+	free(has_phi);
+	free(banked);
+	free(walked);
+	free(bank);
+	free(next_banked);
+	free(stack);
+	free(pairs);
+	free(site_start);
+	free(sites);
+	free(level);
+	free(child_start);
+	free(children);
+}
+
+// what renaming a variable replaced, to put back once the dominator subtree it was renamed in is done
+struct rename {
+	u32 var;
+	Adr was;
+};
+
+// a new temporary for a write to var, logging the name it replaces
+static Adr new_name(SSA *ssa, u32 var, Adr *current, struct rename **undo, u32 *count, u32 *cap) {
+	if (*count == *cap) {
+		*cap = *cap ? *cap * 2 : 64;
+		*undo = realloc(*undo, *cap * sizeof(struct rename));
+		if (!*undo) abort();
+	}
+	(*undo)[(*count)++] = (struct rename){ var, current[var] };
+	return current[var] = (Adr){ A_TMP, ssa->next_tmp++ };
+}
+
+// down the dominator tree, giving each write a new temporary and each read the one reaching it
+static void rename_vars(SSA *ssa) {
+	const CFG *cfg = ssa->cfg;
+	u32 var_count = var_total(&ssa->vars);
+	Adr *current = malloc((var_count ? var_count : 1) * sizeof(Adr));
+	for (u32 v = 0; v < var_count; v++)
+		current[v] = var_adr(&ssa->vars, v);
+	struct rename *undo = NULL;
+	u32 undo_count = 0, undo_cap = 0;
+
+	u32 *child_start, *children;
+	dom_children(cfg, &child_start, &children);
+
+	u32 *mark = malloc((cfg->block_count ? cfg->block_count : 1) * sizeof(u32)); // undo_count on entering each
+	u32 *stack = malloc((2 * cfg->block_count + 1) * sizeof(u32));
+	u32 depth = 0;
+	if (cfg->block_count)
+		stack[depth++] = 0;
+	while (depth) {
+		u32 b = stack[--depth];
+		if (b & RENAMED) {
+			for (b &= ~RENAMED; undo_count > mark[b]; undo_count--)
+				current[undo[undo_count - 1].var] = undo[undo_count - 1].was;
+			continue;
+		}
+		mark[b] = undo_count;
+		const Block *block = &cfg->blocks[b];
+		for (u32 p = ssa->phi_start[b]; p < ssa->phi_start[b + 1]; p++)
+			ssa->phis[p].dest = new_name(ssa, ssa->phis[p].var, current, &undo, &undo_count, &undo_cap);
+		for (u32 i = block->first; i < block->end; i++) {
+			Line *l = block_line(ssa, i);
+			Adr *uses[3];
+			u32 n = tac_line_uses(l, uses);
+			for (u32 k = 0; k < n; k++)
+				*uses[k] = current[var_number(&ssa->vars, *uses[k])];
+			Adr *dest = tac_line_def(l);
+			if (dest)
+				*dest = new_name(ssa, var_number(&ssa->vars, *dest), current, &undo, &undo_count, &undo_cap);
+		}
+		for (u32 s = 0; s < block->succ_count; s++) {
+			u32 succ = block->succ[s];
+			u32 j = pred_index(cfg, succ, b);
+			for (u32 p = ssa->phi_start[succ]; p < ssa->phi_start[succ + 1]; p++)
+				ssa->phi_args[ssa->phis[p].arg_start + j] = current[ssa->phis[p].var];
+		}
+		stack[depth++] = b | RENAMED;
+		for (u32 i = child_start[b + 1]; i-- > child_start[b];)
+			stack[depth++] = children[i];
+	}
+	free(stack);
+	free(mark);
+	free(child_start);
+	free(children);
+	free(undo);
+	free(current);
+}
+
+SSA *ssa_build(const TAC *tac, u32 func) {
+	SSA *ssa = malloc(sizeof(SSA));
+	ssa->cfg = cfg_build(tac, func);
+	ssa->line_count = cfg_next_func(tac, func) - func;
+	ssa->lines = malloc(ssa->line_count * sizeof(Line));
+	memcpy(ssa->lines, vector_at(tac->lines, func), ssa->line_count * sizeof(Line));
+	ssa->vars = var_numbering(ssa->lines, ssa->line_count);
+	ssa->next_tmp = ssa->vars.tmp_count;
+
+	// the lines aren't renamed yet, so liveness over the TAC's is theirs
+	Dataflow *live = dataflow_liveness(ssa->cfg, &ssa->vars);
+	place_phis(ssa, live);
+	dataflow_free(live);
+	rename_vars(ssa);
+	return ssa;
+}
+
+void ssa_free(SSA *ssa) {
+	if (!ssa) return;
+	cfg_free(ssa->cfg);
+	free(ssa->lines);
+	free(ssa->phis);
+	free(ssa->phi_start);
+	free(ssa->phi_args);
+	free(ssa);
+}
+
+// copies along one edge, as if all done at once
+struct copies {
+	Adr *dests, *srcs;
+	u32 count, cap;
+};
+
+// the phi args block's pred gives it, bar any already in place
+static void edge_copies(const SSA *ssa, u32 pred, u32 block, struct copies *c) {
+	c->count = 0;
+	u32 j = pred_index(ssa->cfg, block, pred);
+	for (u32 p = ssa->phi_start[block]; p < ssa->phi_start[block + 1]; p++) {
+		Adr src = ssa->phi_args[ssa->phis[p].arg_start + j];
+		if (adr_equals(src, ssa->phis[p].dest))
+			continue;
+		if (c->count == c->cap) {
+			c->cap = c->cap ? c->cap * 2 : 16;
+			c->dests = realloc(c->dests, c->cap * sizeof(Adr));
+			c->srcs = realloc(c->srcs, c->cap * sizeof(Adr));
+			if (!c->dests || !c->srcs) abort();
+		}
+		c->dests[c->count] = ssa->phis[p].dest;
+		c->srcs[c->count++] = src;
+	}
+}
+
+static void push_line(Vector *lines, enum operation op, Adr left, Adr right) {
+	Line l = { op, left, { A_EMPTY, 0 }, right, 0 };
+	vector_push(lines, &l);
+}
+
+// the copies one at a time, each only once nothing left reads its dest, saving a dest to a new
+// temporary to break a cycle of them
+static void sequentialise(SSA *ssa, struct copies *c, Vector *lines) {
+	u32 n = c->count;
+	if (!n) return;
+	u32 *reads = calloc(n, sizeof(u32)); // how many copies still to be done read each one's dest
+	u32 *from = malloc(n * sizeof(u32)); // the copy whose dest each one reads, CFG_NONE for none
+	u32 *ready = malloc(n * sizeof(u32));
+	char *done = calloc(n, 1);
+	for (u32 k = 0; k < n; k++) {
+		from[k] = CFG_NONE;
+		for (u32 i = 0; i < n; i++) {
+			if (adr_equals(c->srcs[k], c->dests[i])) {
+				from[k] = i;
+				reads[i]++;
+			}
+		}
+	}
+	u32 ready_count = 0, left = n;
+	for (u32 i = 0; i < n; i++) {
+		if (!reads[i])
+			ready[ready_count++] = i;
+	}
+	while (left) {
+		while (ready_count) {
+			u32 i = ready[--ready_count];
+			push_line(lines, O_ASIGN, c->dests[i], c->srcs[i]);
+			done[i] = 1;
+			left--;
+			if (from[i] != CFG_NONE && !--reads[from[i]])
+				ready[ready_count++] = from[i];
+		}
+		if (!left)
+			break;
+		// the rest are cycles, so any of them goes
+		u32 i = 0;
+		while (done[i])
+			i++;
+		Adr saved = { A_TMP, ssa->next_tmp++ };
+		push_line(lines, O_ASIGN, saved, c->dests[i]);
+		for (u32 k = 0; k < n; k++) {
+			if (!done[k] && from[k] == i) {
+				c->srcs[k] = saved;
+				from[k] = CFG_NONE;
+			}
+		}
+		reads[i] = 0;
+		ready[ready_count++] = i;
+	}
+	free(reads);
+	free(from);
+	free(ready);
+	free(done);
+}
+
+void ssa_lower(SSA *ssa, Vector *lines, u32 *next_label) {
+	const CFG *cfg = ssa->cfg;
+	u32 *label = malloc((cfg->block_count ? cfg->block_count : 1) * sizeof(u32)); // CFG_NONE for none yet
+	for (u32 b = 0; b < cfg->block_count; b++) {
+		Line *first = block_line(ssa, cfg->blocks[b].first);
+		label[b] = first->op == O_LABEL ? first->left.adr : CFG_NONE;
+	}
+	struct copies fall = { NULL, NULL, 0, 0 }, jump = { NULL, NULL, 0, 0 };
+	for (u32 b = 0; b < cfg->block_count; b++) {
+		const Block *block = &cfg->blocks[b];
+		Line *first = block_line(ssa, block->first);
+		Line *last = block_line(ssa, block->end - 1);
+		if (label[b] != CFG_NONE && first->op != O_LABEL)
+			push_line(lines, O_LABEL, (Adr){ A_LABEL, label[b] }, (Adr){ A_EMPTY, 0 });
+		for (Line *l = first; l < last; l++)
+			vector_push(lines, l);
+		fall.count = jump.count = 0;
+		Line branch = *last;
+		switch (last->op) {
+			case O_GOTO:
+				edge_copies(ssa, b, block->succ[0], &jump);
+				sequentialise(ssa, &jump, lines);
+				vector_push(lines, last);
+				break;
+			case O_GOTOT: case O_GOTOF:
+				if (block->exits) {
+					// falling through leaves the function, so nothing past the branch needs what the copies write
+					edge_copies(ssa, b, block->succ[0], &jump);
+					if (jump.count) {
+						for (u32 i = 0; i < jump.count; i++) {
+							if (adr_equals(jump.dests[i], branch.right)) {
+								Adr saved = { A_TMP, ssa->next_tmp++ };
+								push_line(lines, O_ASIGN, saved, branch.right);
+								branch.right = saved;
+								break;
+							}
+						}
+						sequentialise(ssa, &jump, lines);
+					}
+					vector_push(lines, &branch);
+				} else if (block->succ_count == 1) {
+					// both ways go to the same place
+					edge_copies(ssa, b, block->succ[0], &jump);
+					if (!jump.count) {
+						vector_push(lines, last);
+						break;
+					}
+					sequentialise(ssa, &jump, lines);
+					if (block->succ[0] != b + 1)
+						push_line(lines, O_GOTO, (Adr){ A_LABEL, label[block->succ[0]] }, (Adr){ A_EMPTY, 0 });
+				} else {
+					edge_copies(ssa, b, block->succ[0], &fall);
+					edge_copies(ssa, b, block->succ[1], &jump);
+					if (!jump.count) {
+						vector_push(lines, last);
+						sequentialise(ssa, &fall, lines);
+						break;
+					}
+					if (label[b + 1] == CFG_NONE)
+						label[b + 1] = (*next_label)++;
+					if (!fall.count) {
+						// branch the other way round to the fall through, so the jump's copies can follow
+						branch.op = branch.op == O_GOTOF ? O_GOTOT : O_GOTOF;
+						branch.left.adr = label[b + 1];
+						vector_push(lines, &branch);
+						sequentialise(ssa, &jump, lines);
+						push_line(lines, O_GOTO, (Adr){ A_LABEL, label[block->succ[1]] }, (Adr){ A_EMPTY, 0 });
+						break;
+					}
+					// the jump's copies go in a block of their own, after the fall through's
+					u32 split = (*next_label)++;
+					branch.left.adr = split;
+					vector_push(lines, &branch);
+					sequentialise(ssa, &fall, lines);
+					push_line(lines, O_GOTO, (Adr){ A_LABEL, label[b + 1] }, (Adr){ A_EMPTY, 0 });
+					push_line(lines, O_LABEL, (Adr){ A_LABEL, split }, (Adr){ A_EMPTY, 0 });
+					sequentialise(ssa, &jump, lines);
+					push_line(lines, O_GOTO, (Adr){ A_LABEL, label[block->succ[1]] }, (Adr){ A_EMPTY, 0 });
+				}
+				break;
+			default:
+				vector_push(lines, last);
+				if (block->succ_count) {
+					edge_copies(ssa, b, block->succ[0], &fall);
+					sequentialise(ssa, &fall, lines);
+				}
+		}
+	}
+	free(fall.dests);
+	free(fall.srcs);
+	free(jump.dests);
+	free(jump.srcs);
+	free(label);
+}
+
+void ssa_roundtrip(TAC *tac) {
+	u32 next_label = 0;
+	for (u32 i = 0; i < vector_len(tac->lines); i++) {
+		Line *l = vector_at(tac->lines, i);
+		if (l->left.type == A_LABEL && l->left.adr >= next_label)
+			next_label = l->left.adr + 1;
+	}
+	Vector *lines = vector_create(sizeof(Line));
+	u32 func = 0;
+	for (; func < vector_len(tac->lines) && ((Line *)vector_at(tac->lines, func))->op != O_FUNC; func++)
+		vector_push(lines, vector_at(tac->lines, func));
+	for (; func < vector_len(tac->lines); func = cfg_next_func(tac, func)) {
+		SSA *ssa = ssa_build(tac, func);
+		ssa_lower(ssa, lines, &next_label);
+		ssa_free(ssa);
+	}
+	vector_free(tac->lines);
+	tac->lines = lines;
+}
+
+static void print_ssa(const SSA *ssa) {
+	const CFG *cfg = ssa->cfg;
+	printf("function: %u blocks, %u phis\n", cfg->block_count, ssa->phi_start[cfg->block_count]);
+	for (u32 b = 0; b < cfg->block_count; b++) {
+		const Block *block = &cfg->blocks[b];
+		printf("B%u: pred", b);
+		if (!block->pred_count)
+			printf(" -");
+		for (u32 i = 0; i < block->pred_count; i++)
+			printf(" B%u", cfg_pred(cfg, b, i));
+		if (block->idom == CFG_NONE)
+			printf(", unreachable");
+		printf("\n");
+		for (u32 p = ssa->phi_start[b]; p < ssa->phi_start[b + 1]; p++) {
+			const Phi *phi = &ssa->phis[p];
+			Adr var = var_adr(&ssa->vars, phi->var);
+			printf("\t%s%u = phi(", adr_prefix[phi->dest.type], phi->dest.adr);
+			for (u32 i = 0; i < block->pred_count; i++) {
+				Adr arg = ssa->phi_args[phi->arg_start + i];
+				printf("%s%s%u B%u", i ? ", " : "", adr_prefix[arg.type], arg.adr, cfg_pred(cfg, b, i));
+			}
+			printf(") ; %s%u\n", adr_prefix[var.type], var.adr);
+		}
+		for (u32 i = block->first; i < block->end; i++) {
+			Line *l = block_line(ssa, i);
+			printf("\t");
+			if (l->linenum != 0)
+				printf("%u: ", l->linenum);
+			print_tac_line(l);
+		}
+	}
+}
+
+void ssa_printf(const TAC *tac) {
+	u32 func = 0;
+	while (func < vector_len(tac->lines) && ((Line *)vector_at(tac->lines, func))->op != O_FUNC)
+		func++;
+	for (; func < vector_len(tac->lines); func = cfg_next_func(tac, func)) {
+		SSA *ssa = ssa_build(tac, func);
+		print_ssa(ssa);
+		ssa_free(ssa);
+	}
+}
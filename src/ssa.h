@@ -0,0 +1,46 @@
+// static single assignment form for a function's TAC: each temporary, variable or parameter written gets a
+// new temporary per write, with phis joining them where control flow meets, and the way back out again
+
+#ifndef SSA_H
+#define SSA_H
+
+#include "cfg.h"
+#include "dataflow.h"
+#include "threeaddresscode.h"
+#include "lib/vector.h"
+#include "lib/defs.h"
+
+// at the start of its block, dest is the arg of whichever pred control came from
+typedef struct phi {
+	Adr dest;
+	u32 var; // the function's variable it joins, numbered as in vars
+	u32 arg_start; // into the SSA's phi_args, one for each of the block's preds, in the CFG's order
+} Phi;
+
+typedef struct ssa {
+	CFG *cfg;
+	Line *lines; // the function's lines renamed, lines[i] being the TAC's line cfg->func + i
+	u32 line_count;
+	VarNumbering vars; // of the function before renaming
+	u32 next_tmp; // the new names are temporaries from vars.tmp_count up to here
+	Phi *phis; // grouped by block
+	u32 *phi_start; // block b's phis are phis[phi_start[b]] up to phis[phi_start[b + 1]]
+	Adr *phi_args;
+} SSA;
+
+// func is an O_FUNC line, as for cfg_build
+// uses with no write before them on some path keep the original address, as do unreachable blocks
+SSA *ssa_build(const TAC *tac, u32 func);
+void ssa_free(SSA *ssa);
+
+// appends the function's lines to lines with each phi made copies on its incoming edges, splitting a
+// jump's edge where it needs its own, new labels being numbered from *next_label
+void ssa_lower(SSA *ssa, Vector *lines, u32 *next_label);
+
+// takes every function of tac into SSA form and back out, in place
+void ssa_roundtrip(TAC *tac);
+
+// every function's blocks in SSA form, with their phis
+void ssa_printf(const TAC *tac);
+
+#endif
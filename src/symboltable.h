@@ -1,27 +1,69 @@
-
 #ifndef SYMBOLTABLE_H
 #define SYMBOLTABLE_H
 
 #include "lib/sds.h"
 #include "lib/hashmap.h"
+#include "lib/stringpool.h"
 #include "lib/defs.h"
 
+/* symbols are kept in chunks of SYMBOL_CHUNK, which never move once made (so a Symbol* stays good) */
+#define SYMBOL_CHUNK_BITS 10
+#define SYMBOL_CHUNK (1u << SYMBOL_CHUNK_BITS)
+
 typedef struct symboltable {
-	sds stringspace;
-	HashMap *seen_idens; /* string -> index */
-	HashMap *table; /* sds -> symbol */
-	HashMap *live_pointers; /* symbol* -> null */
+	StringPool *pool; /* interned names, shared with the lexer */
+	struct symbol **chunks; /* handle -> symbol, one per name and scope (handle 0 is none) */
+	u32 symbol_count, chunk_cap;
+	u32 *slots; /* open addressing over handles (0 is an empty slot) */
+	u32 slot_mask; /* slot count - 1 (a power of 2) */
+	u32 *bindings; /* name id -> handle of its innermost declaration, chained outwards through shadowed */
+	u32 binding_cap;
+	u32 *bound; /* handles declared in the open scopes, the innermost scope's last */
+	u32 bound_count, bound_cap;
+	u32 *scope_starts; /* where each open scope's run of bound begins */
+	u32 scope_depth, scope_cap;
 } SymbolTable;
 
-struct sindex {
-	size_t start;
-	size_t len;
-};
+struct attribute; /* astree.h */
 
 typedef struct symbol {
-	struct sindex index;
-	u16 scope;
+	u32 id; /* interned name */
+	u32 scope; /* global=0, func∈[1,N), main=N */
+	u32 shadowed; /* handle of the declaration of the same name this one hides, 0 for none */
+	struct attribute *attribute; /* what it was declared as, NULL if it hasn't been */
 } Symbol;
 
-#endif
+static inline Symbol *symboltable_symbol(const SymbolTable *st, u32 handle) {
+	return handle ? st->chunks[handle >> SYMBOL_CHUNK_BITS] + (handle & (SYMBOL_CHUNK - 1)) : NULL;
+}
+
+/* the handle of the symbol for name id in scope, added if there isn't one yet */
+u32 symboltable_intern(SymbolTable *st, u32 id, u32 scope);
+/* the handle of the symbol for name id in scope, 0 if there isn't one (does not allocate) */
+u32 symboltable_find(const SymbolTable *st, u32 id, u32 scope);
 
+/* declarations made between these are taken out of the binding chains again on exit
+   (their symbols keep their attributes, so later passes can still look them up) */
+void symboltable_enter_scope(SymbolTable *st);
+void symboltable_exit_scope(SymbolTable *st);
+/* exits every open scope, for when the parser gives up partway through one */
+void symboltable_exit_scopes(SymbolTable *st);
+/* the global declaration of name id, NULL if there isn't one */
+Symbol *symboltable_global(const SymbolTable *st, u32 id);
+
+// hashmap callbacks for Symbol* keys
+static inline u32 symbol_hash(const void *ptr) {
+	const Symbol *sym = (const Symbol *)ptr;
+	return (sym->id * 2654435761u) ^ sym->scope;
+}
+static inline int symbol_equals(const void *a, const void *b) {
+	const Symbol *s1 = (const Symbol *)a;
+	const Symbol *s2 = (const Symbol *)b;
+	return s1->id == s2->id && s1->scope == s2->scope;
+}
+// equality for symbols, ignoring scope
+static inline int unscoped_symbol_equals(const Symbol *s1, const Symbol *s2) {
+	return s1->id == s2->id;
+}
+
+#endif
@@ -0,0 +1,214 @@
+/*
+  Builds the CFG of every function in each program and checks it against the definitions, worked out the
+  slow way: the dominators as the fixed point of dom(n) = {n} + the intersection of dom(p) over n's
+  predecessors, the post-dominators the same over the reversed graph from the exit, and each loop's body as
+  its header and every block reaching one of its back edges without passing through it. Every pair of
+  blocks is asked cfg_dominates, cfg_post_dominates and whether one is in the other's loop.
+  usage: cfgcheck file.cd...
+  exits 1 if a program doesn't analyse or its CFG disagrees with the definitions
+*/
+#include "../parser.h"
+#include "../semantic_analysis.h"
+#include "../cfg.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// node n's edges, out (side 0) or in (side 1), with the exit a node after the blocks
+static u32 edges_of(const CFG *cfg, u32 n, int side, u32 *list) {
+	u32 count = 0;
+	if (side == 0) {
+		if (n == cfg->exit)
+			return 0;
+		for (u32 s = 0; s < cfg->blocks[n].succ_count; s++)
+			list[count++] = cfg->blocks[n].succ[s];
+		if (cfg->blocks[n].exits)
+			list[count++] = cfg->exit;
+		return count;
+	}
+	for (u32 b = 0; b < cfg->block_count; b++) {
+		u32 out[3], out_count = edges_of(cfg, b, 0, out);
+		for (u32 e = 0; e < out_count; e++) {
+			if (out[e] == n)
+				list[count++] = b;
+		}
+	}
+	return count;
+}
+
+// dom[n * nodes + d] is set when d dominates n, reached[n] when root reaches n, following side's edges
+static void dominator_sets(const CFG *cfg, u32 root, int side, char *dom, char *reached) {
+	u32 nodes = cfg->block_count + 1;
+	u32 *stack = malloc(nodes * sizeof(u32)), *list = malloc(nodes * sizeof(u32)), depth = 0;
+	memset(reached, 0, nodes);
+	reached[root] = 1;
+	stack[depth++] = root;
+	while (depth) {
+		u32 n = stack[--depth], count = edges_of(cfg, n, side, list);
+		for (u32 e = 0; e < count; e++) {
+			if (!reached[list[e]]) {
+				reached[list[e]] = 1;
+				stack[depth++] = list[e];
+			}
+		}
+	}
+	for (u32 n = 0; n < nodes; n++)
+		memset(dom + n * nodes, n != root, nodes);
+	dom[root * nodes + root] = 1;
+	for (int changed = 1; changed;) {
+		changed = 0;
+		for (u32 n = 0; n < nodes; n++) {
+			if (n == root || !reached[n])
+				continue;
+			u32 count = edges_of(cfg, n, !side, list);
+			for (u32 d = 0; d < nodes; d++) {
+				char in = 1;
+				for (u32 e = 0; e < count && in; e++)
+					in = !reached[list[e]] || dom[list[e] * nodes + d];
+				in |= d == n;
+				if (dom[n * nodes + d] != in) {
+					dom[n * nodes + d] = in;
+					changed = 1;
+				}
+			}
+		}
+	}
+	free(stack);
+	free(list);
+}
+
+// the strict dominator of n that every other one dominates, CFG_NONE if unreached
+static u32 immediate(const char *dom, const char *reached, u32 nodes, u32 root, u32 n) {
+	if (!reached[n])
+		return CFG_NONE;
+	if (n == root)
+		return root;
+	for (u32 d = 0; d < nodes; d++) {
+		if (d == n || !dom[n * nodes + d])
+			continue;
+		u32 others = 1;
+		for (u32 e = 0; e < nodes && others; e++)
+			others = e == n || !dom[n * nodes + e] || dom[d * nodes + e];
+		if (others)
+			return d;
+	}
+	return CFG_NONE;
+}
+
+static int check_function(const CFG *cfg) {
+	u32 nodes = cfg->block_count + 1, blocks = cfg->block_count;
+	char *dom = malloc((size_t)nodes * nodes), *pdom = malloc((size_t)nodes * nodes);
+	char *reached = malloc(nodes), *returns = malloc(nodes);
+	dominator_sets(cfg, 0, 0, dom, reached);
+	dominator_sets(cfg, cfg->exit, 1, pdom, returns);
+	int wrong = 0;
+	for (u32 b = 0; b < blocks && !wrong; b++) {
+		if (cfg->blocks[b].idom != immediate(dom, reached, nodes, 0, b)) {
+			printf("B%u: idom B%u, should be B%u\n", b, cfg->blocks[b].idom, immediate(dom, reached, nodes, 0, b));
+			wrong = 1;
+		}
+		if (cfg->blocks[b].ipdom != immediate(pdom, returns, nodes, cfg->exit, b)) {
+			printf("B%u: ipdom B%u, should be B%u\n", b, cfg->blocks[b].ipdom,
+				immediate(pdom, returns, nodes, cfg->exit, b));
+			wrong = 1;
+		}
+		for (u32 a = 0; a < nodes && !wrong; a++) {
+			if (a < blocks && reached[a] && reached[b] && cfg_dominates(cfg, a, b) != dom[b * nodes + a]) {
+				printf("cfg_dominates(B%u, B%u) is wrong\n", a, b);
+				wrong = 1;
+			}
+			if (returns[a] && returns[b] && cfg_post_dominates(cfg, a, b) != pdom[b * nodes + a]) {
+				printf("cfg_post_dominates(B%u, B%u) is wrong\n", a, b);
+				wrong = 1;
+			}
+		}
+	}
+
+	// body[h * nodes + b] is set when b is in the loop headed by h
+	char *body = calloc((size_t)nodes * nodes, 1);
+	u32 *stack = malloc(4 * nodes * sizeof(u32)), *list = malloc(nodes * sizeof(u32)); // an entry an edge
+	for (u32 h = 0; h < blocks; h++) {
+		u32 count = edges_of(cfg, h, 1, list), depth = 0;
+		for (u32 e = 0; e < count; e++) {
+			if (reached[list[e]] && dom[list[e] * nodes + h]) // a back edge
+				stack[depth++] = list[e];
+		}
+		if (depth)
+			body[h * nodes + h] = 1;
+		while (depth) {
+			u32 n = stack[--depth];
+			if (!reached[n] || body[h * nodes + n])
+				continue;
+			body[h * nodes + n] = 1;
+			depth += edges_of(cfg, n, 1, stack + depth);
+		}
+	}
+	u32 headers = 0;
+	for (u32 h = 0; h < blocks; h++)
+		headers += body[h * nodes + h];
+	if (!wrong && headers != cfg->loop_count) {
+		printf("%u loops, should be %u\n", cfg->loop_count, headers);
+		wrong = 1;
+	}
+	for (u32 b = 0; b < blocks && !wrong; b++) {
+		char *in = calloc(nodes, 1); // the headers of the loops the CFG has b in
+		for (u32 loop = cfg->blocks[b].loop; loop != CFG_NONE; loop = cfg->loops[loop].parent)
+			in[cfg->loops[loop].header] = 1;
+		for (u32 h = 0; h < blocks && !wrong; h++) {
+			if (in[h] != body[h * nodes + b]) {
+				printf("B%u %s the loop headed by B%u, and shouldn't be\n", b, in[h] ? "is in" : "isn't in", h);
+				wrong = 1;
+			}
+		}
+		free(in);
+	}
+	free(dom);
+	free(pdom);
+	free(reached);
+	free(returns);
+	free(body);
+	free(stack);
+	free(list);
+	return wrong;
+}
+
+int main(int argc, char **argv) {
+	if (argc < 2) {
+		fprintf(stderr, "usage: %s file.cd...\n", argv[0]);
+		return 1;
+	}
+	int failed = 0;
+	for (int f = 1; f < argc; f++) {
+		Lister *lst = lister_create(NULL);
+		ASTree *ast = get_AST(argv[f], lst, 0, 1, NULL);
+		analyse_program(ast, lst);
+		if (!ast->is_valid) {
+			printf("%s: doesn't analyse\n", argv[f]);
+			failed = 1;
+			continue;
+		}
+		TAC *tac = tac_from_ast(ast);
+		u32 func = 0, functions = 0, blocks = 0, loops = 0;
+		while (func < vector_len(tac->lines) && ((Line *)vector_at(tac->lines, func))->op != O_FUNC)
+			func++;
+		int wrong = 0;
+		for (; func < vector_len(tac->lines) && !wrong; func = cfg_next_func(tac, func)) {
+			CFG *cfg = cfg_build(tac, func);
+			cfg_find_loops(cfg);
+			wrong = check_function(cfg);
+			if (wrong)
+				printf("%s: in the function at TAC line %u\n", argv[f], func);
+			functions++;
+			blocks += cfg->block_count;
+			loops += cfg->loop_count;
+			cfg_free(cfg);
+		}
+		if (!wrong)
+			printf("%s: %u functions, %u blocks, %u loops, as defined\n", argv[f], functions, blocks, loops);
+		failed |= wrong;
+		tac_free(tac);
+		astree_free(ast);
+		lister_close(lst);
+	}
+	return failed;
+}
@@ -0,0 +1,297 @@
+/*
+  Makes random edits to a program through the incremental parser (document_edit), checking after each that
+  the document's text and tree are the same as a fresh parse of that text gives, and prints how long the
+  edits took (those that patched the tree, and those that parsed it again) against the fresh parses.
+  Each edit is undone straight after half the time, and always when it breaks the program, so there's
+  nearly always a tree to patch.
+  usage: edits file [edits [seed]]
+  exits 1 at the first edit whose tree or text differs
+*/
+#define _POSIX_C_SOURCE 200809L // clock_gettime, mkstemp
+#include "../parser.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+// whole statements and lines, to keep the program parsing
+static const char *snippets[] = {
+	"\ta = a + 1;\n",
+	"\tOut << a << Line;\n",
+	"\t/-- a comment\n",
+	"\t/** a\n\tcomment **/\n",
+	"\n",
+	"\tif (a < 2)\n\t\ta = 2;\n\tend\n",
+	"\tif (a < 2)\n\t\ta = 2;\n\telse\n\t\ta = 3;\n\tend\n",
+	"\trepeat (b = 0)\n\t\tb += 1;\n\tuntil b > 0;\n",
+	"\tfor (c = 0; c < 2)\n\t\tc += 1;\n\tend\n",
+};
+// and single characters, which mostly don't
+static const char scatter[] = " \t\n;a1+-*()=<>.\"/";
+
+static unsigned long state;
+
+static unsigned long next_random(void) {
+	state ^= state << 13;
+	state ^= state >> 7;
+	state ^= state << 17;
+	return state;
+}
+
+static double now_ms(void) {
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec * 1e3 + t.tv_nsec / 1e6;
+}
+
+// the text, kept alongside the document's
+typedef struct text {
+	char *s;
+	size_t len, cap;
+} Text;
+
+static void text_splice(Text *t, size_t start, size_t old_len, const char *with, size_t len) {
+	if (t->len - old_len + len + 1 > t->cap) {
+		t->cap = (t->len - old_len + len + 1) * 2;
+		t->s = realloc(t->s, t->cap);
+	}
+	memmove(t->s + start + len, t->s + start + old_len, t->len - start - old_len);
+	if (len)
+		memcpy(t->s + start, with, len);
+	t->len = t->len - old_len + len;
+}
+
+// the start of the line pos is on
+static size_t line_start(const Text *t, size_t pos) {
+	while (pos > 0 && t->s[pos - 1] != '\n')
+		pos--;
+	return pos;
+}
+
+// one edit as a range of the text and what it becomes
+typedef struct edit {
+	size_t start, old_len;
+	char *with;
+	size_t len;
+} Edit;
+
+static Edit random_edit(const Text *t) {
+	Edit e = { 0, 0, NULL, 0 };
+	size_t pos = t->len ? next_random() % t->len : 0;
+	char buf[32];
+	switch (next_random() % 5) {
+		case 0: { // a different number in place of the next one
+			size_t p = pos;
+			while (p < t->len && (t->s[p] < '0' || t->s[p] > '9'))
+				p++;
+			if (p < t->len) {
+				e.start = p;
+				while (p < t->len && t->s[p] >= '0' && t->s[p] <= '9')
+					p++;
+				e.old_len = p - e.start;
+				snprintf(buf, sizeof(buf), "%lu", next_random() % 1000);
+				e.with = strdup(buf);
+				e.len = strlen(buf);
+				return e;
+			}
+			pos = 0;
+		}
+		/* fallthrough */
+		case 1: { // a statement put in before a line
+			const char *s = snippets[next_random() % (sizeof(snippets) / sizeof(*snippets))];
+			e.start = line_start(t, pos);
+			e.with = strdup(s);
+			e.len = strlen(s);
+			return e;
+		}
+		case 2: { // a line taken out
+			e.start = line_start(t, pos);
+			size_t end = e.start;
+			while (end < t->len && t->s[end] != '\n')
+				end++;
+			e.old_len = end - e.start + (end < t->len);
+			break;
+		}
+		case 3: { // a line repeated
+			e.start = line_start(t, pos);
+			size_t end = e.start;
+			while (end < t->len && t->s[end] != '\n')
+				end++;
+			e.len = end - e.start + (end < t->len);
+			e.with = malloc(e.len + 1);
+			memcpy(e.with, t->s + e.start, e.len);
+			return e;
+		}
+		default: // a few characters out and a few in
+			e.start = pos;
+			e.old_len = next_random() % 4;
+			if (e.old_len > t->len - pos)
+				e.old_len = t->len - pos;
+			e.len = next_random() % 4;
+			for (size_t i = 0; i < e.len; i++)
+				buf[i] = scatter[next_random() % (sizeof(scatter) - 1)];
+			e.with = malloc(e.len + 1);
+			memcpy(e.with, buf, e.len);
+	}
+	return e;
+}
+
+// a name the same in both trees, as symbol handles and name ids are numbered in the order they're made
+static int same_symbol(const ASTree *a, const ASTNode *x, const ASTree *b, const ASTNode *y) {
+	const Symbol *s = node_symbol(a, x), *t = node_symbol(b, y);
+	if (!s || !t)
+		return !s && !t;
+	StrView u = stringpool_view(a->symboltable->pool, s->id), v = stringpool_view(b->symboltable->pool, t->id);
+	return s->scope == t->scope && u.len == v.len && memcmp(u.str, v.str, u.len) == 0;
+}
+
+static int same_tree(const ASTree *a, const ASTree *b) {
+	if (a->is_valid != b->is_valid || !a->root != !b->root)
+		return 0;
+	if (!a->root)
+		return 1;
+	NodeStack left = { 0 }, right = { 0 };
+	node_stack_push(&left, node_id(a->root));
+	node_stack_push(&right, node_id(b->root));
+	int same = 1;
+	while (same && left.count) {
+		const ASTNode *x = astree_node(a, node_stack_pop(&left)), *y = astree_node(b, node_stack_pop(&right));
+		same = x->type == y->type && x->row == y->row && x->col == y->col && x->symbol_type == y->symbol_type
+			&& !x->left == !y->left && !x->middle == !y->middle && !x->right == !y->right
+			&& same_symbol(a, x, b, y);
+		if (x->type == NILIT)
+			same = same && x->lit.i == y->lit.i;
+		else if (x->type == NFLIT)
+			same = same && memcmp(&x->lit.f, &y->lit.f, sizeof(double)) == 0;
+		node_stack_push_children(&left, x);
+		node_stack_push_children(&right, y);
+	}
+	node_stack_free(&left);
+	node_stack_free(&right);
+	return same;
+}
+
+// what the compiler makes of the text from scratch
+static ASTree *fresh_parse(const Text *t, const char *path, double *took) {
+	FILE *f = fopen(path, "wb");
+	if (!f || fwrite(t->s, 1, t->len, f) != t->len || fclose(f)) {
+		fprintf(stderr, "could not write %s\n", path);
+		exit(1);
+	}
+	Lister *lst = lister_create(NULL);
+	double start = now_ms();
+	ASTree *ast = get_AST(path, lst, 0, 1, NULL);
+	*took = now_ms() - start;
+	lister_close(lst);
+	return ast;
+}
+
+static int compare_ms(const void *a, const void *b) {
+	double x = *(const double *)a, y = *(const double *)b;
+	return (x > y) - (x < y);
+}
+
+static void report(const char *what, double *ms, long n) {
+	if (!n) {
+		printf("%s: none\n", what);
+		return;
+	}
+	qsort(ms, n, sizeof(double), compare_ms);
+	printf("%s: %ld, median %.3f ms, 99th %.3f ms, max %.3f ms\n", what, n, ms[n / 2], ms[n * 99 / 100], ms[n - 1]);
+}
+
+int main(int argc, char **argv) {
+	long edits = argc > 2 ? atol(argv[2]) : 1000;
+	state = argc > 3 ? strtoul(argv[3], NULL, 10) : 1;
+	if (argc < 2 || argc > 4 || edits < 1 || !state) {
+		fprintf(stderr, "usage: %s file [edits [seed]]\n", argv[0]);
+		return 1;
+	}
+	FILE *f = fopen(argv[1], "rb");
+	if (!f) {
+		fprintf(stderr, "could not read %s\n", argv[1]);
+		return 1;
+	}
+	Text text = { malloc(4096), 0, 4096 };
+	size_t got;
+	while ((got = fread(text.s + text.len, 1, text.cap - text.len, f)) > 0) {
+		text.len += got;
+		if (text.len == text.cap)
+			text.s = realloc(text.s, text.cap *= 2);
+	}
+	fclose(f);
+	char path[] = "/tmp/edits_XXXXXX";
+	int fd = mkstemp(path);
+	if (fd < 0) {
+		fprintf(stderr, "could not make a temporary file\n");
+		return 1;
+	}
+	close(fd);
+
+	Lister *lst = lister_create(NULL);
+	Document *doc = document_open(argv[1], lst);
+	double *patched = malloc(2 * edits * sizeof(double)), *rebuilt = malloc(2 * edits * sizeof(double));
+	double *fresh = malloc(2 * edits * sizeof(double));
+	long patched_count = 0, rebuilt_count = 0, fresh_count = 0, failed = 0;
+	for (long n = 0; n < edits && !failed; n++) {
+		Edit e = random_edit(&text);
+		char *was = malloc(e.old_len + 1);
+		memcpy(was, text.s + e.start, e.old_len);
+		int undo = next_random() % 2;
+		for (int pass = 0; pass < 2 && !failed; pass++) {
+			double start = now_ms();
+			int result = document_edit(doc, e.start, e.old_len, e.with, e.len, lst);
+			double took = now_ms() - start;
+			if (result < 0) {
+				printf("edit %ld: document_edit refused %zu+%zu of %zu bytes\n", n, e.start, e.old_len, text.len);
+				failed = 1;
+				break;
+			}
+			if (result)
+				patched[patched_count++] = took;
+			else
+				rebuilt[rebuilt_count++] = took;
+			text_splice(&text, e.start, e.old_len, e.with, e.len);
+			for (char *msg; (msg = lister_pop_warning(lst)) || (msg = lister_pop_error(lst));)
+				free(msg);
+
+			size_t len;
+			const char *doc_text = document_text(doc, &len);
+			ASTree *ast = fresh_parse(&text, path, &fresh[fresh_count++]);
+			if (len != text.len || memcmp(doc_text, text.s, len) != 0) {
+				printf("edit %ld%s: the document's text differs\n", n, pass ? " (undone)" : "");
+				failed = 1;
+			} else if (!same_tree(document_ast(doc), ast)) {
+				printf("edit %ld%s (%s %zu+%zu -> %zu bytes): the tree differs from a fresh parse\n", n,
+					pass ? " (undone)" : "", result ? "patched" : "parsed again", e.start, e.old_len, e.len);
+				failed = 1;
+			}
+			int valid = ast->is_valid;
+			astree_free(ast);
+			if (!undo && valid)
+				break;
+			// the undo puts back what was there
+			size_t new_len = e.len;
+			free(e.with);
+			e.with = was;
+			e.len = e.old_len;
+			e.old_len = new_len;
+			was = NULL;
+		}
+		free(e.with);
+		free(was);
+	}
+	printf("%s: %zu bytes\n", argv[1], text.len);
+	report("patched", patched, patched_count);
+	report("parsed again", rebuilt, rebuilt_count);
+	report("fresh parse", fresh, fresh_count);
+	document_close(doc);
+	lister_close(lst);
+	unlink(path);
+	free(patched);
+	free(rebuilt);
+	free(fresh);
+	free(text.s);
+	return failed;
+}
@@ -0,0 +1,25 @@
+#!/bin/sh
+# random edits through the incremental parser, each checked against a fresh parse: edits (1000 by default)
+# to every program in cd25_programs, then a fifth as many to a generated program of 50k lines
+set -e
+
+if [ $# -gt 1 ]; then
+    echo "Usage: $0 [edits]"
+    exit 1
+fi
+
+tests=$(cd "$(dirname "$0")" && pwd)
+edits=${1:-1000}
+out=$(mktemp -d)
+trap 'rm -rf "$out"' EXIT
+
+for program in "$tests"/../../cd25_programs/*.cd; do
+    if ! "$tests/edits" "$program" $edits > "$out/log"; then
+        cat "$out/log"
+        exit 1
+    fi
+    # the file name and how the edits went
+    echo "$(basename "$program"): $(grep -E '^(patched|parsed again):' "$out/log" | tr '\n' ' ')"
+done
+"$tests/gen_cd25" lines 50000 > "$out/lines.cd"
+"$tests/edits" "$out/lines.cd" $((edits / 5))
@@ -0,0 +1,37 @@
+33
+  41   3  52  91   0   0   0   0
+   3  43  91   0   0   0   8   3
+  43  91   0   0   0  16   3  43
+  91   0   0   0   0  41   1  43
+  90   0   0   0 255  81   0   0
+   0   0  41   2  12  23  81   0
+   0   0   0  41   2  12  23  81
+   0   0   0   0  41   2  12  23
+  81   0   0   0   0  41   2  12
+  23  81   0   0   0   0  41   2
+  12  23  81   0   0   0   0  41
+   2  12  23  81   0   0   0   0
+  41   2  12  23  81   0   0   0
+   0  41   2  12  23  81   0   0
+   0   0  41   2  12  23  81   0
+   0   0   0  41   2  12  23  81
+   0   0   0   0  41   2  12  23
+  81   0   0   0   0  41   2  12
+  23  81   0   0   0   0  41   2
+  12  23  81   0   0   0   0  41
+   2  12  23  81   0   0   0   0
+  41   2  12  23  81   0   0   0
+   0  41   2  12  23  81   0   0
+   0   0  41   2  12  23  81   0
+   0   0   0  41   2  12  23  81
+   0   0   0   0  41   2  12  23
+  81   0   0   0   0  41   2  12
+  23  81   0   0   0   0  41   2
+  12  23  31  31  31  31  31  31
+  31  31  31  31  31  31  31  31
+  31  31  31  31  31  31  36  91
+   0   0   0   0  41   2  43  81
+   0   0   0   0  62  65   0   0
+0
+0
+0
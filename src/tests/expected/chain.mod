@@ -0,0 +1,18 @@
+14
+  41   3  52  91   0   0   0   0
+   3  43  91   0   0   0   8   3
+  43  91   0   0   0  16   3  43
+  91   0   0   0   0  41   1  43
+  91   0   0   0   0  81   0   0
+   0   0  41   1  11  41   1  11
+  41   1  11  41   1  11  41   1
+  11  41   1  11  41   1  11  41
+   1  11  41   1  11  41   1  11
+  41   1  11  41   1  11  41   1
+  11  41   1  11  41   1  11  41
+   1  11  41   1  11  41   1  11
+  41   1  11  41   1  11  43  81
+   0   0   0   0  62  65   0   0
+0
+0
+0
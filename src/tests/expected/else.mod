@@ -0,0 +1,99 @@
+95
+  41   3  52  91   0   0   0   0
+   3  43  91   0   0   0   8   3
+  43  91   0   0   0  16   3  43
+  91   0   0   0   0  41   1  43
+  90   0   0   0  67  81   0   0
+   0   0  41   2  12  23  36  91
+   0   0   0   0  81   0   0   0
+   0  41   1  11  43  90   0   0
+   2 234  37  90   0   0   0 102
+  81   0   0   0   0  41   2  12
+  23  36  91   0   0   0   0  81
+   0   0   0   0  41   1  11  43
+  90   0   0   2 234  37  90   0
+   0   0 137  81   0   0   0   0
+  41   2  12  23  36  91   0   0
+   0   0  81   0   0   0   0  41
+   1  11  43  90   0   0   2 234
+  37  90   0   0   0 172  81   0
+   0   0   0  41   2  12  23  36
+  91   0   0   0   0  81   0   0
+   0   0  41   1  11  43  90   0
+   0   2 234  37  90   0   0   0
+ 207  81   0   0   0   0  41   2
+  12  23  36  91   0   0   0   0
+  81   0   0   0   0  41   1  11
+  43  90   0   0   2 234  37  90
+   0   0   0 242  81   0   0   0
+   0  41   2  12  23  36  91   0
+   0   0   0  81   0   0   0   0
+  41   1  11  43  90   0   0   2
+ 234  37  90   0   0   1  21  81
+   0   0   0   0  41   2  12  23
+  36  91   0   0   0   0  81   0
+   0   0   0  41   1  11  43  90
+   0   0   2 234  37  90   0   0
+   1  56  81   0   0   0   0  41
+   2  12  23  36  91   0   0   0
+   0  81   0   0   0   0  41   1
+  11  43  90   0   0   2 234  37
+  90   0   0   1  91  81   0   0
+   0   0  41   2  12  23  36  91
+   0   0   0   0  81   0   0   0
+   0  41   1  11  43  90   0   0
+   2 234  37  90   0   0   1 126
+  81   0   0   0   0  41   2  12
+  23  36  91   0   0   0   0  81
+   0   0   0   0  41   1  11  43
+  90   0   0   2 234  37  90   0
+   0   1 161  81   0   0   0   0
+  41   2  12  23  36  91   0   0
+   0   0  81   0   0   0   0  41
+   1  11  43  90   0   0   2 234
+  37  90   0   0   1 196  81   0
+   0   0   0  41   2  12  23  36
+  91   0   0   0   0  81   0   0
+   0   0  41   1  11  43  90   0
+   0   2 234  37  90   0   0   1
+ 231  81   0   0   0   0  41   2
+  12  23  36  91   0   0   0   0
+  81   0   0   0   0  41   1  11
+  43  90   0   0   2 234  37  90
+   0   0   2  10  81   0   0   0
+   0  41   2  12  23  36  91   0
+   0   0   0  81   0   0   0   0
+  41   1  11  43  90   0   0   2
+ 234  37  90   0   0   2  45  81
+   0   0   0   0  41   2  12  23
+  36  91   0   0   0   0  81   0
+   0   0   0  41   1  11  43  90
+   0   0   2 234  37  90   0   0
+   2  80  81   0   0   0   0  41
+   2  12  23  36  91   0   0   0
+   0  81   0   0   0   0  41   1
+  11  43  90   0   0   2 234  37
+  90   0   0   2 115  81   0   0
+   0   0  41   2  12  23  36  91
+   0   0   0   0  81   0   0   0
+   0  41   1  11  43  90   0   0
+   2 234  37  90   0   0   2 150
+  81   0   0   0   0  41   2  12
+  23  36  91   0   0   0   0  81
+   0   0   0   0  41   1  11  43
+  90   0   0   2 234  37  90   0
+   0   2 185  81   0   0   0   0
+  41   2  12  23  36  91   0   0
+   0   0  81   0   0   0   0  41
+   1  11  43  90   0   0   2 234
+  37  90   0   0   2 220  81   0
+   0   0   0  41   2  12  23  36
+  91   0   0   0   0  81   0   0
+   0   0  41   1  11  43  90   0
+   0   2 234  37  91   0   0   0
+   0  81   0   0   0   0  41   1
+  11  43  81   0   0   0   0  62
+  65   0   0   0   0   0   0   0
+0
+0
+0
@@ -0,0 +1,81 @@
+77
+  41   3  52  91   0   0   0   0
+   3  43  91   0   0   0   8   3
+  43  91   0   0   0  16   3  43
+  91   0   0   0   0  41   1  43
+  91   0   0   0   8   3  43  90
+   0   0   2  91  81   0   0   0
+   8  41   1  12  23  36  91   0
+   0   0   8   3  43  90   0   0
+   2  85  81   0   0   0   8  41
+   1  12  23  36  91   0   0   0
+   8   3  43  90   0   0   2  79
+  81   0   0   0   8  41   1  12
+  23  36  91   0   0   0   8   3
+  43  90   0   0   2  73  81   0
+   0   0   8  41   1  12  23  36
+  91   0   0   0   8   3  43  90
+   0   0   2  67  81   0   0   0
+   8  41   1  12  23  36  91   0
+   0   0   8   3  43  90   0   0
+   2  61  81   0   0   0   8  41
+   1  12  23  36  91   0   0   0
+   8   3  43  90   0   0   2  55
+  81   0   0   0   8  41   1  12
+  23  36  91   0   0   0   8   3
+  43  90   0   0   2  49  81   0
+   0   0   8  41   1  12  23  36
+  91   0   0   0   8   3  43  90
+   0   0   2  43  81   0   0   0
+   8  41   1  12  23  36  91   0
+   0   0   8   3  43  90   0   0
+   2  37  81   0   0   0   8  41
+   1  12  23  36  91   0   0   0
+   8   3  43  90   0   0   2  31
+  81   0   0   0   8  41   1  12
+  23  36  91   0   0   0   8   3
+  43  90   0   0   2  25  81   0
+   0   0   8  41   1  12  23  36
+  91   0   0   0   8   3  43  90
+   0   0   2  19  81   0   0   0
+   8  41   1  12  23  36  91   0
+   0   0   8   3  43  90   0   0
+   2  13  81   0   0   0   8  41
+   1  12  23  36  91   0   0   0
+   8   3  43  90   0   0   2   7
+  81   0   0   0   8  41   1  12
+  23  36  91   0   0   0   8   3
+  43  90   0   0   2   1  81   0
+   0   0   8  41   1  12  23  36
+  91   0   0   0   8   3  43  90
+   0   0   1 251  81   0   0   0
+   8  41   1  12  23  36  91   0
+   0   0   8   3  43  90   0   0
+   1 245  81   0   0   0   8  41
+   1  12  23  36  91   0   0   0
+   8   3  43  90   0   0   1 239
+  81   0   0   0   8  41   1  12
+  23  36  91   0   0   0   8   3
+  43  90   0   0   1 233  81   0
+   0   0   8  41   1  12  23  36
+  91   0   0   0   8  56  40  41
+   1  11  43  90   0   0   1 201
+  37  90   0   0   1 179  37  90
+   0   0   1 157  37  90   0   0
+   1 135  37  90   0   0   1 113
+  37  90   0   0   1  91  37  90
+   0   0   1  69  37  90   0   0
+   1  47  37  90   0   0   1  25
+  37  90   0   0   1   3  37  90
+   0   0   0 237  37  90   0   0
+   0 215  37  90   0   0   0 193
+  37  90   0   0   0 171  37  90
+   0   0   0 149  37  90   0   0
+   0 127  37  90   0   0   0 105
+  37  90   0   0   0  83  37  90
+   0   0   0  61  37  90   0   0
+   0  39  37  81   0   0   0   0
+  62  65   0   0   0   0   0   0
+0
+0
+0
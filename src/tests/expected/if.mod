@@ -0,0 +1,49 @@
+45
+  41   3  52  91   0   0   0   0
+   3  43  91   0   0   0   8   3
+  43  91   0   0   0  16   3  43
+  91   0   0   0   0  41   1  43
+  90   0   0   1  90  81   0   0
+   0   0  41   2  12  23  36  90
+   0   0   1  90  81   0   0   0
+   0  41   2  12  23  36  90   0
+   0   1  90  81   0   0   0   0
+  41   2  12  23  36  90   0   0
+   1  90  81   0   0   0   0  41
+   2  12  23  36  90   0   0   1
+  90  81   0   0   0   0  41   2
+  12  23  36  90   0   0   1  90
+  81   0   0   0   0  41   2  12
+  23  36  90   0   0   1  90  81
+   0   0   0   0  41   2  12  23
+  36  90   0   0   1  90  81   0
+   0   0   0  41   2  12  23  36
+  90   0   0   1  90  81   0   0
+   0   0  41   2  12  23  36  90
+   0   0   1  90  81   0   0   0
+   0  41   2  12  23  36  90   0
+   0   1  90  81   0   0   0   0
+  41   2  12  23  36  90   0   0
+   1  90  81   0   0   0   0  41
+   2  12  23  36  90   0   0   1
+  90  81   0   0   0   0  41   2
+  12  23  36  90   0   0   1  90
+  81   0   0   0   0  41   2  12
+  23  36  90   0   0   1  90  81
+   0   0   0   0  41   2  12  23
+  36  90   0   0   1  90  81   0
+   0   0   0  41   2  12  23  36
+  90   0   0   1  90  81   0   0
+   0   0  41   2  12  23  36  90
+   0   0   1  90  81   0   0   0
+   0  41   2  12  23  36  90   0
+   0   1  90  81   0   0   0   0
+  41   2  12  23  36  90   0   0
+   1  90  81   0   0   0   0  41
+   2  12  23  36  91   0   0   0
+   0  81   0   0   0   0  41   1
+  11  43  81   0   0   0   0  62
+  65   0   0   0   0   0   0   0
+0
+0
+0
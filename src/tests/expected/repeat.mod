@@ -0,0 +1,63 @@
+59
+  41   3  52  91   0   0   0   0
+   3  43  91   0   0   0   8   3
+  43  91   0   0   0  16   3  43
+  91   0   0   0   0  41   1  43
+  91   0   0   0   8   3  43  91
+   0   0   0   8   3  43  91   0
+   0   0   8   3  43  91   0   0
+   0   8   3  43  91   0   0   0
+   8   3  43  91   0   0   0   8
+   3  43  91   0   0   0   8   3
+  43  91   0   0   0   8   3  43
+  91   0   0   0   8   3  43  91
+   0   0   0   8   3  43  91   0
+   0   0   8   3  43  91   0   0
+   0   8   3  43  91   0   0   0
+   8   3  43  91   0   0   0   8
+   3  43  91   0   0   0   8   3
+  43  91   0   0   0   8   3  43
+  91   0   0   0   8   3  43  91
+   0   0   0   8   3  43  91   0
+   0   0   8   3  43  91   0   0
+   0   8   3  43  91   0   0   0
+   8  56  40  41   1  11  43  90
+   0   0   0 172  81   0   0   0
+   8   3  12  21  36  90   0   0
+   0 165  81   0   0   0   8   3
+  12  21  36  90   0   0   0 158
+  81   0   0   0   8   3  12  21
+  36  90   0   0   0 151  81   0
+   0   0   8   3  12  21  36  90
+   0   0   0 144  81   0   0   0
+   8   3  12  21  36  90   0   0
+   0 137  81   0   0   0   8   3
+  12  21  36  90   0   0   0 130
+  81   0   0   0   8   3  12  21
+  36  90   0   0   0 123  81   0
+   0   0   8   3  12  21  36  90
+   0   0   0 116  81   0   0   0
+   8   3  12  21  36  90   0   0
+   0 109  81   0   0   0   8   3
+  12  21  36  90   0   0   0 102
+  81   0   0   0   8   3  12  21
+  36  90   0   0   0  95  81   0
+   0   0   8   3  12  21  36  90
+   0   0   0  88  81   0   0   0
+   8   3  12  21  36  90   0   0
+   0  81  81   0   0   0   8   3
+  12  21  36  90   0   0   0  74
+  81   0   0   0   8   3  12  21
+  36  90   0   0   0  67  81   0
+   0   0   8   3  12  21  36  90
+   0   0   0  60  81   0   0   0
+   8   3  12  21  36  90   0   0
+   0  53  81   0   0   0   8   3
+  12  21  36  90   0   0   0  46
+  81   0   0   0   8   3  12  21
+  36  90   0   0   0  39  81   0
+   0   0   8   3  12  21  36  81
+   0   0   0   0  62  65   0   0
+0
+0
+0
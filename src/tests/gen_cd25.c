@@ -0,0 +1,93 @@
+/*
+  Writes synthetic CD25 programs to stdout, for the stress test and benchmarks
+  usage: gen_cd25 kind n
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char *kinds[] = { "if", "else", "for", "repeat", "paren", "rparen", "chain", "pow", "bool", "stats", "lines" };
+
+static void repeat(const char *s, long n) {
+	for (long i = 0; i < n; i++)
+		fputs(s, stdout);
+}
+
+// about n lines of everyday statements, each block of them with its own literal, temporaries and labels, so
+// every counter grows with the program
+static void lines(long n) {
+	for (long i = 0; i < n / 11 + 1; i++) {
+		printf("\ta = a + %ld;\n", i);
+		puts("\tb = a * 2 - b / 3;\n"
+			"\tif (a < b)\n\t\ta = a + 1;\n\telse\n\t\tb = b - 1;\n\tend\n"
+			"\tfor (c = 0; c < 2)\n\t\tc += 1;\n\tend\n"
+			"\tOut << a << Line;");
+	}
+}
+
+// a single statement or condition nested n deep (or n statements), in a main with three integers
+static void nested(const char *kind, long n) {
+	if (!strcmp(kind, "if")) {
+		repeat("if (a < 2)\n", n);
+		puts("\ta = a + 1;");
+		repeat("end\n", n);
+	} else if (!strcmp(kind, "else")) {
+		repeat("if (a < 2)\n\ta = a + 1;\nelse\n", n);
+		puts("\ta = a + 1;");
+		repeat("end\n", n);
+	} else if (!strcmp(kind, "for")) {
+		repeat("for (b = 0; b < 1)\n", n);
+		puts("\tb += 1;");
+		repeat("end\n", n);
+	} else if (!strcmp(kind, "repeat")) {
+		repeat("repeat (b = 0)\n", n);
+		puts("\tb += 1;");
+		repeat("until b > 0;\n", n);
+	} else if (!strcmp(kind, "paren")) {
+		fputs("\ta = ", stdout);
+		repeat("(", n);
+		fputs("a", stdout);
+		repeat(")", n);
+		puts(";");
+	} else if (!strcmp(kind, "rparen")) {
+		fputs("\ta = ", stdout);
+		repeat("(a + ", n);
+		fputs("a", stdout);
+		repeat(")", n);
+		puts(";");
+	} else if (!strcmp(kind, "chain")) {
+		fputs("\ta = a", stdout);
+		repeat(" + 1", n);
+		puts(";");
+	} else if (!strcmp(kind, "pow")) {
+		fputs("\ta = a", stdout);
+		repeat(" ^ 1", n);
+		puts(";");
+	} else if (!strcmp(kind, "bool")) {
+		fputs("if (a < 2", stdout);
+		repeat(" and a < 2", n);
+		puts(")\n\ta = 2;\nend");
+	} else if (!strcmp(kind, "stats")) {
+		repeat("\ta = a + 1;\n", n);
+	} else if (!strcmp(kind, "lines")) {
+		lines(n);
+	}
+}
+
+int main(int argc, char **argv) {
+	size_t kind = 0;
+	while (argc == 3 && kind < sizeof(kinds) / sizeof(*kinds) && strcmp(argv[1], kinds[kind]))
+		kind++;
+	if (argc != 3 || kind == sizeof(kinds) / sizeof(*kinds) || atol(argv[2]) < 1) {
+		fprintf(stderr, "usage: %s kind n, kind being one of", argv[0]);
+		for (kind = 0; kind < sizeof(kinds) / sizeof(*kinds); kind++)
+			fprintf(stderr, " %s", kinds[kind]);
+		fprintf(stderr, "\n");
+		return 1;
+	}
+	long n = atol(argv[2]);
+	puts("CD25 Gen\n\nmain\n\ta : integer, b : integer, c : integer\nbegin\n\ta = 1;");
+	nested(argv[1], n);
+	puts("\tOut << a << Line;\nend CD25 Gen");
+	return 0;
+}
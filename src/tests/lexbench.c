@@ -0,0 +1,174 @@
+/*
+  Lexes a generated source of about megabytes MB (32 by default), and then the given files over and over
+  until about as much of them has gone through, with each set of skip kernels the cpu has, printing the
+  throughput of each in MB/s (best of three runs) along with a checksum of the tokens
+  built with -DLEXER_BRANCH_FSM it times the branching FSM the transition table replaced (see lexbench.sh)
+  usage: lexbench [megabytes [file...]]
+  exits 1 if the kernel sets don't produce the same tokens
+*/
+#define _POSIX_C_SOURCE 200809L // clock_gettime
+#include "../lexer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define RUNS 3
+
+#ifdef LEXER_BRANCH_FSM
+#define ENGINE "branches"
+#else
+#define ENGINE "table"
+#endif
+
+static const char *sets[] = { "scalar", "sse2", "avx2" };
+
+// mostly what the lexer skips in runs: indentation, long names, numbers and both kinds of comment
+static char *generate(size_t want, size_t *len) {
+	static const char *chunk =
+		"/-- keep a running total of every sample that is still inside the window we care about\n"
+		"\t\trunningTotalOfSamples = runningTotalOfSamples + sampleValue%lu * 1048576;\n"
+		"\t\t/** the window only ever moves forwards, so a sample that falls out of it\n"
+		"\t\t    will never be seen again and can be dropped from the total here **/\n"
+		"\t\tif (windowStartPosition < currentPositionInStream - 65536)\n"
+		"\t\t\twindowStartPosition = windowStartPosition + 3.14159265358979;\n"
+		"\t\tend\n";
+	size_t cap = want + 1024;
+	char *text = malloc(cap);
+	size_t n = 0;
+	for (unsigned long i = 0; n < want; i++)
+		n += snprintf(text + n, cap - n, chunk, i);
+	*len = n;
+	return text;
+}
+
+static double now(void) {
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+// the whole of a file, NULL if it can't be read
+static char *slurp(const char *path, size_t *len) {
+	FILE *f = fopen(path, "rb");
+	if (!f)
+		return NULL;
+	size_t cap = 4096;
+	char *text = malloc(cap);
+	*len = 0;
+	size_t got;
+	while ((got = fread(text + *len, 1, cap - *len, f)) > 0) {
+		*len += got;
+		if (*len == cap)
+			text = realloc(text, cap *= 2);
+	}
+	fclose(f);
+	return text;
+}
+
+// lexes text to the end with kernels, returning how long it took, and adding the tokens to count and sum
+static double lex_all(const char *text, size_t len, const SkipKernels *kernels, u32 *count, unsigned long *sum) {
+	Lister *lst = lister_create(NULL);
+	StringPool *pool = stringpool_create();
+	Lexer *lex = lexer_create_text(text, len, lst, pool);
+	lex->skip = kernels;
+	double start = now();
+	Token t;
+	u32 i = 0;
+	do {
+		t = lexer_token_at(lex, i++);
+		*sum = (*sum ^ ((unsigned long)t.type << 48 ^ (unsigned long)t.row << 24 ^ t.col ^ t.id)) * 1099511628211ul;
+	} while (t.type != T_EOF);
+	double took = now() - start;
+	*count += i;
+	lexer_free(lex);
+	stringpool_free(pool);
+	lister_close(lst);
+	return took;
+}
+
+// texts lexed reps times over, as one input
+struct input {
+	const char *name;
+	char **texts;
+	size_t *lens;
+	int count;
+	long reps;
+	size_t bytes; // in all, counting every rep
+};
+
+// the best of RUNS times through input with kernels, returning its MB/s, and the tokens of a run
+static double bench(const struct input *in, const SkipKernels *kernels, u32 *count, unsigned long *sum) {
+	double best = 0;
+	for (int r = 0; r < RUNS; r++) {
+		double took = 0;
+		*count = 0;
+		*sum = 0;
+		for (long rep = 0; rep < in->reps; rep++) {
+			for (int i = 0; i < in->count; i++)
+				took += lex_all(in->texts[i], in->lens[i], kernels, count, sum);
+		}
+		if (!r || took < best)
+			best = took;
+	}
+	return in->bytes / 1048576.0 / best;
+}
+
+int main(int argc, char **argv) {
+	long mb = argc > 1 ? atol(argv[1]) : 32;
+	if (mb < 1) {
+		fprintf(stderr, "usage: %s [megabytes [file...]]\n", argv[0]);
+		return 1;
+	}
+	struct input inputs[2];
+	int input_count = 0;
+	size_t len;
+	char *synthetic = generate((size_t)mb << 20, &len);
+	inputs[input_count++] = (struct input){ "synthetic", &synthetic, &len, 1, 1, len };
+	char **files = malloc((argc > 2 ? argc - 2 : 1) * sizeof(char *));
+	size_t *file_lens = malloc((argc > 2 ? argc - 2 : 1) * sizeof(size_t));
+	size_t file_bytes = 0;
+	for (int i = 2; i < argc; i++) {
+		if (!(files[i - 2] = slurp(argv[i], &file_lens[i - 2]))) {
+			fprintf(stderr, "could not read %s\n", argv[i]);
+			return 1;
+		}
+		file_bytes += file_lens[i - 2];
+	}
+	if (file_bytes) {
+		long reps = ((size_t)mb << 20) / file_bytes + 1;
+		inputs[input_count++] = (struct input){ "files", files, file_lens, argc - 2, reps, file_bytes * reps };
+	}
+	printf("# %s FSM, %.1f MB synthetic, %d files of %.1f KB, chosen kernels %s\n# input kernels MB/s tokens checksum\n",
+		ENGINE, len / 1048576.0, argc > 2 ? argc - 2 : 0, file_bytes / 1024.0, lexer_simd_kernels()->name);
+	int differ = 0;
+	for (int n = 0; n < input_count; n++) {
+		u32 first_count = 0;
+		unsigned long first_sum = 0;
+		int tried = 0;
+		for (size_t k = 0; k < sizeof(sets) / sizeof(*sets); k++) {
+			const SkipKernels *kernels = lexer_simd_kernels_named(sets[k]);
+			if (!kernels) {
+				printf("%s %s unsupported\n", inputs[n].name, sets[k]);
+				continue;
+			}
+			u32 count;
+			unsigned long sum;
+			double speed = bench(&inputs[n], kernels, &count, &sum);
+			printf("%s %s %.1f %u %016lx\n", inputs[n].name, kernels->name, speed, count, sum);
+			if (!tried++) {
+				first_count = count;
+				first_sum = sum;
+			} else if (count != first_count || sum != first_sum) {
+				printf("%s %s: tokens differ from %s\n", inputs[n].name, kernels->name, sets[0]);
+				differ = 1;
+			}
+		}
+	}
+	for (int i = 0; i < argc - 2; i++)
+		free(files[i]);
+	free(files);
+	free(file_lens);
+	free(synthetic);
+	return differ;
+}
@@ -0,0 +1,26 @@
+#!/bin/sh
+# lexer throughput with the transition table against the branching FSM it replaced, on a generated source of
+# megabytes MB (32 by default) and on every program in cd25_programs, failing if the two lex differently
+set -e
+
+if [ $# -gt 1 ]; then
+    echo "Usage: $0 [megabytes]"
+    exit 1
+fi
+
+tests=$(cd "$(dirname "$0")" && pwd)
+mb=${1:-32}
+out=$(mktemp -d)
+trap 'rm -rf "$out"' EXIT
+
+for engine in table branches; do
+    if [ $engine = table ]; then bench="$tests/lexbench"; else bench="$tests/lexbench_branches"; fi
+    "$bench" $mb "$tests"/../../cd25_programs/*.cd > "$out/$engine"
+    cat "$out/$engine"
+    # everything but the timings
+    grep -v '^#' "$out/$engine" | awk '{ print $1, $2, $4, $5 }' > "$out/$engine.tokens"
+done
+if ! cmp -s "$out/table.tokens" "$out/branches.tokens"; then
+    echo "the table and branches lex differently"
+    exit 1
+fi
@@ -0,0 +1,183 @@
+/*
+  Times the open-addressing HashMap (lib/hashmap.c) against the chained map it replaced, on symbol keys as
+  the symbol table used them: n inserts, then a lookup of each key (hits) and of as many keys that aren't
+  there (misses), in ns an operation (best of three runs), for n from 1k up to max_n (100k by default)
+  the chained map is timed with the 20 buckets the tree makes most of them with, and with n buckets
+  usage: mapbench [max_n]
+  exits 1 if the maps don't find the same values
+*/
+#define _POSIX_C_SOURCE 200809L // clock_gettime
+#include "../lib/hashmap.h"
+#include "../symboltable.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define RUNS 3
+
+// the replaced map, as it was: a fixed number of buckets, each a list of entries allocated one by one
+struct chain_node {
+	struct chain_node *prev, *next;
+	void *data;
+};
+
+typedef struct chained {
+	u32 size;
+	struct chain_node **heads, **tails;
+	hash_func_t hash_func;
+	equals_func_t equals_func;
+} Chained;
+
+static Chained *chained_create(u32 size, hash_func_t hash_func, equals_func_t equals_func) {
+	Chained *ht = malloc(sizeof(Chained));
+	ht->size = size;
+	ht->heads = calloc(size, sizeof(struct chain_node *));
+	ht->tails = calloc(size, sizeof(struct chain_node *));
+	ht->hash_func = hash_func;
+	ht->equals_func = equals_func;
+	return ht;
+}
+
+static void chained_free(Chained *ht) {
+	for (u32 i = 0; i < ht->size; i++) {
+		for (struct chain_node *n = ht->heads[i], *next; n; n = next) {
+			next = n->next;
+			free(n->data);
+			free(n);
+		}
+	}
+	free(ht->heads);
+	free(ht->tails);
+	free(ht);
+}
+
+static void chained_add(Chained *ht, void *key, void *val) {
+	u32 index = ht->hash_func(key) % ht->size;
+	Entry *entry = malloc(sizeof(Entry));
+	entry->key = key;
+	entry->val = val;
+	struct chain_node *n = malloc(sizeof(struct chain_node));
+	n->prev = ht->tails[index];
+	n->next = NULL;
+	n->data = entry;
+	if (ht->tails[index])
+		ht->tails[index]->next = n;
+	else
+		ht->heads[index] = n;
+	ht->tails[index] = n;
+}
+
+static void *chained_get(const Chained *ht, void *key) {
+	u32 index = ht->hash_func(key) % ht->size;
+	for (struct chain_node *n = ht->heads[index]; n; n = n->next) {
+		Entry *entry = n->data;
+		if (ht->equals_func(entry->key, key))
+			return entry->val;
+	}
+	return NULL;
+}
+
+static void free_noop(void *p) {
+	(void)p;
+}
+
+static double now(void) {
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+// ns an operation for each phase
+struct timing {
+	double insert, hit, miss;
+	unsigned long found; // checksum of the values the lookups found
+};
+
+static void keep_best(struct timing *best, const struct timing *t, int run) {
+	if (!run || t->insert < best->insert)
+		best->insert = t->insert;
+	if (!run || t->hit < best->hit)
+		best->hit = t->hit;
+	if (!run || t->miss < best->miss)
+		best->miss = t->miss;
+	best->found = t->found;
+}
+
+// keys[0..n) go in, keys[n..2n) are the misses
+static struct timing time_hashmap(Symbol *keys, u32 n) {
+	struct timing t = { 0, 0, 0, 0 };
+	double start = now();
+	HashMap *map = hashmap_create(20, symbol_hash, symbol_equals);
+	for (u32 i = 0; i < n; i++)
+		hashmap_add(map, &keys[i], &keys[i]);
+	t.insert = (now() - start) * 1e9 / n;
+	start = now();
+	for (u32 i = 0; i < n; i++)
+		t.found += ((Symbol *)hashmap_get(map, &keys[i]))->id;
+	t.hit = (now() - start) * 1e9 / n;
+	start = now();
+	for (u32 i = n; i < 2 * n; i++)
+		t.found += hashmap_get(map, &keys[i]) != NULL;
+	t.miss = (now() - start) * 1e9 / n;
+	hashmap_free(map, free_noop, free_noop);
+	return t;
+}
+
+static struct timing time_chained(Symbol *keys, u32 n, u32 buckets) {
+	struct timing t = { 0, 0, 0, 0 };
+	double start = now();
+	Chained *map = chained_create(buckets, symbol_hash, symbol_equals);
+	for (u32 i = 0; i < n; i++)
+		chained_add(map, &keys[i], &keys[i]);
+	t.insert = (now() - start) * 1e9 / n;
+	start = now();
+	for (u32 i = 0; i < n; i++)
+		t.found += ((Symbol *)chained_get(map, &keys[i]))->id;
+	t.hit = (now() - start) * 1e9 / n;
+	start = now();
+	for (u32 i = n; i < 2 * n; i++)
+		t.found += chained_get(map, &keys[i]) != NULL;
+	t.miss = (now() - start) * 1e9 / n;
+	chained_free(map);
+	return t;
+}
+
+int main(int argc, char **argv) {
+	long max_n = argc > 1 ? atol(argv[1]) : 100000;
+	if (argc > 2 || max_n < 1000) {
+		fprintf(stderr, "usage: %s [max_n], max_n being at least 1000\n", argv[0]);
+		return 1;
+	}
+	// names spread over a few scopes, as a program's symbols are
+	Symbol *keys = malloc(2 * max_n * sizeof(Symbol));
+	for (long i = 0; i < 2 * max_n; i++)
+		keys[i] = (Symbol){ .id = (u32)(i / 4 + 1), .scope = (u32)(i % 4) };
+	// shuffled, so the misses aren't just the ids past the hits
+	srand(1);
+	for (long i = 2 * max_n - 1; i > 0; i--) {
+		long j = rand() % (i + 1);
+		Symbol swap = keys[i];
+		keys[i] = keys[j];
+		keys[j] = swap;
+	}
+	printf("# map n insert_ns hit_ns miss_ns\n");
+	int differ = 0;
+	for (u32 n = 1000; n <= max_n; n *= 10) {
+		const char *names[] = { "hashmap", "chained/20", "chained/n" };
+		struct timing best[3];
+		for (int run = 0; run < RUNS; run++) {
+			struct timing t[3] = { time_hashmap(keys, n), time_chained(keys, n, 20), time_chained(keys, n, n) };
+			for (int m = 0; m < 3; m++)
+				keep_best(&best[m], &t[m], run);
+		}
+		for (int m = 0; m < 3; m++) {
+			printf("%s %u %.1f %.1f %.1f\n", names[m], n, best[m].insert, best[m].hit, best[m].miss);
+			if (best[m].found != best[0].found) {
+				printf("%s %u: found different values from hashmap\n", names[m], n);
+				differ = 1;
+			}
+		}
+	}
+	free(keys);
+	return differ;
+}
@@ -0,0 +1,43 @@
+/*
+  Runs a command with its output thrown away, printing its wall time in seconds and peak resident set in KB
+  usage: measure command [args...]
+  exits with the command's status (128 + the signal if it was killed)
+*/
+#define _POSIX_C_SOURCE 200809L // clock_gettime
+#include <fcntl.h>
+#include <stdio.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+int main(int argc, char **argv) {
+	if (argc < 2) {
+		fprintf(stderr, "usage: %s command [args...]\n", argv[0]);
+		return 1;
+	}
+	struct timespec start, end;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	pid_t pid = fork();
+	if (pid < 0) {
+		perror("fork");
+		return 1;
+	}
+	if (pid == 0) {
+		int null = open("/dev/null", O_WRONLY);
+		dup2(null, STDOUT_FILENO);
+		dup2(null, STDERR_FILENO);
+		execvp(argv[1], argv + 1);
+		_exit(127);
+	}
+	int status;
+	if (waitpid(pid, &status, 0) < 0) {
+		perror("waitpid");
+		return 1;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	struct rusage usage;
+	getrusage(RUSAGE_CHILDREN, &usage); // the only child, so its peak
+	printf("%.3f %ld\n", (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9, usage.ru_maxrss);
+	return WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+}
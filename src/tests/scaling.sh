@@ -0,0 +1,29 @@
+#!/bin/sh
+# compiles generated programs of each size in lines (1k to 1M by default) through each stage, printing wall
+# time and peak RSS a row each, in columns gnuplot can take as they are
+set -e
+
+tests=$(cd "$(dirname "$0")" && pwd)
+cd25c="$tests/../cd25c"
+sizes=${*:-1000 10000 100000 1000000}
+out=$(mktemp -d)
+trap 'rm -rf "$out"' EXIT
+cd "$out" # where the modules and asm go
+
+echo "# lines stage seconds peak_mb us_per_line"
+for lines in $sizes; do
+    "$tests/gen_cd25" lines $lines > gen.cd
+    for stage in tac sm25 x86 x86-ssa; do
+        case $stage in
+            tac) flags="-T" ;;
+            sm25) flags="-a sm25" ;;
+            x86) flags="-a x86" ;;
+            x86-ssa) flags="-O -a x86" ;;
+        esac
+        if ! result=$("$tests/measure" "$cd25c" $flags gen.cd); then
+            echo "$lines lines: cd25c $flags failed"
+            exit 1
+        fi
+        echo "$lines $stage $result" | awk '{ printf "%d %s %.3f %.1f %.2f\n", $1, $2, $3, $4 / 1024, $3 * 1e6 / $1 }'
+    done
+done
@@ -0,0 +1,68 @@
+#!/bin/sh
+# checks each kind of nested program at a small depth against what the recursive compiler made of it
+# (tests/expected) and its CFGs against the definitions of dominators and loops (cfgcheck), and the literal
+# pools of tests/literals.cd against tests/expected/literals.tac, then compiles each kind depth levels deep
+# (100k by default) through every stage, stopping at the first that fails
+set -e
+
+if [ $# -gt 1 ]; then
+    echo "Usage: $0 [depth]"
+    exit 1
+fi
+
+tests=$(cd "$(dirname "$0")" && pwd)
+cd25c="$tests/../cd25c"
+depth=${1:-100000}
+kinds="if else for repeat paren rparen chain pow bool stats"
+out=$(mktemp -d)
+trap 'rm -rf "$out"' EXIT
+cd "$out" # where the listings, modules and asm go
+
+# the expected output was made at this depth by the compiler before it walked trees with work stacks
+for kind in $kinds; do
+    "$tests/gen_cd25" $kind 20 > $kind.cd
+    "$cd25c" -A $kind.cd > $kind.ast 2>&1 || true
+    "$cd25c" -T $kind.cd > $kind.tac 2>&1 || true
+    "$cd25c" -a sm25 -o $kind.mod $kind.cd > log 2>&1 || true
+    for output in ast tac mod; do
+        if ! cmp -s $kind.$output "$tests/expected/$kind.$output"; then
+            echo "$kind, depth 20: $output differs from tests/expected/$kind.$output"
+            diff "$tests/expected/$kind.$output" $kind.$output | head -n 10
+            exit 1
+        fi
+    done
+done
+echo "every kind, depth 20: same output as the recursive compiler"
+
+# literals are pooled by value, equal ones sharing an entry and reals told apart exactly
+"$cd25c" -T "$tests/literals.cd" > literals.tac 2>&1 || true
+if ! cmp -s literals.tac "$tests/expected/literals.tac"; then
+    echo "literals: tac differs from tests/expected/literals.tac"
+    diff "$tests/expected/literals.tac" literals.tac | head -n 10
+    exit 1
+fi
+echo "literals: pooled as in tests/expected"
+
+for kind in $kinds; do
+    if ! "$tests/cfgcheck" $kind.cd > log; then
+        cat log
+        exit 1
+    fi
+done
+if ! "$tests/cfgcheck" "$tests"/../../cd25_programs/valid*.cd > log; then
+    cat log
+    exit 1
+fi
+echo "every kind, depth 20, and every valid program: CFGs as defined"
+
+for kind in $kinds; do
+    "$tests/gen_cd25" $kind $depth > $kind.cd
+    for stage in "-A" "-T" "-G" "-O -G" "-l -a sm25" "-a x86" "-O"; do
+        if ! "$cd25c" $stage $kind.cd > log 2>&1; then
+            echo "$kind, depth $depth: cd25c $stage failed"
+            tail -n 5 log
+            exit 1
+        fi
+    done
+    echo "$kind, depth $depth: ok"
+done
@@ -0,0 +1,106 @@
+/*
+  Analyses each program, then has eight threads read its symbol table at once: every symbol looked up again
+  by name and scope, its attribute fetched, and the lists hanging off it walked. Built with
+  -fsanitize=thread (make tsan), so any write a read makes shows up as a race.
+  usage: tsan_readers file.cd...
+  exits 1 if a program doesn't analyse or the threads disagree on what they read
+*/
+#include "../parser.h"
+#include "../semantic_analysis.h"
+#include <pthread.h>
+#include <stdio.h>
+
+#define READERS 8
+
+typedef struct reader {
+	pthread_t thread;
+	ASTree *ast;
+	unsigned long sum; // of everything it read, the same for every reader if they all saw the same table
+} Reader;
+
+static unsigned long mix(unsigned long sum, unsigned long x) {
+	return (sum ^ x) * 1099511628211ul;
+}
+
+static unsigned long read_attribute(ASTree *ast, Attribute *atr) {
+	if (!atr)
+		return 0;
+	unsigned long sum = mix(atr->type, atr->offset * 2 + atr->is_param);
+	switch (atr->type) {
+		case SARRAY:
+		case SSTRUCT: { // the type it's of
+			Attribute *of = astree_get_attribute(ast, atr->data);
+			sum = mix(sum, of ? of->type : SNONE);
+			break;
+		}
+		case SFIELDS: {
+			LLIter it = linkedlist_iter(atr->data);
+			Element *e;
+			for (; (e = lliter_get(it)); lliter_next(&it))
+				sum = mix(mix(sum, e->name->id), e->type);
+			sum = mix(sum, linkedlist_len(atr->data));
+			break;
+		}
+		default: // a function's parameters, none for a variable
+			if (atr->data) {
+				LLIter it = linkedlist_iter(atr->data);
+				Attribute *param;
+				for (; (param = lliter_get(it)); lliter_next(&it))
+					sum = mix(mix(sum, param->type), param->is_param);
+				sum = mix(sum, linkedlist_len(atr->data));
+			}
+	}
+	return sum;
+}
+
+static void *read_table(void *arg) {
+	Reader *r = arg;
+	const SymbolTable *st = r->ast->symboltable;
+	unsigned long sum = 0;
+	for (u32 handle = 1; handle < st->symbol_count; handle++) {
+		Symbol *sym = symboltable_symbol(st, handle);
+		if (symboltable_find(st, sym->id, sym->scope) != handle)
+			sum = mix(sum, 0xbad);
+		sum = mix(sum, read_attribute(r->ast, astree_get_attribute(r->ast, sym)));
+		sum = mix(sum, stringpool_view(st->pool, sym->id).len);
+	}
+	r->sum = sum;
+	return NULL;
+}
+
+int main(int argc, char **argv) {
+	if (argc < 2) {
+		fprintf(stderr, "usage: %s file.cd...\n", argv[0]);
+		return 1;
+	}
+	int failed = 0;
+	for (int f = 1; f < argc; f++) {
+		Lister *lst = lister_create(NULL);
+		ASTree *ast = get_AST(argv[f], lst, 0, 1, NULL);
+		analyse_program(ast, lst);
+		if (!ast->is_valid) {
+			printf("%s: doesn't analyse\n", argv[f]);
+			failed = 1;
+			continue;
+		}
+		Reader readers[READERS];
+		for (int i = 0; i < READERS; i++) {
+			readers[i] = (Reader){ .ast = ast };
+			if (pthread_create(&readers[i].thread, NULL, read_table, &readers[i]) != 0) {
+				perror("pthread_create");
+				return 1;
+			}
+		}
+		int same = 1;
+		for (int i = 0; i < READERS; i++) {
+			pthread_join(readers[i].thread, NULL);
+			same &= readers[i].sum == readers[0].sum;
+		}
+		printf("%s: %u symbols, %d readers %s\n", argv[f], ast->symboltable->symbol_count - 1, READERS,
+			same ? "agree" : "disagree");
+		failed |= !same;
+		astree_free(ast);
+		lister_close(lst);
+	}
+	return failed;
+}
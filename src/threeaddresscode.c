@@ -2,149 +2,68 @@
 #include "astree.h"
 #include "node.h"
 #include "symboltable.h"
-#include <math.h>
 #include <stdlib.h>
 #include <string.h>
 #include "lib/linkedlist.h"
-#include "lib/sds.h"
+#include "lib/vector.h"
 #include "lib/defs.h"
 #include "lib/hashmap.h"
+#include "lib/u64map.h"
 #include <stdio.h> // used in tac_printf
 
 typedef struct tac_state {
 	TAC *tac;
 	ASTree *ast;
-	HashMap *seen_strings; // due to bad design earlier, literals aren't in symbol table
-	HashMap *seen_intvals; // <val: int, offset: int>
-	HashMap *seen_floatvals; // <val: double, offset: int>
+	u32 *string_adrs; // string pool id -> its A_STR address + 1 (0 for none yet)
+	U64Map *int_adrs; // value -> its A_ILIT address
+	U64Map *float_adrs; // bits of the value -> its A_FLIT address
 	// function local
-	u16 temp_reg_counter;
+	u32 temp_reg_counter;
 	// global
-	u16 label_counter;
-	u16 string_counter;
-	u16 float_counter;
-	u16 int_counter;
-	u16 array_counter;
+	u32 label_counter;
+	u32 string_counter;
+	u32 float_counter;
+	u32 int_counter;
+	u32 array_counter;
 	HashMap *array_len_map; // <symbol, int>
 	HashMap *array_structsize_map; // <symbol, int>
 	HashMap *const_map; // <symbol, int>
+	struct pending_expr *pending; // operators waiting on an operand (see tac_resolve)
+	u32 pending_count, pending_cap;
 } T_S;
 
+// an operator in tac_resolve, with its left operand done (at stage 1) or not
+struct pending_expr {
+	ASTNode *node;
+	Adr tmp; // a boolean's result, taken before its operands like the recursive version did
+	Adr lhs;
+	int stage;
+};
+
 // predefinitions
 void tac_gen_stats(T_S *ts, ASTNode *node);
 void tac_gen_sdecl(T_S *ts, ASTNode *node);
 Adr tac_get_adr(T_S *ts, ASTNode *node);
 Adr tac_gen_fncall(T_S *ts, ASTNode *node);
-long *heap_long(long k);
 int *heap_int(int k);
-double *heap_double(double x);
 
-// abstracted away because I might want to use dynamic arrays later
 void append_int(T_S *ts, long val) {
-	linkedlist_push_tail(ts->tac->ints, heap_long(val));
+	vector_push(ts->tac->ints, &val);
 }
 
 void append_float(T_S *ts, double val) {
-	linkedlist_push_tail(ts->tac->floats, heap_double(val));
-}
-
-// takes ownership
-void append_sds(T_S *ts, sds str) {
-	linkedlist_push_tail(ts->tac->strings, str);
-}
-
-void append_line(T_S *ts, Line *line) {
-	linkedlist_push_tail(ts->tac->lines, line);
-}
-
-static sds sds_substr(const sds src, size_t start, size_t len) {
-	size_t src_len = sdslen(src);
-	if (start >= src_len) return sdsnew("");  // empty string if start past end
-	if (start + len > src_len) len = src_len - start;
-	return sdsnewlen(src + start, len);
-}
-
-static sds sds_from_symbol(ASTree *ast, Symbol *s) {
-	return sds_substr(
-		ast->symboltable->stringspace,
-		s->index.start,
-		s->index.len
-	);
-}
-
-static int sym_to_int(ASTree *ast, Symbol *s) {
-	sds str = sds_from_symbol(ast, s);
-	int val = atoi(str);
-	sdsfree(str);
-	return val;
-}
-
-static double sym_to_double(ASTree *ast, Symbol *s) {
-	sds str = sds_from_symbol(ast, s);
-	double val = atof(str);
-	sdsfree(str);
-	return val;
-}
-
-static unsigned hash_symbol(const void *ptr) {
-	const Symbol *sym = (const Symbol *)ptr;
-	unsigned hash = 17;
-	hash = hash * 31 + (unsigned)(sym->index.start ^ (sym->index.start >> 32));
-	hash = hash * 31 + (unsigned)(sym->index.len ^ (sym->index.len >> 32));
-	hash = hash * 31 + sym->scope;
-	return hash;
-}
-
-static int equal_symbol(const void *a, const void *b) {
-	const Symbol *s1 = (const Symbol *)a;
-	const Symbol *s2 = (const Symbol *)b;
-	return s1->index.start == s2->index.start &&
-	       s1->index.len   == s2->index.len &&
-	       s1->scope       == s2->scope;
-}
-
-static unsigned hash_str(const void *ptr) {
-	char *s = (char *) ptr;
-	unsigned hashval;
-	for (hashval = 0; *s != '\0'; s++)
-		hashval = *s + 31 * hashval;
-	return hashval;
-}
-static int equal_str(const void *a, const void *b) {
-	return strcmp((char *)a, (char *)b) == 0;
-}
-
-static unsigned hash_i64(const void *ptr) {
-	const i64 *val = (const i64 *)ptr;
-	return *val * 7;
-}
-static int equal_i64(const void *a, const void *b) {
-	const i64 *i1 = (const i64 *)a;
-	const i64 *i2 = (const i64 *)b;
-	return *i1 == *i2;
-}
-
-static inline u64 quantise_double(double x) {
-	return (u64) floor(x / 0.0001);
-}
-
-static unsigned hash_double(const void *ptr) {
-	u64 quantised = quantise_double(*(double*)ptr);
-	quantised *= 11400714819323198485ull;
-	return (unsigned) quantised;
+	vector_push(ts->tac->floats, &val);
 }
 
-static int equal_double(const void *x, const void *y) {
-	u64 a = quantise_double(*(double*)x);
-	u64 b = quantise_double(*(double*)y);
-	return a == b;
+void append_line(T_S *ts, Line line) {
+	vector_push(ts->tac->lines, &line);
 }
 
 Adr blank(void) {
 	return (Adr) {A_EMPTY, 0};
 }
 
-Adr mkadr(enum adr_type type, u16 adr) {
+Adr mkadr(enum adr_type type, u32 adr) {
 	return (Adr) {type, adr};
 }
 
@@ -156,34 +75,20 @@ Adr mklabel(T_S *ts) {
 	return mkadr(A_LABEL, ts->label_counter++);
 }
 
-Line *ternary_line(enum operation op, Adr left, Adr middle, Adr right, u16 linenum) {
-	Line *new = malloc(sizeof(Line));
-	*new = (Line) { op, left, middle, right, linenum};
-	return new;
+Line ternary_line(enum operation op, Adr left, Adr middle, Adr right, u32 linenum) {
+	return (Line) { op, left, middle, right, linenum};
 }
 
-Line *binary_line(enum operation op, Adr left, Adr right, u16 linenum) {
-	Line *new = malloc(sizeof(Line));
-	*new = (Line) {op, left, blank(), right, linenum};
-	return new;
+Line binary_line(enum operation op, Adr left, Adr right, u32 linenum) {
+	return (Line) {op, left, blank(), right, linenum};
 }
 
-Line *unary_line(enum operation op, Adr left, u16 linenum) {
-	Line *new = malloc(sizeof(Line));
-	*new = (Line) {op, left, blank(), blank(), linenum};
-	return new;
+Line unary_line(enum operation op, Adr left, u32 linenum) {
+	return (Line) {op, left, blank(), blank(), linenum};
 }
 
-Line *nonary_line(enum operation op, u16 linenum) {
-	Line *new = malloc(sizeof(Line));
-	*new = (Line) {op, blank(), blank(), blank(), linenum};
-	return new;
-}
-
-long *heap_long(long k) {
-	long *hk = malloc(sizeof(long));
-	*hk = k;
-	return hk;
+Line nonary_line(enum operation op, u32 linenum) {
+	return (Line) {op, blank(), blank(), blank(), linenum};
 }
 
 int *heap_int(int k) {
@@ -192,64 +97,43 @@ int *heap_int(int k) {
 	return hk;
 }
 
-u16 *heap_u16(u16 k) {
-	u16 *hk = malloc(sizeof(u16));
-	*hk = k;
-	return hk;
-}
-
-double *heap_double(double x) {
-	double *hx = malloc(sizeof(double));
-	*hx = x;
-	return hx;
-}
-
 Adr adr_of_int(T_S *ts, const int val) {
-	u16 adr;
-	if (hashmap_get(ts->seen_intvals, heap_long(val))) {
-		adr = * (u16*) hashmap_get(ts->seen_intvals, heap_long(val));
-	} else {
+	u32 adr = u64map_intern(ts->int_adrs, (u64)(i64)val, ts->int_counter);
+	if (adr == ts->int_counter) {
 		append_int(ts, val);
-		adr = ts->int_counter++;
-		hashmap_add(ts->seen_intvals, heap_long(val), heap_u16(adr));
+		ts->int_counter++;
 	}
 	return mkadr(A_ILIT, adr);
 }
 
 Adr adr_of_double(T_S *ts, double val) {
-	u16 adr;
-	if (hashmap_get(ts->seen_floatvals, heap_double(val))) {
-		adr = * (u16*) hashmap_get(ts->seen_floatvals, heap_double(val));
-	} else {
-		adr = ts->float_counter;
+	u64 bits;
+	memcpy(&bits, &val, sizeof bits); // so 0.1 and 0.10000000000000001 stay apart, unlike quantising
+	u32 adr = u64map_intern(ts->float_adrs, bits, ts->float_counter);
+	if (adr == ts->float_counter) {
 		append_float(ts, val);
-		hashmap_add(ts->seen_floatvals, heap_double(val), heap_long(ts->float_counter++));
+		ts->float_counter++;
 	}
 	return mkadr(A_FLIT, adr);
 }
 
-// takes ownership of the passed string
-Adr adr_of_sds(T_S *ts, sds s) {
-	i16 adr;
-	if (hashmap_get(ts->seen_strings, s)) {
-		adr = * (u16*) hashmap_get(ts->seen_strings, s);
-	} else {
-		append_sds(ts, sdsdup(s));
-		adr = ts->string_counter++;
-
-		hashmap_add(ts->seen_strings, sdsdup(s), heap_u16(adr));
+// id is the string's in the tree's pool, which the TAC then points into
+Adr adr_of_string(T_S *ts, u32 id) {
+	if (!ts->string_adrs[id]) {
+		StrView view = stringpool_view(ts->ast->symboltable->pool, id);
+		vector_push(ts->tac->strings, &view);
+		ts->string_adrs[id] = ++ts->string_counter;
 	}
-	sdsfree(s);
-	return mkadr(A_STR, adr);
+	return mkadr(A_STR, ts->string_adrs[id] - 1);
 }
 
 TAC *tac_create(void) {
 	TAC *tac = malloc(sizeof(TAC));
-	tac->lines = linkedlist_create();
-	tac->strings = linkedlist_create();
-	tac->floats = linkedlist_create();
-	tac->ints = linkedlist_create();
-	tac->arrays = linkedlist_create();
+	tac->lines = vector_create(sizeof(Line));
+	tac->strings = vector_create(sizeof(StrView));
+	tac->floats = vector_create(sizeof(double));
+	tac->ints = vector_create(sizeof(long));
+	tac->arrays = vector_create(sizeof(int));
 	return tac;
 }
 
@@ -258,128 +142,49 @@ T_S *t_s_create(TAC *tac, ASTree *ast) {
 	*new = (T_S) {0};
 	new->tac = tac;
 	new->ast = ast;
-	new->seen_strings = hashmap_create(50, hash_str, equal_str);
-	new->seen_intvals = hashmap_create(50, hash_i64, equal_i64);
-	new->seen_floatvals = hashmap_create(50, hash_double, equal_double);
-	new->array_len_map = hashmap_create(20, hash_symbol, equal_symbol);
-	new->array_structsize_map = hashmap_create(20, hash_symbol, equal_symbol);
-	new->const_map = hashmap_create(20, hash_symbol, equal_symbol);
+	new->string_adrs = calloc(ast->symboltable->pool->count, sizeof(u32));
+	new->int_adrs = u64map_create(50);
+	new->float_adrs = u64map_create(50);
+	new->array_len_map = hashmap_create(20, symbol_hash, symbol_equals);
+	new->array_structsize_map = hashmap_create(20, symbol_hash, symbol_equals);
+	new->const_map = hashmap_create(20, symbol_hash, symbol_equals);
 	return new;
 }
 
-Adr tac_resolve_numeric(T_S *ts, ASTNode *node) {
-	enum operation op;
-	int promote_left = 0;
-	int promote_right = 0;
-	Adr tmp;
-	switch (node->type) {
-		case NADD:
-			if (node->symbol_type == SINT) {
-				op = O_ADDI;
-			} else {
-				op = O_ADDF;
-			}
-			break;
-		case NSUB:
-			if (node->symbol_type == SINT) {
-				op = O_SUBI;
-			} else {
-				op = O_SUBF;
-			}
-			break;
-		case NMUL:
-			if (node->symbol_type == SINT) {
-				op = O_MULI;
-			} else {
-				op = O_MULF;
-			}
-			break;
-		case NDIV:
-			if (node->symbol_type == SINT) {
-				op = O_DIVI;
-			} else {
-				op = O_DIVF;
-			}
-			break;
-		case NPOW:
-			if (node->right_child->symbol_type == SINT) {
-				op = O_POWII;
-			} else {
-				op = O_POWIF;
-			}
-			break;
-		case NMOD:
-			op = O_MOD; // mod is for ints only in CD25
-			break;
-		case NFCALL:
-			return tac_gen_fncall(ts, node);
-		case NARRV:
-			tmp = mktmp(ts);
-			append_line(ts, binary_line(O_DEREF, tmp, tac_get_adr(ts, node), node->row));
-			return tmp;
-		default: // terminal node
-			return tac_get_adr(ts, node);
-	}
-	if (node->symbol_type == SREAL) {
-		if (node->left_child->symbol_type == SINT) {
-			promote_left = 1;
-		}
-		if (node->right_child->symbol_type == SINT) {
-			promote_right = 1;
-		}
-	}
-	// assumption: no numeric has 1 child (correct I think)
-	Adr lhs = tac_resolve_numeric(ts, node->left_child);
-	if (promote_left) {
-		Adr tmp = mktmp(ts);
-		append_line(ts, binary_line(O_ITOF, tmp, lhs, node->row));
-		lhs = tmp;
-	}
-	Adr rhs = tac_resolve_numeric(ts, node->right_child);
-	if (promote_right) {
-		Adr tmp = mktmp(ts);
-		append_line(ts, binary_line(O_ITOF, tmp, rhs, node->row));
-		rhs = tmp;
-	}
-	tmp = mktmp(ts);
-	append_line(ts, ternary_line(op, tmp, lhs, rhs, node->row));
-	return tmp;
-}
-
-enum operation relop_at(ASTNode *node) {
+enum operation relop_at(T_S *ts, ASTNode *node) {
 	switch (node->type) {
 		case NGRT:
-			if (node->left_child->symbol_type == SREAL || node->right_child->symbol_type == SREAL) {
+			if (node_left(ts->ast, node)->symbol_type == SREAL || node_right(ts->ast, node)->symbol_type == SREAL) {
 				return O_GTF;
 			} else {
 				return O_GTI;
 			}
 		case NGEQ:
-			if (node->left_child->symbol_type == SREAL || node->right_child->symbol_type == SREAL) {
+			if (node_left(ts->ast, node)->symbol_type == SREAL || node_right(ts->ast, node)->symbol_type == SREAL) {
 				return O_GTEF;
 			} else {
 				return O_GTEI;
 			}
 		case NLSS:
-			if (node->left_child->symbol_type == SREAL || node->right_child->symbol_type == SREAL) {
+			if (node_left(ts->ast, node)->symbol_type == SREAL || node_right(ts->ast, node)->symbol_type == SREAL) {
 				return O_LTF;
 			} else {
 				return O_LTI;
 			}
 		case NLEQ:
-			if (node->left_child->symbol_type == SREAL || node->right_child->symbol_type == SREAL) {
+			if (node_left(ts->ast, node)->symbol_type == SREAL || node_right(ts->ast, node)->symbol_type == SREAL) {
 				return O_LTEF;
 			} else {
 				return O_LTEI;
 			}
 		case NEQL:
-			if (node->left_child->symbol_type == SREAL || node->right_child->symbol_type == SREAL) {
+			if (node_left(ts->ast, node)->symbol_type == SREAL || node_right(ts->ast, node)->symbol_type == SREAL) {
 				return O_EQF;
 			} else {
 				return O_EQI;
 			}
 		case NNEQ:
-			if (node->left_child->symbol_type == SREAL || node->right_child->symbol_type == SREAL) {
+			if (node_left(ts->ast, node)->symbol_type == SREAL || node_right(ts->ast, node)->symbol_type == SREAL) {
 				return O_NEQF;
 			} else {
 				return O_NEQI;
@@ -388,14 +193,88 @@ enum operation relop_at(ASTNode *node) {
 	}
 }
 
-Adr tac_resolve_boolean(T_S *ts, ASTNode *node) {
+static enum operation arith_op(T_S *ts, ASTNode *node) {
+	switch (node->type) {
+		case NADD:
+			return node->symbol_type == SINT ? O_ADDI : O_ADDF;
+		case NSUB:
+			return node->symbol_type == SINT ? O_SUBI : O_SUBF;
+		case NMUL:
+			return node->symbol_type == SINT ? O_MULI : O_MULF;
+		case NDIV:
+			return node->symbol_type == SINT ? O_DIVI : O_DIVF;
+		case NPOW:
+			return node_right(ts->ast, node)->symbol_type == SINT ? O_POWII : O_POWIF;
+		case NMOD:
+			return O_MOD; // mod is for ints only in CD25
+		default: abort();
+	}
+}
+
+static enum operation bool_op(ASTNode *op) {
+	switch (op->type) {
+		case NAND:
+			return O_AND;
+		case NOR:
+			return O_OR;
+		case NXOR:
+			return O_XOR;
+		default: abort();
+	}
+}
+
+static int is_relop(enum node_type type) {
+	return type == NEQL || type == NNEQ || type == NGRT || type == NLSS || type == NLEQ || type == NGEQ;
+}
+
+// whether the side of a numeric operator or comparison has to be made a float first
+static int promotes(T_S *ts, ASTNode *node, ASTNode *side) {
+	if (side->symbol_type != SINT)
+		return 0;
+	if (node->type == NNOT || is_relop(node->type))
+		return node_left(ts->ast, node)->symbol_type == SREAL || node_right(ts->ast, node)->symbol_type == SREAL;
+	return node->symbol_type == SREAL;
+}
+
+static Adr promote(T_S *ts, ASTNode *node, ASTNode *side, Adr adr) {
+	if (!promotes(ts, node, side))
+		return adr;
+	Adr tmp = mktmp(ts);
+	append_line(ts, binary_line(O_ITOF, tmp, adr, node->row));
+	return tmp;
+}
+
+static void push_pending(T_S *ts, struct pending_expr e) {
+	if (ts->pending_count == ts->pending_cap) {
+		ts->pending_cap = ts->pending_cap ? ts->pending_cap * 2 : 32;
+		ts->pending = realloc(ts->pending, ts->pending_cap * sizeof(struct pending_expr));
+	}
+	ts->pending[ts->pending_count++] = e;
+}
+
+// starts on node, returning 1 with its address in *result if it's done, or 0 having pushed it to wait on its left
+static int tac_resolve_start(T_S *ts, ASTNode *node, int boolean, Adr *result) {
+	if (!boolean) {
+		switch (node->type) {
+			case NADD: case NSUB: case NMUL: case NDIV: case NPOW: case NMOD:
+				// assumption: no numeric has 1 child (correct I think)
+				push_pending(ts, (struct pending_expr){ node, blank(), blank(), 0 });
+				return 0;
+			case NFCALL:
+				*result = tac_gen_fncall(ts, node);
+				return 1;
+			case NARRV:
+				*result = mktmp(ts);
+				append_line(ts, binary_line(O_DEREF, *result, tac_get_adr(ts, node), node->row));
+				return 1;
+			case NFALS: case NTRUE: case NBOOL: case NNOT: case NEQL: case NNEQ: case NGRT: case NGEQ: case NLSS: case NLEQ:
+				break; // what tac_get_adr would do
+			default: // terminal node
+				*result = tac_get_adr(ts, node);
+				return 1;
+		}
+	}
 	Adr tmp = mktmp(ts);
-	Adr not_tmp;
-	enum operation op;
-	Adr lhs;
-	Adr rhs;
-	int promotion = 0;
-	Adr temp;
 	switch (node->type) {
 		case NFALS:
 			append_line(ts, unary_line(O_FALSE, tmp, node->row));
@@ -405,74 +284,74 @@ Adr tac_resolve_boolean(T_S *ts, ASTNode *node) {
 			break;
 		case NSIMV:
 		case NARRV:
-			return tac_get_adr(ts, node);
-		case NNOT:
-			if (node->left_child->symbol_type == SREAL || node->right_child->symbol_type == SREAL) {
-				promotion = 1;
-			}
-			lhs = tac_resolve_numeric(ts, node->left_child);
-			if (promotion && node->left_child->symbol_type == SINT) {
-				temp = mktmp(ts);
-				append_line(ts, binary_line(O_ITOF, temp, lhs, node->row));
-				lhs = temp;
-			}
-			rhs = tac_resolve_numeric(ts, node->right_child);
-			if (promotion && node->right_child->symbol_type == SINT) {
-				temp = mktmp(ts);
-				append_line(ts, binary_line(O_ITOF, temp, rhs, node->row));
-				rhs = temp;
-			}
-			op = relop_at(node->middle_child);
-			append_line(ts, ternary_line(op, tmp, lhs, rhs, node->row));
-			not_tmp = mktmp(ts);
-			append_line(ts, binary_line(O_NOT, not_tmp, tmp, node->row));
-			return not_tmp;
-		case NBOOL:
-			lhs = tac_resolve_boolean(ts, node->left_child);
-			rhs = tac_resolve_boolean(ts, node->right_child);
-			switch (node->middle_child->type) {
-				case NAND:
-					op = O_AND;
-					break;
-				case NOR:
-					op = O_OR;
-					break;
-				case NXOR:
-					op = O_XOR;
-					break;
-				default: abort();
-			}
-			append_line(ts, ternary_line(op, tmp, lhs, rhs, node->row));
+			tmp = tac_get_adr(ts, node);
 			break;
-		case NEQL:
-		case NNEQ:
-		case NGRT:
-		case NLSS:
-		case NLEQ:
-		case NGEQ:
-			if (node->left_child->symbol_type == SREAL || node->right_child->symbol_type == SREAL) {
-				promotion = 1;
+		case NFCALL:
+			tmp = tac_gen_fncall(ts, node);
+			break;
+		case NNOT: case NBOOL: case NEQL: case NNEQ: case NGRT: case NLSS: case NLEQ: case NGEQ:
+			push_pending(ts, (struct pending_expr){ node, tmp, blank(), 0 });
+			return 0;
+		default: abort();
+	}
+	*result = tmp;
+	return 1;
+}
+
+// the address of node's value as a number (boolean = 0) or a boolean, after the lines to work it out
+// operands are done left then right on ts->pending rather than by recursion, so nesting depth costs one
+// pending_expr a level; calls and array indices still recurse through tac_gen_fncall and tac_get_adr
+static Adr tac_resolve(T_S *ts, ASTNode *node, int boolean) {
+	u32 base = ts->pending_count; // tac_gen_fncall and tac_get_adr get here again from further in
+	Adr result;
+	for (;;) {
+		while (!tac_resolve_start(ts, node, boolean, &result)) {
+			node = node_left(ts->ast, node);
+			boolean = ts->pending[ts->pending_count - 1].node->type == NBOOL;
+		}
+		// hand result to the operators waiting on it, until one still needs its right
+		for (;;) {
+			if (ts->pending_count == base)
+				return result;
+			struct pending_expr *e = &ts->pending[ts->pending_count - 1];
+			node = e->node;
+			if (e->stage == 0) {
+				e->lhs = promote(ts, node, node_left(ts->ast, node), result);
+				e->stage = 1;
+				boolean = node->type == NBOOL;
+				node = node_right(ts->ast, node);
+				break;
 			}
-			lhs = tac_resolve_numeric(ts, node->left_child);
-			if (promotion && node->left_child->symbol_type == SINT) {
-				temp = mktmp(ts);
-				append_line(ts, binary_line(O_ITOF, temp, lhs, node->row));
-				lhs = temp;
+			Adr lhs = e->lhs;
+			Adr tmp = e->tmp;
+			ts->pending_count--;
+			if (node->type == NBOOL) {
+				append_line(ts, ternary_line(bool_op(node_middle(ts->ast, node)), tmp, lhs, result, node->row));
+				result = tmp;
+				continue;
 			}
-			rhs = tac_resolve_numeric(ts, node->right_child);
-			if (promotion && node->right_child->symbol_type == SINT) {
-				temp = mktmp(ts);
-				append_line(ts, binary_line(O_ITOF, temp, rhs, node->row));
-				rhs = temp;
+			Adr rhs = promote(ts, node, node_right(ts->ast, node), result);
+			if (node->type == NNOT) {
+				append_line(ts, ternary_line(relop_at(ts, node_middle(ts->ast, node)), tmp, lhs, rhs, node->row));
+				result = mktmp(ts);
+				append_line(ts, binary_line(O_NOT, result, tmp, node->row));
+			} else if (is_relop(node->type)) {
+				append_line(ts, ternary_line(relop_at(ts, node), tmp, lhs, rhs, node->row));
+				result = tmp;
+			} else {
+				result = mktmp(ts);
+				append_line(ts, ternary_line(arith_op(ts, node), result, lhs, rhs, node->row));
 			}
-			op = relop_at(node);
-			append_line(ts, ternary_line(op, tmp, lhs, rhs, node->row));
-			break;
-		case NFCALL:
-			return tac_gen_fncall(ts, node);
-		default: abort();
+		}
 	}
-	return tmp;
+}
+
+Adr tac_resolve_numeric(T_S *ts, ASTNode *node) {
+	return tac_resolve(ts, node, 0);
+}
+
+Adr tac_resolve_boolean(T_S *ts, ASTNode *node) {
+	return tac_resolve(ts, node, 1);
 }
 
 Adr tac_resolve_expr(T_S *ts, ASTNode *node) {
@@ -491,28 +370,23 @@ Adr tac_resolve_expr(T_S *ts, ASTNode *node) {
 	}
 }
 
-static int unscoped_symbol_equals(const Symbol *s1, const Symbol *s2) {
-	return s1->index.start == s2->index.start &&
-	       s1->index.len   == s2->index.len;
-}
-
 // TODO: fix name. this gets values, except for arrays which return pointers
 Adr tac_get_adr(T_S *ts, ASTNode *node) {
 	enum adr_type type;
-	u16 adr;
+	u32 adr;
 	int ival;
 	double fval;
 	Adr tmp0;
 	Adr tmp1;
 	Adr tmp2;
 	Adr array_start;
-	u16 offset;
+	u32 offset;
 	Attribute *array_atr;
 	int struct_size;
 	Symbol globscoped;
 	switch (node->type) {
 		case NSIMV:
-			globscoped = *node->symbol_value;
+			globscoped = *node_symbol(ts->ast, node);
 			globscoped.scope = 0;
 			if (hashmap_get(ts->const_map, &globscoped)) {
 				int val = *(int*)hashmap_get(ts->const_map, &globscoped);
@@ -524,38 +398,36 @@ Adr tac_get_adr(T_S *ts, ASTNode *node) {
 					default: abort();
 				}
 			}
-			if (astree_is_param(ts->ast, node->symbol_value)) {
+			if (astree_is_param(ts->ast, node_symbol(ts->ast, node))) {
 				type = A_PARAM;
 			} else if (node->symbol_type == SARRAY) {
 				type = A_ARRAY;
 			} else {
 				type = A_VAR;
 			}
-			adr = astree_get_offset(ts->ast, node->symbol_value);
+			adr = astree_get_offset(ts->ast, node_symbol(ts->ast, node));
 			return mkadr(type, adr);
 			break;
 		case NILIT:
-			ival = sym_to_int(ts->ast, node->symbol_value);
+			ival = (int)node->lit.i;
 			return adr_of_int(ts, ival);
 		case NFLIT:
-			fval = sym_to_double(ts->ast, node->symbol_value);
+			fval = node->lit.f;
 			return adr_of_double(ts, fval);
 		case NADD: case NSUB: case NMUL: case NDIV: case NMOD: case NPOW:
 			return tac_resolve_numeric(ts, node);
 		case NFALS: case NTRUE: case NBOOL: case NNOT: case NEQL: case NNEQ: case NGRT: case NGEQ: case NLSS: case NLEQ:
 			return tac_resolve_boolean(ts, node);
 		case NARRV:
-			array_atr = astree_get_attribute(ts->ast, node->left_child->symbol_value);
-			offset = astree_get_offset(ts->ast, node->left_child->symbol_value);
+			array_atr = astree_get_attribute(ts->ast, node_symbol(ts->ast, node_left(ts->ast, node)));
+			offset = astree_get_offset(ts->ast, node_symbol(ts->ast, node_left(ts->ast, node)));
 			if (array_atr->is_param) {
 				type = A_PARAM;
 			} else {
 				type = A_ARRAY;
 			}
 			array_start = mkadr(type, offset);
-			Adr index = tac_resolve_numeric(ts, node->right_child);
-			// todo: why is the scope of that not 0? it's written as 0
-			((Symbol*)array_atr->data)->scope = 0;
+			Adr index = tac_resolve_numeric(ts, node_right(ts->ast, node));
 			struct_size = *(int*)hashmap_get(ts->array_structsize_map, array_atr->data);
 			tmp0 = mktmp(ts);
 			append_line(ts, ternary_line(O_MULI, tmp0, index, adr_of_int(ts, struct_size), node->row));
@@ -565,13 +437,13 @@ Adr tac_get_adr(T_S *ts, ASTNode *node) {
 			Attribute *struct_atr = astree_get_attribute(ts->ast, array_atr->data);
 			Attribute *struct_fields = astree_get_attribute(ts->ast, struct_atr->data);
 			LinkedList *elements = (LinkedList *)struct_fields->data;
-			linkedlist_start(elements);
-			Symbol *target_element = node->symbol_value;
+			LLIter it = linkedlist_iter(elements);
+			Symbol *target_element = node_symbol(ts->ast, node);
 			while (!unscoped_symbol_equals(
-				((Element*)linkedlist_get_current(elements))->name,
+				((Element*)lliter_get(it))->name,
 				target_element
 			) ) {
-				linkedlist_forward(elements);
+				lliter_next(&it);
 				struct_offset += 8;
 			}
 			Adr withinstruct = adr_of_int(ts, struct_offset);
@@ -585,8 +457,8 @@ Adr tac_get_adr(T_S *ts, ASTNode *node) {
 			/* return tmp3; */
 			break;
 		case NAELT:
-			array_atr = astree_get_attribute(ts->ast, node->left_child->symbol_value);
-			offset = astree_get_offset(ts->ast, node->left_child->symbol_value);
+			array_atr = astree_get_attribute(ts->ast, node_symbol(ts->ast, node_left(ts->ast, node)));
+			offset = astree_get_offset(ts->ast, node_symbol(ts->ast, node_left(ts->ast, node)));
 			if (array_atr->is_param) {
 				type = A_PARAM;
 			} else {
@@ -595,7 +467,7 @@ Adr tac_get_adr(T_S *ts, ASTNode *node) {
 			array_start = mkadr(type, offset);
 			// TODO: study how the next line breaks the whole program (tmp0 unitialised)
 			/* append_line(ts, binary_line(O_ASIGN, tmp0, array_start, node->row)); */
-			Adr diff = tac_resolve_numeric(ts, node->right_child);
+			Adr diff = tac_resolve_numeric(ts, node_right(ts->ast, node));
 			Adr muldiff = mktmp(ts);
 			struct_size = *(int*)hashmap_get(ts->array_structsize_map, array_atr->data);
 			append_line(ts, ternary_line(O_MULI, muldiff, diff, adr_of_int(ts, struct_size), node->row));
@@ -610,23 +482,23 @@ Adr tac_get_adr(T_S *ts, ASTNode *node) {
 
 void tac_gen_plist(T_S *ts, ASTNode *node) {
 	// TODO: this could be in parser
-	u16 num_vars = 0;
+	u32 num_vars = 0;
 	while (node->type == NPLIST) {
-		if (node->left_child->type == NARRC) {
-			astree_set_offset(ts->ast, node->left_child->left_child->symbol_value, num_vars++);
-			astree_mark_param(ts->ast, node->left_child->left_child->symbol_value);
+		if (node_left(ts->ast, node)->type == NARRC) {
+			astree_set_offset(ts->ast, node_symbol(ts->ast, node_left(ts->ast, node_left(ts->ast, node))), num_vars++);
+			astree_mark_param(ts->ast, node_symbol(ts->ast, node_left(ts->ast, node_left(ts->ast, node))));
 		} else {
-			astree_set_offset(ts->ast, node->left_child->symbol_value, num_vars++);
-			astree_mark_param(ts->ast, node->left_child->symbol_value);
+			astree_set_offset(ts->ast, node_symbol(ts->ast, node_left(ts->ast, node)), num_vars++);
+			astree_mark_param(ts->ast, node_symbol(ts->ast, node_left(ts->ast, node)));
 		}
-		node = node->right_child;
+		node = node_right(ts->ast, node);
 	}
-	if (node->left_child && node->left_child->type == NARRC) {
-		astree_set_offset(ts->ast, node->left_child->left_child->symbol_value, num_vars++);
-		astree_mark_param(ts->ast, node->left_child->left_child->symbol_value);
+	if (node_left(ts->ast, node) && node_left(ts->ast, node)->type == NARRC) {
+		astree_set_offset(ts->ast, node_symbol(ts->ast, node_left(ts->ast, node_left(ts->ast, node))), num_vars++);
+		astree_mark_param(ts->ast, node_symbol(ts->ast, node_left(ts->ast, node_left(ts->ast, node))));
 	} else {
-		astree_set_offset(ts->ast, node->symbol_value, num_vars++);
-		astree_mark_param(ts->ast, node->symbol_value);
+		astree_set_offset(ts->ast, node_symbol(ts->ast, node), num_vars++);
+		astree_mark_param(ts->ast, node_symbol(ts->ast, node));
 	}
 }
 
@@ -635,36 +507,36 @@ void tac_gen_func_locals(T_S *ts, ASTNode *node) {
 	int num_vars = 0;
 	ASTNode *cursor = node;
 	while (cursor->type == NDLIST) {
-		astree_set_offset(ts->ast, cursor->left_child->symbol_value, num_vars++);
-		cursor = cursor->right_child;
+		astree_set_offset(ts->ast, node_symbol(ts->ast, node_left(ts->ast, cursor)), num_vars++);
+		cursor = node_right(ts->ast, cursor);
 	}
 	// somehow cursor->symbol_vaue is null???
-	astree_set_offset(ts->ast, cursor->symbol_value, num_vars++);
+	astree_set_offset(ts->ast, node_symbol(ts->ast, cursor), num_vars++);
 	/* Adr vars_num_adr = adr_of_int(ts, num_vars); */
 	/* append_line(ts, unary_line(O_ALLOC, vars_num_adr)); */
 	cursor = node;
 	while (cursor->type == NDLIST) {
-		tac_gen_sdecl(ts, cursor->left_child); // technically this is _decl, but identical code
-		cursor = cursor->right_child;
+		tac_gen_sdecl(ts, node_left(ts->ast, cursor)); // technically this is _decl, but identical code
+		cursor = node_right(ts->ast, cursor);
 	}
 	tac_gen_sdecl(ts, cursor);
 }
 
 void tac_gen_func(T_S *ts, ASTNode* nfuncs) {
-	Adr fname = adr_of_sds(ts, sds_from_symbol(ts->ast, nfuncs->symbol_value));
+	Adr fname = adr_of_string(ts, node_symbol(ts->ast, nfuncs)->id);
 	append_line(ts, unary_line(O_FUNC, fname, 0));
-	tac_gen_plist(ts, nfuncs->left_child);
-	tac_gen_func_locals(ts, nfuncs->middle_child);
-	tac_gen_stats(ts, nfuncs->right_child);
+	tac_gen_plist(ts, node_left(ts->ast, nfuncs));
+	tac_gen_func_locals(ts, node_middle(ts->ast, nfuncs));
+	tac_gen_stats(ts, node_right(ts->ast, nfuncs));
 	// reset these counters to keep temp reg's local
 	ts->temp_reg_counter = 0;
 }
 
 void tac_gen_funcs(T_S *ts, ASTNode *nfuncs) {
 	if (!nfuncs) return;
-	while (nfuncs && nfuncs->left_child) {
-		tac_gen_func(ts, nfuncs->left_child);
-		nfuncs = nfuncs->right_child;
+	while (nfuncs && node_left(ts->ast, nfuncs)) {
+		tac_gen_func(ts, node_left(ts->ast, nfuncs));
+		nfuncs = node_right(ts->ast, nfuncs);
 	}
 	if (nfuncs) {
 		tac_gen_func(ts, nfuncs);
@@ -672,32 +544,32 @@ void tac_gen_funcs(T_S *ts, ASTNode *nfuncs) {
 }
 
 void tac_gen_nasgn(T_S *ts, ASTNode *node) {
-	Adr lhs = tac_get_adr(ts, node->left_child);
+	Adr lhs = tac_get_adr(ts, node_left(ts->ast, node));
 	Adr rhs;
 	Attribute *array_atr;
-	switch (node->right_child->symbol_type) {
+	switch (node_right(ts->ast, node)->symbol_type) {
 		case SINT:
 		case SREAL:
-			rhs = tac_resolve_numeric(ts, node->right_child);
-			if (node->left_child->type == NARRV) {
+			rhs = tac_resolve_numeric(ts, node_right(ts->ast, node));
+			if (node_left(ts->ast, node)->type == NARRV) {
 				append_line(ts, binary_line(O_STORE, lhs, rhs, node->row));
 			} else {
 				append_line(ts, binary_line(O_ASIGN, lhs, rhs, node->row));
 			}
 			break;
 		case SBOOL:
-			rhs = tac_resolve_boolean(ts, node->right_child);
-			if (node->left_child->type == NARRV) {
+			rhs = tac_resolve_boolean(ts, node_right(ts->ast, node));
+			if (node_left(ts->ast, node)->type == NARRV) {
 				append_line(ts, binary_line(O_STORE, lhs, rhs, node->row));
 			} else {
 				append_line(ts, binary_line(O_ASIGN, lhs, rhs, node->row));
 			}
 			break;
 		case SARRAY:
-			array_atr = astree_get_attribute(ts->ast, node->left_child->symbol_value);
+			array_atr = astree_get_attribute(ts->ast, node_symbol(ts->ast, node_left(ts->ast, node)));
 			int array_size = *(int*)hashmap_get(ts->array_len_map, array_atr->data);
 			// todo: inline loop with labels?
-			rhs = tac_get_adr(ts, node->right_child);
+			rhs = tac_get_adr(ts, node_right(ts->ast, node));
 			for (int i = 0; i < array_size; ++i) {
 				Adr tmp0 = mktmp(ts);
 				append_line(ts, ternary_line(O_ADDI, tmp0, lhs, adr_of_int(ts, i*8), node->row));
@@ -709,10 +581,10 @@ void tac_gen_nasgn(T_S *ts, ASTNode *node) {
 			}
 			break;
 		case SSTRUCT:
-			array_atr = astree_get_attribute(ts->ast, node->left_child->left_child->symbol_value);
+			array_atr = astree_get_attribute(ts->ast, node_symbol(ts->ast, node_left(ts->ast, node_left(ts->ast, node))));
 			int struct_size = *(int*)hashmap_get(ts->array_structsize_map, array_atr->data);
 			// todo: inline loop with labels?
-			rhs = tac_get_adr(ts, node->right_child);
+			rhs = tac_get_adr(ts, node_right(ts->ast, node));
 			for (int i = 0; i < struct_size; i += 8) {
 				Adr tmp0 = mktmp(ts);
 				append_line(ts, ternary_line(O_ADDI, tmp0, lhs, adr_of_int(ts, i), node->row));
@@ -728,34 +600,34 @@ void tac_gen_nasgn(T_S *ts, ASTNode *node) {
 }
 
 void tac_gen_nasgnop(T_S *ts, ASTNode *node) {
-	Adr lhs = tac_get_adr(ts, node->left_child);
+	Adr lhs = tac_get_adr(ts, node_left(ts->ast, node));
 	enum operation op;
-	Adr rhs = tac_resolve_numeric(ts, node->right_child);
+	Adr rhs = tac_resolve_numeric(ts, node_right(ts->ast, node));
 	int promote_right = 0;
 	switch (node->type) {
 		case NPLEQ:
-			if (node->left_child->symbol_type == SINT) {
+			if (node_left(ts->ast, node)->symbol_type == SINT) {
 				op = O_ADDI;
 			} else {
 				op = O_ADDF;
 			}
 			break;
 		case NMNEQ:
-			if (node->left_child->symbol_type == SINT) {
+			if (node_left(ts->ast, node)->symbol_type == SINT) {
 				op = O_SUBI;
 			} else {
 				op = O_SUBF;
 			}
 			break;
 		case NSTEA:
-			if (node->left_child->symbol_type == SINT) {
+			if (node_left(ts->ast, node)->symbol_type == SINT) {
 				op = O_MULI;
 			} else {
 				op = O_MULF;
 			}
 			break;
 		case NDVEQ:
-			if (node->left_child->symbol_type == SINT) {
+			if (node_left(ts->ast, node)->symbol_type == SINT) {
 				op = O_DIVI;
 			} else {
 				op = O_DIVF;
@@ -763,8 +635,8 @@ void tac_gen_nasgnop(T_S *ts, ASTNode *node) {
 			break;
 		default: abort();
 	}
-	if (node->left_child->symbol_type == SREAL) {
-		if (node->right_child->symbol_type == SINT) {
+	if (node_left(ts->ast, node)->symbol_type == SREAL) {
+		if (node_right(ts->ast, node)->symbol_type == SINT) {
 			promote_right = 1;
 		}
 	}
@@ -773,7 +645,7 @@ void tac_gen_nasgnop(T_S *ts, ASTNode *node) {
 		append_line(ts, binary_line(O_ITOF, tmp, rhs, node->row));
 		rhs = tmp;
 	}
-	if (node->left_child->type == NAELT) {
+	if (node_left(ts->ast, node)->type == NAELT) {
 		Adr t1 = mktmp(ts);
 		append_line(ts, binary_line(O_DEREF, t1, lhs, node->row));
 		Adr t2 = mktmp(ts);
@@ -787,57 +659,75 @@ void tac_gen_nasgnop(T_S *ts, ASTNode *node) {
 void tac_gen_asgnlist(T_S *ts, ASTNode *node) {
 	if (!node)
 		return;
-	if (node->type == NASGNS) {
-		tac_gen_nasgn(ts, node->left_child);
-		tac_gen_asgnlist(ts, node->right_child);
-	}
+	for (; node->type == NASGNS; node = node_right(ts->ast, node))
+		tac_gen_nasgn(ts, node_left(ts->ast, node));
 	tac_gen_nasgn(ts, node);
 }
 
-void tac_gen_if(T_S *ts, ASTNode *node) {
+// what's left to do of the statements being generated, the next thing last
+typedef struct tac_work {
+	enum { W_STATS, W_LABEL, W_GOTO, W_UNTIL } what;
+	ASTNode *node; // the statements for W_STATS, the repeat for W_UNTIL
+	Adr label;
+} TacWork;
+
+typedef struct tac_work_stack {
+	TacWork *items;
+	u32 count, cap;
+} TacWorkStack;
+
+static void push_work(TacWorkStack *w, int what, ASTNode *node, Adr label) {
+	if (w->count == w->cap) {
+		w->cap = w->cap ? w->cap * 2 : 16;
+		w->items = realloc(w->items, w->cap * sizeof(TacWork));
+	}
+	w->items[w->count++] = (TacWork){ what, node, label };
+}
+
+// the block statements emit up to their statements, and leave what comes after on w
+void tac_gen_if(T_S *ts, ASTNode *node, TacWorkStack *w) {
 	Adr label = mklabel(ts);
-	Adr cond = tac_resolve_boolean(ts, node->left_child);
+	Adr cond = tac_resolve_boolean(ts, node_left(ts->ast, node));
 	append_line(ts, binary_line(O_GOTOF, label, cond, 0));
-	tac_gen_stats(ts, node->right_child);
-	append_line(ts, unary_line(O_LABEL, label, 0));
+	push_work(w, W_LABEL, NULL, label);
+	push_work(w, W_STATS, node_right(ts->ast, node), blank());
 }
 
-void tac_gen_ifelse(T_S *ts, ASTNode *node) {
+void tac_gen_ifelse(T_S *ts, ASTNode *node, TacWorkStack *w) {
 	Adr truelabel = mklabel(ts);
 	Adr falselabel = mklabel(ts);
-	Adr cond = tac_resolve_boolean(ts, node->left_child);
+	Adr cond = tac_resolve_boolean(ts, node_left(ts->ast, node));
 	append_line(ts, binary_line(O_GOTOF, falselabel, cond, 0));
-	tac_gen_stats(ts, node->middle_child);
-	append_line(ts, unary_line(O_GOTO, truelabel, 0));
-	append_line(ts, unary_line(O_LABEL, falselabel, 0));
-	tac_gen_stats(ts, node->right_child);
-	append_line(ts, unary_line(O_LABEL, truelabel, 0));
+	push_work(w, W_LABEL, NULL, truelabel);
+	push_work(w, W_STATS, node_right(ts->ast, node), blank());
+	push_work(w, W_LABEL, NULL, falselabel);
+	push_work(w, W_GOTO, NULL, truelabel);
+	push_work(w, W_STATS, node_middle(ts->ast, node), blank());
 }
 
-void tac_gen_for(T_S *ts, ASTNode *node) {
-	tac_gen_asgnlist(ts, node->left_child);
+void tac_gen_for(T_S *ts, ASTNode *node, TacWorkStack *w) {
+	tac_gen_asgnlist(ts, node_left(ts->ast, node));
 	Adr start = mklabel(ts);
 	Adr end = mklabel(ts);
 	append_line(ts, unary_line(O_LABEL, start, 0));
-	Adr cond = tac_resolve_boolean(ts, node->middle_child);
+	Adr cond = tac_resolve_boolean(ts, node_middle(ts->ast, node));
 	append_line(ts, binary_line(O_GOTOF, end, cond, 0));
-	tac_gen_stats(ts, node->right_child);
-	append_line(ts, unary_line(O_GOTO, start, 0));
-	append_line(ts, unary_line(O_LABEL, end, 0));
+	push_work(w, W_LABEL, NULL, end);
+	push_work(w, W_GOTO, NULL, start);
+	push_work(w, W_STATS, node_right(ts->ast, node), blank());
 }
 
-void tac_gen_repeat(T_S *ts, ASTNode *node) {
-	tac_gen_asgnlist(ts, node->left_child);
+void tac_gen_repeat(T_S *ts, ASTNode *node, TacWorkStack *w) {
+	tac_gen_asgnlist(ts, node_left(ts->ast, node));
 	Adr start = mklabel(ts);
 	append_line(ts, unary_line(O_LABEL, start, 0));
-	tac_gen_stats(ts, node->middle_child);
-	Adr cond = tac_resolve_boolean(ts, node->right_child);
-	append_line(ts, binary_line(O_GOTOF, start, cond, 0));
+	push_work(w, W_UNTIL, node, start);
+	push_work(w, W_STATS, node_middle(ts->ast, node), blank());
 }
 
 void tac_gen_printitem(T_S*ts, ASTNode *node) {
 	if (node->type == NSTRG) {
-		Adr str_adr = adr_of_sds(ts, sds_from_symbol(ts->ast, node->symbol_value));
+		Adr str_adr = adr_of_string(ts, node_symbol(ts->ast, node)->id);
 		append_line(ts, unary_line(O_PRINTSTR, str_adr, node->row));
 	} else {
 		/* Adr space = adr_of_sds(ts, sdsnew(" ")); */
@@ -862,24 +752,21 @@ void tac_gen_printitem(T_S*ts, ASTNode *node) {
 }
 
 void tac_gen_prlist(T_S *ts, ASTNode *node) {
-	if (node->type == NPRLST) {
-		tac_gen_printitem(ts, node->left_child);
-		tac_gen_prlist(ts, node->right_child);
-	} else {
-		tac_gen_printitem(ts, node);
-	}
+	for (; node->type == NPRLST; node = node_right(ts->ast, node))
+		tac_gen_printitem(ts, node_left(ts->ast, node));
+	tac_gen_printitem(ts, node);
 }
 
 void tac_gen_noutp(T_S *ts, ASTNode *node) {
-	tac_gen_prlist(ts, node->left_child);
+	tac_gen_prlist(ts, node_left(ts->ast, node));
 }
 
 void tac_gen_noutl(T_S *ts, ASTNode *node) {
-	if (!node->left_child) {
+	if (!node_left(ts->ast, node)) {
 		append_line(ts, nonary_line(O_PRINTLN, node->row));
 		return;
 	}
-	tac_gen_prlist(ts, node->left_child);
+	tac_gen_prlist(ts, node_left(ts->ast, node));
 	append_line(ts, nonary_line(O_PRINTLN, node->row));
 }
 
@@ -903,24 +790,21 @@ void tac_gen_input_var(T_S *ts, ASTNode *node) {
 }
 
 void tac_gen_nvlist(T_S *ts, ASTNode *node) {
-	if (node->type == NVLIST) {
-		tac_gen_input_var(ts, node->left_child);
-		tac_gen_nvlist(ts, node->right_child);
-	} else {
-		tac_gen_input_var(ts, node);
-	}
+	for (; node->type == NVLIST; node = node_right(ts->ast, node))
+		tac_gen_input_var(ts, node_left(ts->ast, node));
+	tac_gen_input_var(ts, node);
 }
 
 void tac_gen_ninput(T_S *ts, ASTNode *node) {
-	tac_gen_nvlist(ts, node->left_child);
+	tac_gen_nvlist(ts, node_left(ts->ast, node));
 }
 
-void tac_gen_parameters(T_S *ts, ASTNode *node, u16 *paramcount) {
+void tac_gen_parameters(T_S *ts, ASTNode *node, u32 *paramcount) {
 	if (!node) return;
 	if (node->type == NEXPL) {
-		Adr par = tac_resolve_expr(ts, node->left_child);
+		Adr par = tac_resolve_expr(ts, node_left(ts->ast, node));
 		(*paramcount)++;
-		tac_gen_parameters(ts, node->right_child, paramcount);
+		tac_gen_parameters(ts, node_right(ts->ast, node), paramcount);
 		append_line(ts, unary_line(O_PARAM, par, node->row));
 	} else {
 		Adr par = tac_resolve_expr(ts, node);
@@ -930,33 +814,33 @@ void tac_gen_parameters(T_S *ts, ASTNode *node, u16 *paramcount) {
 }
 
 void tac_gen_callstat(T_S *ts, ASTNode *node) {
-	u16 paramcount = 0;
-	tac_gen_parameters(ts, node->left_child, &paramcount);
+	u32 paramcount = 0;
+	tac_gen_parameters(ts, node_left(ts->ast, node), &paramcount);
 	Adr pcount = adr_of_int(ts, paramcount);
-	Adr fname = adr_of_sds(ts, sds_from_symbol(ts->ast, node->symbol_value));
+	Adr fname = adr_of_string(ts, node_symbol(ts->ast, node)->id);
 	append_line(ts, binary_line(O_CALL, fname, pcount, node->row));
 }
 
 Adr tac_gen_fncall(T_S *ts, ASTNode *node) {
 	Adr tmp = mktmp(ts);
-	u16 paramcount = 0;
-	tac_gen_parameters(ts, node->left_child, &paramcount);
+	u32 paramcount = 0;
+	tac_gen_parameters(ts, node_left(ts->ast, node), &paramcount);
 	Adr pcount = adr_of_int(ts, paramcount);
-	Adr fname = adr_of_sds(ts, sds_from_symbol(ts->ast, node->symbol_value));
+	Adr fname = adr_of_string(ts, node_symbol(ts->ast, node)->id);
 	append_line(ts, ternary_line(O_CALLVAL, tmp, fname, pcount, node->row));
 	return tmp;
 }
 
 void tac_gen_returnstat(T_S *ts, ASTNode *node) {
-	if (node->left_child) {
-		Adr radr = tac_resolve_expr(ts, node->left_child);
+	if (node_left(ts->ast, node)) {
+		Adr radr = tac_resolve_expr(ts, node_left(ts->ast, node));
 		append_line(ts, unary_line(O_RVAL, radr, node->row));
 	} else {
 		append_line(ts, nonary_line(O_RETN, node->row));
 	}
 }
 
-void tac_gen_stat(T_S *ts, ASTNode *node) {
+void tac_gen_stat(T_S *ts, ASTNode *node, TacWorkStack *w) {
 	switch (node->type) {
 		case NOUTP:
 			tac_gen_noutp(ts, node);
@@ -968,16 +852,16 @@ void tac_gen_stat(T_S *ts, ASTNode *node) {
 			tac_gen_ninput(ts, node);
 			break;
 		case NIFTH:
-			tac_gen_if(ts, node);
+			tac_gen_if(ts, node, w);
 			break;
 		case NIFTE:
-			tac_gen_ifelse(ts, node);
+			tac_gen_ifelse(ts, node, w);
 			break;
 		case NREPT:
-			tac_gen_repeat(ts, node);
+			tac_gen_repeat(ts, node, w);
 			break;
 		case NFORL:
-			tac_gen_for(ts, node);
+			tac_gen_for(ts, node, w);
 			break;
 		case NASGN:
 			tac_gen_nasgn(ts, node);
@@ -998,15 +882,37 @@ void tac_gen_stat(T_S *ts, ASTNode *node) {
 	}
 }
 
+// nested blocks go on a work stack rather than the C stack
 void tac_gen_stats(T_S *ts, ASTNode *node) {
-	if (node->type == NSTATS) {
-		tac_gen_stat(ts, node->left_child);
-		if (node->right_child) {
-			tac_gen_stats(ts, node->right_child);
+	TacWorkStack w = { 0 };
+	push_work(&w, W_STATS, node, blank());
+	while (w.count) {
+		TacWork next = w.items[--w.count];
+		switch (next.what) {
+			case W_STATS:
+				node = next.node;
+				if (node->type != NSTATS) {
+					tac_gen_stat(ts, node, &w);
+					break;
+				}
+				if (node_right(ts->ast, node))
+					push_work(&w, W_STATS, node_right(ts->ast, node), blank());
+				tac_gen_stat(ts, node_left(ts->ast, node), &w);
+				break;
+			case W_LABEL:
+				append_line(ts, unary_line(O_LABEL, next.label, 0));
+				break;
+			case W_GOTO:
+				append_line(ts, unary_line(O_GOTO, next.label, 0));
+				break;
+			case W_UNTIL: {
+				Adr cond = tac_resolve_boolean(ts, node_right(ts->ast, next.node));
+				append_line(ts, binary_line(O_GOTOF, next.label, cond, 0));
+				break;
+			}
 		}
-	} else {
-		tac_gen_stat(ts, node);
 	}
+	free(w.items);
 }
 
 // set local variables to 0
@@ -1014,15 +920,15 @@ void tac_gen_sdecl(T_S *ts, ASTNode *node) {
 	int offset;
 	switch (node->symbol_type) {
 		case SREAL:
-			offset = astree_get_offset(ts->ast, node->symbol_value);
+			offset = astree_get_offset(ts->ast, node_symbol(ts->ast, node));
 			append_line(ts, binary_line(O_ASIGN, mkadr(A_VAR, offset), adr_of_double(ts, 0.0), 0));
 			break;
 		case SINT:
-			offset = astree_get_offset(ts->ast, node->symbol_value);
+			offset = astree_get_offset(ts->ast, node_symbol(ts->ast, node));
 			append_line(ts, binary_line(O_ASIGN, mkadr(A_VAR, offset), adr_of_int(ts, 0), 0));
 			break;
 		case SBOOL: // assumption: uninitialised booleans are false
-			offset = astree_get_offset(ts->ast, node->symbol_value);
+			offset = astree_get_offset(ts->ast, node_symbol(ts->ast, node));
 			append_line(ts, unary_line(O_FALSE, mkadr(A_VAR, offset), 0));
 			break;
 		default: abort();
@@ -1033,88 +939,82 @@ void tac_gen_slist(T_S *ts, ASTNode *node) {
 	int num_vars = 0;
 	ASTNode *cursor = node;
 	while (cursor->type == NSDLST) {
-		astree_set_offset(ts->ast, cursor->left_child->symbol_value, num_vars++);
-		cursor = cursor->right_child;
+		astree_set_offset(ts->ast, node_symbol(ts->ast, node_left(ts->ast, cursor)), num_vars++);
+		cursor = node_right(ts->ast, cursor);
 	}
-	astree_set_offset(ts->ast, cursor->symbol_value, num_vars++);
+	astree_set_offset(ts->ast, node_symbol(ts->ast, cursor), num_vars++);
 	/* Adr vars_num_adr = adr_of_int(ts, num_vars); */
 	/* append_line(ts, unary_line(O_ALLOC, vars_num_adr)); */
 	cursor = node;
 	while (cursor->type == NSDLST) {
-		tac_gen_sdecl(ts, cursor->left_child);
-		cursor = cursor->right_child;
+		tac_gen_sdecl(ts, node_left(ts->ast, cursor));
+		cursor = node_right(ts->ast, cursor);
 	}
 	tac_gen_sdecl(ts, cursor);
 }
 
 void tac_gen_main(T_S *ts, ASTNode *nmain) {
-	tac_gen_slist(ts, nmain->left_child);
-	tac_gen_stats(ts, nmain->right_child);
+	tac_gen_slist(ts, node_left(ts->ast, nmain));
+	tac_gen_stats(ts, node_right(ts->ast, nmain));
 }
 
-void sdsfree_wrapper_unary(void *ptr) {
-	sdsfree((sds)ptr);
+static void free_noop(void *ptr) {
+	(void)ptr; // the table's symbols, not the map's
 }
 
 void t_s_free(T_S *ts) {
-	hashmap_free(ts->seen_intvals, free, free);
-	hashmap_free(ts->seen_floatvals, free, free);
-	hashmap_free(ts->seen_strings, sdsfree_wrapper_unary, free);
+	u64map_free(ts->int_adrs);
+	u64map_free(ts->float_adrs);
+	free(ts->string_adrs);
+	hashmap_free(ts->array_len_map, free_noop, free);
+	hashmap_free(ts->array_structsize_map, free_noop, free);
+	hashmap_free(ts->const_map, free_noop, free);
+	free(ts->pending);
+	free(ts);
 }
 
 void tac_gen_init(T_S *ts, ASTNode* node) {
-	if (node->left_child->type != NILIT && node->left_child->type != NFLIT) {
+	if (node_left(ts->ast, node)->type != NILIT && node_left(ts->ast, node)->type != NFLIT) {
 		// todo: put constexpr here (nontrivial because int is not symbol)
 		printf("sorry, only integer/float literals are implemented as constants\n");
 		return;
 	}
-	if (node->left_child->type == NILIT) {
-		sds s = sds_from_symbol(ts->ast, node->left_child->symbol_value);
-		long val = atol(s);
-		linkedlist_push_tail(ts->tac->ints, heap_long(val));
+	if (node_left(ts->ast, node)->type == NILIT) {
+		long val = node_left(ts->ast, node)->lit.i;
+		append_int(ts, val);
 		/* astree_set_offset(ts->ast, node->symbol_value, ts->int_counter++); */
-		hashmap_add(ts->const_map, node->symbol_value, heap_int(ts->int_counter++));
+		hashmap_add(ts->const_map, node_symbol(ts->ast, node), heap_int(ts->int_counter++));
 	}
-	if (node->left_child->type == NFLIT) {
-		sds s = sds_from_symbol(ts->ast, node->left_child->symbol_value);
-		double val = atof(s);
-		linkedlist_push_tail(ts->tac->ints, heap_double(val));
+	if (node_left(ts->ast, node)->type == NFLIT) {
+		double val = node_left(ts->ast, node)->lit.f;
+		append_float(ts, val);
 		/* astree_set_offset(ts->ast, node->symbol_value, ts->float_counter++); */
-		hashmap_add(ts->const_map, node->symbol_value, heap_int(ts->float_counter++));
+		hashmap_add(ts->const_map, node_symbol(ts->ast, node), heap_int(ts->float_counter++));
 	}
 }
 
 void tac_gen_consts(T_S *ts, ASTNode* node) {
 	if (!node) return;
 	while (node->type == NILIST) {
-		tac_gen_init(ts, node->left_child);
-		node = node->right_child;
+		tac_gen_init(ts, node_left(ts->ast, node));
+		node = node_right(ts->ast, node);
 	}
 	tac_gen_init(ts, node);
 }
 
 // TODO: constfloat
 int tac_gen_constint(T_S *ts, ASTNode* node) {
-	sds glyph;
-	int result;
 	int offset;
 	switch (node->type) {
 		case NILIT:
-			glyph = sds_from_symbol(ts->ast, node->symbol_value);
-			result = atoi(glyph);
-			sdsfree(glyph);
-			return result;
+			return (int)node->lit.i;
 		case NSIMV:
-			offset = *(int*)hashmap_get(ts->const_map, node->symbol_value);
-			linkedlist_start(ts->tac->ints);
-			for (int i = 0; i < offset; ++i) {
-				linkedlist_forward(ts->tac->ints);
-			}
-			return *(int*)linkedlist_get_current(ts->tac->ints);
+			offset = *(int*)hashmap_get(ts->const_map, node_symbol(ts->ast, node));
+			return (int)*(long*)tac_data(ts->tac, mkadr(A_ILIT, offset));
 		default: abort();
 	}
-	int lhs = tac_gen_constint(ts, node->left_child);
-	int rhs = tac_gen_constint(ts, node->right_child);
+	int lhs = tac_gen_constint(ts, node_left(ts->ast, node));
+	int rhs = tac_gen_constint(ts, node_right(ts->ast, node));
 	switch (node->type) {
 		case NADD:
 			return lhs + rhs;
@@ -1131,21 +1031,21 @@ int tac_gen_constint(T_S *ts, ASTNode* node) {
 }
 
 void tac_gen_arrtype(T_S *ts, ASTNode *node) {
-	Attribute *struct_atr = astree_get_attribute(ts->ast, node->symbol_value);
+	Attribute *struct_atr = astree_get_attribute(ts->ast, node_symbol(ts->ast, node));
 	Attribute *struct_fields = astree_get_attribute(ts->ast, struct_atr->data);
 	LinkedList *elements = (LinkedList *)struct_fields->data;
 	int structsize = 8 * linkedlist_len(elements);
-	int len = structsize * tac_gen_constint(ts, node->left_child);
-	hashmap_add(ts->array_len_map, node->symbol_value, heap_int(len));
-	hashmap_add(ts->array_structsize_map, node->symbol_value, heap_int(structsize));
+	int len = structsize * tac_gen_constint(ts, node_left(ts->ast, node));
+	hashmap_add(ts->array_len_map, node_symbol(ts->ast, node), heap_int(len));
+	hashmap_add(ts->array_structsize_map, node_symbol(ts->ast, node), heap_int(structsize));
 }
 
 void tac_gen_types(T_S *ts, ASTNode *node) {
 	if (!node) return;
 	while (node->type == NTYPEL) {
 		if (node->type == NATYPE)
-			tac_gen_arrtype(ts, node->left_child);
-		node = node->right_child;
+			tac_gen_arrtype(ts, node_left(ts->ast, node));
+		node = node_right(ts->ast, node);
 	}
 	if (node->type == NATYPE)
 		tac_gen_arrtype(ts, node);
@@ -1153,51 +1053,50 @@ void tac_gen_types(T_S *ts, ASTNode *node) {
 
 void tac_gen_array(T_S *ts, ASTNode *node) {
 	if (!node) return;
-	Attribute *atr = astree_get_attribute(ts->ast, node->symbol_value);
-	u16 arr_offset = ts->array_counter++;
-	astree_set_offset(ts->ast, node->symbol_value, arr_offset);
+	Attribute *atr = astree_get_attribute(ts->ast, node_symbol(ts->ast, node));
+	u32 arr_offset = ts->array_counter++;
+	astree_set_offset(ts->ast, node_symbol(ts->ast, node), arr_offset);
 	int len = * (int*)hashmap_get(ts->array_len_map, atr->data);
-	linkedlist_push_tail(ts->tac->arrays, heap_int(len));
+	vector_push(ts->tac->arrays, &len);
 }
 
 void tac_gen_arrays(T_S *ts, ASTNode *node) {
 	if (!node) return;
 	while (node->type == NALIST) {
-		tac_gen_array(ts, node->left_child);
-		node = node->right_child;
+		tac_gen_array(ts, node_left(ts->ast, node));
+		node = node_right(ts->ast, node);
 	}
 	tac_gen_array(ts, node);
 }
 
 void tac_gen_globals(T_S *ts, ASTNode* nglobs) {
 	if (!nglobs) return;
-	tac_gen_consts(ts, nglobs->left_child);
-	tac_gen_types(ts, nglobs->middle_child);
-	tac_gen_arrays(ts, nglobs->right_child);
+	tac_gen_consts(ts, node_left(ts->ast, nglobs));
+	tac_gen_types(ts, node_middle(ts->ast, nglobs));
+	tac_gen_arrays(ts, node_right(ts->ast, nglobs));
 }
 
 TAC *tac_from_ast(ASTree *ast) {
 	TAC *tac = tac_create();
+	u32 main_id = stringpool_intern(ast->symboltable->pool, "main", 4); // before the pool is pointed into
 	T_S *state = t_s_create(tac, ast);
-	tac_gen_globals(state, ast->root->left_child);
-	tac_gen_funcs(state, ast->root->middle_child);
-	Adr main = adr_of_sds(state, sdsnew("main"));
-	linkedlist_push_tail(tac->lines, unary_line(O_FUNC, main, 0));
-	tac_gen_main(state, ast->root->right_child);
+	tac_gen_globals(state, node_left(ast, ast->root));
+	tac_gen_funcs(state, node_middle(ast, ast->root));
+	Adr main = adr_of_string(state, main_id);
+	Line main_func = unary_line(O_FUNC, main, 0);
+	vector_push(tac->lines, &main_func);
+	tac_gen_main(state, node_right(ast, ast->root));
 	t_s_free(state);
 	return tac;
 }
 
-void sdsfree_wrapper(void *ptr, va_list args) {
-	sdsfree((sds)ptr);
-}
-
 void tac_free(TAC* tac) {
-	linkedlist_free(tac->lines);
-	linkedlist_free(tac->ints);
-	linkedlist_free(tac->floats);
-	linkedlist_free(tac->arrays);
-	linkedlist_free_ctx(tac->strings, sdsfree_wrapper);
+	vector_free(tac->lines);
+	vector_free(tac->ints);
+	vector_free(tac->floats);
+	vector_free(tac->arrays);
+	vector_free(tac->strings);
+	free(tac);
 }
 
 void print_adr(Adr adr) {
@@ -1279,82 +1178,90 @@ void print_tac_line(Line *l) {
 	printf("\n");
 }
 
+Adr *tac_line_def(Line *l) {
+	switch (l->op) {
+		case O_ASIGN: case O_CALLVAL:
+		case O_READI: case O_READF: case O_TRUE: case O_FALSE:
+		case O_ITOF: case O_NOT: case O_DEREF: case O_ALLOC:
+		case O_ADDF: case O_ADDI: case O_SUBF: case O_SUBI: case O_MULF: case O_MULI: case O_DIVF: case O_DIVI: case O_POWIF: case O_POWII: case O_MOD:
+		case O_EQI: case O_NEQI: case O_LTI: case O_LTEI: case O_GTI: case O_GTEI:
+		case O_EQF: case O_NEQF: case O_LTF: case O_LTEF: case O_GTF: case O_GTEF:
+		case O_OR: case O_AND: case O_XOR:
+			return adr_is_var(l->left) ? &l->left : NULL;
+		default:
+			return NULL;
+	}
+}
+
+static void add_use(Adr *adr, Adr *uses[3], u32 *count) {
+	if (adr_is_var(*adr))
+		uses[(*count)++] = adr;
+}
+
+u32 tac_line_uses(Line *l, Adr *uses[3]) {
+	u32 count = 0;
+	switch (l->op) {
+		case O_ASIGN:
+		case O_ITOF: case O_NOT: case O_DEREF: case O_ALLOC:
+		case O_GOTOF: case O_GOTOT:
+			add_use(&l->right, uses, &count);
+			break;
+		case O_PRINTI: case O_PRINTF: case O_PRINTSTR:
+		case O_PARAM: case O_RVAL:
+			add_use(&l->left, uses, &count);
+			break;
+		case O_STORE: // left is the address stored to, so read too
+			add_use(&l->left, uses, &count);
+			add_use(&l->right, uses, &count);
+			break;
+		case O_ADDF: case O_ADDI: case O_SUBF: case O_SUBI: case O_MULF: case O_MULI: case O_DIVF: case O_DIVI: case O_POWIF: case O_POWII: case O_MOD:
+		case O_EQI: case O_NEQI: case O_LTI: case O_LTEI: case O_GTI: case O_GTEI:
+		case O_EQF: case O_NEQF: case O_LTF: case O_LTEF: case O_GTF: case O_GTEF:
+		case O_OR: case O_AND: case O_XOR:
+			add_use(&l->middle, uses, &count);
+			add_use(&l->right, uses, &count);
+			break;
+		default:
+			break;
+	}
+	return count;
+}
+
 void tac_printf(TAC* tac) {
-	int i;
-	i = 0;
-	int *k;
 	printf(".arrays (zero-init):\n");
-	linkedlist_start(tac->arrays);
-	while ((k=(int*)linkedlist_get_current(tac->arrays))) {
-		printf("A%d: %d\n", i, *k);
-		linkedlist_forward(tac->arrays);
-		++i;
-	}
-	i = 0;
+	for (u32 i = 0; i < vector_len(tac->arrays); i++)
+		printf("A%u: %d\n", i, *(int*)vector_at(tac->arrays, i));
 	printf(".ints:\n");
-	linkedlist_start(tac->ints);
-	while ((k=(int*)linkedlist_get_current(tac->ints))) {
-		printf("I%d: %d\n", i, *k);
-		linkedlist_forward(tac->ints);
-		++i;
-	}
+	for (u32 i = 0; i < vector_len(tac->ints); i++)
+		printf("I%u: %d\n", i, (int)*(long*)vector_at(tac->ints, i));
 	printf(".floats:\n");
-	linkedlist_start(tac->floats);
-	i = 0;
-	double *x;
-	while ((x=(double*)linkedlist_get_current(tac->floats))) {
-		printf("F%d: %f\n", i, *x);
-		linkedlist_forward(tac->floats);
-		++i;
-	}
+	for (u32 i = 0; i < vector_len(tac->floats); i++)
+		printf("F%u: %f\n", i, *(double*)vector_at(tac->floats, i));
 	printf(".strings:\n");
-	linkedlist_start(tac->strings);
-	i = 0;
-	char *s;
-	while ((s=(char*)linkedlist_get_current(tac->strings))) {
-		printf("S%d: \"%s\"\n", i, s);
-		linkedlist_forward(tac->strings);
-		++i;
+	for (u32 i = 0; i < vector_len(tac->strings); i++) {
+		StrView *s = vector_at(tac->strings, i);
+		printf("S%u: \"%.*s\"\n", i, (int)s->len, s->str);
 	}
 	printf(".code:\n");
-	linkedlist_start(tac->lines);
-	Line *l;
-	while ((l=(Line*)linkedlist_get_current(tac->lines))) {
+	for (u32 n = 0; n < vector_len(tac->lines); n++) {
+		Line *l = vector_at(tac->lines, n);
 		if (l->linenum != 0) {
 			printf("%d: ", l->linenum);
 		}
 		print_tac_line(l);
-		linkedlist_forward(tac->lines);
 	}
 }
 
 void* tac_data(TAC* tac, Adr adr) {
-	int i;
 	switch (adr.type) {
 		case A_ILIT:
-			linkedlist_start(tac->ints);
-			for (i = 0; i < adr.adr; ++i) {
-				linkedlist_forward(tac->ints);
-			}
-			return linkedlist_get_current(tac->ints);
+			return vector_at(tac->ints, adr.adr);
 		case A_ARRAY:
-			linkedlist_start(tac->arrays);
-			for (i = 0; i < adr.adr; ++i) {
-				linkedlist_forward(tac->arrays);
-			}
-			return linkedlist_get_current(tac->arrays);
+			return vector_at(tac->arrays, adr.adr);
 		case A_FLIT:
-			linkedlist_start(tac->floats);
-			for (i = 0; i < adr.adr; ++i) {
-				linkedlist_forward(tac->floats);
-			}
-			return linkedlist_get_current(tac->floats);
+			return vector_at(tac->floats, adr.adr);
 		case A_STR:
-			linkedlist_start(tac->strings);
-			for (i = 0; i < adr.adr; ++i) {
-				linkedlist_forward(tac->strings);
-			}
-			return linkedlist_get_current(tac->strings);
+			return vector_at(tac->strings, adr.adr);
 		default:
 			abort();
 	}
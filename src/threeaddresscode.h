@@ -3,6 +3,7 @@
 
 #include "astree.h"
 #include "lib/linkedlist.h"
+#include "lib/vector.h"
 
 enum operation {
 	O_PRINTI,
@@ -96,7 +97,7 @@ static char adr_prefix[9][2] = {
 typedef struct address {
 	enum adr_type type;
 	/* enum val_type val_type */
-	u16 adr;
+	u32 adr;
 } Adr;
 
 // left, then right, then middle for 1/2/3 address operations
@@ -105,23 +106,36 @@ typedef struct tac_line {
 	Adr left; // no named variables in the IR
 	Adr middle;
 	Adr right;
-	u16 linenum;
+	u32 linenum;
 } Line;
 
 typedef struct threeaddresscode {
-	LinkedList *lines; // Line
-	LinkedList *strings; // char*
-	LinkedList *floats; // double
-	LinkedList *ints; // long
-	LinkedList *arrays; // int
+	Vector *lines; // Line
+	Vector *strings; // StrView, into the tree's string pool (so the tree has to outlive the TAC)
+	Vector *floats; // double
+	Vector *ints; // long
+	Vector *arrays; // int, each one's length
 } TAC;
 
 TAC *tac_from_ast(ASTree *ast);
 
 void tac_free(TAC* tac);
 void tac_printf(TAC* tac);
+void print_tac_line(Line *l);
 
-/* it's up to the user to cast the type (it's in the adr after all) */
+// a temporary, variable or parameter, the addresses a line can write
+static inline int adr_is_var(Adr adr) {
+	return adr.type == A_TMP || adr.type == A_VAR || adr.type == A_PARAM;
+}
+static inline int adr_equals(Adr a, Adr b) {
+	return a.type == b.type && a.adr == b.adr;
+}
+// the address l writes, NULL if it writes none
+Adr *tac_line_def(Line *l);
+// the addresses l reads that are variables, into uses, returning how many (at most 3)
+u32 tac_line_uses(Line *l, Adr *uses[3]);
+
+/* it's up to the user to cast the type (it's in the adr after all), good until the pool grows */
 void* tac_data(TAC* tac, Adr adr);
 
 #endif
@@ -1,11 +1,13 @@
 /*
   Is essentially a read-only tuple the Lexer passes to the Parser
+  (a view of one entry in the lexer's TokenStream)
 */
 
 #ifndef TOKEN_H
 #define TOKEN_H
 
 #include "lib/sds.h"
+#include "lib/defs.h"
 
 enum token_type {
 	// Token value for end of file
@@ -29,9 +31,18 @@ enum token_type {
 	NULLTOKEN
 };
 
+// binary value of a TILIT/TFLIT, parsed once by the lexer
+union literal {
+	long i;
+	double f;
+};
+
 typedef struct token {
 	enum token_type type;
-	char* val;
+	const char *val; // span into the lexer's source buffer (not terminated)
+	u32 len;
+	u32 id; // the value interned in the symbol table's string pool
+	union literal lit;
 	int row;
 	int col;
 } Token;
@@ -53,7 +64,17 @@ static char TPRINT[64][7] = {
 	"TIDEN ","TILIT ","TFLIT ","TSTRG ","TUNDF "
 };
 
-// void token_free(Token *t);
+// the lexer's output: one entry per token, in parallel arrays
+typedef struct token_stream {
+	u32 count, cap;
+	u8 *type; // enum token_type
+	u32 *offset; // value span into the source (len 0 for keywords/operators)
+	u32 *len;
+	u32 *id;
+	union literal *lit;
+	int *row;
+	int *col;
+} TokenStream;
 
 #endif
 
@@ -5,6 +5,7 @@
 #include "x86_code_generation.h"
 #include "../threeaddresscode.h"
 #include "../lib/linkedlist.h"
+#include "../lib/vector.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -54,12 +55,13 @@ static char *strdup(const char *s)
 typedef struct x86_codegen {
 	TAC *tac;
 	FILE *out_file;
-	u16 num_in_params;
-	u16 num_vars;
-	u16 num_tmp_regs;
-	u16 source_line;
+	u32 num_in_params;
+	u32 num_vars;
+	u32 num_tmp_regs;
+	u32 source_line;
 	char *source_name;
-	u16 num_generated_labels;
+	u32 num_generated_labels;
+	u32 line; // index into tac->lines of the one being resolved
 } Codegen;
 
 enum x86_register {
@@ -101,11 +103,11 @@ const char reg_print[26][6] = {
 
 typedef struct x86_adr {
 	enum x86_register reg;
-	u16 offset;
+	u32 offset;
 } xadr;
 
 xadr get_reg(Codegen *cdg, Adr adr) {
-	u16 offset;
+	u32 offset;
 	switch (adr.type) {
 		case A_PARAM:
 			offset = adr.adr;
@@ -183,25 +185,16 @@ void print_unary(Codegen *cdg, const char *op, xadr first) {
 	free(a1);
 }
 
-void params_of_next_call(Codegen *cdg, int *step_counter, int *paramsbetween) {
-	linkedlist_forward(cdg->tac->lines);
-	++*step_counter;
-	while (linkedlist_get_current(cdg->tac->lines)) {
-		enum operation op = ((Line*)linkedlist_get_current(cdg->tac->lines))->op;
+void params_of_next_call(Codegen *cdg, int *paramsbetween) {
+	for (u32 i = cdg->line + 1; i < vector_len(cdg->tac->lines); i++) {
+		enum operation op = ((Line*)vector_at(cdg->tac->lines, i))->op;
 		if (op == O_CALL || op == O_CALLVAL) {
-			break;
+			return;
 		} else if (op == O_PARAM) {
 			++*paramsbetween;
 		}
-		linkedlist_forward(cdg->tac->lines);
-		++*step_counter;
-	}
-	if (linkedlist_get_current(cdg->tac->lines)) {
-		/* return *(long*) tac_data(cdg->tac, ((Line*)linkedlist_get_current(cdg->tac->lines))->right); */
-		return;
-	} else {
-		abort();
 	}
+	abort();
 }
 
 void arithmetic(Codegen *cdg, const char *op, Line *line) {
@@ -243,7 +236,8 @@ void resolve_line(Codegen *cdg, Line *line) {
 		cdg->source_line = line->linenum;
 	}
 	char *s;
-	int step_counter;
+	StrView *name;
+	u32 step_counter;
 	int paramsbetween;
 	Line *l;
 	switch (line->op) {
@@ -468,13 +462,7 @@ void resolve_line(Codegen *cdg, Line *line) {
 		case O_PARAM:
 			// do a lookahead to find the matching function call
 			paramsbetween = 0;
-			step_counter = 0;
-			params_of_next_call(cdg, &step_counter, &paramsbetween);
-			// get back to this line
-			while (step_counter > 0) {
-				linkedlist_back(cdg->tac->lines);
-				step_counter--;
-			}
+			params_of_next_call(cdg, &paramsbetween);
 			switch (paramsbetween) {
 				case 0:
 					print_binary(cdg, "mov", mkreg(rdi), get_reg(cdg, line->left));
@@ -497,10 +485,12 @@ void resolve_line(Codegen *cdg, Line *line) {
 			}
 			break;
 		case O_CALL:
-			fprintf(out, "    call %s\n", (char*)tac_data(cdg->tac, line->left));
+			name = tac_data(cdg->tac, line->left);
+			fprintf(out, "    call %.*s\n", (int)name->len, name->str);
 			break;
 		case O_CALLVAL:
-			fprintf(out, "    call %s\n", (char*)tac_data(cdg->tac, line->middle));
+			name = tac_data(cdg->tac, line->middle);
+			fprintf(out, "    call %.*s\n", (int)name->len, name->str);
 			print_binary(cdg, "mov", get_reg(cdg, line->left), mkreg(rax));
 			break;
 		case O_RVAL:
@@ -512,9 +502,10 @@ void resolve_line(Codegen *cdg, Line *line) {
 			fprintf(out, "    ret\n");
 			break;
 		case O_FUNC:
-			fprintf(out, "    global %s\n", (char*)tac_data(cdg->tac, line->left));
-			fprintf(out, "%s:\n", (char*)tac_data(cdg->tac, line->left));
-			if (strcmp("main", (char*)tac_data(cdg->tac, line->left)) == 0) {
+			name = tac_data(cdg->tac, line->left);
+			fprintf(out, "    global %.*s\n", (int)name->len, name->str);
+			fprintf(out, "%.*s:\n", (int)name->len, name->str);
+			if (strview_equals(*name, "main")) {
 				fprintf(out, "    mov rdi, FILENAME\n");
 				fprintf(out, "    mov rsi, READMODE\n");
 				fprintf(out, "    call fopen\n");
@@ -531,14 +522,16 @@ void resolve_line(Codegen *cdg, Line *line) {
 				fprintf(out, "    syscall\n");
 				fprintf(out, ".fileopened:\n");
 			}
-			step_counter = 0;
 			// find biggest temp var (on left)
 			cdg->num_tmp_regs = 0;
 			// find biggest var (on left)
 			cdg->num_vars = 0;
 			// find biggest param (on right)
 			cdg->num_in_params = 0;
-			while ((l = linkedlist_get_current(cdg->tac->lines))) {
+			for (u32 i = cdg->line; i < vector_len(cdg->tac->lines); i++) {
+				l = vector_at(cdg->tac->lines, i);
+				if (i > cdg->line && l->op == O_FUNC)
+					break;
 				if (l->left.type == A_VAR) {
 					if (l->left.adr >= cdg->num_vars) {
 						cdg->num_vars = l->left.adr + 1;
@@ -563,17 +556,6 @@ void resolve_line(Codegen *cdg, Line *line) {
 						cdg->num_in_params = l->right.adr + 1;
 					}
 				}
-				linkedlist_forward(cdg->tac->lines);
-				step_counter++;
-				if ( !linkedlist_get_current(cdg->tac->lines) ||
-				     ((Line*)linkedlist_get_current(cdg->tac->lines))->op == O_FUNC) {
-					// go back to the end if the LL is now in the void
-					if (!linkedlist_get_current(cdg->tac->lines)) {
-						linkedlist_end(cdg->tac->lines);
-						step_counter--;
-					}
-					break;
-				}
 			}
 			if (cdg->num_in_params + cdg->num_tmp_regs + cdg->num_vars % 2 == 1) {
 				cdg->num_tmp_regs++;
@@ -583,29 +565,25 @@ void resolve_line(Codegen *cdg, Line *line) {
 			int alloc_bytes = (cdg->num_in_params + cdg->num_tmp_regs + cdg->num_vars)*8;
 			alloc_bytes += alloc_bytes % 16; // align stack for word boundary (call frame added 8, push rbp another 8)
 			fprintf(out, "    sub rsp, %d\n", alloc_bytes);
-			while (step_counter > 0) {
-				linkedlist_back(cdg->tac->lines);
-				step_counter--;
-			}
 			for (step_counter = 0; step_counter < cdg->num_in_params; ++step_counter) {
 				switch (step_counter) {
 					case 0:
-						fprintf(out, "    mov [rbp-%d], rdi\n", (1+step_counter)*8);
+						fprintf(out, "    mov [rbp-%u], rdi\n", (1+step_counter)*8);
 						break;
 					case 1:
-						fprintf(out, "    mov [rbp-%d], rsi\n", (1+step_counter)*8);
+						fprintf(out, "    mov [rbp-%u], rsi\n", (1+step_counter)*8);
 						break;
 					case 2:
-						fprintf(out, "    mov [rbp-%d], rdx\n", (1+step_counter)*8);
+						fprintf(out, "    mov [rbp-%u], rdx\n", (1+step_counter)*8);
 						break;
 					case 3:
-						fprintf(out, "    mov [rbp-%d], rcx\n", (1+step_counter)*8);
+						fprintf(out, "    mov [rbp-%u], rcx\n", (1+step_counter)*8);
 						break;
 					case 4:
-						fprintf(out, "    mov [rbp-%d], r8\n", (1+step_counter)*8);
+						fprintf(out, "    mov [rbp-%u], r8\n", (1+step_counter)*8);
 						break;
 					case 5:
-						fprintf(out, "    mov [rbp-%d], r9\n", (1+step_counter)*8);
+						fprintf(out, "    mov [rbp-%u], r9\n", (1+step_counter)*8);
 						break;
 				}
 			}
@@ -614,32 +592,18 @@ void resolve_line(Codegen *cdg, Line *line) {
 }
 
 void print_code(Codegen *cdg) {
-	linkedlist_start(cdg->tac->lines);
-	while (linkedlist_get_current(cdg->tac->lines)) {
-		resolve_line(cdg, linkedlist_get_current(cdg->tac->lines));
-		linkedlist_forward(cdg->tac->lines);
-	}
+	for (cdg->line = 0; cdg->line < vector_len(cdg->tac->lines); cdg->line++)
+		resolve_line(cdg, vector_at(cdg->tac->lines, cdg->line));
 }
 
 void print_consts(Codegen *cdg) {
 	TAC *tac = cdg->tac;
-	int i;
 	// because of movq these are still needed
-	linkedlist_start(tac->floats);
-	i = 0;
-	double *x;
-	while ((x=(double*)linkedlist_get_current(tac->floats))) {
-		fprintf(cdg->out_file, "    F%d dq %f\n", i, *x);
-		linkedlist_forward(tac->floats);
-		++i;
-	}
-	linkedlist_start(tac->strings);
-	i = 0;
-	char *s;
-	while ((s=(char*)linkedlist_get_current(tac->strings))) {
-		fprintf(cdg->out_file, "    S%d db \"%s\", 0\n", i, s);
-		linkedlist_forward(tac->strings);
-		++i;
+	for (u32 i = 0; i < vector_len(tac->floats); i++)
+		fprintf(cdg->out_file, "    F%u dq %f\n", i, *(double*)vector_at(tac->floats, i));
+	for (u32 i = 0; i < vector_len(tac->strings); i++) {
+		StrView *s = vector_at(tac->strings, i);
+		fprintf(cdg->out_file, "    S%u db \"%.*s\", 0\n", i, (int)s->len, s->str);
 	}
 }
 
@@ -666,16 +630,12 @@ void x86_code_gen(char *dest_path, TAC* tac, char *source_name) {
 		0,
 		source_name,
 		0,
+		0, // line
 	};
 	fprintf(out, "section .bss\n");
 	fprintf(out, "    fp resq 1\n");
-	linkedlist_start(tac->arrays);
-	int count = 0;
-	while (linkedlist_get_current(tac->arrays)) {
-		int len = *(int*)linkedlist_get_current(tac->arrays);
-	fprintf(out, "    A%d resb %d\n", count++, len);
-		linkedlist_forward(tac->arrays);
-	}
+	for (u32 i = 0; i < vector_len(tac->arrays); i++)
+		fprintf(out, "    A%u resb %d\n", i, *(int*)vector_at(tac->arrays, i));
 	fprintf(out, "section .rodata\n");
 	print_consts(&state);
 	fprintf(out, "    strtmp db \"%%s\", 0\n");